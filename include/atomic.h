@@ -0,0 +1,192 @@
+/**
+ * @file atomic.h
+ * @brief Operaciones atómicas del kernel (LL/SC o LSE según la CPU)
+ *
+ * @details
+ *   Interfaz C sobre atomic.S. Todas las operaciones son de 64 bits.
+ *   Al arrancar, cpufeature_init() activa las instrucciones LSE de
+ *   ARMv8.1 (LDADD, LDSET, LDCLR, SWP, CAS) si la CPU las tiene; si no,
+ *   se usan bucles LDXR/STXR.
+ *
+ *   FAMILIAS:
+ *   - atomic_t: contador (read/set, add/sub/inc/dec, *_return, fetch_*)
+ *   - xchg()/cmpxchg(): sobre cualquier unsigned long compartido
+ *   - Bitops: set_bit, clear_bit, test_and_set_bit, ... sobre un
+ *     array de unsigned long (bit nr en la palabra nr / 64)
+ *
+ *   ORDEN DE MEMORIA:
+ *   - Sin sufijo: orden completo (barrera antes y después)
+ *   - _acquire: los accesos posteriores no se adelantan a la operación
+ *   - _release: los accesos anteriores no se retrasan tras la operación
+ *   - _relaxed: solo atomicidad
+ *   - atomic_add/sub/inc/dec y set_bit/clear_bit (sin valor de retorno)
+ *     son _relaxed
+ *
+ *   @code
+ *   static atomic_t refs = ATOMIC_INIT(1);
+ *   atomic_inc(&refs);
+ *   if (atomic_dec_and_test(&refs)) liberar();
+ *
+ *   if (!test_and_set_bit_lock(0, &flags)) {
+ *       ... sección crítica ...
+ *       clear_bit_unlock(0, &flags);
+ *   }
+ *   @endcode
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ */
+
+#ifndef ATOMIC_H
+#define ATOMIC_H
+
+#include "barrier.h"
+
+/* ========================================================================== */
+/* PRIMITIVAS (atomic.S)                                                     */
+/* ========================================================================== */
+
+#define ATOMIC_DECLARE_ORDERS(name, args)           \
+    extern unsigned long name##_relaxed args;       \
+    extern unsigned long name##_acquire args;       \
+    extern unsigned long name##_release args;       \
+    extern unsigned long name args;
+
+ATOMIC_DECLARE_ORDERS(arch_atomic_fetch_add,    (unsigned long i, volatile unsigned long *p))
+ATOMIC_DECLARE_ORDERS(arch_atomic_fetch_or,     (unsigned long i, volatile unsigned long *p))
+ATOMIC_DECLARE_ORDERS(arch_atomic_fetch_andnot, (unsigned long i, volatile unsigned long *p))
+ATOMIC_DECLARE_ORDERS(arch_atomic_xchg,         (volatile unsigned long *p, unsigned long v))
+ATOMIC_DECLARE_ORDERS(arch_atomic_cmpxchg,      (volatile unsigned long *p, unsigned long old, unsigned long new))
+
+#undef ATOMIC_DECLARE_ORDERS
+
+/* ========================================================================== */
+/* XCHG / CMPXCHG                                                            */
+/* ========================================================================== */
+
+/* *p = v, devuelve el valor anterior */
+#define xchg(p, v)          arch_atomic_xchg((p), (v))
+#define xchg_acquire(p, v)  arch_atomic_xchg_acquire((p), (v))
+#define xchg_release(p, v)  arch_atomic_xchg_release((p), (v))
+#define xchg_relaxed(p, v)  arch_atomic_xchg_relaxed((p), (v))
+
+/* Si *p == old, *p = new. Devuelve el valor anterior (== old si éxito) */
+#define cmpxchg(p, o, n)          arch_atomic_cmpxchg((p), (o), (n))
+#define cmpxchg_acquire(p, o, n)  arch_atomic_cmpxchg_acquire((p), (o), (n))
+#define cmpxchg_release(p, o, n)  arch_atomic_cmpxchg_release((p), (o), (n))
+#define cmpxchg_relaxed(p, o, n)  arch_atomic_cmpxchg_relaxed((p), (o), (n))
+
+/* ========================================================================== */
+/* ATOMIC_T                                                                  */
+/* ========================================================================== */
+
+typedef struct {
+    volatile unsigned long counter;
+} atomic_t;
+
+#define ATOMIC_INIT(i) { (unsigned long)(i) }
+
+static inline long atomic_read(const atomic_t *v) {
+    return (long)READ_ONCE(v->counter);
+}
+
+static inline void atomic_set(atomic_t *v, long i) {
+    WRITE_ONCE(v->counter, (unsigned long)i);
+}
+
+static inline long atomic_fetch_add(long i, atomic_t *v) {
+    return (long)arch_atomic_fetch_add((unsigned long)i, &v->counter);
+}
+
+static inline long atomic_fetch_add_acquire(long i, atomic_t *v) {
+    return (long)arch_atomic_fetch_add_acquire((unsigned long)i, &v->counter);
+}
+
+static inline long atomic_fetch_add_release(long i, atomic_t *v) {
+    return (long)arch_atomic_fetch_add_release((unsigned long)i, &v->counter);
+}
+
+static inline long atomic_fetch_add_relaxed(long i, atomic_t *v) {
+    return (long)arch_atomic_fetch_add_relaxed((unsigned long)i, &v->counter);
+}
+
+static inline long atomic_fetch_or(long i, atomic_t *v) {
+    return (long)arch_atomic_fetch_or((unsigned long)i, &v->counter);
+}
+
+static inline long atomic_fetch_andnot(long i, atomic_t *v) {
+    return (long)arch_atomic_fetch_andnot((unsigned long)i, &v->counter);
+}
+
+static inline long atomic_xchg(atomic_t *v, long i) {
+    return (long)xchg(&v->counter, (unsigned long)i);
+}
+
+static inline long atomic_cmpxchg(atomic_t *v, long old, long new) {
+    return (long)cmpxchg(&v->counter, (unsigned long)old, (unsigned long)new);
+}
+
+static inline long atomic_cmpxchg_acquire(atomic_t *v, long old, long new) {
+    return (long)cmpxchg_acquire(&v->counter, (unsigned long)old, (unsigned long)new);
+}
+
+static inline long atomic_cmpxchg_release(atomic_t *v, long old, long new) {
+    return (long)cmpxchg_release(&v->counter, (unsigned long)old, (unsigned long)new);
+}
+
+/* Sin valor de retorno (relaxed) */
+static inline void atomic_add(long i, atomic_t *v) { atomic_fetch_add_relaxed(i, v); }
+static inline void atomic_sub(long i, atomic_t *v) { atomic_fetch_add_relaxed(-i, v); }
+static inline void atomic_inc(atomic_t *v)         { atomic_fetch_add_relaxed(1, v); }
+static inline void atomic_dec(atomic_t *v)         { atomic_fetch_add_relaxed(-1, v); }
+
+/* Devuelven el valor nuevo (orden completo) */
+static inline long atomic_add_return(long i, atomic_t *v) { return atomic_fetch_add(i, v) + i; }
+static inline long atomic_sub_return(long i, atomic_t *v) { return atomic_fetch_add(-i, v) - i; }
+static inline long atomic_inc_return(atomic_t *v)         { return atomic_add_return(1, v); }
+static inline long atomic_dec_return(atomic_t *v)         { return atomic_sub_return(1, v); }
+
+/* 1 si el valor nuevo es 0 (típico para contadores de referencias) */
+static inline int atomic_dec_and_test(atomic_t *v) {
+    return atomic_dec_return(v) == 0;
+}
+
+/* ========================================================================== */
+/* BITOPS                                                                    */
+/* ========================================================================== */
+
+#define BITS_PER_LONG  64
+#define BIT_WORD(nr)   ((nr) / BITS_PER_LONG)
+#define BIT_MASK(nr)   (1UL << ((nr) % BITS_PER_LONG))
+
+static inline void set_bit(unsigned long nr, volatile unsigned long *addr) {
+    arch_atomic_fetch_or_relaxed(BIT_MASK(nr), addr + BIT_WORD(nr));
+}
+
+static inline void clear_bit(unsigned long nr, volatile unsigned long *addr) {
+    arch_atomic_fetch_andnot_relaxed(BIT_MASK(nr), addr + BIT_WORD(nr));
+}
+
+static inline int test_bit(unsigned long nr, const volatile unsigned long *addr) {
+    return (READ_ONCE(addr[BIT_WORD(nr)]) & BIT_MASK(nr)) != 0;
+}
+
+/* Devuelven el valor anterior del bit (orden completo) */
+static inline int test_and_set_bit(unsigned long nr, volatile unsigned long *addr) {
+    return (arch_atomic_fetch_or(BIT_MASK(nr), addr + BIT_WORD(nr)) & BIT_MASK(nr)) != 0;
+}
+
+static inline int test_and_clear_bit(unsigned long nr, volatile unsigned long *addr) {
+    return (arch_atomic_fetch_andnot(BIT_MASK(nr), addr + BIT_WORD(nr)) & BIT_MASK(nr)) != 0;
+}
+
+/* Bit como lock: adquirir (acquire) y liberar (release) */
+static inline int test_and_set_bit_lock(unsigned long nr, volatile unsigned long *addr) {
+    return (arch_atomic_fetch_or_acquire(BIT_MASK(nr), addr + BIT_WORD(nr)) & BIT_MASK(nr)) != 0;
+}
+
+static inline void clear_bit_unlock(unsigned long nr, volatile unsigned long *addr) {
+    arch_atomic_fetch_andnot_release(BIT_MASK(nr), addr + BIT_WORD(nr));
+}
+
+#endif /* ATOMIC_H */
@@ -0,0 +1,56 @@
+/**
+ * @file barrier.h
+ * @brief Barreras de memoria y accesos "una sola vez"
+ *
+ * @details
+ *   Primitivas de orden para las estructuras que se leen sin lock
+ *   (seqcounts, y en general cualquier publicación productor/consumidor):
+ *
+ *   - smp_mb():  orden completo (DMB ISH)
+ *   - smp_rmb(): ordena lecturas con lecturas (DMB ISHLD)
+ *   - smp_wmb(): ordena escrituras con escrituras (DMB ISHST)
+ *   - barrier(): solo impide que el compilador reordene
+ *   - READ_ONCE()/WRITE_ONCE(): un único acceso, sin que el compilador
+ *     lo parta, lo repita ni lo saque de un bucle
+ *   - smp_load_acquire()/smp_store_release(): LDAR/STLR. Lo escrito
+ *     antes del release es visible para quien lee el valor con acquire
+ *   - cpu_relax(): pista de espera activa (YIELD)
+ *
+ *   Fuera de AArch64 (simulador del host, tools/schedsim) se traducen a
+ *   las barreras equivalentes de GCC.
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ */
+
+#ifndef BARRIER_H
+#define BARRIER_H
+
+/* Barrera del compilador */
+#define barrier() asm volatile("" ::: "memory")
+
+#ifdef __aarch64__
+
+#define smp_mb()    asm volatile("dmb ish" ::: "memory")
+#define smp_rmb()   asm volatile("dmb ishld" ::: "memory")
+#define smp_wmb()   asm volatile("dmb ishst" ::: "memory")
+#define cpu_relax() asm volatile("yield" ::: "memory")
+
+#else
+
+#define smp_mb()    __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define smp_rmb()   __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define smp_wmb()   __atomic_thread_fence(__ATOMIC_RELEASE)
+#define cpu_relax() barrier()
+
+#endif
+
+/* Acceso único a una variable compartida */
+#define READ_ONCE(x)     (*(const volatile __typeof__(x) *)&(x))
+#define WRITE_ONCE(x, v) (*(volatile __typeof__(x) *)&(x) = (v))
+
+/* Lectura con semántica acquire / escritura con semántica release */
+#define smp_load_acquire(p)     __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define smp_store_release(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+
+#endif /* BARRIER_H */
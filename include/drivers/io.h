@@ -41,6 +41,17 @@ void uart_handle_irq();
  */
 char uart_getc_nonblocking();
 
+/**
+ * @brief Lee un carácter, durmiendo hasta que llegue uno
+ * @return Carácter leído
+ *
+ * @details
+ *   Espera en una wait queue que despierta el IRQ de la UART: el
+ *   lector se ejecuta en cuanto llega la tecla, sin sondear. Solo desde
+ *   contexto de proceso (un único lector: el shell).
+ */
+char uart_getc(void);
+
 /**
  * @brief Imprime con formato (similar a printf)
  * @param fmt Cadena de formato
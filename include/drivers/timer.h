@@ -49,6 +49,10 @@
 /* FUNCIONES EXTERNAS (Implementadas en Assembly)                           */
 /* ========================================================================== */
 
+/* Frecuencia y valor actual del contador del sistema (src/utils.S) */
+extern unsigned long timer_get_freq(void);
+extern unsigned long timer_get_count(void);
+
 /* Configura el valor del timeout del timer (src/utils.S) */
 extern void timer_set_tval(unsigned long);
 
@@ -62,6 +66,10 @@ extern void set_vbar_el1(void *);
 extern void enable_interrupts(void);
 extern void disable_interrupts(void);
 
+/* Guarda/restaura el estado de IRQs (DAIF) para secciones anidables (src/entry.S) */
+extern unsigned long local_irq_save(void);
+extern void local_irq_restore(unsigned long flags);
+
 /* Tabla de vectores de excepciones (src/vectors.S) */
 extern void vectors(void);
 
@@ -94,9 +102,19 @@ void timer_init(void);
  * 
  * @details
  *   Función invocada cada ~104ms por el GIC (ID 30).
- *   Llama a timer_tick() para actualizar quantum y luego
- *   a schedule() para ejecutar el planificador Round-Robin.
+ *   Llama a timer_tick() para actualizar quantum y marca need_reschedule;
+ *   irq_handler_stub ejecuta las softirqs y después schedule().
  */
 void handle_timer_irq(void);
 
+/**
+ * @brief Tiempo desde el arranque en microsegundos
+ *
+ * @details
+ *   ticks * TIMER_INTERVAL más los ciclos CNTPCT transcurridos desde el
+ *   último tick (acotados a un intervalo, así el valor nunca retrocede).
+ *   Lee la pareja (ticks, CNTPCT) con sys_time_read() sin bloquear.
+ */
+unsigned long timer_uptime_us(void);
+
 #endif // TIMER_H
\ No newline at end of file
@@ -1,10 +1,17 @@
 #ifndef VFS_H
 #define VFS_H
 
+#include "../spinlock.h"
+
 #define MAX_FILES 64
 #define FILE_NAME_LEN 32
 #define MAX_FILE_SIZE 4096 /* Ficheros de 1 pagina por ahora */
 
+/* Estados de un iNodo (campo is_used) */
+#define INODE_FREE  0   /* Libre */
+#define INODE_USED  1   /* Archivo visible */
+#define INODE_DYING 2   /* Borrado: esperando el periodo de gracia RCU */
+
 /* Tipos de iNodo */
 #define FS_FILE      1
 #define FS_DIRECTORY 2
@@ -18,7 +25,7 @@ typedef struct {
     int size;                   /* Tamaño en bytes */
     unsigned long data_ptr;     /* Puntero a la memoria donde están los datos */
     char name[FILE_NAME_LEN];   /* Nombre del archivo (Simplificación para RamFS) */
-    int is_used;                /* 1 si está ocupado, 0 si está libre */
+    volatile int is_used;       /* INODE_FREE / INODE_USED / INODE_DYING */
 } inode_t;
 
 /* ========================================================================== */
@@ -29,6 +36,7 @@ typedef struct {
     int free_inodes;            /* iNodos disponibles */
     unsigned long start_addr;   /* Dirección física donde empieza el disco en RAM */
     inode_t inodes[MAX_FILES];  /* Tabla de iNodos (Directorio raíz plano) */
+    struct rwlock lock;         /* Lectores: ls/read. Escritores: create/write/remove */
 } superblock_t;
 
 /* ========================================================================== */
@@ -0,0 +1,91 @@
+/**
+ * @file checkpoint.h
+ * @brief Checkpoint/restore de procesos para arranque rápido de servicios
+ *
+ * @details
+ *   Un proceso ya inicializado se "fotografía" a sí mismo con
+ *   process_checkpoint(). Después se pueden crear instancias idénticas
+ *   con process_restore() sin repetir la inicialización en frío.
+ *
+ *   QUÉ SE GUARDA (imagen en RamFS):
+ *   - Prioridad y nombre del PCB
+ *   - Contexto de registros (x19-x29, LR, SP) en el punto del checkpoint
+ *   - La parte USADA del stack (desde SP hasta la cima)
+ *   - Las páginas de demand paging del proceso (pcb->vm_pages): solo sus
+ *     descriptores; los marcos físicos se comparten copy-on-write (la
+ *     imagen mantiene una referencia y quedan de solo lectura)
+ *
+ *   SEMÁNTICA (como fork/setjmp):
+ *   @code
+ *   init_lento();
+ *   if (process_checkpoint("svc.ckpt") == 1) {
+ *       // Instancia restaurada: empieza aquí, ya inicializada
+ *   }
+ *   @endcode
+ *
+ *   ESPACIOS DE DIRECCIONES:
+ *   - Cada instancia tiene su tabla base: las páginas de la imagen se
+ *     mapean en ella de solo lectura, y la copia que crea su primera
+ *     escritura es privada de esa instancia.
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "../sched.h"
+
+/* ========================================================================== */
+/* FORMATO DE LA IMAGEN                                                      */
+/* ========================================================================== */
+
+#define CKPT_MAGIC 0x544E504B43484B43UL  /* "CKHCKPNT" */
+
+/**
+ * @brief Cabecera de la imagen (seguida de 'stack_len' bytes de stack)
+ */
+struct ckpt_header {
+    unsigned long magic;
+    int priority;
+    char name[16];
+    struct cpu_context ctx;                      /* Registros en el checkpoint */
+    unsigned long stack_top;                     /* Cima del stack original */
+    unsigned long stack_len;                     /* Bytes de stack guardados */
+    int nr_pages;
+    unsigned long page_va[PROC_MAX_VM_PAGES];    /* VAs de demand paging */
+    unsigned long page_desc[PROC_MAX_VM_PAGES];  /* Descriptor L3 (física + atributos) */
+};
+
+/* ========================================================================== */
+/* FUNCIONES PUBLICAS                                                        */
+/* ========================================================================== */
+
+/**
+ * @brief Guarda una imagen del proceso actual en RamFS
+ * @param name Nombre del fichero de imagen (no debe existir)
+ * @return 0 en el proceso original si se guardó, 1 en cada instancia
+ *         restaurada desde la imagen, -1 en caso de error
+ */
+long process_checkpoint(const char *name);
+
+/**
+ * @brief Crea una instancia nueva a partir de una imagen
+ * @param name Nombre del fichero de imagen
+ * @return PID de la instancia (READY), -1 en caso de error
+ *
+ * @details
+ *   Copia el stack guardado al stack nuevo, reubica los punteros que
+ *   apuntaban al stack original y comparte las páginas COW.
+ */
+long process_restore(const char *name);
+
+/**
+ * @brief Borra una imagen y suelta sus referencias a las páginas
+ * @param name Nombre del fichero de imagen
+ * @return 0 si se borró, -1 si no existe o no es una imagen
+ */
+int ckpt_delete(const char *name);
+
+#endif /* CHECKPOINT_H */
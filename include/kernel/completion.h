@@ -0,0 +1,132 @@
+/**
+ * @file completion.h
+ * @brief Completions y variables de condición sobre wait queues
+ *
+ * @details
+ *   COMPLETION: "esperar a que algo termine una vez".
+ *   @code
+ *   struct completion done;
+ *   init_completion(&done);
+ *   create_process(worker, &done, ...);
+ *   wait_for_completion(&done);        // worker llama complete(&done)
+ *   @endcode
+ *   - complete() despierta a un waiter; si no hay ninguno, el aviso se
+ *     guarda (done++) y el siguiente wait_for_completion() no se bloquea
+ *   - complete_all() despierta a todos y deja la completion abierta
+ *     hasta reinit_completion()
+ *
+ *   VARIABLE DE CONDICIÓN: esperar un predicado protegido por un mutex.
+ *   @code
+ *   mutex_lock(&m);
+ *   while (!hay_datos)
+ *       cond_wait(&cv, &m);           // suelta m, duerme, retoma m
+ *   ... consumir ...
+ *   mutex_unlock(&m);
+ *
+ *   // Productor
+ *   mutex_lock(&m); hay_datos = 1; cond_signal(&cv); mutex_unlock(&m);
+ *   @endcode
+ *   - Soltar el mutex y bloquearse es atómico (IRQs deshabilitadas
+ *     entre ambos): un cond_signal() no puede perderse en medio
+ *   - Como en POSIX, el predicado debe comprobarse en un bucle
+ *
+ *   Los timeouts se expresan en ticks del timer; las variantes _timeout
+ *   devuelven 0 si vencieron y los ticks restantes si no.
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ */
+
+#ifndef COMPLETION_H
+#define COMPLETION_H
+
+#include "wait.h"
+#include "../mutex.h"
+
+/* ========================================================================== */
+/* COMPLETIONS                                                               */
+/* ========================================================================== */
+
+/* Valor de 'done' tras complete_all(): nunca vuelve a bloquear */
+#define COMPLETION_DONE_ALL 0x7FFFFFFFUL
+
+struct completion {
+    volatile unsigned long done;     /* Avisos pendientes */
+    struct wait_queue_head wait;
+};
+
+/**
+ * @brief Inicializa una completion sin avisos pendientes
+ */
+void init_completion(struct completion *c);
+
+/**
+ * @brief Vuelve a dejarla sin avisos (tras complete_all)
+ */
+void reinit_completion(struct completion *c);
+
+/**
+ * @brief Espera un aviso de complete()/complete_all()
+ */
+void wait_for_completion(struct completion *c);
+
+/**
+ * @brief Espera un aviso durante un máximo de 'timeout' ticks
+ * @return 0 si venció; si no, ticks restantes (al menos 1)
+ */
+long wait_for_completion_timeout(struct completion *c, long timeout);
+
+/**
+ * @brief Consume un aviso sin bloquear
+ * @return 1 si había aviso, 0 si no
+ */
+int try_wait_for_completion(struct completion *c);
+
+/**
+ * @brief Da un aviso (despierta a un waiter). Seguro desde IRQ
+ */
+void complete(struct completion *c);
+
+/**
+ * @brief Despierta a todos los waiters, presentes y futuros. Seguro desde IRQ
+ */
+void complete_all(struct completion *c);
+
+/* ========================================================================== */
+/* VARIABLES DE CONDICIÓN                                                    */
+/* ========================================================================== */
+
+struct condvar {
+    struct wait_queue_head wait;
+};
+
+/**
+ * @brief Inicializa una variable de condición
+ */
+void cond_init(struct condvar *cv);
+
+/**
+ * @brief Suelta 'm', duerme hasta cond_signal/cond_broadcast y retoma 'm'
+ *
+ * @details El llamador debe tener 'm'.
+ */
+void cond_wait(struct condvar *cv, struct mutex *m);
+
+/**
+ * @brief cond_wait() con un máximo de 'timeout' ticks
+ * @return 0 si venció; si no, ticks restantes (al menos 1). En ambos
+ *         casos vuelve con 'm' tomado
+ */
+long cond_wait_timeout(struct condvar *cv, struct mutex *m, long timeout);
+
+/**
+ * @brief Despierta a un proceso esperando en la condición
+ */
+void cond_signal(struct condvar *cv);
+
+/**
+ * @brief Despierta a todos los procesos esperando en la condición
+ */
+void cond_broadcast(struct condvar *cv);
+
+#endif /* COMPLETION_H */
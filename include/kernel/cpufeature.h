@@ -0,0 +1,81 @@
+/**
+ * @file cpufeature.h
+ * @brief Detección de características de la CPU y parcheo de código
+ *
+ * @details
+ *   Al arrancar se leen los registros de identificación (ID_AA64*_EL1)
+ *   y, para cada característica presente, se aplican las
+ *   "alternativas": instrucciones del kernel que se sustituyen en
+ *   caliente por otra más adecuada para esa CPU.
+ *
+ *   ALTERNATIVAS:
+ *   - Cada entrada de la sección .altinstr indica una instrucción
+ *     (site), la característica que la activa y la instrucción nueva
+ *   - El código por defecto es el que funciona en cualquier ARMv8.0;
+ *     el parche solo se aplica si la característica existe
+ *   - Se aplican una sola vez, en cpufeature_init(), antes de que haya
+ *     otros procesos ni interrupciones
+ *
+ *   CARACTERÍSTICAS:
+ *   - CPU_FEATURE_LSE: atómicos ARMv8.1 (CAS, LDADD, SWP...).
+ *     ID_AA64ISAR0_EL1.Atomic (bits 23:20) >= 2. En QEMU hace falta
+ *     '-cpu max' (make run QEMU_CPU=max); cortex-a72 no las tiene
+ *   - CPU_FEATURE_TLBIRANGE: TLBI por rangos ARMv8.4 (RVAE1IS).
+ *     ID_AA64ISAR0_EL1.TLB (bits 59:56) == 2. La usa
+ *     tlb_invalidate_range() (mm_utils.S)
+ *
+ *   Este header también lo incluyen atomic.S y mm_utils.S (solo las
+ *   constantes).
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ */
+
+#ifndef CPUFEATURE_H
+#define CPUFEATURE_H
+
+/* Características detectables */
+#define CPU_FEATURE_LSE       0
+#define CPU_FEATURE_TLBIRANGE 1
+#define CPU_FEATURE_COUNT     2
+
+/* Campo Atomic de ID_AA64ISAR0_EL1 */
+#define ID_AA64ISAR0_ATOMIC_SHIFT 20
+#define ID_AA64ISAR0_ATOMIC_LSE   2
+
+/* Campo TLB de ID_AA64ISAR0_EL1 (2 = TLBI por rangos y Outer Shareable) */
+#define ID_AA64ISAR0_TLB_SHIFT    56
+#define ID_AA64ISAR0_TLB_RANGE    2
+
+/* Codificación de NOP (sustituto habitual de un salto) */
+#define AARCH64_INSN_NOP 0xd503201f
+
+#ifndef __ASSEMBLER__
+
+/**
+ * @brief Entrada de la sección .altinstr (la genera atomic.S)
+ */
+struct alt_entry {
+    unsigned long site;     /* Dirección de la instrucción a sustituir */
+    unsigned int feature;   /* CPU_FEATURE_* que activa el parche */
+    unsigned int insn;      /* Instrucción nueva */
+};
+
+/**
+ * @brief Detecta las características de la CPU y aplica las alternativas
+ *
+ * @details
+ *   Debe llamarse lo primero en kernel(), antes de usar atomic.h.
+ */
+void cpufeature_init(void);
+
+/**
+ * @brief Indica si la CPU tiene una característica
+ * @param feature CPU_FEATURE_*
+ * @return 1 si la tiene, 0 si no
+ */
+int cpu_has_feature(int feature);
+
+#endif /* __ASSEMBLER__ */
+
+#endif /* CPUFEATURE_H */
@@ -0,0 +1,83 @@
+/**
+ * @file fdt.h
+ * @brief Lectura del Device Tree (FDT) que pasa el cargador
+ *
+ * @details
+ *   El firmware (QEMU) describe la máquina en un blob FDT: RAM,
+ *   periféricos, línea de comandos... _start guarda en 'boot_dtb' el
+ *   puntero recibido en x0. Si no es un FDT válido (QEMU arranca los
+ *   ELF "bare-metal" con x0 = 0) se busca al principio de la RAM, donde
+ *   QEMU lo deja si la imagen no lo pisa.
+ *
+ *   FORMATO (todo big-endian):
+ *   @code
+ *   +-----------+---------------+------------------+-----------+
+ *   | cabecera  | reservas      | estructura       | cadenas   |
+ *   | (magic)   | {addr, size}* | BEGIN_NODE/PROP/ | nombres   |
+ *   |           | ... {0, 0}    | END_NODE ... END | de props  |
+ *   +-----------+---------------+------------------+-----------+
+ *   @endcode
+ *
+ *   Solo se lee lo necesario para el arranque: los nodos /memory y el
+ *   bloque de reservas.
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ */
+
+#ifndef FDT_H
+#define FDT_H
+
+/* Primera palabra de un FDT válido */
+#define FDT_MAGIC 0xD00DFEED
+
+/* Dirección física de la RAM en QEMU virt (DTB de arranque "bare-metal") */
+#define FDT_QEMU_RAM_BASE 0x40000000UL
+
+/* Máximo de rangos que devuelven las funciones de consulta */
+#define FDT_MAX_REGIONS 8
+
+/**
+ * @brief Rango físico [base, base + size)
+ */
+struct fdt_region {
+    unsigned long base;
+    unsigned long size;
+};
+
+/**
+ * @brief Valor de x0 al entrar en _start (boot.s)
+ */
+extern unsigned long boot_dtb;
+
+/**
+ * @brief Localiza el FDT de arranque
+ * @return Dirección del blob, o 0 si no hay ninguno válido
+ */
+unsigned long fdt_find(void);
+
+/**
+ * @brief Comprueba la cabecera de un FDT
+ * @return 1 si 'dtb' apunta a un FDT válido
+ */
+int fdt_valid(unsigned long dtb);
+
+/**
+ * @brief Tamaño total del blob en bytes (para reservarlo)
+ */
+unsigned long fdt_total_size(unsigned long dtb);
+
+/**
+ * @brief Rangos de RAM de los nodos /memory (propiedad 'reg')
+ * @param out Destino (al menos 'max' entradas)
+ * @return Número de rangos encontrados (0 si ninguno)
+ */
+int fdt_memory_regions(unsigned long dtb, struct fdt_region *out, int max);
+
+/**
+ * @brief Rangos del bloque de reservas de memoria del FDT
+ * @return Número de rangos copiados en 'out'
+ */
+int fdt_reserved_regions(unsigned long dtb, struct fdt_region *out, int max);
+
+#endif /* FDT_H */
@@ -0,0 +1,165 @@
+/**
+ * @file futex.h
+ * @brief Futex: espera/despertar en el kernel indexados por dirección
+ *
+ * @details
+ *   Un futex es un entero de 32 bits en memoria del proceso. El kernel
+ *   no guarda estado por futex: solo colas de espera indexadas (hash)
+ *   por la dirección. Así un lock de usuario resuelve el caso sin
+ *   contención con instrucciones atómicas y solo entra al kernel cuando
+ *   tiene que dormir o despertar a alguien.
+ *
+ *   SYSCALL SYS_FUTEX (x8 = 4):
+ *   - x0 = dirección del futex (alineada a 4)
+ *   - x1 = operación (FUTEX_WAIT / FUTEX_WAKE)
+ *   - x2 = FUTEX_WAIT: valor esperado / FUTEX_WAKE: máximo a despertar
+ *   - Retorno en x0:
+ *     FUTEX_WAIT: 0 al despertar, -1 si *uaddr != valor (no duerme)
+ *     FUTEX_WAKE: número de procesos despertados
+ *
+ *   La comprobación "*uaddr == val" y el encolado se hacen con el lock
+ *   del bucket tomado: un FUTEX_WAKE posterior al cambio del valor no
+ *   se puede perder.
+ *
+ *   MUTEX DE USUARIO (umutex, algoritmo de Drepper "Futexes are tricky"):
+ *   - 0 = libre, 1 = tomado, 2 = tomado con posibles waiters
+ *   - lock: CAS 0->1 (LDAXR/STLXR). Solo si falla se marca 2 y se
+ *     hace FUTEX_WAIT
+ *   - unlock: XCHG a 0. Solo si valía 2 se hace FUTEX_WAKE
+ *
+ *   Las claves son direcciones físicas: cada proceso tiene su propia
+ *   tabla y la misma VA puede ser memoria distinta (o la misma página
+ *   compartida con otra VA). Si la VA no está mapeada en la tabla del
+ *   proceso (p. ej. datos del kernel) se usa la propia VA.
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ */
+
+#ifndef FUTEX_H
+#define FUTEX_H
+
+#include "sys.h"
+
+/* ========================================================================== */
+/* CONSTANTES                                                                */
+/* ========================================================================== */
+
+#define FUTEX_WAIT 0
+#define FUTEX_WAKE 1
+
+/* Buckets de la tabla hash de colas de espera (potencia de 2) */
+#define FUTEX_HASH_SIZE 16
+
+/* ========================================================================== */
+/* FUNCIONES PUBLICAS (Kernel)                                               */
+/* ========================================================================== */
+
+/**
+ * @brief Duerme al proceso actual si *uaddr sigue valiendo 'val'
+ * @return 0 al ser despertado, -1 si el valor no coincidía
+ */
+long futex_wait(volatile int *uaddr, int val);
+
+/**
+ * @brief Despierta hasta 'nr' procesos esperando en uaddr (FIFO)
+ * @return Número de procesos despertados
+ */
+long futex_wake(volatile int *uaddr, int nr);
+
+/**
+ * @brief Handler de SYS_FUTEX (deja el resultado en regs->x0)
+ */
+void sys_futex(struct pt_regs *regs);
+
+/**
+ * @brief Número de SYS_FUTEX atendidas desde el arranque
+ */
+unsigned long futex_syscall_count(void);
+
+/* ========================================================================== */
+/* LADO USUARIO                                                              */
+/* ========================================================================== */
+
+/**
+ * @brief Invoca SYS_FUTEX mediante SVC
+ */
+static inline long futex_call(volatile int *uaddr, int op, int val) {
+    register long x0 asm("x0") = (long)uaddr;
+    register long x1 asm("x1") = op;
+    register long x2 asm("x2") = val;
+    register long x8 asm("x8") = SYS_FUTEX;
+
+    asm volatile("svc #0"
+                 : "+r"(x0)
+                 : "r"(x1), "r"(x2), "r"(x8)
+                 : "memory");
+    return x0;
+}
+
+/**
+ * @brief CAS atómico: si *p == old, *p = new. Devuelve el valor previo
+ */
+static inline int umutex_cmpxchg(volatile int *p, int old, int new) {
+    int prev;
+    unsigned int fail;
+
+    asm volatile(
+        "1: ldaxr %w0, [%2]\n"
+        "   cmp %w0, %w3\n"
+        "   b.ne 2f\n"
+        "   stlxr %w1, %w4, [%2]\n"
+        "   cbnz %w1, 1b\n"
+        "   b 3f\n"
+        "2: clrex\n"
+        "3:\n"
+        : "=&r"(prev), "=&r"(fail)
+        : "r"(p), "r"(old), "r"(new)
+        : "cc", "memory");
+    return prev;
+}
+
+/**
+ * @brief Intercambio atómico: *p = new. Devuelve el valor previo
+ */
+static inline int umutex_xchg(volatile int *p, int new) {
+    int prev;
+    unsigned int fail;
+
+    asm volatile(
+        "1: ldaxr %w0, [%2]\n"
+        "   stlxr %w1, %w3, [%2]\n"
+        "   cbnz %w1, 1b\n"
+        : "=&r"(prev), "=&r"(fail)
+        : "r"(p), "r"(new)
+        : "memory");
+    return prev;
+}
+
+/**
+ * @brief Adquiere un mutex de usuario (sin syscall si está libre)
+ */
+static inline void umutex_lock(volatile int *m) {
+    int c = umutex_cmpxchg(m, 0, 1);
+    if (c == 0) return;
+
+    /* Contención: marcar "con waiters" y dormir hasta conseguirlo */
+    if (c != 2) {
+        c = umutex_xchg(m, 2);
+    }
+    while (c != 0) {
+        futex_call(m, FUTEX_WAIT, 2);
+        c = umutex_xchg(m, 2);
+    }
+}
+
+/**
+ * @brief Libera un mutex de usuario (syscall solo si hay waiters)
+ */
+static inline void umutex_unlock(volatile int *m) {
+    if (umutex_xchg(m, 0) == 2) {
+        futex_call(m, FUTEX_WAKE, 1);
+    }
+}
+
+#endif /* FUTEX_H */
@@ -0,0 +1,135 @@
+/**
+ * @file ipc.h
+ * @brief IPC síncrono cliente/servidor (estilo L4) con hand-off directo
+ *
+ * @details
+ *   Paso de mensajes síncrono y sin buffers intermedios en el kernel:
+ *
+ *   MODELO:
+ *   - El cliente hace ipc_call(): envía una petición y se bloquea hasta
+ *     recibir la respuesta (send + receive atómicos)
+ *   - El servidor hace ipc_recv() una vez y luego ipc_reply_recv() en
+ *     bucle: responde al cliente actual y espera al siguiente
+ *
+ *   HAND-OFF DIRECTO (el camino rápido):
+ *   - Si el destino ya está esperando, el emisor le copia el mensaje y
+ *     cambia a él con cpu_switch_to(), SIN pasar por la elección de
+ *     schedule() (ni aging ni recorrido de process[])
+ *   - El receptor hereda el quantum restante del emisor (donación de
+ *     tiempo): el par cliente/servidor consume la rodaja del cliente
+ *   - Si el destino no está esperando, el emisor se encola en él y se
+ *     bloquea (camino lento, vía schedule())
+ *
+ *   MENSAJE:
+ *   - Una etiqueta (tag) + hasta IPC_MR_WORDS palabras ("message
+ *     registers"). Solo se copian las palabras indicadas en la etiqueta.
+ *
+ *   USO TÍPICO:
+ *   @code
+ *   // Servidor
+ *   struct ipc_msg m;
+ *   long client = ipc_recv(&m);
+ *   while (1) {
+ *       m.mr[0] = atender(m.mr[0]);
+ *       m.tag = IPC_TAG(0, 1);
+ *       client = ipc_reply_recv(client, &m, &m);
+ *   }
+ *
+ *   // Cliente
+ *   struct ipc_msg m = { .tag = IPC_TAG(OP_X, 1), .mr = { arg } };
+ *   ipc_call(server_pid, &m);   // m contiene ya la respuesta
+ *   @endcode
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ */
+
+#ifndef IPC_H
+#define IPC_H
+
+#include "../sched.h"
+
+/* ========================================================================== */
+/* FORMATO DEL MENSAJE                                                       */
+/* ========================================================================== */
+
+/* Número de palabras de datos por mensaje (message registers) */
+#define IPC_MR_WORDS 6
+
+/**
+ * @brief Etiqueta del mensaje
+ *
+ * @details
+ *   bits [5:0]  : Número de palabras mr[] válidas (0..IPC_MR_WORDS)
+ *   bits [63:16]: Etiqueta libre (código de operación / resultado)
+ */
+#define IPC_TAG(label, words)  (((unsigned long)(label) << 16) | ((words) & 0x3F))
+#define IPC_TAG_LABEL(tag)     ((tag) >> 16)
+#define IPC_TAG_WORDS(tag)     ((tag) & 0x3F)
+
+/* Receptor sin emisor concreto (ipc_partner en espera de cualquiera) */
+#define IPC_ANY (-1)
+
+/**
+ * @brief Mensaje IPC
+ */
+struct ipc_msg {
+    unsigned long tag;
+    unsigned long mr[IPC_MR_WORDS];
+};
+
+/* ========================================================================== */
+/* FUNCIONES PUBLICAS                                                        */
+/* ========================================================================== */
+
+/**
+ * @brief Envía una petición y espera la respuesta
+ * @param dest PID del servidor
+ * @param msg Petición (entrada) y respuesta (salida)
+ * @return 0 si se recibió respuesta, -1 si el destino no es válido o
+ *         terminó antes de responder
+ */
+long ipc_call(long dest, struct ipc_msg *msg);
+
+/**
+ * @brief Espera la siguiente petición
+ * @param msg Buffer donde se copia la petición
+ * @return PID del cliente (al que hay que responder)
+ */
+long ipc_recv(struct ipc_msg *msg);
+
+/**
+ * @brief Responde a un cliente sin bloquearse
+ * @param client PID del cliente (devuelto por ipc_recv)
+ * @param msg Respuesta
+ * @return 0 si se entregó, -1 si el cliente no esperaba respuesta nuestra
+ *
+ * @details
+ *   El cliente pasa a READY; el servidor sigue ejecutándose.
+ */
+long ipc_reply(long client, struct ipc_msg *msg);
+
+/**
+ * @brief Responde al cliente actual y espera la siguiente petición
+ * @param client PID del cliente al que se responde
+ * @param reply Respuesta
+ * @param msg Buffer para la siguiente petición (puede ser == reply)
+ * @return PID del siguiente cliente, -1 si 'client' no es válido
+ *
+ * @details
+ *   Si no hay más peticiones encoladas, cambia directamente al cliente
+ *   (hand-off) y el servidor queda bloqueado en recepción.
+ */
+long ipc_reply_recv(long client, struct ipc_msg *reply, struct ipc_msg *msg);
+
+/**
+ * @brief Aborta el IPC pendiente contra un proceso que termina
+ * @param p Proceso que va a terminar (llamado desde exit())
+ *
+ * @details
+ *   Despierta con error (-1) a los clientes encolados en él y a los que
+ *   esperaban su respuesta.
+ */
+void ipc_exit(struct pcb *p);
+
+#endif /* IPC_H */
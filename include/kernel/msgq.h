@@ -0,0 +1,164 @@
+/**
+ * @file msgq.h
+ * @brief Colas de mensajes asíncronas con transferencia de páginas sin copia
+ *
+ * @details
+ *   Cola FIFO de capacidad fija (anillo de slots) entre productores y
+ *   consumidores que NO se esperan mutuamente (a diferencia de ipc.h):
+ *
+ *   MENSAJES PEQUEÑOS (<= MSGQ_INLINE_MAX bytes):
+ *   - Se copian dentro del propio slot del anillo (msgq_send)
+ *
+ *   MENSAJES GRANDES (páginas completas, zero-copy):
+ *   - msgq_send_pages() desmapea las páginas del emisor y guarda en el
+ *     slot solo sus direcciones físicas
+ *   - msgq_recv() las mapea con map_page() en la dirección que indique el
+ *     receptor: el contenido nunca pasa por la CPU
+ *   - La propiedad de las páginas pasa al receptor, que las devuelve con
+ *     msgq_release_pages() al terminar
+ *
+ *   BLOQUEO:
+ *   - Dos semáforos con wait queue: 'space' (slots libres) e 'items'
+ *     (mensajes listos). Emisor bloquea si la cola está llena; receptor
+ *     si está vacía. NO hay busy-wait.
+ *
+ *   USO TÍPICO:
+ *   @code
+ *   struct msgq *q = msgq_create(16);
+ *
+ *   // Etapa A: rellena 2 páginas en BUF_VA y las entrega
+ *   msgq_send_pages(q, BUF_VA, 2, 8000);
+ *
+ *   // Etapa B: las recibe mapeadas en RX_VA
+ *   long len = msgq_recv(q, nullptr, 0, RX_VA);
+ *   procesar((void *)RX_VA, len);
+ *   msgq_release_pages(RX_VA, 2);
+ *   @endcode
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ */
+
+#ifndef MSGQ_H
+#define MSGQ_H
+
+#include "../semaphore.h"
+
+/* ========================================================================== */
+/* CONSTANTES                                                                */
+/* ========================================================================== */
+
+/* Tamaño máximo de un mensaje copiado dentro del slot */
+#define MSGQ_INLINE_MAX 64
+
+/* Máximo de páginas por mensaje zero-copy (sus direcciones caben en el slot) */
+#define MSGQ_MAX_PAGES  (MSGQ_INLINE_MAX / sizeof(unsigned long))
+
+/* ========================================================================== */
+/* ESTRUCTURAS                                                               */
+/* ========================================================================== */
+
+/**
+ * @brief Slot del anillo
+ *
+ * @details
+ *   npages == 0: mensaje inline, 'data' contiene 'len' bytes
+ *   npages  > 0: mensaje por páginas, 'pages' contiene sus direcciones
+ *                físicas y 'len' los bytes válidos desde la primera
+ */
+struct msg_slot {
+    unsigned int len;
+    unsigned int npages;
+    unsigned long flags;         /* Atributos de mapeo de las páginas */
+    union {
+        unsigned char data[MSGQ_INLINE_MAX];
+        unsigned long pages[MSGQ_MAX_PAGES];
+    };
+};
+
+/**
+ * @brief Cola de mensajes
+ */
+struct msgq {
+    struct msg_slot *slots;      /* Anillo de 'size' slots */
+    unsigned int size;
+    unsigned int head;           /* Próximo slot a leer */
+    unsigned int tail;           /* Próximo slot a escribir */
+    struct semaphore items;      /* Mensajes disponibles */
+    struct semaphore space;      /* Slots libres */
+};
+
+/* ========================================================================== */
+/* FUNCIONES PUBLICAS                                                        */
+/* ========================================================================== */
+
+/**
+ * @brief Crea una cola de mensajes
+ * @param size Número de slots (mensajes en vuelo como máximo)
+ * @return Puntero a la cola, o nullptr si no hay memoria
+ */
+struct msgq *msgq_create(unsigned int size);
+
+/**
+ * @brief Destruye una cola (libera las páginas de mensajes no leídos)
+ * @param q Cola
+ *
+ * @details
+ *   No debe haber procesos bloqueados en ella.
+ */
+void msgq_destroy(struct msgq *q);
+
+/**
+ * @brief Envía un mensaje pequeño (copiado en el slot)
+ * @param q Cola
+ * @param buf Datos
+ * @param len Bytes (<= MSGQ_INLINE_MAX)
+ * @return 0 si se envió, -1 si es demasiado grande
+ *
+ * @details
+ *   Bloquea si la cola está llena.
+ */
+int msgq_send(struct msgq *q, const void *buf, unsigned int len);
+
+/**
+ * @brief Envía páginas completas sin copiarlas
+ * @param q Cola
+ * @param va Dirección virtual del buffer (alineada a 4KB)
+ * @param npages Número de páginas (1..MSGQ_MAX_PAGES)
+ * @param len Bytes válidos del mensaje (<= npages * PAGE_SIZE)
+ * @return 0 si se envió, -1 si los argumentos o las páginas no son válidos
+ *
+ * @details
+ *   Las páginas deben estar mapeadas en [DEMAND_VA_BASE, USER_VA_END)
+ *   y tener todas los mismos permisos. Tras el envío, 'va' queda desmapeada en el emisor (un
+ *   nuevo acceso provoca un Page Fault y obtiene una página nueva).
+ *   Bloquea si la cola está llena.
+ */
+int msgq_send_pages(struct msgq *q, unsigned long va, unsigned int npages, unsigned int len);
+
+/**
+ * @brief Recibe el siguiente mensaje
+ * @param q Cola
+ * @param buf Buffer para mensajes inline (o para copiar páginas si map_va == 0)
+ * @param buflen Tamaño de 'buf'
+ * @param map_va Dirección (alineada a 4KB) donde mapear un mensaje por
+ *               páginas, o 0 para copiarlo a 'buf' y liberar las páginas
+ * @return Longitud del mensaje (puede ser > buflen si se truncó la copia)
+ *
+ * @details
+ *   Bloquea si la cola está vacía. Si el mensaje llega mapeado en
+ *   map_va, el receptor es dueño de las páginas y debe liberarlas con
+ *   msgq_release_pages(). La ventana debe estar en [DEMAND_VA_BASE,
+ *   USER_VA_END) y sin mapear; si no, el mensaje se copia a 'buf'
+ *   como con map_va == 0.
+ */
+long msgq_recv(struct msgq *q, void *buf, unsigned int buflen, unsigned long map_va);
+
+/**
+ * @brief Desmapea y libera páginas recibidas con msgq_recv()
+ * @param va Dirección donde se mapearon
+ * @param npages Número de páginas
+ */
+void msgq_release_pages(unsigned long va, unsigned int npages);
+
+#endif /* MSGQ_H */
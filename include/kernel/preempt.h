@@ -0,0 +1,51 @@
+/**
+ * @file preempt.h
+ * @brief Secciones sin expropiación (preempt_disable / preempt_enable)
+ *
+ * @details
+ *   Mientras current_process->prempt_count > 0 el IRQ del timer no
+ *   cambia de proceso (is_reschedule_pending() devuelve 0). Las IRQs
+ *   siguen habilitadas: solo se aplaza el cambio de contexto. Al salir
+ *   de la sección más externa se atiende el need_reschedule pendiente.
+ *
+ *   Entrar y salir es un incremento/decremento del PCB propio: sin
+ *   instrucciones atómicas ni barreras de hardware.
+ *
+ *   Dentro de la sección NO se puede bloquear (sleep, sem_wait,
+ *   mutex_lock, kprintf...).
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ */
+
+#ifndef PREEMPT_H
+#define PREEMPT_H
+
+#include "process.h"
+#include "scheduler.h"
+#include "../barrier.h"
+
+/**
+ * @brief Impide que el timer expropie al proceso actual (anidable)
+ */
+static inline void preempt_disable(void) {
+    struct pcb *p = current_process;
+    if (p != nullptr) {
+        p->prempt_count++;
+    }
+    barrier();
+}
+
+/**
+ * @brief Cierra una sección preempt_disable(); en la más externa, cede
+ *        la CPU si el timer lo pidió mientras tanto
+ */
+static inline void preempt_enable(void) {
+    barrier();
+    struct pcb *p = current_process;
+    if (p != nullptr && --p->prempt_count == 0 && need_reschedule) {
+        preempt_schedule();
+    }
+}
+
+#endif /* PREEMPT_H */
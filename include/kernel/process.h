@@ -14,13 +14,43 @@
 #define PROCESS_H
 
 #include "../sched.h"
+#include "../seqlock.h"
+#include "sys.h"
 
 /* Variables globales de procesos */
 extern struct pcb process[MAX_PROCESS];
 extern struct pcb *current_process;
 extern int num_process;
+
+/* Seqlock de ocupación/liberación de slots de process[] */
+extern struct seqlock process_table_lock;
+
+/**
+ * @brief Foto de un PCB para listados (comando 'ps')
+ */
+struct proc_info {
+    long pid;
+    long state;
+    int priority;
+    int block_reason;
+    unsigned long cpu_time;
+    char name[16];
+};
 // extern uint8_t process_stack[MAX_PROCESS][4096];
 
+/**
+ * @brief Reserva un PCB y un stack de 4KB sin configurar el contexto
+ * @param priority Prioridad inicial del proceso
+ * @param name Nombre descriptivo del proceso (máx 15 chars)
+ * @return PID reservado, -1 en caso de error
+ * 
+ * @details
+ *   Base común de create_process() y process_restore(). El PCB queda en
+ *   PROCESS_BLOCKED hasta que el llamador rellene 'context' y lo pase a
+ *   PROCESS_READY.
+ */
+long process_alloc(int priority, const char *name);
+
 /**
  * @brief Crea un nuevo thread del kernel
  * @param fn Función a ejecutar
@@ -43,8 +73,9 @@ long create_process(void (*fn)(void*), void *arg, int priority, const char *name
  * @return PID del proceso creado, -1 en caso de error
  * 
  * @details
- *   En BareMetalM4 (v0.6), como no hay separación de memoria virtual por proceso,
- *   todos los procesos son técnicamente hilos del kernel que comparten espacio de direcciones.
+ *   Todos los procesos comparten el kernel (código, heap, mapa lineal),
+ *   pero cada uno tiene su propio espacio de usuario a partir de
+ *   DEMAND_VA_BASE (tabla base en TTBR0 etiquetada con su ASID).
  *   
  *   Wrapper sobre create_process() que pasa NULL como argumento.
  */
@@ -80,11 +111,34 @@ void schedule_tail(void);
  * @brief Libera recursos de procesos ZOMBIE (reaper)
  * 
  * @details
- *   Recorre process[] y libera stacks de procesos ZOMBIE,
- *   marcándolos como UNUSED para reutilización.
+ *   Recorre process[] y pasa los ZOMBIE a DEAD. Tras un periodo de
+ *   gracia RCU se libera su stack y el slot queda UNUSED.
  */
 void free_zombie();
 
+/**
+ * @brief Copia coherente de un slot de process[] sin tomar locks
+ * @param slot Índice en process[]
+ * @param info Destino de la copia
+ * @return 1 si el slot está en uso, 0 si está libre (o fuera de rango)
+ *
+ * @details
+ *   Lector del seqlock process_table_lock: nunca retrasa a
+ *   process_alloc() ni a free_zombie().
+ */
+int process_get_info(int slot, struct proc_info *info);
+
+/**
+ * @brief Busca un proceso vivo por PID (lectura RCU, sin locks)
+ * @param pid PID buscado
+ * @return PCB, o nullptr si no existe o ha terminado
+ *
+ * @details
+ *   Llamar dentro de rcu_read_lock()/rcu_read_unlock() (o con IRQs
+ *   deshabilitadas): mientras tanto el slot no se reutiliza.
+ */
+struct pcb *process_find(long pid);
+
 /**
  * @brief Crea un proceso de usuario (EL0)
  * @param user_fn Función que se ejecutará en modo usuario
@@ -103,4 +157,40 @@ void free_zombie();
  */
 long create_user_process(void (*user_fn)(void), const char *name);
 
+/**
+ * @brief Clona el proceso actual (handler de SYS_FORK)
+ * @param regs Frame de la SVC del proceso actual
+ * @return PID del hijo al padre, -1 si no hay memoria o PCBs
+ * 
+ * @details
+ *   El hijo recibe:
+ *   - Copia del stack de kernel: vuelve de la misma SVC con x0 = 0
+ *     (si la llamada vino de EL1, los punteros a su stack se reubican
+ *     como en process_restore())
+ *   - Su propia tabla base con el espacio de usuario compartido en
+ *     copy-on-write (vmm_fork_user_space()): cuesta copiar tablas, no
+ *     páginas; cada escritura posterior copia solo la página tocada
+ *   - La misma prioridad, nombre y páginas de demand paging
+ */
+long process_fork(struct pt_regs *regs);
+
+/* ========================================================================== */
+/* LADO USUARIO                                                              */
+/* ========================================================================== */
+
+/**
+ * @brief Invoca SYS_FORK mediante SVC (desde EL0 o desde un thread)
+ * @return PID del hijo en el padre, 0 en el hijo, -1 si falla
+ */
+static inline long fork(void) {
+    register long x0 asm("x0");
+    register long x8 asm("x8") = SYS_FORK;
+
+    asm volatile("svc #0"
+                 : "=r"(x0)
+                 : "r"(x8)
+                 : "memory");
+    return x0;
+}
+
 #endif /* PROCESS_H */
@@ -0,0 +1,117 @@
+/**
+ * @file rcu.h
+ * @brief RCU (Read-Copy-Update) mínimo para un solo core
+ *
+ * @details
+ *   Lectores sin locks ni escrituras atómicas; los escritores publican
+ *   una versión nueva y liberan la vieja cuando ningún lector puede
+ *   seguir usándola:
+ *
+ *   @code
+ *   // Lector
+ *   rcu_read_lock();
+ *   struct obj *o = rcu_dereference(global_ptr);
+ *   // ... usar o (sin bloquearse) ...
+ *   rcu_read_unlock();
+ *
+ *   // Escritor (serializado con su propio lock)
+ *   rcu_assign_pointer(global_ptr, nuevo);
+ *   call_rcu(&viejo->rcu, liberar_obj);   // o synchronize_rcu(); kfree(viejo);
+ *   @endcode
+ *
+ *   PERIODOS DE GRACIA:
+ *   - rcu_read_lock() solo deshabilita la expropiación (preempt.h): un
+ *     lector no puede perder la CPU a mitad de su sección
+ *   - Por tanto cada paso por schedule() es un estado quiescente: todo
+ *     lector que empezó antes ya ha terminado.
+ *     rcu_note_context_switch() lo registra
+ *   - Con un solo core, un estado quiescente posterior a call_rcu()
+ *     basta para completar el periodo de gracia
+ *
+ *   CALLBACKS:
+ *   - call_rcu() los encola; en el siguiente cambio de contexto pasan a
+ *     "listos" y se ejecutan en un kworker (contexto de proceso: pueden
+ *     usar kfree(), que no es seguro desde IRQ)
+ *
+ *   REGLAS:
+ *   - No bloquearse dentro de rcu_read_lock()/rcu_read_unlock()
+ *   - synchronize_rcu() solo desde contexto de proceso y fuera de una
+ *     sección de lectura
+ *   - Con las IRQs deshabilitadas tampoco hay cambio de contexto: una
+ *     sección con IRQs deshabilitadas es también una sección de lectura
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ */
+
+#ifndef RCU_H
+#define RCU_H
+
+#include "preempt.h"
+
+/* ========================================================================== */
+/* LECTORES                                                                  */
+/* ========================================================================== */
+
+static inline void rcu_read_lock(void) {
+    preempt_disable();
+}
+
+static inline void rcu_read_unlock(void) {
+    preempt_enable();
+}
+
+/* Lectura de un puntero publicado con rcu_assign_pointer(). En AArch64 la
+   dependencia de dirección ya ordena los accesos a través del puntero. */
+#define rcu_dereference(p) READ_ONCE(p)
+
+/* Publica 'v' en 'p' después de que su contenido sea visible */
+#define rcu_assign_pointer(p, v) \
+    do { smp_wmb(); WRITE_ONCE(p, v); } while (0)
+
+/* ========================================================================== */
+/* ESCRITORES                                                                */
+/* ========================================================================== */
+
+/**
+ * @brief Inicializa el subsistema RCU (work de callbacks)
+ */
+void rcu_init(void);
+
+/**
+ * @brief Espera a que termine un periodo de gracia
+ *
+ * @details
+ *   Cede la CPU hasta que schedule() registre un estado quiescente.
+ *   Al volver, ningún lector que empezara antes de la llamada sigue
+ *   dentro de su sección.
+ */
+void synchronize_rcu(void);
+
+/**
+ * @brief Ejecuta func(head) tras un periodo de gracia (sin esperar)
+ * @param head Enlace embebido en el objeto a liberar
+ * @param func Callback (contexto de proceso, en un kworker)
+ *
+ * @details Seguro desde cualquier contexto.
+ */
+void call_rcu(struct rcu_head *head, void (*func)(struct rcu_head *head));
+
+/**
+ * @brief Registra un estado quiescente (lo llama schedule())
+ *
+ * @details Se llama con IRQs deshabilitadas.
+ */
+void rcu_note_context_switch(void);
+
+/**
+ * @brief Estados quiescentes registrados desde el arranque
+ */
+unsigned long rcu_gp_count(void);
+
+/**
+ * @brief Callbacks de call_rcu() ejecutados desde el arranque
+ */
+unsigned long rcu_callbacks_done(void);
+
+#endif /* RCU_H */
@@ -27,6 +27,36 @@
 /* Contador global de ticks del sistema */
 extern volatile unsigned long sys_timer_count;
 
+/**
+ * @brief Lee de forma coherente el tick actual y el CNTPCT de ese tick
+ * @param stamp Si no es nullptr, recibe el CNTPCT del último tick
+ * @return Valor de sys_timer_count emparejado con *stamp
+ *
+ * @details
+ *   Lectura sin lock (seqcount): para un solo valor basta con leer
+ *   sys_timer_count; esta función es para quien necesita la pareja
+ *   (p.ej. timer_uptime_us()).
+ */
+unsigned long sys_time_read(unsigned long *stamp);
+
+/* Bandera de cambio de contexto pendiente (se atiende a la salida del IRQ) */
+extern volatile int need_reschedule;
+
+/**
+ * @brief Verifica si hay un cambio de contexto pendiente
+ * @return 1 si need_reschedule está activo y no se están ejecutando softirqs
+ *
+ * @details Lo consulta irq_handler_stub (src/entry.S) antes de schedule().
+ */
+int is_reschedule_pending(void);
+
+/**
+ * @brief Atiende need_reschedule al salir de una sección sin expropiación
+ *
+ * @details Lo llama preempt_enable() (kernel/preempt.h).
+ */
+void preempt_schedule(void);
+
 /**
  * @brief Planificador de procesos (Scheduler)
  * 
@@ -53,12 +83,27 @@ void schedule(void);
  *   1. Incrementa sys_timer_count (reloj global)
  *   2. Decrementa quantum del proceso actual
  *   3. Marca need_reschedule cuando quantum=0 (expropriación)
- *   4. Despierta procesos con wake_up_time <= sys_timer_count
+ *   4. Marca SOFTIRQ_TIMER si hay un evento temporal vencido
  *   
  *   Implementa Round-Robin con Quantum (preemptive multitasking).
  */
 void timer_tick(void);
 
+/**
+ * @brief Handler de SOFTIRQ_TIMER
+ * 
+ * @details
+ *   Despierta procesos con wake_up_time <= sys_timer_count y expira
+ *   el delayed work vencido. Se ejecuta fuera del hard-IRQ.
+ */
+void timer_softirq(void);
+
+/**
+ * @brief Registra un evento temporal en el tick absoluto 'when'
+ * @param when Tick en el que timer_softirq() debe ejecutarse
+ */
+void timer_schedule_event(unsigned long when);
+
 /**
  * @brief Duerme el proceso actual durante un número de ticks
  * @param ticks Número de ticks del timer a dormir
@@ -67,7 +112,7 @@ void timer_tick(void);
  *   Implementa sleep eficiente:
  *   - Marca proceso como BLOCKED (block_reason = SLEEP)
  *   - NO consume CPU mientras duerme (NO busy-wait)
- *   - timer_tick() lo despertará automáticamente
+ *   - timer_softirq() lo despertará automáticamente
  */
 void sleep(unsigned int ticks);
 
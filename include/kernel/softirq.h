@@ -0,0 +1,75 @@
+/**
+ * @file softirq.h
+ * @brief Softirqs: trabajo diferido que se ejecuta a la salida de un IRQ
+ *
+ * @details
+ *   Divide el manejo de interrupciones en dos mitades:
+ *   - Mitad "hard": el handler del IRQ (handle_timer_irq, uart_handle_irq)
+ *     hace lo mínimo (EOI, leer el dispositivo) y marca una softirq.
+ *   - Mitad "soft": do_softirq() se ejecuta en irq_handler_stub, justo antes
+ *     de kernel_exit, con las IRQs HABILITADAS. Aquí va el trabajo caro
+ *     (recorrer process[], expirar delayed work, etc.).
+ *
+ *   REGLAS:
+ *   - Una softirq NUNCA duerme (no sem_wait, no sleep, no kprintf)
+ *   - Las softirqs no se anidan: si llega un IRQ mientras se ejecutan,
+ *     su do_softirq() retorna inmediatamente
+ *   - Para trabajo que necesita dormir, usar workqueues (workqueue.h)
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ */
+
+#ifndef SOFTIRQ_H
+#define SOFTIRQ_H
+
+/* ========================================================================== */
+/* NUMEROS DE SOFTIRQ (menor número = se ejecuta antes)                      */
+/* ========================================================================== */
+
+#define SOFTIRQ_TIMER     0  /* Despertar procesos dormidos + delayed work */
+#define SOFTIRQ_TEST      3  /* Sondas de las pruebas (utils/tests.c) */
+#define NR_SOFTIRQS       4
+
+/* Máximo de pasadas por salida de IRQ (evita que las softirqs monopolicen
+   la CPU si se re-disparan continuamente). Lo pendiente queda para el
+   siguiente IRQ. */
+#define MAX_SOFTIRQ_RESTART 4
+
+/* ========================================================================== */
+/* FUNCIONES PUBLICAS                                                        */
+/* ========================================================================== */
+
+/**
+ * @brief Registra el handler de una softirq
+ * @param nr Número de softirq (SOFTIRQ_*)
+ * @param handler Función a ejecutar cuando la softirq esté pendiente
+ */
+void open_softirq(int nr, void (*handler)(void));
+
+/**
+ * @brief Marca una softirq como pendiente
+ * @param nr Número de softirq
+ *
+ * @details
+ *   Seguro desde cualquier contexto (IRQ o proceso). Se ejecutará en la
+ *   próxima salida de IRQ.
+ */
+void raise_softirq(int nr);
+
+/**
+ * @brief Ejecuta las softirqs pendientes (llamado desde irq_handler_stub)
+ *
+ * @details
+ *   Se invoca con IRQs deshabilitadas. Habilita IRQs mientras ejecuta
+ *   los handlers y las vuelve a deshabilitar antes de retornar.
+ */
+void do_softirq(void);
+
+/**
+ * @brief Indica si la CPU está ejecutando softirqs
+ * @return 1 si estamos dentro de do_softirq(), 0 en caso contrario
+ */
+int in_softirq(void);
+
+#endif /* SOFTIRQ_H */
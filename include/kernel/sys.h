@@ -9,7 +9,7 @@
  *   - Interfaz del dispatcher de syscalls
  * 
  * @author Sistema Operativo Educativo BareMetalM4
- * @version 0.6
+ * @version 0.7
  */
 
 #ifndef SYS_H
@@ -23,6 +23,8 @@
 #define SYS_EXIT  1  /* Terminación de proceso */
 #define SYS_OPEN  2
 #define SYS_READ  3
+#define SYS_FUTEX 4  /* FUTEX_WAIT / FUTEX_WAKE (ver kernel/futex.h) */
+#define SYS_FORK  5  /* Clona el proceso actual (ver process_fork) */
 
 /* ========================================================================== */
 /* ESTRUCTURA DE REGISTROS GUARDADOS                                         */
@@ -70,6 +72,7 @@ struct pt_regs {
     unsigned long x30;      /* Link Register (LR) */
     unsigned long pstate;   /* SPSR_EL1 (Estado del procesador) */
     unsigned long pc;       /* ELR_EL1 (Program Counter / Dónde ocurrió la excepción) */
+    unsigned long sp;       /* SP_EL0 (stack de usuario) */
 };
 
 /* ========================================================================== */
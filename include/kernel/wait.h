@@ -0,0 +1,155 @@
+/**
+ * @file wait.h
+ * @brief Wait queues genéricas: esperar una condición con o sin timeout
+ *
+ * @details
+ *   Un proceso espera en una wait queue hasta que otro (proceso o IRQ)
+ *   haga cierta una condición y llame a wake_up():
+ *
+ *   @code
+ *   // Consumidor
+ *   wait_event(rx_wait, ring_count(&rx) > 0);
+ *
+ *   // Productor (p.ej. el IRQ de la UART)
+ *   ring_enqueue(&rx, c);
+ *   wake_up(&rx_wait);
+ *   @endcode
+ *
+ *   SIN DESPERTARES PERDIDOS:
+ *   La condición se evalúa con las IRQs deshabilitadas y siguen así
+ *   hasta el cambio de contexto. En un solo core, ni un IRQ ni otro
+ *   proceso pueden hacer cierta la condición entre la comprobación y el
+ *   bloqueo. Por eso la condición debe ser una lectura simple: nada que
+ *   duerma ni imprima.
+ *
+ *   TIMEOUTS:
+ *   - wait_event_timeout() guarda el tick límite en wake_up_time y lo
+ *     registra con timer_schedule_event()
+ *   - Si vence antes del wake_up(), timer_softirq() lo saca de la cola
+ *     (wait_queue_timeout()) y lo pasa a READY
+ *   - Devuelve 0 si venció con la condición falsa; si no, los ticks que
+ *     quedaban (al menos 1)
+ *
+ *   DESPERTAR INMEDIATO:
+ *   wake_up() marca need_reschedule: si se llama desde un IRQ, el
+ *   despertado puede ejecutarse a la salida de ese mismo IRQ en lugar de
+ *   esperar al siguiente tick.
+ *
+ *   Sobre estas colas se construyen las completions y las variables de
+ *   condición (completion.h).
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ */
+
+#ifndef WAIT_H
+#define WAIT_H
+
+#include "../sched.h"
+#include "../spinlock.h"
+
+/* Espera sin límite de tiempo */
+#define WAIT_FOREVER 0x7FFFFFFFFFFFFFFFL
+
+/* ========================================================================== */
+/* ESTRUCTURAS                                                               */
+/* ========================================================================== */
+
+/**
+ * @brief Cola de procesos esperando un evento
+ *
+ * @details
+ *   FIFO enlazada por el campo 'next' del PCB (un proceso espera en una
+ *   sola cola a la vez); el PCB apunta a la cola en 'wait_queue'.
+ */
+struct wait_queue_head {
+    volatile int lock;   /* Spinlock (spin_lock_irqsave) */
+    struct pcb *head;
+    struct pcb *tail;
+};
+
+#define WAIT_QUEUE_HEAD_INIT { 0, nullptr, nullptr }
+
+/* ========================================================================== */
+/* FUNCIONES PUBLICAS                                                        */
+/* ========================================================================== */
+
+/**
+ * @brief Inicializa una wait queue vacía
+ */
+void init_waitqueue_head(struct wait_queue_head *wq);
+
+/**
+ * @brief Bloquea el proceso actual en la cola (base de los wait_event)
+ * @param wq Cola
+ * @param timeout Ticks máximos de espera, o WAIT_FOREVER
+ * @return Ticks que quedaban al despertar (0 si venció el timeout;
+ *         WAIT_FOREVER si no había límite)
+ *
+ * @details
+ *   Se llama con las IRQs deshabilitadas y vuelve con ellas igual.
+ *   Puede volver sin que la condición del llamador sea cierta: hay que
+ *   volver a comprobarla.
+ */
+long wait_queue_block(struct wait_queue_head *wq, long timeout);
+
+/**
+ * @brief Despierta a todos los procesos de la cola
+ * @return Número de procesos despertados
+ *
+ * @details Seguro desde IRQ y con IRQs deshabilitadas.
+ */
+int wake_up(struct wait_queue_head *wq);
+
+/**
+ * @brief Despierta al primer proceso de la cola (FIFO)
+ * @return 1 si había alguien esperando, 0 si no
+ */
+int wake_up_one(struct wait_queue_head *wq);
+
+/**
+ * @brief Indica si hay procesos esperando
+ */
+int waitqueue_active(struct wait_queue_head *wq);
+
+/**
+ * @brief Timeout vencido: saca al proceso de su cola y lo despierta
+ *
+ * @details Lo llama timer_softirq() con IRQs deshabilitadas.
+ */
+void wait_queue_timeout(struct pcb *p);
+
+/* ========================================================================== */
+/* MACROS DE ESPERA                                                          */
+/* ========================================================================== */
+
+/**
+ * @brief Duerme hasta que 'condition' sea cierta
+ */
+#define wait_event(wq, condition)                               \
+    do {                                                        \
+        unsigned long __we_flags = local_irq_save();            \
+        while (!(condition)) {                                  \
+            wait_queue_block(&(wq), WAIT_FOREVER);              \
+        }                                                       \
+        local_irq_restore(__we_flags);                          \
+    } while (0)
+
+/**
+ * @brief Duerme hasta que 'condition' sea cierta o pasen 'timeout' ticks
+ * @return 0 si venció el timeout con la condición falsa; si no, los
+ *         ticks restantes (al menos 1)
+ */
+#define wait_event_timeout(wq, condition, timeout)              \
+    ({                                                          \
+        long __we_ret = (long)(timeout);                        \
+        int __we_ok;                                            \
+        unsigned long __we_flags = local_irq_save();            \
+        while (!(__we_ok = !!(condition)) && __we_ret > 0) {    \
+            __we_ret = wait_queue_block(&(wq), __we_ret);       \
+        }                                                       \
+        local_irq_restore(__we_flags);                          \
+        __we_ok ? (__we_ret > 0 ? __we_ret : 1) : 0;            \
+    })
+
+#endif /* WAIT_H */
@@ -0,0 +1,143 @@
+/**
+ * @file workqueue.h
+ * @brief Workqueues: trabajo diferido ejecutado por hilos del kernel
+ *
+ * @details
+ *   Permite sacar trabajo del contexto de interrupción (o de cualquier
+ *   camino crítico) y ejecutarlo más tarde en un hilo del kernel, donde
+ *   SÍ se puede dormir, usar semáforos o imprimir.
+ *
+ *   COLAS POR PRIORIDAD:
+ *   - WQ_HIGH:   kworker/H (latencia mínima, p.ej. completar I/O)
+ *   - WQ_NORMAL: kworker/N (uso general, schedule_work())
+ *   - WQ_LOW:    kworker/L (mantenimiento en segundo plano)
+ *
+ *   USO TÍPICO:
+ *   @code
+ *   static struct work_struct rx_work;
+ *
+ *   void rx_done(struct work_struct *w) { ...procesar... }
+ *
+ *   init_work(&rx_work, rx_done);   // Una vez
+ *   queue_work(WQ_HIGH, &rx_work);  // Desde el IRQ handler
+ *   @endcode
+ *
+ *   Un work ya encolado no se vuelve a encolar (queue_work devuelve 0):
+ *   varias peticiones se agrupan en una sola ejecución (batching).
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ */
+
+#ifndef WORKQUEUE_H
+#define WORKQUEUE_H
+
+#include "../types.h"
+
+/* ========================================================================== */
+/* PRIORIDADES DE WORKQUEUE                                                  */
+/* ========================================================================== */
+
+#define WQ_HIGH     0
+#define WQ_NORMAL   1
+#define WQ_LOW      2
+#define NR_WORKQUEUES 3
+
+/* ========================================================================== */
+/* ESTRUCTURAS                                                               */
+/* ========================================================================== */
+
+/**
+ * @brief Unidad de trabajo diferido
+ *
+ * @details
+ *   func: Función que ejecutará el worker (recibe el propio work;
+ *         usar container_of() para llegar al objeto que lo contiene)
+ *   next: Enlace en la cola del worker (lista FIFO)
+ *   pending: 1 mientras está encolado y aún no se ha ejecutado
+ */
+struct work_struct {
+    void (*func)(struct work_struct *work);
+    struct work_struct *next;
+    volatile int pending;
+};
+
+/**
+ * @brief Trabajo diferido con retardo (en ticks del timer)
+ *
+ * @details
+ *   Se mantiene en una lista de espera hasta que sys_timer_count alcanza
+ *   'expires'; entonces timer_softirq() lo pasa a la cola 'wq'.
+ */
+struct delayed_work {
+    struct work_struct work;
+    unsigned long expires;       /* Tick absoluto de expiración */
+    int wq;                      /* Cola destino (WQ_HIGH/NORMAL/LOW) */
+    struct delayed_work *next;   /* Enlace en la lista de espera */
+};
+
+/* ========================================================================== */
+/* FUNCIONES PUBLICAS                                                        */
+/* ========================================================================== */
+
+/**
+ * @brief Inicializa un work
+ * @param work Work a inicializar
+ * @param func Función a ejecutar
+ */
+void init_work(struct work_struct *work, void (*func)(struct work_struct *));
+
+/**
+ * @brief Inicializa un delayed work
+ * @param dwork Delayed work a inicializar
+ * @param func Función a ejecutar
+ */
+void init_delayed_work(struct delayed_work *dwork, void (*func)(struct work_struct *));
+
+/**
+ * @brief Encola un work en la workqueue indicada
+ * @param wq Cola destino (WQ_HIGH, WQ_NORMAL, WQ_LOW)
+ * @param work Work a encolar
+ * @return 1 si se encoló, 0 si ya estaba pendiente (o wq inválida)
+ *
+ * @details
+ *   Seguro desde contexto de IRQ/softirq. Despierta al worker de la cola.
+ */
+int queue_work(int wq, struct work_struct *work);
+
+/**
+ * @brief Encola un work en la cola normal (WQ_NORMAL)
+ */
+int schedule_work(struct work_struct *work);
+
+/**
+ * @brief Encola un work tras 'delay' ticks
+ * @param wq Cola destino
+ * @param dwork Delayed work
+ * @param delay Ticks de retardo (0 = encolar inmediatamente)
+ * @return 1 si se programó, 0 si ya estaba pendiente
+ */
+int queue_delayed_work(int wq, struct delayed_work *dwork, unsigned long delay);
+
+/**
+ * @brief Cancela un delayed work que aún no ha expirado
+ * @param dwork Delayed work
+ * @return 1 si se canceló, 0 si no estaba en espera
+ */
+int cancel_delayed_work(struct delayed_work *dwork);
+
+/**
+ * @brief Expira el delayed work vencido (llamado desde timer_softirq)
+ * @param now Tick actual
+ */
+void delayed_work_tick(unsigned long now);
+
+/**
+ * @brief Crea los hilos worker (kworker/H, kworker/N, kworker/L)
+ *
+ * @details
+ *   Debe llamarse después de init_process_system().
+ */
+void init_workqueues(void);
+
+#endif /* WORKQUEUE_H */
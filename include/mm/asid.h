@@ -0,0 +1,87 @@
+/**
+ * @file asid.h
+ * @brief Identificadores de espacio de direcciones (ASID) por generaciones
+ *
+ * @details
+ *   Cada proceso tiene su propia tabla base en TTBR0_EL1. Para no
+ *   invalidar la TLB en cada cambio de contexto, las traducciones del
+ *   espacio de usuario (MM_NG) se guardan en la TLB etiquetadas con el
+ *   ASID que va en TTBR0_EL1[63:48]; las del kernel son globales y
+ *   sirven a todos los procesos.
+ *
+ *   ASIGNACIÓN POR GENERACIONES:
+ *   @code
+ *   pcb->asid = generación | número     (número en los asid_bits bajos)
+ *   @endcode
+ *   - switch_mm(next) reutiliza el ASID de 'next' si es de la generación
+ *     vigente; si no, le da el siguiente número libre
+ *   - Agotados los números (255 o 65535) empieza otra generación: se
+ *     invalida la TLB entera una sola vez y cada proceso toma un número
+ *     nuevo la próxima vez que se planifique
+ *   - El ASID 0 es de kernel_pgd (PID 0) y no se reparte
+ *
+ *   Un proceso que termina no devuelve su número: no se reutiliza hasta
+ *   la siguiente generación, así que sus entradas de la TLB nunca pueden
+ *   confundirse con las de otro proceso.
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ */
+
+#ifndef ASID_H
+#define ASID_H
+
+#include "../sched.h"
+
+/* Campo ASIDBits de ID_AA64MMFR0_EL1 */
+#define ID_AA64MMFR0_ASID_SHIFT 4
+#define ID_AA64MMFR0_ASID_16    2
+
+/* Posición del ASID en TTBR0_EL1 */
+#define TTBR_ASID_SHIFT 48
+
+/* Primer número que se reparte (0 = kernel_pgd) */
+#define ASID_FIRST 1
+
+/**
+ * @brief Estado del asignador (comando 'test asid')
+ */
+struct asid_stats {
+    unsigned int bits;          /* 8 o 16 */
+    unsigned long generation;   /* Generación vigente (1, 2, ...) */
+    unsigned long allocs;       /* ASIDs repartidos desde el arranque */
+    unsigned long rollovers;    /* Cambios de generación (TLB invalidada) */
+};
+
+/**
+ * @brief Detecta el ancho de ASID de la CPU
+ * @return 8 o 16. Con 16 hay que activar TCR_EL1.AS
+ */
+unsigned int asid_init(void);
+
+/**
+ * @brief Prepara el TTBR0 de 'next' antes de cpu_switch_to()
+ *
+ * @details
+ *   Le asigna un ASID si no tiene uno de la generación vigente y deja
+ *   en next->context.ttbr0 la tabla base con el ASID. cpu_switch_to()
+ *   solo escribe TTBR0_EL1: no invalida la TLB.
+ */
+void switch_mm(struct pcb *next);
+
+/**
+ * @brief Invalida en la TLB todo el espacio de usuario de 'p'
+ *
+ * @details
+ *   Solo las entradas de su ASID (TLBI ASIDE1IS); las del kernel y las
+ *   de los demás procesos siguen en la TLB. Si 'p' no tiene un ASID de
+ *   la generación vigente no hay nada suyo en la TLB.
+ */
+void flush_tlb_mm(struct pcb *p);
+
+/**
+ * @brief Copia el estado del asignador
+ */
+void asid_get_stats(struct asid_stats *out);
+
+#endif /* ASID_H */
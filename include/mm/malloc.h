@@ -5,11 +5,13 @@
  * @details
  *   Define funciones para la gestión dinámica de memoria:
  *   - Inicialización del heap
- *   - Asignación de memoria (kmalloc)
+ *   - Asignación de memoria (kmalloc, kzalloc)
  *   - Liberación de memoria (kfree)
+ *   - Estadísticas y rastreo por sitio de llamada (meminfo)
+ *   Seguras con expropiación y desde IRQ.
  * 
  * @author Sistema Operativo Educativo BareMetalM4
- * @version 0.6
+ * @version 0.7
  */
 
 #ifndef MALLOC_H
@@ -17,6 +19,40 @@
 
 #include "../types.h"
 
+/* Desde este tamaño kmalloc() pide páginas al buddy en lugar de al heap */
+#define KMALLOC_LARGE (16 * 4096)
+
+/* Entradas de la tabla de sitios de llamada y cuántas muestra meminfo */
+#define MEMTRACE_SITES 128
+#define MEMTRACE_TOP   16
+
+/**
+ * @brief Contadores del heap (bytes incluyen la cabecera de cada bloque)
+ */
+struct kheap_stats {
+    unsigned long total_bytes;
+    unsigned long in_use_bytes;     /* Entregados por kmalloc() */
+    unsigned long peak_bytes;       /* Máximo de in_use_bytes */
+    unsigned long cached_bytes;     /* Libres pero retenidos en magazines */
+    unsigned long large_bytes;      /* Peticiones grandes servidas por el buddy */
+    unsigned long free_bytes;
+    unsigned long free_blocks;
+    unsigned long largest_free;     /* Mayor bloque libre */
+    unsigned long allocs;
+    unsigned long frees;
+};
+
+/**
+ * @brief Asignaciones de un sitio de llamada (dirección de retorno)
+ */
+struct alloc_site {
+    unsigned long site;
+    unsigned long allocs;
+    unsigned long frees;
+    unsigned long live_bytes;       /* Asignados y aún sin liberar */
+    unsigned long total_bytes;      /* Acumulado */
+};
+
 /**
  * @brief Inicializa el heap del kernel
  * @param start_addr Dirección inicial del heap
@@ -25,16 +61,64 @@
 void kheap_init(unsigned long start_addr, unsigned long end_addr);
 
 /**
- * @brief Reserva memoria (first-fit)
+ * @brief Reserva memoria (segregated fit, O(1))
  * @param size Tamaño en bytes
- * @return Puntero asignado o nullptr si falla
+ * @return Puntero asignado (alineado a 16, SIN inicializar) o nullptr
  */
 void *kmalloc(uint32_t size);
 
+/**
+ * @brief Reserva memoria puesta a cero
+ * @param size Tamaño en bytes
+ * @return Puntero asignado o nullptr si falla
+ */
+void *kzalloc(uint32_t size);
+
 /**
  * @brief Libera un bloque previamente asignado
- * @param ptr Puntero devuelto por kmalloc
+ * @param ptr Puntero devuelto por kmalloc/kzalloc (nullptr se ignora)
+ * 
+ * @details Fusiona el bloque con sus vecinos libres en O(1).
  */
 void kfree(void *ptr);
 
-#endif // MALLOC_H
\ No newline at end of file
+/**
+ * @brief Devuelve al heap los bloques retenidos en magazines
+ * @return Número de bloques devueltos
+ * 
+ * @details kmalloc() la usa antes de rendirse por falta de memoria.
+ */
+int kheap_drain(void);
+
+/**
+ * @brief Comprueba la consistencia del heap (tests y depuración)
+ * @return Número de inconsistencias (0 = correcto)
+ */
+int kheap_check(void);
+
+/**
+ * @brief Copia los contadores del heap en 'st'
+ */
+void kheap_get_stats(struct kheap_stats *st);
+
+/**
+ * @brief Activa (1) o desactiva (0) el rastreo por sitio de llamada
+ * @return Estado anterior
+ * 
+ * @details Las peticiones grandes (buddy) no se rastrean por sitio.
+ */
+int kheap_trace(int enable);
+
+/**
+ * @brief Sitios de llamada con más bytes vivos, ordenados
+ * @param out Destino (al menos 'max' entradas)
+ * @return Número de entradas copiadas
+ */
+int kheap_trace_top(struct alloc_site *out, int max);
+
+/**
+ * @brief Muestra los contadores del heap, del PMM y los sitios rastreados
+ */
+void meminfo_print(void);
+
+#endif // MALLOC_H
@@ -0,0 +1,100 @@
+/**
+ * @file memblock.h
+ * @brief Asignador de regiones de arranque (memblock)
+ *
+ * @details
+ *   Antes de que exista el PMM hay que repartir la RAM entre el
+ *   kernel, el DTB, el heap, el RamDisk y el propio mapa de páginas
+ *   del PMM. memblock lleva dos listas de rangos físicos:
+ *   - memory: la RAM que describe el Device Tree
+ *   - reserved: lo que ya tiene dueño (imagen del kernel, DTB y todo
+ *     lo que entrega memblock_alloc())
+ *
+ *   @code
+ *   memblock_add(0x40000000, ram_size);
+ *   memblock_reserve(kernel_start, kernel_end - kernel_start);
+ *   unsigned long heap = memblock_alloc(heap_size, PAGE_SIZE);
+ *   ...
+ *   memblock_free_all();          // El resto pasa al buddy del PMM
+ *   @endcode
+ *
+ *   Tras memblock_free_all() el PMM es el dueño de la memoria libre y
+ *   memblock_alloc() ya no entrega nada.
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ */
+
+#ifndef MEMBLOCK_H
+#define MEMBLOCK_H
+
+/* Rangos por lista (se fusionan los contiguos) */
+#define MEMBLOCK_MAX_REGIONS 32
+
+/**
+ * @brief Rango físico [base, base + size)
+ */
+struct memblock_region {
+    unsigned long base;
+    unsigned long size;
+};
+
+/* ========================================================================== */
+/* FUNCIONES PUBLICAS                                                        */
+/* ========================================================================== */
+
+/**
+ * @brief Declara un rango de RAM
+ * @return 0 si se añadió, -1 si la tabla está llena
+ */
+int memblock_add(unsigned long base, unsigned long size);
+
+/**
+ * @brief Marca un rango como ocupado
+ * @return 0 si se añadió, -1 si la tabla está llena
+ */
+int memblock_reserve(unsigned long base, unsigned long size);
+
+/**
+ * @brief Reserva 'size' bytes de RAM libre (primer hueco, de abajo a arriba)
+ * @param align Alineación (potencia de 2)
+ * @return Dirección física, o 0 si no hay hueco o el PMM ya tomó la RAM
+ */
+unsigned long memblock_alloc(unsigned long size, unsigned long align);
+
+/**
+ * @brief Rango de RAM número 'i' (por dirección creciente)
+ * @return 0 si existe, -1 si 'i' está fuera de la lista
+ */
+int memblock_memory_region(int i, struct memblock_region *out);
+
+/**
+ * @brief Primera y última dirección de RAM (end exclusiva)
+ */
+unsigned long memblock_start_of_dram(void);
+unsigned long memblock_end_of_dram(void);
+
+/**
+ * @brief Bytes de RAM declarados
+ */
+unsigned long memblock_phys_mem_size(void);
+
+/**
+ * @brief Bytes reservados (kernel, DTB y lo asignado con memblock_alloc())
+ */
+unsigned long memblock_reserved_size(void);
+
+/**
+ * @brief Entrega al PMM toda la RAM no reservada
+ * @return Páginas entregadas
+ *
+ * @details pmm_init() debe haberse llamado con el rango de RAM completo.
+ */
+unsigned long memblock_free_all(void);
+
+/**
+ * @brief Muestra las listas memory y reserved
+ */
+void memblock_dump(void);
+
+#endif /* MEMBLOCK_H */
@@ -7,12 +7,26 @@
  *   registros de sistema ARM64 y el TLB.
  * 
  * @author Sistema Operativo Educativo BareMetalM4
- * @version 0.6
+ * @version 0.7
  */
 
 #ifndef MM_H
 #define MM_H
 
+/* Tamaño del RamDisk que reserva init_memory_system() */
+#define RAMDISK_SIZE (1 * 1024 * 1024)
+
+/**
+ * @brief Reparto de la RAM física hecho en el arranque (rangos [start, end))
+ */
+struct mem_layout {
+    unsigned long ram_start, ram_end;         /* Primera/última RAM (puede haber huecos) */
+    unsigned long kernel_start, kernel_end;   /* Imagen del kernel */
+    unsigned long dtb_start, dtb_end;         /* 0 si no había Device Tree */
+    unsigned long heap_start, heap_end;
+    unsigned long ramdisk_start, ramdisk_end;
+};
+
 /* ========================================================================== */
 /* FUNCIONES EXTERNAS (Assembly - mm_utils.S)                               */
 /* ========================================================================== */
@@ -33,6 +47,13 @@ extern unsigned long get_sctlr_el1(void);
 
 /* Translation Lookaside Buffer */
 extern void tlb_invalidate_all(void);
+/* Una página / [start, end) del proceso actual (o del kernel); RVAE1IS con FEAT_TLBIRANGE */
+extern void tlb_invalidate_page(unsigned long va);
+extern void tlb_invalidate_range(unsigned long start, unsigned long end);
+/* Todas las entradas no globales de un ASID */
+extern void tlb_invalidate_asid(unsigned long asid);
+/* Tras mapear sobre un descriptor inválido: no hay nada que invalidar */
+extern void tlb_map_barrier(void);
 
 /* ========================================================================== */
 /* INICIALIZACIÓN DE MEMORIA                                                 */
@@ -49,9 +70,15 @@ void mem_init(unsigned long heap_start, unsigned long heap_size);
 /**
  * @brief Inicializa el subsistema de gestión de memoria
  * 
- * Configura estructuras de datos para la gestión dinámica
+ * Lee la RAM del Device Tree, reparte heap, RamDisk y PMM con memblock
+ * y configura estructuras de datos para la gestión dinámica
  * de memoria (kmalloc/kfree).
  */
 void init_memory_system();
 
+/**
+ * @brief Reparto de la RAM hecho por init_memory_system()
+ */
+const struct mem_layout *mm_layout(void);
+
 #endif // MM_H
\ No newline at end of file
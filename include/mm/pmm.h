@@ -5,11 +5,12 @@
  * @details
  *   Define funciones para gestionar páginas físicas de memoria:
  *   - Inicialización del PMM
- *   - Asignación y liberación de páginas físicas
+ *   - Asignación y liberación de bloques de 2^order páginas (buddy)
+ *   - Pool de páginas a cero rellenado en segundo plano
  *   - Integración con Demand Paging (get_free_page llamado por handle_fault)
  * 
  * @author Sistema Operativo Educativo BareMetalM4
- * @version 0.6
+ * @version 0.7
  */
 
 #ifndef PMM_H
@@ -23,24 +24,81 @@
 #define PAGE_SIZE 4096
 #define PAGE_SHIFT 12
 
+/* Páginas a cero que el bucle IDLE mantiene preparadas (256KB) */
+#define ZERO_POOL_TARGET 64
+
+/* Orden máximo del buddy allocator: bloques de hasta 2^10 páginas (4MB) */
+#define MAX_ORDER 10
+
+/* ========================================================================== */
+/* ESTADÍSTICAS                                                              */
+/* ========================================================================== */
+
+/**
+ * @brief Contadores del PMM (comando 'meminfo')
+ */
+struct pmm_stats {
+    unsigned long total_pages;       /* Páginas gestionadas */
+    unsigned long free_pages;        /* Libres (buddy + pool a cero) */
+    unsigned long peak_used_pages;   /* Máximo de páginas asignadas a la vez */
+    unsigned long zero_pool_pages;
+    unsigned long zero_pool_misses;
+    unsigned long allocs;
+    unsigned long frees;
+    int largest_order;               /* Mayor orden con bloques libres (-1 = ninguno) */
+};
+
 /* ========================================================================== */
 /* FUNCIONES PUBLICAS                                                        */
 /* ========================================================================== */
 
 /**
  * @brief Inicializa el gestor de memoria física
- * @param mem_start Dirección donde empieza la RAM libre (después del Kernel)
- * @param mem_size Tamaño de la memoria a gestionar
+ * @param mem_start Primera dirección de la RAM
+ * @param mem_size Tamaño de la RAM (con lo ya ocupado)
+ * 
+ * @details
+ *   Toma de memblock el mapa de páginas; todas quedan reservadas hasta
+ *   que memblock_free_all() entregue los huecos libres.
  */
 void pmm_init(unsigned long mem_start, unsigned long mem_size);
 
+/**
+ * @brief Entrega al buddy las páginas de [start, end)
+ * @return Número de páginas añadidas
+ */
+unsigned long pmm_free_range(unsigned long start, unsigned long end);
+
+/**
+ * @brief Reserva 2^order páginas físicas contiguas
+ * @param order Orden del bloque (0 = una página, MAX_ORDER = 4MB)
+ * @return Dirección física alineada a PAGE_SIZE << order (0 si no hay)
+ * 
+ * @details
+ *   Para tablas de páginas, anillos DMA y huge pages. La memoria NO se
+ *   limpia. Coste O(MAX_ORDER).
+ */
+unsigned long alloc_pages(unsigned int order);
+
+/**
+ * @brief Libera un bloque de alloc_pages()
+ * @param addr Dirección devuelta por alloc_pages()
+ * @param order El mismo orden con el que se pidió
+ * 
+ * @details
+ *   Fusiona el bloque con su buddy mientras esté libre. Se niega (con
+ *   aviso) si el bloque está compartido (más de una referencia): esas
+ *   páginas se sueltan con page_put().
+ */
+void free_pages(unsigned long addr, unsigned int order);
+
 /**
  * @brief Busca y reserva una página física libre
  * @return Dirección física de la página (o 0 si no hay memoria)
  * 
  * @details
- *   Asigna una página física de 4KB mediante First-Fit.
- *   Realiza security zeroing antes de devolverla.
+ *   Devuelve una página de 4KB a cero, normalmente del pool que
+ *   rellena el bucle IDLE; si está vacío la limpia en el momento.
  *   
  *   INTEGRACION CON DEMAND PAGING:
  *   Invocado por handle_fault() cuando ocurre un Page Fault
@@ -54,4 +112,67 @@ unsigned long get_free_page(void);
  */
 void free_page(unsigned long page);
 
+/**
+ * @brief Limpia una página libre y la guarda para get_free_page()
+ * @return 1 si añadió una página, 0 si el pool ya está lleno o no hay
+ *         memoria
+ * 
+ * @details Pensada para el bucle IDLE del kernel (PID 0).
+ */
+int pmm_zero_pool_refill(void);
+
+/**
+ * @brief Muestra los bloques libres de cada orden
+ */
+void pmm_buddyinfo(void);
+
+/**
+ * @brief Número total de páginas libres
+ */
+unsigned long pmm_nr_free_pages(void);
+
+/**
+ * @brief Copia los contadores del PMM en 'st'
+ */
+void pmm_get_stats(struct pmm_stats *st);
+
+/**
+ * @brief Orden con el que se asignó el bloque que empieza en 'page'
+ */
+unsigned int page_order(unsigned long page);
+
+/**
+ * @brief Añade una referencia a una página compartida
+ * @param page Dirección física de la página
+ * 
+ * @details
+ *   Usado al compartir páginas copy-on-write (checkpoints). Cada
+ *   page_get() debe equilibrarse con un page_put().
+ */
+void page_get(unsigned long page);
+
+/**
+ * @brief Quita una referencia y libera el bloque si era la última
+ * @param page Dirección física de la página
+ */
+void page_put(unsigned long page);
+
+/**
+ * @brief Quita una referencia solo si hay más de una
+ * @param page Dirección física de la página
+ * @return 1 si se soltó la referencia, 0 si era la única (sin cambios)
+ *
+ * @details
+ *   Comprobación y decremento en un solo paso bajo pmm_lock: lo usa
+ *   vmm_cow_fault() para decidir entre quedarse la copia o la original.
+ */
+int page_put_shared(unsigned long page);
+
+/**
+ * @brief Consulta el número de referencias de una página
+ * @param page Dirección física de la página
+ * @return Referencias (1 = privada, >1 = compartida, 0 = libre)
+ */
+int page_refcount(unsigned long page);
+
 #endif //PMM_H
\ No newline at end of file
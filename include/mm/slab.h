@@ -0,0 +1,133 @@
+/**
+ * @file slab.h
+ * @brief Cachés de objetos de tamaño fijo (slab allocator)
+ *
+ * @details
+ *   Para objetos pequeños que se crean y destruyen a menudo (contextos
+ *   de usuario, descriptores...), kmalloc() paga una cabecera de 32
+ *   bytes por objeto y mezcla tamaños en el heap. Una caché reserva
+ *   bloques del buddy ("slabs") y los trocea en objetos iguales:
+ *
+ *   @code
+ *   static struct kmem_cache *ctx_cache;
+ *   ctx_cache = kmem_cache_create("user_context",
+ *                                 sizeof(struct user_context), 0, nullptr);
+ *   struct user_context *ctx = kmem_cache_alloc(ctx_cache);
+ *   ...
+ *   kmem_cache_free(ctx_cache, ctx);
+ *   @endcode
+ *
+ *   - Asignar y liberar es O(1): pop/push en la lista libre del slab
+ *   - Cada slab está alineado a su tamaño (buddy), así que el slab de
+ *     un objeto se obtiene enmascarando su dirección
+ *   - El constructor opcional se ejecuta una vez por objeto al crear el
+ *     slab; kmem_cache_free() debe recibir el objeto en ese mismo estado
+ *   - 'slabinfo' en el shell muestra las estadísticas de cada caché
+ *
+ *   Las cachés son seguras desde IRQ (spinlock irqsave por caché).
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ */
+
+#ifndef SLAB_H
+#define SLAB_H
+
+/* Tamaño máximo de un slab: 2^3 páginas (32KB) */
+#define SLAB_MAX_ORDER 3
+
+/* Alineación mínima de los objetos (ARM64) */
+#define SLAB_MIN_ALIGN 16
+
+/* Longitud máxima del nombre de una caché */
+#define SLAB_NAME_LEN 24
+
+/* ========================================================================== */
+/* ESTRUCTURAS                                                               */
+/* ========================================================================== */
+
+struct slab;
+
+/**
+ * @brief Caché de objetos de un tamaño
+ *
+ * @details
+ *   Tres listas de slabs: parciales (de donde se asigna), llenos y
+ *   vacíos (se guarda uno como reserva; el resto vuelve al buddy).
+ */
+struct kmem_cache {
+    char name[SLAB_NAME_LEN];
+    unsigned long object_size;      /* Tamaño pedido */
+    unsigned long size;             /* Separación entre objetos */
+    unsigned long align;            /* Alineación de los objetos */
+    unsigned long offset;           /* Posición del enlace libre en el objeto */
+    unsigned int order;             /* Páginas por slab = 2^order */
+    unsigned int objs_per_slab;
+    void (*ctor)(void *);
+
+    volatile int lock;
+    struct slab *partial;
+    struct slab *full;
+    struct slab *empty;
+
+    /* Estadísticas (con el lock tomado) */
+    unsigned long nr_slabs;
+    unsigned long nr_empty;
+    unsigned long active_objs;
+    unsigned long allocs;
+    unsigned long frees;
+
+    struct kmem_cache *next;        /* Lista global (slabinfo) */
+};
+
+/* ========================================================================== */
+/* FUNCIONES PUBLICAS                                                        */
+/* ========================================================================== */
+
+/**
+ * @brief Prepara la caché de descriptores de caché
+ *
+ * @details Llamada desde init_memory_system() tras iniciar el PMM.
+ */
+void kmem_cache_init(void);
+
+/**
+ * @brief Crea una caché de objetos
+ * @param name Nombre para slabinfo (se copia)
+ * @param size Tamaño de cada objeto en bytes
+ * @param align Alineación (0 = SLAB_MIN_ALIGN; se redondea a potencia de 2)
+ * @param ctor Constructor opcional, una vez por objeto al crear el slab
+ * @return La caché, o nullptr si el tamaño no cabe en un slab
+ */
+struct kmem_cache *kmem_cache_create(const char *name, unsigned long size,
+                                     unsigned long align, void (*ctor)(void *));
+
+/**
+ * @brief Destruye una caché vacía
+ * @return 0 si se destruyó, -1 si aún tiene objetos asignados
+ */
+int kmem_cache_destroy(struct kmem_cache *cache);
+
+/**
+ * @brief Asigna un objeto de la caché
+ * @return Objeto (construido si hay ctor; si no, sin inicializar) o nullptr
+ */
+void *kmem_cache_alloc(struct kmem_cache *cache);
+
+/**
+ * @brief Devuelve un objeto a su caché
+ */
+void kmem_cache_free(struct kmem_cache *cache, void *obj);
+
+/**
+ * @brief Devuelve al buddy todos los slabs vacíos de la caché
+ * @return Número de slabs liberados
+ */
+int kmem_cache_shrink(struct kmem_cache *cache);
+
+/**
+ * @brief Muestra las estadísticas de todas las cachés
+ */
+void slabinfo_print(void);
+
+#endif /* SLAB_H */
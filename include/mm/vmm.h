@@ -19,9 +19,11 @@
  *   - Páginas de 4KB (PAGE_SIZE = 4096)
  *   - Traducción de 3 niveles (L1/L2/L3)
  *   - 48 bits de espacio de direcciones virtuales
+ *   - Bloques de 1GB (L1) y 2MB (L2) y bit de contigüidad con
+ *     map_range(), para mapas lineales grandes
  * 
  * @author Sistema Operativo Educativo BareMetalM4
- * @version 0.6
+ * @version 0.7
  */
 
 #ifndef VMM_H
@@ -44,6 +46,35 @@
 #define PT_PAGE      3     /* Entrada apunta a página física (L3) */
 #define PT_BLOCK     1     /* Entrada es un bloque grande (L1, L2) */
 
+/* Zona virtual para demand paging (pruebas y datos de procesos): por
+   encima de cualquier RAM de QEMU virt, que se mapea 1:1 desde 0x40000000
+   y con '-m 2G' ya ocupa 0x50000000 */
+#define DEMAND_VA_BASE 0x4000000000UL
+
+/* Espacio privado de cada proceso: de DEMAND_VA_BASE al final de TTBR0
+   (T0SZ = 25, 39 bits). Las entradas de la tabla base por debajo de
+   USER_PGD_FIRST son las del kernel y se comparten con kernel_pgd */
+#define USER_VA_END    (1UL << 39)
+#define USER_PGD_FIRST L1_INDEX(DEMAND_VA_BASE)
+
+/* Dirección de salida de un descriptor (bits 47-12) */
+#define PTE_ADDR_MASK 0xFFFFFFFFF000UL
+
+/* Tamaño que cubre una entrada de bloque en cada nivel */
+#define L1_BLOCK_SIZE (1UL << 30)   /* 1GB */
+#define L2_BLOCK_SIZE (1UL << 21)   /* 2MB */
+
+/**
+ * @brief Contiguous hint
+ * 
+ * Marca un grupo de CONT_ENTRIES entradas consecutivas, alineado a su
+ * tamaño total y con direcciones físicas contiguas y atributos
+ * idénticos: la TLB lo guarda como una sola entrada (64KB con páginas
+ * de 4KB, 32MB con bloques de 2MB).
+ */
+#define MM_CONTIG    (1UL << 52)
+#define CONT_ENTRIES 16
+
 /* ========================================================================== */
 /* ATRIBUTOS DE MEMORIA (Lower Attributes)                                  */
 /* ========================================================================== */
@@ -55,6 +86,7 @@
  * MM_SH: Shareability (Inner) - Para coherencia de cache multicore
  * MM_RO/RW: Permisos de escritura
  * MM_USER/KERNEL: Accesible desde EL0 o solo EL1
+ * MM_NG: Traducción privada del proceso (ASID); sin ella es global
  * MM_EXEC/NOEXEC: Execute Never (XN) - Previene ejecución de código
  */
 #define MM_ACCESS    (1 << 10) /* Access Flag (AF) - Debe estar a 1 */
@@ -63,6 +95,7 @@
 #define MM_RW        (0 << 7)  /* Read Write */
 #define MM_USER      (1 << 6)  /* Accesible por EL0 (usuario) */
 #define MM_KERNEL    (0 << 6)  /* Solo EL1 (kernel) */
+#define MM_NG        (1 << 11) /* not-Global: en la TLB va etiquetada con el ASID */
 #define MM_EXEC      (0UL << 54) /* Execute Never (XN) = 0 (Ejecutable) */
 #define MM_NOEXEC    (1UL << 54) /* Execute Never (XN) = 1 (No Ejecutable) */
 
@@ -109,7 +142,8 @@
  * 
  * Array de 512 entradas de 64 bits (4KB total)
  * Alineado a 4KB como requiere la arquitectura ARM64
- * Se carga en TTBR0_EL1 durante el boot
+ * Se carga en TTBR0_EL1 durante el boot. Después es el espacio del PID 0
+ * (ASID 0) y el origen de las entradas del kernel de cada proceso
  */
 extern unsigned long kernel_pgd[512] __attribute__((aligned(4096)));
 
@@ -127,13 +161,118 @@ extern unsigned long kernel_pgd[512] __attribute__((aligned(4096)));
  * @details
  *   Crea o actualiza una entrada en las tablas de páginas.
  *   Crea automáticamente tablas intermedias (L2/L3) si no existen.
+ *   Si la dirección cae en un bloque de 1GB/2MB, lo parte en una
+ *   tabla del nivel siguiente con los mismos atributos.
  *   Usa get_free_page() del PMM para nuevas tablas.
  *   
- *   IMPORTANTE: Tras llamar a map_page(), debe invalidarse la TLB
- *   con tlb_invalidate_all() para que la MMU vea los cambios.
+ *   IMPORTANTE: Tras llamar a map_page() sobre una entrada válida hay
+ *   que invalidarla (tlb_invalidate_page()); sobre una vacía basta con
+ *   tlb_map_barrier(): la TLB no guarda entradas inválidas.
  */
 void map_page(unsigned long *root_table, unsigned long virt, unsigned long phys, unsigned long flags);
 
+/**
+ * @brief Mapea un rango con el mayor tamaño de entrada que encaje
+ * @param root_table Tabla base (L1/PGD)
+ * @param virt Dirección virtual inicial (alineada a 4KB)
+ * @param phys Dirección física inicial (alineada a 4KB)
+ * @param size Bytes a mapear (múltiplo de 4KB)
+ * @param flags Permisos y atributos, como en map_page()
+ * @return 0 si todo quedó mapeado, -1 si faltó memoria para tablas
+ * 
+ * @details
+ *   Donde virt y phys están alineadas y queda rango suficiente usa
+ *   bloques de 1GB (L1) o 2MB (L2); el resto, páginas de 4KB. Grupos
+ *   de CONT_ENTRIES entradas alineados llevan MM_CONTIG. Los bloques
+ *   solo se ponen sobre entradas vacías. Como map_page(), el llamador
+ *   invalida la TLB.
+ */
+int map_range(unsigned long *root_table, unsigned long virt, unsigned long phys,
+              unsigned long size, unsigned long flags);
+
+/**
+ * @brief Traduce una dirección virtual recorriendo las tablas
+ * @param root_table Tabla base (L1/PGD)
+ * @param virt Dirección virtual
+ * @return Dirección física (con el desplazamiento), o 0 si no está mapeada
+ */
+unsigned long vmm_translate(unsigned long *root_table, unsigned long virt);
+
+/**
+ * @brief Libera las tablas L2/L3 que cuelgan de una tabla base
+ * @param root_table Tabla base (L1/PGD), que queda vacía
+ * 
+ * @details No libera las páginas mapeadas ni la propia tabla base.
+ */
+void vmm_free_tables(unsigned long *root_table);
+
+/**
+ * @brief Crea la tabla base de un proceso nuevo
+ * @return Tabla base (L1) o nullptr si no hay memoria
+ * 
+ * @details
+ *   Las entradas del kernel (por debajo de USER_PGD_FIRST) se copian de
+ *   kernel_pgd y apuntan a sus mismas tablas: el mapa lineal, el código
+ *   y los periféricos se comparten. El espacio de usuario empieza vacío.
+ */
+unsigned long *vmm_create_pgd(void);
+
+/**
+ * @brief Destruye el espacio de usuario de un proceso y su tabla base
+ * @param pgd Tabla creada con vmm_create_pgd()
+ * 
+ * @details
+ *   Suelta una referencia (page_put) de cada página mapeada en el
+ *   espacio de usuario y libera sus tablas L2/L3. No invalida la TLB:
+ *   el ASID del proceso no se reutiliza hasta la siguiente generación,
+ *   que empieza invalidándola entera (ver mm/asid.h).
+ */
+void vmm_destroy_pgd(unsigned long *pgd);
+
+/**
+ * @brief Duplica el espacio de usuario de 'src' en 'dst' con copy-on-write
+ * @param dst Tabla base vacía (vmm_create_pgd())
+ * @param src Tabla base del proceso que se clona
+ * @return Páginas compartidas, o -1 si faltó memoria para las tablas
+ * 
+ * @details
+ *   No copia ninguna página: las mapea de solo lectura (MM_RO) en las
+ *   dos tablas y toma una referencia (page_get) por cada una. Deja en
+ *   'src' entradas que eran de escritura: el llamador debe invalidar su
+ *   ASID (flush_tlb_mm()). Si falla, 'dst' queda a medias y se libera
+ *   con vmm_destroy_pgd().
+ */
+long vmm_fork_user_space(unsigned long *dst, unsigned long *src);
+
+/**
+ * @brief Busca la entrada L3 (PTE) de una dirección virtual
+ * @param root_table Tabla base (L1/PGD)
+ * @param virt Dirección virtual
+ * @return Puntero al descriptor L3, o nullptr si no hay tablas intermedias
+ *         (o la dirección cae en un bloque de 1GB/2MB)
+ */
+unsigned long *vmm_get_pte(unsigned long *root_table, unsigned long virt);
+
+/**
+ * @brief Elimina el mapeo de una página virtual (sin liberar la física)
+ * @param root_table Tabla base (L1/PGD)
+ * @param virt Dirección virtual alineada a 4KB
+ * @return Dirección física que estaba mapeada (0 si no había)
+ * 
+ * @details
+ *   Tras llamarla, debe invalidarse la entrada (tlb_invalidate_page()
+ *   o tlb_invalidate_range() para varias).
+ */
+unsigned long unmap_page(unsigned long *root_table, unsigned long virt);
+
+/**
+ * @brief Resuelve un fallo de escritura sobre una página copy-on-write
+ * @param root_table Tabla base (L1/PGD)
+ * @param virt Dirección que provocó el fallo
+ * @return 0 si se resolvió (copia o permiso restaurado), -1 si no era COW
+ */
+int vmm_cow_fault(unsigned long *root_table, unsigned long virt);
+
 /**
  * @brief Inicializa el subsistema de memoria virtual
  * 
@@ -0,0 +1,112 @@
+/**
+ * @file mutex.h
+ * @brief Mutex con propietario, espera adaptativa y herencia de prioridad
+ *
+ * @details
+ *   A diferencia de struct semaphore, un mutex sabe QUIÉN lo tiene:
+ *
+ *   - Solo el propietario puede liberarlo
+ *   - ESPERA ADAPTATIVA: si el propietario está ejecutándose (en otra
+ *     CPU) se espera activamente un tiempo corto, porque es probable que
+ *     lo suelte enseguida; si no, el proceso se bloquea
+ *   - HERENCIA DE PRIORIDAD: mientras haya en la cola un proceso más
+ *     urgente que el propietario (menor valor de priority), el
+ *     propietario hereda esa prioridad. Así un proceso de prioridad
+ *     media no puede dejar sin CPU a quien retiene el mutex (inversión
+ *     de prioridad no acotada)
+ *   - Al liberar se entrega el mutex directamente al waiter más urgente
+ *
+ *   USO TÍPICO:
+ *   @code
+ *   struct mutex m;
+ *   mutex_init(&m, "mi_mutex");
+ *
+ *   mutex_lock(&m);
+ *   // ... sección crítica ...
+ *   mutex_unlock(&m);
+ *   @endcode
+ *
+ *   La prioridad propia se guarda en el PCB (base_priority), no en el
+ *   mutex: al soltar uno, el propietario queda con la más urgente entre
+ *   la suya y la de los waiters de los mutex que sigue teniendo.
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ */
+
+#ifndef MUTEX_H
+#define MUTEX_H
+
+#include "sched.h"
+
+/* Iteraciones máximas de espera activa mientras el propietario ejecuta */
+#define MUTEX_SPIN_MAX 1000
+
+/* ========================================================================== */
+/* ESTRUCTURAS                                                               */
+/* ========================================================================== */
+
+/**
+ * @brief Mutex dormible con propietario
+ *
+ * @details
+ *   owner: Proceso que lo tiene (nullptr = libre)
+ *   head/tail: Wait queue (campo 'next' del PCB), en orden de llegada;
+ *     al liberar se elige el waiter con menor priority
+ *   held_next: Siguiente mutex del mismo propietario (pcb->held_mutexes)
+ */
+struct mutex {
+    volatile int lock;           /* Spinlock interno (spin_lock_irqsave) */
+    struct pcb *volatile owner;  /* Propietario actual */
+    struct pcb *head;            /* Primer waiter */
+    struct pcb *tail;            /* Último waiter */
+    struct mutex *held_next;     /* Lista de mutex del propietario */
+    const char *name;            /* Nombre (debug) */
+};
+
+/* ========================================================================== */
+/* FUNCIONES PUBLICAS                                                        */
+/* ========================================================================== */
+
+/**
+ * @brief Inicializa un mutex libre
+ * @param m Puntero al mutex
+ * @param name Nombre descriptivo (debug)
+ */
+void mutex_init(struct mutex *m, const char *name);
+
+/**
+ * @brief Adquiere el mutex (espera activa corta o bloqueo)
+ * @param m Puntero al mutex
+ *
+ * @details
+ *   Si hay que bloquearse y el llamador es más urgente que el
+ *   propietario, el propietario hereda su prioridad.
+ *   No se puede llamar desde un IRQ.
+ */
+void mutex_lock(struct mutex *m);
+
+/**
+ * @brief Intenta adquirir el mutex sin esperar
+ * @param m Puntero al mutex
+ * @return 1 si se adquirió, 0 si estaba tomado
+ */
+int mutex_trylock(struct mutex *m);
+
+/**
+ * @brief Libera el mutex
+ * @param m Puntero al mutex
+ *
+ * @details
+ *   Entrega el mutex al waiter más urgente (que queda READY y ya es el
+ *   propietario) y recalcula la prioridad del llamador con los mutex
+ *   que le quedan.
+ */
+void mutex_unlock(struct mutex *m);
+
+/**
+ * @brief Indica si el proceso actual tiene el mutex
+ */
+int mutex_is_owner(struct mutex *m);
+
+#endif /* MUTEX_H */
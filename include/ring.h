@@ -0,0 +1,172 @@
+/**
+ * @file ring.h
+ * @brief Colas circulares sin locks (SPSC y MPMC) de palabras de 64 bits
+ *
+ * @details
+ *   Bloque básico para caminos productor/consumidor del kernel (IRQ ->
+ *   proceso, proceso -> proceso). Cada elemento es un unsigned long (un
+ *   valor o un puntero convertido).
+ *
+ *   COMUNES:
+ *   - Tamaño potencia de 2: el índice es pos & mask, sin divisiones
+ *   - Índices de 64 bits que solo crecen (nunca dan la vuelta en la
+ *     práctica): lleno = head - tail == tamaño, vacío = head == tail
+ *   - El almacenamiento lo aporta el llamador (array estático o kmalloc)
+ *   - Operaciones por lotes (_burst): una sola publicación para n
+ *     elementos; devuelven cuántos se movieron (0..n)
+ *
+ *   SPSC (un productor, un consumidor):
+ *   - Sin instrucciones atómicas de lectura-modificación-escritura
+ *   - El productor escribe los slots y publica head con STLR (release);
+ *     el consumidor lee head con LDAR (acquire) antes de leer los slots.
+ *     Simétrico para tail
+ *   - Cada lado guarda una copia del índice del otro y solo lo relee
+ *     cuando la copia dice lleno/vacío
+ *   - head y tail en líneas de caché distintas
+ *
+ *   MPMC (varios productores y consumidores, algoritmo de Vyukov):
+ *   - Cada slot lleva un número de secuencia: seq == pos (libre para el
+ *     productor de pos), seq == pos + 1 (lleno para el consumidor de pos)
+ *   - Se reclama una posición con CAS sobre head/tail y se publica el
+ *     slot con un store-release de su seq
+ *   - Un productor que pierde la CPU entre reclamar y publicar retiene
+ *     ese slot: los consumidores ven la cola vacía desde ahí hasta que
+ *     publique
+ *
+ *   @code
+ *   static unsigned long slots[64];
+ *   static struct spsc_ring r;
+ *   spsc_ring_init(&r, slots, 64);
+ *
+ *   spsc_ring_enqueue(&r, valor);          // productor
+ *   if (spsc_ring_dequeue(&r, &v) == 0)    // consumidor
+ *       usar(v);
+ *   @endcode
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ */
+
+#ifndef RING_H
+#define RING_H
+
+/* Tamaño de línea de caché (Cortex-A72) */
+#define RING_CACHELINE 64
+
+/* ========================================================================== */
+/* ESTRUCTURAS                                                               */
+/* ========================================================================== */
+
+/**
+ * @brief Cola SPSC
+ */
+struct spsc_ring {
+    /* Lado productor */
+    volatile unsigned long head;    /* Próxima posición a escribir */
+    unsigned long tail_cache;       /* Última tail leída */
+
+    /* Lado consumidor */
+    volatile unsigned long tail __attribute__((aligned(RING_CACHELINE)));
+    unsigned long head_cache;       /* Última head leída */
+
+    /* Configuración (solo lectura tras init) */
+    unsigned long mask __attribute__((aligned(RING_CACHELINE)));
+    unsigned long *slots;
+};
+
+/**
+ * @brief Slot de la cola MPMC
+ */
+struct mpmc_slot {
+    volatile unsigned long seq;
+    unsigned long val;
+};
+
+/**
+ * @brief Cola MPMC
+ */
+struct mpmc_ring {
+    volatile unsigned long head;    /* Próxima posición a reclamar (productores) */
+    volatile unsigned long tail __attribute__((aligned(RING_CACHELINE)));
+    unsigned long mask __attribute__((aligned(RING_CACHELINE)));
+    struct mpmc_slot *slots;
+};
+
+/* ========================================================================== */
+/* SPSC                                                                      */
+/* ========================================================================== */
+
+/**
+ * @brief Inicializa una cola SPSC vacía
+ * @param slots Almacenamiento de 'size' elementos
+ * @param size Capacidad (potencia de 2)
+ * @return 0 si éxito, -1 si size no es potencia de 2
+ */
+int spsc_ring_init(struct spsc_ring *r, unsigned long *slots, unsigned long size);
+
+/**
+ * @brief Encola hasta n elementos (solo el productor)
+ * @return Número de elementos encolados
+ */
+unsigned long spsc_ring_enqueue_burst(struct spsc_ring *r, const unsigned long *vals, unsigned long n);
+
+/**
+ * @brief Desencola hasta n elementos (solo el consumidor)
+ * @return Número de elementos desencolados
+ */
+unsigned long spsc_ring_dequeue_burst(struct spsc_ring *r, unsigned long *vals, unsigned long n);
+
+/**
+ * @brief Encola un elemento
+ * @return 0 si éxito, -1 si la cola está llena
+ */
+int spsc_ring_enqueue(struct spsc_ring *r, unsigned long val);
+
+/**
+ * @brief Desencola un elemento
+ * @return 0 si éxito, -1 si la cola está vacía
+ */
+int spsc_ring_dequeue(struct spsc_ring *r, unsigned long *val);
+
+/**
+ * @brief Elementos en la cola (aproximado si el otro lado está activo)
+ */
+unsigned long spsc_ring_count(struct spsc_ring *r);
+
+/* ========================================================================== */
+/* MPMC                                                                      */
+/* ========================================================================== */
+
+/**
+ * @brief Inicializa una cola MPMC vacía
+ * @param slots Almacenamiento de 'size' slots
+ * @param size Capacidad (potencia de 2)
+ * @return 0 si éxito, -1 si size no es potencia de 2
+ */
+int mpmc_ring_init(struct mpmc_ring *r, struct mpmc_slot *slots, unsigned long size);
+
+/**
+ * @brief Encola hasta n elementos consecutivos (cualquier productor)
+ * @return Número de elementos encolados
+ */
+unsigned long mpmc_ring_enqueue_burst(struct mpmc_ring *r, const unsigned long *vals, unsigned long n);
+
+/**
+ * @brief Desencola hasta n elementos consecutivos (cualquier consumidor)
+ * @return Número de elementos desencolados
+ */
+unsigned long mpmc_ring_dequeue_burst(struct mpmc_ring *r, unsigned long *vals, unsigned long n);
+
+/**
+ * @brief Encola un elemento
+ * @return 0 si éxito, -1 si la cola está llena
+ */
+int mpmc_ring_enqueue(struct mpmc_ring *r, unsigned long val);
+
+/**
+ * @brief Desencola un elemento
+ * @return 0 si éxito, -1 si la cola está vacía
+ */
+int mpmc_ring_dequeue(struct mpmc_ring *r, unsigned long *val);
+
+#endif /* RING_H */
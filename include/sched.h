@@ -20,7 +20,7 @@
  *   - Wait queues para sincronización eficiente
  * 
  * @author Sistema Operativo Educativo BareMetalM4
- * @version 0.6
+ * @version 0.7
  */
 
 #ifndef SCHED_H
@@ -38,12 +38,15 @@
  * READY (2): Proceso listo para ejecutar, esperando su turno
  * BLOCKED (3): Proceso bloqueado (durmiendo o esperando recurso)
  * ZOMBIE (4): Proceso terminado, esperando limpieza (free_zombie)
+ * DEAD (5): Recogido por free_zombie(); el slot vuelve a UNUSED tras un
+ *   periodo de gracia RCU (ver kernel/rcu.h)
  */
 #define PROCESS_UNUSED 0
 #define PROCESS_RUNNING 1
 #define PROCESS_READY 2
 #define PROCESS_BLOCKED 3
 #define PROCESS_ZOMBIE 4
+#define PROCESS_DEAD 5
 
 /* ========================================================================== */
 /* RAZONES DE BLOQUEO                                                        */
@@ -54,7 +57,10 @@
  * 
  * BLOCK_REASON_NONE (0): No bloqueado (estado READY/RUNNING)
  * BLOCK_REASON_SLEEP (1): Durmiendo por sleep() - Despierta en timer_tick()
- * BLOCK_REASON_WAIT (2): Esperando semáforo/recurso - Despierta en sem_signal()
+ * BLOCK_REASON_WAIT (2): Esperando semáforo/recurso - Despierta en sem_signal(),
+ *   wake_up() o, si esperaba con timeout, en timer_softirq()
+ * BLOCK_REASON_IPC_* (3-5): Bloqueado en IPC síncrono (ver kernel/ipc.h)
+ * BLOCK_REASON_FUTEX (6): FUTEX_WAIT sobre una dirección de usuario
  * 
  * IMPORTANTE: Los procesos BLOCKED NO consumen CPU.
  * El scheduler (schedule()) los ignora hasta que sean despertados.
@@ -62,6 +68,10 @@
 #define BLOCK_REASON_NONE 0
 #define BLOCK_REASON_SLEEP 1
 #define BLOCK_REASON_WAIT 2     /* Semáforos, I/O, etc. */
+#define BLOCK_REASON_IPC_SEND 3   /* ipc_call(): encolado, servidor ocupado */
+#define BLOCK_REASON_IPC_RECV 4   /* ipc_recv(): servidor esperando petición */
+#define BLOCK_REASON_IPC_REPLY 5  /* ipc_call(): petición entregada, esperando respuesta */
+#define BLOCK_REASON_FUTEX 6      /* FUTEX_WAIT (ver kernel/futex.h) */
 
 /* ========================================================================== */
 /* CONSTANTES DEL SISTEMA                                                    */
@@ -81,6 +91,7 @@
 #define MAX_PROCESS 64
 #define BUFFER_SIZE 4
 #define DEFAULT_QUANTUM 5  /* Ticks de quantum para Round-Robin */
+#define PROC_MAX_VM_PAGES 16  /* Páginas de demand paging registradas por proceso */
 
 /* ========================================================================== */
 /* ESTRUCTURAS                                                               */
@@ -95,6 +106,8 @@
  *   - fp (x29): Frame Pointer
  *   - pc: Program Counter (dirección de retorno)
  *   - sp: Stack Pointer
+ *   - ttbr0: Valor de TTBR0_EL1 (tabla base + ASID). Lo calcula
+ *     switch_mm() y cpu_switch_to() solo lo carga si cambia
  *   
  *   Los registros x0-x18 son caller-saved y no se guardan aquí.
  */
@@ -112,6 +125,15 @@ struct cpu_context {
     unsigned long fp;   /* x29 - Frame Pointer */
     unsigned long pc;   /* Program Counter */
     unsigned long sp;   /* Stack Pointer */
+    unsigned long ttbr0; /* Tabla base | ASID (switch_mm, mm/asid.h) */
+};
+
+/**
+ * @brief Enlace para liberaciones diferidas con call_rcu() (kernel/rcu.h)
+ */
+struct rcu_head {
+    struct rcu_head *next;
+    void (*func)(struct rcu_head *head);
 };
 
 /**
@@ -127,15 +149,45 @@ struct cpu_context {
  *   
  *   SCHEDULING:
  *   - priority: Valor de prioridad (menor valor = mayor prioridad)
+ *   - base_priority: Prioridad propia guardada al heredar la de un
+ *     waiter de mutex (-1 = no hay herencia activa)
  *   - quantum: Ticks restantes antes de expropriación (Round-Robin)
+ *   - prempt_count: Secciones sin expropiación anidadas (rcu_read_lock);
+ *     mientras sea > 0 el IRQ del timer no cambia de proceso
  *   - wake_up_time: Tick en el que despertar si block_reason=SLEEP
  *   
  *   BLOQUEO Y SINCRONIZACIÓN:
  *   - block_reason: Por qué está bloqueado (SLEEP, WAIT, NONE)
  *   - next: Puntero para wait queues en semáforos (lista enlazada)
+ *   - wait_queue: Wait queue genérica en la que espera (kernel/wait.h),
+ *     o nullptr. Con timeout, wake_up_time es el tick límite (0 = sin
+ *     límite) y timer_softirq() lo saca de la cola al vencer
+ *   
+ *   IPC SÍNCRONO:
+ *   - ipc_buf: Mensaje del proceso (petición/respuesta) mientras bloquea
+ *   - ipc_partner: Con quién habla (servidor destino / cliente actual)
+ *   - ipc_senders: Clientes encolados esperando a este servidor
+ *     (enlazados por 'next': un proceso solo espera en una cola a la vez)
+ *   - ipc_status: Resultado de la última ipc_call() (0 o -1)
+ *   
+ *   MUTEX:
+ *   - held_mutexes: Mutex de los que es propietario. Al soltar uno, la
+ *     prioridad se recalcula con los waiters de los que sigue teniendo
+ *   
+ *   FUTEX:
+ *   - futex_key: Dirección por la que espera en FUTEX_WAIT (enlazado por
+ *     'next' en el bucket de la tabla hash)
  *   
  *   MEMORIA:
- *   - stack_addr: Dirección base del stack (para kfree en free_zombie)
+ *   - stack_addr: Dirección base del stack (se libera tras free_zombie)
+ *   - rcu: Enlace de call_rcu() para devolver el slot a UNUSED
+ *   - vm_pages: Direcciones virtuales asignadas por demand paging
+ *     (las que se guardan en un checkpoint)
+ *   - pgd: Tabla base propia (vmm_create_pgd); kernel_pgd en el PID 0
+ *   - asid: Generación | ASID asignado por switch_mm() (0 = ninguno)
+ *   - is_user: El proceso ejecuta en EL0 (create_user_process): sus
+ *     páginas de demanda son accesibles desde EL0 aunque el fallo lo
+ *     provoque el kernel dentro de una syscall
  *   
  *   ESTADÍSTICAS:
  *   - cpu_time: Ticks de CPU consumidos (para profiling)
@@ -147,7 +199,8 @@ struct pcb {
     long state;                  /* Estado del proceso */
     long pid;                    /* Process ID */
     int priority;                /* Prioridad (menor = más urgente) */
-    long prempt_count;           /* Contador de preempciones */
+    int base_priority;           /* Propia antes de heredar (-1 = sin herencia) */
+    long prempt_count;           /* > 0: expropiación deshabilitada */
     unsigned long wake_up_time;  /* Tick para despertar (si BLOCKED) */
     char name[16];               /* Nombre del proceso (debug) */
     unsigned long stack_addr;    /* Dirección base de la pila */
@@ -158,6 +211,24 @@ struct pcb {
 
     int quantum;                 /* Quantum restante (Round-Robin) */
     struct pcb *next;            /* Para wait queues en semáforos */
+    struct wait_queue_head *wait_queue; /* Cola de wait_event() (o nullptr) */
+
+    struct ipc_msg *ipc_buf;     /* Mensaje en tránsito (IPC) */
+    long ipc_partner;            /* PID del otro extremo (IPC) */
+    struct pcb *ipc_senders;     /* Clientes esperando a este servidor */
+    long ipc_status;             /* Resultado de ipc_call() */
+
+    unsigned long futex_key;     /* Dirección esperada en FUTEX_WAIT */
+
+    struct mutex *held_mutexes;  /* Mutex que tiene (enlazados por held_next) */
+
+    unsigned long vm_pages[PROC_MAX_VM_PAGES]; /* VAs de demand paging */
+    int nr_vm_pages;             /* Entradas válidas en vm_pages */
+    unsigned long *pgd;          /* Tabla base del espacio de direcciones */
+    unsigned long asid;          /* Generación | ASID (mm/asid.h) */
+    int is_user;                 /* Ejecuta código en EL0 */
+
+    struct rcu_head rcu;         /* Liberación del slot tras free_zombie() */
 };
 
 #endif // SCHED_H
\ No newline at end of file
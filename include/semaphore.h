@@ -10,7 +10,9 @@
  *   - Wait Queue: Lista enlazada FIFO de procesos bloqueados
  *   - Bloqueo eficiente: Procesos BLOCKED no aparecen en schedule()
  *   - Wake-up explícito: sem_signal() despierta al primer waiter
- *   - Spinlocks: Protección atómica contra race conditions
+ *   - Spinlock por semáforo: Semáforos distintos no compiten entre sí
+ *   - IRQ-safe: sem_signal() se puede llamar con IRQs deshabilitadas o
+ *     desde un IRQ (guarda y restaura DAIF en vez de rehabilitar IRQs)
  *   
  *   USO TÍPICO:
  *   @code
@@ -24,7 +26,7 @@
  *   @endcode
  * 
  * @author Sistema Operativo Educativo BareMetalM4
- * @version 0.6
+ * @version 0.7
  */
 
 #ifndef SEMAPHORE_H
@@ -44,12 +46,15 @@
  *     - count > 0: Recurso disponible, sem_wait() pasa inmediatamente
  *     - count = 0: Recurso ocupado, sem_wait() bloquea el proceso
  *   
+ *   lock: Spinlock propio (0 = libre), tomado con IRQs deshabilitadas
+ *   
  *   head/tail: Wait queue (cola de espera)
  *     - Lista enlazada de procesos bloqueados (campo 'next' del PCB)
  *     - FIFO: Fairness - Primero en llegar, primero en despertar
  *     - Si ambos son NULL, la cola está vacía
  */
 struct semaphore {
+    volatile int lock;   /* Spinlock del semáforo (spin_lock_irqsave) */
     volatile int count;  /* Contador: >0=disponible, 0=ocupado */
     struct pcb *head;    /* Primer proceso en wait queue */
     struct pcb *tail;    /* Último proceso en wait queue */
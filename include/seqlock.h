@@ -0,0 +1,147 @@
+/**
+ * @file seqlock.h
+ * @brief Seqcounts y seqlocks: lecturas sin lock con reintento
+ *
+ * @details
+ *   Pensados para datos pequeños que se leen mucho y se escriben poco.
+ *   El escritor incrementa un contador de secuencia antes y después de
+ *   modificar los datos (impar = escritura en curso). El lector:
+ *
+ *   @code
+ *   unsigned long seq;
+ *   do {
+ *       seq = read_seqbegin(&sl);
+ *       // ... copiar los datos a variables locales ...
+ *   } while (read_seqretry(&sl, seq));
+ *   @endcode
+ *
+ *   Si la secuencia cambió durante la copia, la copia puede estar a medias
+ *   y se repite. El lector nunca escribe en memoria compartida ni retrasa
+ *   al escritor.
+ *
+ *   DOS VARIANTES:
+ *   - struct seqcount: solo el contador. El llamador garantiza que hay
+ *     un único escritor (p.ej. timer_tick(), que corre en el IRQ)
+ *   - struct seqlock: contador + spinlock que serializa a los escritores
+ *     (write_seqlock_irqsave / write_sequnlock_irqrestore)
+ *
+ *   RESTRICCIONES:
+ *   - Los lectores solo deben copiar datos: no seguir punteros que el
+ *     escritor pueda liberar, ni hacer nada con efectos antes de
+ *     read_seqretry()
+ *   - No leer desde un IRQ un seqcount cuyo escritor pueda ser
+ *     interrumpido a mitad (en un solo core esperaría para siempre).
+ *     Los escritores de contexto de proceso usan la variante irqsave
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ */
+
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include "barrier.h"
+#include "spinlock.h"
+
+/* ========================================================================== */
+/* ESTRUCTURAS                                                               */
+/* ========================================================================== */
+
+/**
+ * @brief Contador de secuencia (par = estable, impar = escritura en curso)
+ */
+struct seqcount {
+    volatile unsigned long sequence;
+};
+
+/**
+ * @brief Seqcount con spinlock para varios escritores
+ */
+struct seqlock {
+    struct seqcount seq;
+    volatile int lock;
+};
+
+/* ========================================================================== */
+/* SEQCOUNT                                                                  */
+/* ========================================================================== */
+
+static inline void seqcount_init(struct seqcount *s) {
+    s->sequence = 0;
+}
+
+/**
+ * @brief Inicia una lectura (espera a que no haya escritura en curso)
+ * @return Secuencia a pasar a read_seqcount_retry()
+ */
+static inline unsigned long read_seqcount_begin(const struct seqcount *s) {
+    unsigned long seq;
+
+    while ((seq = s->sequence) & 1) {
+        cpu_relax();
+    }
+    smp_rmb();
+    return seq;
+}
+
+/**
+ * @brief Indica si la lectura iniciada con 'start' debe repetirse
+ * @return 1 si hubo una escritura mientras se leía, 0 si la copia es válida
+ */
+static inline int read_seqcount_retry(const struct seqcount *s, unsigned long start) {
+    smp_rmb();
+    return s->sequence != start;
+}
+
+/**
+ * @brief Abre una escritura (la secuencia pasa a impar)
+ */
+static inline void write_seqcount_begin(struct seqcount *s) {
+    s->sequence++;
+    smp_wmb();
+}
+
+/**
+ * @brief Cierra una escritura (la secuencia vuelve a par)
+ */
+static inline void write_seqcount_end(struct seqcount *s) {
+    smp_wmb();
+    s->sequence++;
+}
+
+/* ========================================================================== */
+/* SEQLOCK                                                                   */
+/* ========================================================================== */
+
+static inline void seqlock_init(struct seqlock *sl) {
+    seqcount_init(&sl->seq);
+    sl->lock = 0;
+}
+
+static inline unsigned long read_seqbegin(const struct seqlock *sl) {
+    return read_seqcount_begin(&sl->seq);
+}
+
+static inline int read_seqretry(const struct seqlock *sl, unsigned long start) {
+    return read_seqcount_retry(&sl->seq, start);
+}
+
+/**
+ * @brief Adquiere el seqlock como escritor (IRQs deshabilitadas)
+ * @return Estado de IRQs previo (para write_sequnlock_irqrestore)
+ */
+static inline unsigned long write_seqlock_irqsave(struct seqlock *sl) {
+    unsigned long flags = spin_lock_irqsave(&sl->lock);
+    write_seqcount_begin(&sl->seq);
+    return flags;
+}
+
+/**
+ * @brief Libera el seqlock y restaura el estado de IRQs
+ */
+static inline void write_sequnlock_irqrestore(struct seqlock *sl, unsigned long flags) {
+    write_seqcount_end(&sl->seq);
+    spin_unlock_irqrestore(&sl->lock, flags);
+}
+
+#endif /* SEQLOCK_H */
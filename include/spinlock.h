@@ -0,0 +1,252 @@
+/**
+ * @file spinlock.h
+ * @brief Spinlocks con guardado/restauración del estado de IRQs
+ *
+ * @details
+ *   Envoltorios sobre las primitivas de src/locks.S (LDXR/STXR) para
+ *   proteger estructuras que también se tocan desde IRQs o softirqs:
+ *
+ *   @code
+ *   unsigned long flags = spin_lock_irqsave(&obj->lock);
+ *   // ... sección crítica (IRQs deshabilitadas) ...
+ *   spin_unlock_irqrestore(&obj->lock, flags);
+ *   @endcode
+ *
+ *   A diferencia de disable_interrupts()/enable_interrupts(), la
+ *   restauración deja DAIF como estaba: si el llamador ya tenía las IRQs
+ *   deshabilitadas, siguen deshabilitadas (las secciones se anidan).
+ *
+ *   Cada objeto lleva su propio lock (volatile int, 0 = libre): objetos
+ *   no relacionados no compiten entre sí.
+ *
+ *   LOCKS JUSTOS CON ESTADÍSTICAS:
+ *   - struct ticket_lock: FIFO con un contador compartido (barato, pero
+ *     todos los que esperan leen la misma línea de caché)
+ *   - struct mcs_lock: FIFO con una cola de nodos; cada uno espera sobre
+ *     su propio nodo (sin tráfico de caché compartido)
+ *
+ *   LOCK DE LECTORES/ESCRITORES (struct rwlock):
+ *   - Varios lectores a la vez, o un único escritor
+ *   - Preferencia de lectores: un escritor espera a que no quede
+ *     ninguno. Adecuado para datos que se leen mucho y cambian poco
+ *
+ *   Todos esperan con WFE (src/locks.S) y registran en struct lock_stat
+ *   adquisiciones, adquisiciones con contención y espera máxima. Los
+ *   inicializados con nombre aparecen en el comando 'lockstat'.
+ *
+ *   Son locks de contexto de proceso: se mantienen con la expropiación
+ *   desactivada (preempt_disable, ver kernel/preempt.h) pero con las IRQs
+ *   habilitadas. Mientras se tienen NO se puede bloquear (sleep,
+ *   sem_wait, mutex_lock, kprintf...). Desde IRQs y softirqs solo se
+ *   pueden usar los *_trylock(), que nunca esperan.
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ */
+
+#ifndef SPINLOCK_H
+#define SPINLOCK_H
+
+/* ========================================================================== */
+/* FUNCIONES EXTERNAS (Ensamblador)                                         */
+/* ========================================================================== */
+
+/* Spinlocks atómicos (src/locks.S) */
+extern void spin_lock(volatile int *lock);
+extern void spin_unlock(volatile int *lock);
+
+/* Estado de IRQs (DAIF) para secciones anidables (src/entry.S) */
+extern unsigned long local_irq_save(void);
+extern void local_irq_restore(unsigned long flags);
+
+/* ========================================================================== */
+/* VARIANTES IRQSAVE                                                         */
+/* ========================================================================== */
+
+/**
+ * @brief Deshabilita IRQs y adquiere el lock
+ * @param lock Lock a adquirir
+ * @return Estado de IRQs previo (para spin_unlock_irqrestore)
+ */
+static inline unsigned long spin_lock_irqsave(volatile int *lock) {
+    unsigned long flags = local_irq_save();
+    spin_lock(lock);
+    return flags;
+}
+
+/**
+ * @brief Libera el lock y restaura el estado de IRQs previo
+ * @param lock Lock a liberar
+ * @param flags Valor devuelto por spin_lock_irqsave()
+ */
+static inline void spin_unlock_irqrestore(volatile int *lock, unsigned long flags) {
+    spin_unlock(lock);
+    local_irq_restore(flags);
+}
+
+/* ========================================================================== */
+/* ESTADÍSTICAS DE CONTENCIÓN                                                */
+/* ========================================================================== */
+
+/**
+ * @brief Contadores de un lock (se actualizan con el lock tomado)
+ */
+struct lock_stat {
+    const char *name;            /* Nombre en 'lockstat' (nullptr = no registrado) */
+    unsigned long acquisitions;  /* Adquisiciones totales */
+    unsigned long contended;     /* Adquisiciones que tuvieron que esperar */
+    unsigned long failed;        /* Trylocks que encontraron el lock tomado */
+    unsigned long max_spin;      /* Espera máxima (ciclos de CNTPCT) */
+    unsigned long total_spin;    /* Espera acumulada (ciclos de CNTPCT) */
+    struct lock_stat *next;      /* Lista global de locks registrados */
+};
+
+/* ========================================================================== */
+/* TICKET LOCK                                                               */
+/* ========================================================================== */
+
+/**
+ * @brief Ticket lock: owner (bits 0-15) y next (bits 16-31) en una palabra
+ */
+struct ticket_lock {
+    volatile unsigned int val;
+    struct lock_stat stat;
+};
+
+/* ========================================================================== */
+/* MCS LOCK                                                                  */
+/* ========================================================================== */
+
+/**
+ * @brief Nodo de la cola MCS (uno por adquisición, normalmente en el stack)
+ *
+ * @details El layout (next @0, locked @8) lo usa src/locks.S.
+ */
+struct mcs_node {
+    struct mcs_node *volatile next;
+    volatile int locked;
+};
+
+/**
+ * @brief Lock MCS: puntero al último nodo de la cola (nullptr = libre)
+ */
+struct mcs_lock {
+    struct mcs_node *volatile tail;
+    struct lock_stat stat;
+};
+
+/* ========================================================================== */
+/* LOCK DE LECTORES/ESCRITORES                                               */
+/* ========================================================================== */
+
+/**
+ * @brief rwlock: bit 31 = escritor dentro, bits 0-30 = lectores dentro
+ */
+struct rwlock {
+    volatile unsigned int val;
+    struct lock_stat stat;
+};
+
+/* ========================================================================== */
+/* FUNCIONES PUBLICAS                                                        */
+/* ========================================================================== */
+
+/**
+ * @brief Inicializa un ticket lock
+ * @param lock Lock a inicializar
+ * @param name Nombre para 'lockstat' (nullptr = sin registrar)
+ */
+void ticket_lock_init(struct ticket_lock *lock, const char *name);
+
+/**
+ * @brief Adquiere un ticket lock (FIFO, espera con WFE)
+ */
+void ticket_lock(struct ticket_lock *lock);
+
+/**
+ * @brief Libera un ticket lock
+ */
+void ticket_unlock(struct ticket_lock *lock);
+
+/**
+ * @brief Intenta adquirir un ticket lock sin esperar
+ * @return 1 si lo adquirió (liberar con ticket_unlock()), 0 si estaba tomado
+ */
+int ticket_trylock(struct ticket_lock *lock);
+
+/**
+ * @brief Inicializa un lock MCS
+ * @param lock Lock a inicializar
+ * @param name Nombre para 'lockstat' (nullptr = sin registrar)
+ */
+void mcs_lock_init(struct mcs_lock *lock, const char *name);
+
+/**
+ * @brief Adquiere un lock MCS
+ * @param node Nodo del llamador: debe seguir vivo hasta mcs_unlock()
+ */
+void mcs_lock(struct mcs_lock *lock, struct mcs_node *node);
+
+/**
+ * @brief Libera un lock MCS
+ * @param node El mismo nodo que se pasó a mcs_lock()
+ */
+void mcs_unlock(struct mcs_lock *lock, struct mcs_node *node);
+
+/**
+ * @brief Intenta adquirir un lock MCS sin esperar (solo si está libre)
+ * @param node Nodo del llamador: si se adquiere, vivo hasta mcs_unlock()
+ * @return 1 si lo adquirió, 0 si estaba tomado
+ */
+int mcs_trylock(struct mcs_lock *lock, struct mcs_node *node);
+
+/**
+ * @brief Inicializa un rwlock libre
+ * @param lock Lock a inicializar
+ * @param name Nombre para 'lockstat' (nullptr = sin registrar)
+ */
+void rwlock_init(struct rwlock *lock, const char *name);
+
+/**
+ * @brief Entra como lector (espera mientras haya un escritor)
+ */
+void read_lock(struct rwlock *lock);
+
+/**
+ * @brief Sale como lector
+ */
+void read_unlock(struct rwlock *lock);
+
+/**
+ * @brief Entra como escritor (espera a que no haya nadie dentro)
+ */
+void write_lock(struct rwlock *lock);
+
+/**
+ * @brief Sale como escritor
+ */
+void write_unlock(struct rwlock *lock);
+
+/**
+ * @brief Intenta entrar como lector sin esperar
+ * @return 1 si entró (salir con read_unlock()), 0 si hay un escritor
+ */
+int read_trylock(struct rwlock *lock);
+
+/**
+ * @brief Intenta entrar como escritor sin esperar
+ * @return 1 si entró (salir con write_unlock()), 0 si hay alguien dentro
+ */
+int write_trylock(struct rwlock *lock);
+
+/**
+ * @brief Imprime la tabla de estadísticas de los locks registrados
+ */
+void lockstat_print(void);
+
+/**
+ * @brief Pone a cero las estadísticas de todos los locks registrados
+ */
+void lockstat_reset(void);
+
+#endif /* SPINLOCK_H */
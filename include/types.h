@@ -28,4 +28,9 @@ typedef unsigned int       uint32_t;
 /* Entero sin signo de 64 bits (0 a 18,446,744,073,709,551,615) */
 typedef unsigned long      uint64_t;
 
+/* Obtiene la estructura contenedora a partir de un puntero a uno de sus campos
+   (p.ej. de un struct work_struct embebido al objeto que lo contiene) */
+#define container_of(ptr, type, member) \
+    ((type *)((char *)(ptr) - __builtin_offsetof(type, member)))
+
 #endif // TYPES_H
\ No newline at end of file
@@ -162,7 +162,7 @@ void test_semaphores_efficiency(void);
  * @brief Prueba de paginación por demanda (Demand Paging)
  * 
  * @details
- *   Intenta escribir en memoria no mapeada (0x50000000).
+ *   Intenta escribir en memoria no mapeada (DEMAND_VA_BASE).
  *   
  *   CON DEMAND PAGING IMPLEMENTADO:
  *   1. Se produce un Page Fault (Data Abort) controlado
@@ -179,4 +179,221 @@ void test_semaphores_efficiency(void);
  */
 void test_demand(void);
 
+/* ========================================================================== */
+/* PRUEBAS DE TRABAJO DIFERIDO                                              */
+/* ========================================================================== */
+
+/**
+ * @brief Prueba de workqueues y delayed work
+ * 
+ * @details
+ *   Encola un work inmediato en WQ_HIGH y un delayed work en WQ_LOW.
+ *   Verifica que los kworkers los ejecutan (fuera del contexto de IRQ)
+ *   y que un work pendiente no se encola dos veces.
+ */
+void test_workqueue(void);
+
+/* ========================================================================== */
+/* PRUEBAS DE IPC                                                           */
+/* ========================================================================== */
+
+/**
+ * @brief Prueba de IPC síncrono cliente/servidor
+ * 
+ * @details
+ *   Un servidor de eco y un cliente que mide la latencia media de
+ *   ipc_call() (ida y vuelta por hand-off directo).
+ */
+void test_ipc(void);
+
+/**
+ * @brief Prueba de colas de mensajes con transferencia de páginas
+ * 
+ * @details
+ *   Un productor cede páginas por remapeo y un consumidor verifica que
+ *   recibe las mismas páginas físicas (sin copia) con su contenido.
+ */
+void test_msgq(void);
+
+/**
+ * @brief Prueba de checkpoint/restore de procesos
+ * 
+ * @details
+ *   Una plantilla se inicializa y se checkpointea; se restauran varias
+ *   instancias desde la imagen y cada una escribe (copy-on-write) en
+ *   la memoria heredada.
+ */
+void test_checkpoint(void);
+
+/* ========================================================================== */
+/* PRUEBAS DE SINCRONIZACIÓN                                                */
+/* ========================================================================== */
+
+/**
+ * @brief Prueba de ticket locks y locks MCS con estadísticas
+ * 
+ * @details
+ *   Varios workers incrementan contadores protegidos por un ticket lock
+ *   y por un lock MCS; al final se imprime la tabla de 'lockstat'.
+ */
+void test_locks(void);
+
+/**
+ * @brief Prueba de mutex con herencia de prioridad
+ * 
+ * @details
+ *   Un proceso poco urgente retiene el mutex mientras uno urgente lo
+ *   espera: el propietario debe heredar la prioridad del waiter.
+ */
+void test_mutex(void);
+
+/**
+ * @brief Prueba de SYS_FUTEX con mutex de usuario
+ * 
+ * @details
+ *   Varios workers comparten un umutex: el caso sin contención se
+ *   resuelve con LDAXR/STLXR y solo la contención llega al kernel.
+ *   Además, procesos de EL0 (create_user_process) usan un umutex en una
+ *   página de demanda propia y otro en una página compartida.
+ */
+void test_futex(void);
+
+/**
+ * @brief Prueba de rwlock, seqlock y base de tiempos coherente
+ * 
+ * @details
+ *   Un escritor actualiza parejas de contadores mientras dos lectores
+ *   comprueban que nunca las ven a medias.
+ */
+void test_rwlock(void);
+
+/**
+ * @brief Prueba de RCU (rcu_read_lock, call_rcu, synchronize_rcu)
+ * 
+ * @details
+ *   Un escritor sustituye y libera objetos mientras los lectores los
+ *   usan y buscan PIDs y archivos sin tomar locks.
+ */
+void test_rcu(void);
+
+/**
+ * @brief Prueba de las colas sin locks SPSC y MPMC (ring.h)
+ * 
+ * @details
+ *   Productores y consumidores sobre colas pequeñas comprueban orden,
+ *   pérdidas y duplicados.
+ */
+void test_ring(void);
+
+/**
+ * @brief Prueba de atomic.h (contadores, cmpxchg y bitops)
+ * 
+ * @details
+ *   Mide el coste de la implementación activa (LSE o LL/SC) y comprueba
+ *   que varios workers no pierden incrementos ni comparten bits.
+ */
+void test_atomic(void);
+
+/**
+ * @brief Prueba de wait queues, completions y variables de condición
+ * 
+ * @details
+ *   Comprueba timeouts vencidos y no vencidos, complete_all() y un
+ *   búfer acotado productor/consumidor con mutex + condvars.
+ */
+void test_wait(void);
+
+/**
+ * @brief Prueba del buddy allocator del PMM
+ * 
+ * @details
+ *   Pide bloques de varios órdenes, comprueba su alineación y que no se
+ *   solapan, y que al liberarlos las listas vuelven a fusionarse.
+ */
+void test_buddy(void);
+
+/**
+ * @brief Prueba de las cachés de objetos (slab)
+ * 
+ * @details
+ *   Llena varios slabs de una caché con constructor, comprueba que los
+ *   objetos no se solapan y que los slabs vacíos vuelven al buddy.
+ */
+void test_slab(void);
+
+/**
+ * @brief Prueba del heap del kernel (kmalloc/kzalloc/kfree)
+ * 
+ * @details
+ *   Fragmenta el heap con tamaños mezclados, comprueba que al liberar
+ *   todo se fusiona de nuevo y que kzalloc() devuelve memoria a cero.
+ */
+void test_heap(void);
+
+/**
+ * @brief Prueba de los contadores de memoria (meminfo)
+ * 
+ * @details
+ *   Comprueba que bytes en uso, máximo y la tabla de sitios de llamada
+ *   siguen a kmalloc()/kfree(), y que el PMM cuenta sus páginas.
+ */
+void test_meminfo(void);
+
+/**
+ * @brief Prueba de map_range() (bloques de 2MB/1GB y contiguous hint)
+ * 
+ * @details
+ *   Sobre tablas de prueba: comprueba los descriptores elegidos, que
+ *   map_page() parte bloques sin alterar otras traducciones y compara
+ *   el coste de mapear 128MB página a página.
+ */
+void test_map(void);
+
+/**
+ * @brief Prueba del reparto de la RAM (Device Tree + memblock)
+ * 
+ * @details
+ *   Comprueba que kernel, DTB, heap y RamDisk no se solapan y que el
+ *   PMM gestiona el resto de la RAM detectada.
+ */
+void test_memblock(void);
+
+/**
+ * @brief Prueba de espacios de direcciones por proceso (TTBR0 + ASID)
+ * 
+ * @details
+ *   Varios procesos escriben en la misma VA de usuario y comprueban
+ *   tras dormir que cada uno sigue viendo su propio valor.
+ */
+void test_asid(void);
+
+/**
+ * @brief Prueba de la invalidación selectiva de la TLB
+ * 
+ * @details
+ *   Cambia las físicas de una ventana ya cargada en la TLB y comprueba
+ *   que tlb_invalidate_page(), tlb_invalidate_range() y flush_tlb_mm()
+ *   hacen visible el cambio; compara el coste frente a vaciarla entera.
+ */
+void test_tlb(void);
+
+/**
+ * @brief Prueba de fork() con copy-on-write
+ * 
+ * @details
+ *   Un proceso rellena unas páginas y se clona varias veces: cada hijo
+ *   ve sus datos, escribe en ellos sin que le llegue al padre y cada
+ *   fork() cuesta páginas de tablas, no de datos.
+ */
+void test_fork(void);
+
+/**
+ * @brief Prueba de un proceso de usuario real (EL0)
+ * 
+ * @details
+ *   Un proceso de create_user_process() usa su pila y una página de
+ *   demanda: ambas deben llegar con permisos de EL0.
+ */
+void test_user(void);
+
 #endif /* TESTS_H */
\ No newline at end of file
@@ -8,9 +8,12 @@
  *   2. Leemos MPIDR_EL1 para identificar el core
  *   3. Si NO somos core 0 -> loop infinito (WFE)
  *   4. Si SI somos core 0 -> configurar el stack y saltar a kernel()
+ *
+ *   El cargador deja en x0 la dirección del Device Tree (si la hay):
+ *   se conserva en x19 y se guarda en 'boot_dtb' tras limpiar el BSS.
  * 
  * @author Sistema Operativo Educativo BareMetalM4
- * @version 0.4
+ * @version 0.7
  */
 
 .section .text
@@ -29,6 +32,8 @@
  *   3. Cores secundarios entran en bucle WFE (wait-for-event)
  */
 _start:
+    mov x19, x0             /* Puntero al DTB (fdt.c) */
+
     /* PASO 1: Identificar el Core (solo core 0 ejecuta el kernel) */
     mrs x0, MPIDR_EL1       /* Leer ID del procesador */
     and x0, x0, #3          /* Extraer Core ID (bits [1:0]) */
@@ -51,6 +56,9 @@ clear_bss_loop:
     cbnz x2, clear_bss_loop /* Si no es 0, repetir */
 
 run_kernel:
+    ldr x0, =boot_dtb       /* En el BSS: se escribe ya limpio */
+    str x19, [x0]
+
     /* PASO 3: Saltar a codigo C */
     bl kernel               /* Branch with Link a kernel() */
 
@@ -16,14 +16,21 @@
  *   - FIFO control (asumimos que siempre acepta datos)
  *   - Interrupciones (polling en lugar de event-driven)
  * 
+ *   ENTRADA DE TECLADO:
+ *   La IRQ de la UART (productor) y el shell (consumidor) se comunican
+ *   por una cola SPSC sin locks (ring.h). El lector duerme en kb_wait
+ *   (uart_getc) y el IRQ lo despierta al encolar.
+ * 
  * @author Sistema Operativo Educativo
- * @version 0.6
+ * @version 0.7
  * @see io.h para interfaz pública
  */
 
 #include <stdarg.h>
 #include "../../include/drivers/io.h"
-#include "../../include/semaphore.h"
+#include "../../include/mutex.h"
+#include "../../include/ring.h"
+#include "../../include/kernel/wait.h"
 
 /* Registro base de la UART en QEMU virt (0x09000000) */
 volatile unsigned int * const UART0_DIR = (unsigned int *)0x09000000;
@@ -34,8 +41,9 @@ volatile unsigned int * const UART0_FR   = (unsigned int *)0x09000018; /* Flag R
 volatile unsigned int * const UART0_IMSC = (unsigned int *)0x09000038; /* Interrupt Mask Set/Clear */
 volatile unsigned int * const UART0_ICR  = (unsigned int *)0x09000044; /* Interrupt Clear Register */
 
-/* Semaforos para la consola */
-struct semaphore console_mutex;
+/* Mutex de la consola (con herencia de prioridad: un proceso poco
+   urgente imprimiendo no retiene indefinidamente a los urgentes) */
+struct mutex console_mutex;
 int console_mutex_init = 0;
 
 /**
@@ -58,11 +66,19 @@ void uart_puts(const char *s) {
 /* BUFFER CIRCULAR DE TECLADO                                                */
 /* ========================================================================== */
 
-#define KB_BUFFER_SIZE 128
+#define KB_BUFFER_SIZE 128  /* Potencia de 2 */
+#define KB_IRQ_BATCH   16   /* Caracteres por publicación desde la IRQ */
+
+/* Productor: uart_handle_irq(). Consumidor: uart_getc_nonblocking().
+   Inicializada estáticamente: válida antes de habilitar la IRQ. */
+static unsigned long kb_slots[KB_BUFFER_SIZE];
+static struct spsc_ring kb_ring = {
+    .mask = KB_BUFFER_SIZE - 1,
+    .slots = kb_slots,
+};
 
-volatile char kb_buffer[KB_BUFFER_SIZE];
-volatile int kb_head = 0; /* Donde escribe la interrupción */
-volatile int kb_tail = 0; /* Donde lee el Shell */
+/* Lectores esperando tecla (uart_getc) */
+static struct wait_queue_head kb_wait = WAIT_QUEUE_HEAD_INIT;
 
 /* ========================================================================== */
 /* INTERRUPCIONES UART                                                       */
@@ -86,21 +102,27 @@ void uart_irq_init() {
  * @details
  *   Esta función la llama el GIC cuando detecta ID 33 (UART RX).
  *   Lee todos los caracteres disponibles en el FIFO de recepción
- *   y los almacena en el buffer circular.
+ *   y los publica en la cola de teclado en lotes de KB_IRQ_BATCH
+ *   (una sola publicación de head por lote). Si la cola está llena,
+ *   los caracteres sobrantes se descartan.
  */
 void uart_handle_irq() {
+    unsigned long batch[KB_IRQ_BATCH];
+    unsigned long n;
+
     /* Bucle: Leemos mientras el bit 4 de Flags (RXFE - RX FIFO Empty) sea 0.
        Es decir: "Mientras NO esté vacío, lee". */
-    
-    while ( !(*UART0_FR & (1 << 4)) ) {
-        char c = (char)(*UART0_DR);
-
-        /* Guardar en buffer circular */
-        int next = (kb_head + 1) % KB_BUFFER_SIZE;
-        if (next != kb_tail) {
-            kb_buffer[kb_head] = c;
-            kb_head = next;
+    do {
+        n = 0;
+        while (n < KB_IRQ_BATCH && !(*UART0_FR & (1 << 4))) {
+            batch[n++] = (unsigned char)(*UART0_DR);
         }
+        spsc_ring_enqueue_burst(&kb_ring, batch, n);
+    } while (n == KB_IRQ_BATCH);
+
+    /* Despertar al lector: se ejecutará a la salida de este IRQ */
+    if (spsc_ring_count(&kb_ring) > 0) {
+        wake_up(&kb_wait);
     }
 
     /* Limpiar interrupciones: Recepción (bit 4) y Timeout (bit 6) */
@@ -113,15 +135,28 @@ void uart_handle_irq() {
  * @return Carácter leído, o 0 si el buffer está vacío
  * 
  * @details
- *   Lee del buffer circular alimentado por uart_handle_irq().
+ *   Lee de la cola alimentada por uart_handle_irq().
  *   No bloquea si no hay datos disponibles.
  */
 char uart_getc_nonblocking() {
-    if (kb_head == kb_tail) return 0; // Buffer vacio
+    unsigned long c;
+
+    if (spsc_ring_dequeue(&kb_ring, &c) != 0) return 0; // Cola vacía
+    return (char)c;
+}
 
-    char c = kb_buffer[kb_tail];
-    kb_tail = (kb_tail + 1) % KB_BUFFER_SIZE;
-    return c;
+/**
+ * @brief Lee un carácter del teclado, bloqueando si no hay ninguno
+ *
+ * @return Carácter leído
+ */
+char uart_getc(void) {
+    unsigned long c;
+
+    while (spsc_ring_dequeue(&kb_ring, &c) != 0) {
+        wait_event(kb_wait, spsc_ring_count(&kb_ring) > 0);
+    }
+    return (char)c;
 }
 
 /**
@@ -179,11 +214,11 @@ void print_num(long val, int base) {
 void kprintf(const char *fmt, ...) {
     /* Inicialización Lazy (la primera vez que alguien imprime) */
     if (!console_mutex_init) {
-        sem_init(&console_mutex, 1); /* 1 = Mutex (desbloqueado) */
+        mutex_init(&console_mutex, "console");
         console_mutex_init = 1;
     }
 
-    sem_wait(&console_mutex);
+    mutex_lock(&console_mutex);
 
     va_list args;
     va_start(args, fmt);
@@ -234,5 +269,5 @@ void kprintf(const char *fmt, ...) {
     }
     va_end(args);
 
-    sem_signal(&console_mutex);
+    mutex_unlock(&console_mutex);
 }
\ No newline at end of file
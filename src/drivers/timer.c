@@ -40,12 +40,13 @@
  *      - CRÍTICO: avisa al GIC que terminamos
  *   8. handle_timer_irq() recargar CNTP_TVAL_EL0
  *      - Timer estará listo para siguiente tick
- *   9. handle_timer_irq() llama a schedule()
- *      - Planificador elige siguiente proceso
- *   10. schedule() llama a cpu_switch_to()
- *       - Context switch (puede cambiar de proceso)
- *   11. irq_handler_stub() restaura registros
- *   12. ERET: vuelve al proceso (posiblemente otro)
+ *   9. handle_timer_irq() marca need_reschedule
+ *   10. irq_handler_stub() llama a do_softirq()
+ *       - Trabajo diferido (wake-ups) con IRQs habilitadas
+ *   11. irq_handler_stub() llama a schedule()
+ *       - Planificador elige siguiente proceso (cpu_switch_to)
+ *   12. irq_handler_stub() restaura registros
+ *   13. ERET: vuelve al proceso (posiblemente otro)
  *   @endcode
  * 
  * @author Sistema Operativo Educativo
@@ -56,13 +57,14 @@
 #include "../../include/drivers/timer.h"
 #include "../../include/drivers/io.h"
 #include "../../include/types.h"
+#include "../../include/kernel/softirq.h"
+#include "../../include/kernel/scheduler.h"
 
 /* Definimos GICD_ISENABLER para habilitar IDs */
 /* ID 0-31 están en ISENABLER0 (Offset 0x100) */
 /* ID 32-63 están en ISENABLER1 (Offset 0x104) */
 #define GICD_ISENABLER1 ((volatile uint32_t *)(GICD_BASE + 0x104))
 
-extern void timer_tick();
 
 /* Inicializa el sistema de interrupciones y el timer del sistema */
 void timer_init() {
@@ -87,6 +89,9 @@ void timer_init() {
     /* PASO 4: Configurar UART Hardware para interrumpir */
     uart_irq_init();
 
+    /* PASO 4b: Mitad "soft" del timer (wake-ups y delayed work) */
+    open_softirq(SOFTIRQ_TIMER, timer_softirq);
+
     /* PASO 5: Habilitar interrupciones en el CPU */
     enable_interrupts();
 }
@@ -101,8 +106,10 @@ void timer_init() {
  *   3. Recarga el contador del timer (TIMER_INTERVAL)
  *   4. Llama a timer_tick() que:
  *      - Decrementa el quantum del proceso actual
- *      - Marca need_reschedule=1 si el quantum llega a 0
- *   5. Llama a schedule() que ejecuta el Round-Robin scheduler
+ *      - Marca SOFTIRQ_TIMER si hay procesos/trabajo que despertar
+ *   5. Marca need_reschedule: irq_handler_stub llamará a schedule()
+ *      DESPUÉS de ejecutar las softirqs, para que los procesos recién
+ *      despertados ya compitan en esta misma elección
  */
 void handle_timer_irq() {
     /* Leer Interrupt Acknowledge Register */
@@ -122,12 +129,35 @@ void handle_timer_irq() {
         /* Actualizar sistema de tiempo */
         timer_tick();
         
-        /* Llamar al scheduler para cambio de contexto */
-        schedule();
+        /* Pedir cambio de contexto a la salida del IRQ */
+        need_reschedule = 1;
     } else if (id == 33) {
         /* Es el Teclado (UART) */
         uart_handle_irq();
         /* No necesitamos llamar a schedule() obligatoriamente aquí, 
            simplemente volvemos a lo que estábamos haciendo */
     }
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Tiempo desde el arranque en microsegundos
+ *
+ * @details
+ *   Interpola entre ticks con CNTPCT. La parte de subtick se acota a
+ *   TIMER_INTERVAL - 1: si el IRQ llega tarde, el valor se congela hasta
+ *   el tick en vez de saltar hacia atrás.
+ */
+unsigned long timer_uptime_us(void) {
+    unsigned long stamp;
+    unsigned long ticks = sys_time_read(&stamp);
+
+    unsigned long delta = timer_get_count() - stamp;
+    if (delta >= TIMER_INTERVAL) {
+        delta = TIMER_INTERVAL - 1;
+    }
+
+    unsigned long mhz = timer_get_freq() / 1000000;
+    if (mhz == 0) mhz = 1;
+
+    return (ticks * TIMER_INTERVAL + delta) / mhz;
+}
@@ -6,11 +6,27 @@
  * - Superbloque global
  * - Gestión de iNodos
  * - Creación y listado de ficheros
+ *
+ * CONCURRENCIA:
+ * - ram_disk.lock (rwlock): vfs_ls y vfs_read entran como lectores y
+ *   pueden ejecutarse a la vez; vfs_create, vfs_write y vfs_remove
+ *   entran como escritores
+ * - vfs_open busca el nombre con RCU (sin locks ni escrituras):
+ *   vfs_create publica el iNodo (is_used = INODE_USED) después de
+ *   escribir el nombre, y vfs_remove lo retira (INODE_DYING) y espera
+ *   un periodo de gracia antes de borrarlo y dejarlo libre
+ * - fd_lock (spinlock): ocupación/liberación de fd_table
+ * - Los mensajes se imprimen con los locks ya liberados: kprintf()
+ *   puede dormir en el mutex de la consola
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
  */
 
 #include "../../include/fs/vfs.h"
 #include "../../include/utils/kutils.h"
 #include "../../include/drivers/io.h"
+#include "../../include/kernel/rcu.h"
 
 /* ========================================================================== */
 /* EL DISCO DURO VIRTUAL (Variable Global)                                   */
@@ -21,6 +37,7 @@ static superblock_t ram_disk;
 /* TABLA DE FICHEROS ABIERTOS (FILE DESCRIPTORS)                             */
 /* ========================================================================== */
 static file_t fd_table[MAX_FILES];
+static volatile int fd_lock = 0;
 
 /* ========================================================================== */
 /* FUNCIONES DEL SISTEMA DE FICHEROS                                         */
@@ -37,11 +54,12 @@ void ramfs_init(unsigned long start_addr, unsigned long size) {
     ram_disk.start_addr = start_addr;
     ram_disk.total_size = size;
     ram_disk.free_inodes = MAX_FILES;
+    rwlock_init(&ram_disk.lock, "ramfs");
 
     /* Limpiar todos los iNodos (marcarlos como libres) */
     for (int i = 0; i < MAX_FILES; i++) {
         ram_disk.inodes[i].id = i;
-        ram_disk.inodes[i].is_used = 0;
+        ram_disk.inodes[i].is_used = INODE_FREE;
         ram_disk.inodes[i].size = 0;
         ram_disk.inodes[i].type = FS_FILE;
         memset(ram_disk.inodes[i].name, 0, sizeof(ram_disk.inodes[i].name));
@@ -58,14 +76,21 @@ void ramfs_init(unsigned long start_addr, unsigned long size) {
  * @return 0 si éxito, -1 si error (disco lleno o nombre duplicado)
  */
 int vfs_create(const char *name) {
+    int result = -1;
+    int inode_id = -1;
+
+    write_lock(&ram_disk.lock);
+
     if (ram_disk.free_inodes <= 0) {
+        write_unlock(&ram_disk.lock);
         kprintf("[VFS] Error: Disco lleno (No quedan iNodos)\n");
         return -1;
     }
 
     /* 1. Comprobar que no existe un archivo con ese nombre */
     for (int i = 0; i < MAX_FILES; i++) {
-        if (ram_disk.inodes[i].is_used && k_strcmp(ram_disk.inodes[i].name, name) == 0) {
+        if (ram_disk.inodes[i].is_used == INODE_USED && k_strcmp(ram_disk.inodes[i].name, name) == 0) {
+            write_unlock(&ram_disk.lock);
             kprintf("[VFS] Error: El archivo '%s' ya existe.\n", name);
             return -1;
         }
@@ -73,9 +98,8 @@ int vfs_create(const char *name) {
 
     /* 2. Buscar el primer iNodo libre */
     for (int i = 0; i < MAX_FILES; i++) {
-        if (!ram_disk.inodes[i].is_used) {
+        if (ram_disk.inodes[i].is_used == INODE_FREE) {
             /* Encontrado, ocupar iNodo */
-            ram_disk.inodes[i].is_used = 1;
             ram_disk.inodes[i].size = 0; /* El archivo está vacío */
 
             /* Copiar nombre (con límite de seguridad) */
@@ -85,16 +109,32 @@ int vfs_create(const char *name) {
             for (int c = 0; c < name_len; c++) ram_disk.inodes[i].name[c] = name[c];
             ram_disk.inodes[i].name[name_len] = '\0';
 
+            /* Publicar: vfs_open() (sin lock) ya puede encontrarlo */
+            smp_wmb();
+            WRITE_ONCE(ram_disk.inodes[i].is_used, INODE_USED);
+
             ram_disk.free_inodes--;
-            kprintf("[VFS] Archivo '%s' creado con éxito (Inodo %d).\n", name, i);
-            return 0;
+            inode_id = i;
+            result = 0;
+            break;
         }
     }
-    return -1;
+
+    write_unlock(&ram_disk.lock);
+
+    if (result == 0) {
+        kprintf("[VFS] Archivo '%s' creado con éxito (Inodo %d).\n", name, inode_id);
+    }
+    return result;
 }
 
 /**
  * @brief Lista los archivos del directorio raíz (comando 'ls')
+ *
+ * @details
+ *   Cada iNodo se copia con el lock de lectura tomado y se imprime ya
+ *   sin él: cada fila es coherente (nombre y tamaño del mismo archivo)
+ *   y los escritores no esperan a la UART.
  */
 void vfs_ls(void) {
     kprintf("\nID  |   Size (Bytes)   | Name\n");
@@ -102,11 +142,17 @@ void vfs_ls(void) {
 
     int count = 0;
     for (int i = 0; i < MAX_FILES; i++) {
-        if (ram_disk.inodes[i].is_used) {
+        inode_t copy;
+
+        read_lock(&ram_disk.lock);
+        copy = ram_disk.inodes[i];
+        read_unlock(&ram_disk.lock);
+
+        if (copy.is_used == INODE_USED) {
             kprintf("%d   |   %d              | %s\n",
-                    ram_disk.inodes[i].id,
-                    ram_disk.inodes[i].size,
-                    ram_disk.inodes[i].name);
+                    copy.id,
+                    copy.size,
+                    copy.name);
             count++;
         }
     }
@@ -120,32 +166,52 @@ void vfs_ls(void) {
 /**
  * @brief Abre un archivo y devuelve un File Descriptor (FD)
  * @return FD (índice >= 0) o -1 si error
+ *
+ * @details
+ *   La búsqueda por nombre es una lectura RCU: no toma ram_disk.lock ni
+ *   escribe en memoria compartida. Mientras dure, vfs_remove() no puede
+ *   reutilizar el iNodo encontrado.
  */
 int vfs_open(const char *name) {
     inode_t *target_inode = nullptr;
+    int fd = -1;
+
+    rcu_read_lock();
 
     /* 1. Buscar el iNodo por nombre */
     for (int i = 0; i < MAX_FILES; i++) {
-        if (ram_disk.inodes[i].is_used && k_strcmp(ram_disk.inodes[i].name, name) == 0) {
-            target_inode = &ram_disk.inodes[i];
+        inode_t *inode = &ram_disk.inodes[i];
+        if (READ_ONCE(inode->is_used) != INODE_USED) continue;
+
+        smp_rmb();   /* Leer el nombre después de ver el iNodo publicado */
+        if (k_strcmp(inode->name, name) == 0) {
+            target_inode = inode;
             break;
         }
     }
 
+    /* 2. Buscar un slot libre en la tabla de File Descriptors
+          (aún dentro de la sección RCU: el iNodo no puede liberarse) */
+    if (target_inode != nullptr) {
+        unsigned long flags = spin_lock_irqsave(&fd_lock);
+        for (int i = 0; i < MAX_FILES; i++) {
+            if (fd_table[i].inode == nullptr) {
+                fd_table[i].inode = target_inode;
+                fd_table[i].position = 0; /* Empezamos a leer/escribir desde el principio */
+                fd = i;
+                break;
+            }
+        }
+        spin_unlock_irqrestore(&fd_lock, flags);
+    }
+
+    rcu_read_unlock();
+
     if (target_inode == nullptr) {
         kprintf("[VFS] Error: Archivo '%s' no encontrado.\n", name);
         return -1;
     }
-
-    /* 2. Buscar un slot libre en la tabla de File Descriptors */
-    for (int i = 0; i < MAX_FILES; i++) {
-        if (fd_table[i].inode == nullptr) {
-            fd_table[i].inode = target_inode;
-            fd_table[i].position = 0; /* Empezamos a leer/escribir desde el principio */
-            return i; /* Devolvemos el número de FD */
-        }
-    }
-    return -1; /* Demasiados archivos abiertos */
+    return fd; /* Número de FD, o -1 si hay demasiados archivos abiertos */
 }
 
 /**
@@ -163,6 +229,8 @@ int vfs_write(const int fd, const char *buf, int count) {
 
     if (bytes_to_write <= 0) return 0;
 
+    write_lock(&ram_disk.lock);
+
     /* Escribir en la memoria RAM directamente (usando el data_ptr del iNodo) */
     char *dest = (char *)(inode->data_ptr + file->position);
     for (int i = 0; i < bytes_to_write; i++) {
@@ -175,6 +243,8 @@ int vfs_write(const int fd, const char *buf, int count) {
         inode->size = file->position;
     }
 
+    write_unlock(&ram_disk.lock);
+
     return bytes_to_write;
 }
 
@@ -187,11 +257,16 @@ int vfs_read(const int fd, char *buf, int count) {
     file_t *file = &fd_table[fd];
     inode_t *inode = file->inode;
 
+    read_lock(&ram_disk.lock);
+
     /* Calcular cuánto podemos leer (no podemos leer más allá del tamaño del archivo) */
     int bytes_left = inode->size - file->position;
     int bytes_to_read = (count > bytes_left) ? bytes_left : count;
 
-    if (bytes_to_read <= 0) return 0; /* Fin de archivo (EOF) */
+    if (bytes_to_read <= 0) {
+        read_unlock(&ram_disk.lock);
+        return 0; /* Fin de archivo (EOF) */
+    }
 
     /* Leer desde la memoria RAM */
     char *src = (char *)(inode->data_ptr + file->position);
@@ -199,6 +274,8 @@ int vfs_read(const int fd, char *buf, int count) {
         buf[i] = src[i];
     }
 
+    read_unlock(&ram_disk.lock);
+
     file->position += bytes_to_read;
     return bytes_to_read;
 }
@@ -210,34 +287,59 @@ int vfs_close(int fd) {
     if (fd < 0 || fd >= MAX_FILES || fd_table[fd].inode == nullptr) return -1;
 
     /* Limpiar el slot para que pueda ser reutilizado */
+    unsigned long flags = spin_lock_irqsave(&fd_lock);
     fd_table[fd].inode = nullptr;
     fd_table[fd].position = 0;
+    spin_unlock_irqrestore(&fd_lock, flags);
     return 0;
 }
 
 /**
  * @brief Elimina un archivo del disco (Libera el Inodo)
+ *
+ * @details
+ *   1. Retirarlo (INODE_DYING): vfs_open() y vfs_ls() ya no lo ven
+ *   2. synchronize_rcu(): esperar a los vfs_open() que lo encontraron
+ *   3. Borrar nombre y datos y devolverlo como INODE_FREE
  */
 int vfs_remove(const char *name) {
-    for (int i = 0; i < MAX_FILES; i++) {
-        if (ram_disk.inodes[i].is_used && k_strcmp(ram_disk.inodes[i].name, name) == 0) {
-            /* 1. Marcar inodo como libre */
-            ram_disk.inodes[i].is_used = 0;
-            ram_disk.inodes[i].size = 0;
+    inode_t *victim = nullptr;
 
-            /* 2. Borrar el nombre (opcional de seguridad) */
-            memset(ram_disk.inodes[i].name, 0, FILE_NAME_LEN);
+    write_lock(&ram_disk.lock);
 
-            /* 3. Limpiar los datos físicos en RAM (security zeroing) */
-            memset((void*)ram_disk.inodes[i].data_ptr, 0, MAX_FILE_SIZE);
-
-            /* 4. Añadir el iNodo libre al contador */
-            ram_disk.free_inodes++;
-            kprintf("[VFS] Archivo '%s' eliminado.\n", name);
-            return 0;
+    for (int i = 0; i < MAX_FILES; i++) {
+        if (ram_disk.inodes[i].is_used == INODE_USED && k_strcmp(ram_disk.inodes[i].name, name) == 0) {
+            victim = &ram_disk.inodes[i];
+            WRITE_ONCE(victim->is_used, INODE_DYING);
+            break;
         }
     }
-    kprintf("[VFS] Error: Archivo '%s' no existe.\n", name);
-    return -1;
-}
 
+    write_unlock(&ram_disk.lock);
+
+    if (victim == nullptr) {
+        kprintf("[VFS] Error: Archivo '%s' no existe.\n", name);
+        return -1;
+    }
+
+    /* Ningún lector RCU puede seguir usando el iNodo tras esto */
+    synchronize_rcu();
+
+    write_lock(&ram_disk.lock);
+
+    /* 1. Borrar el nombre (opcional de seguridad) */
+    victim->size = 0;
+    memset(victim->name, 0, FILE_NAME_LEN);
+
+    /* 2. Limpiar los datos físicos en RAM (security zeroing) */
+    memset((void*)victim->data_ptr, 0, MAX_FILE_SIZE);
+
+    /* 3. Marcar inodo como libre y añadirlo al contador */
+    victim->is_used = INODE_FREE;
+    ram_disk.free_inodes++;
+
+    write_unlock(&ram_disk.lock);
+
+    kprintf("[VFS] Archivo '%s' eliminado.\n", name);
+    return 0;
+}
@@ -0,0 +1,268 @@
+/**
+ * @file checkpoint.c
+ * @brief Implementación de checkpoint/restore de procesos
+ *
+ * @details
+ *   CHECKPOINT (process_checkpoint):
+ *   1. ckpt_save_context() captura x19-x29, LR y SP (como setjmp)
+ *   2. Se copia el stack usado [SP, cima) detrás de la cabecera
+ *   3. Las páginas de demand paging pasan a solo lectura y la imagen
+ *      toma una referencia (page_get) sobre cada marco
+ *   4. Cabecera + stack se escriben en un fichero de RamFS
+ *
+ *   RESTORE (process_restore):
+ *   1. process_alloc() reserva PCB y stack
+ *   2. Se copia el stack a la misma distancia de la cima del nuevo
+ *   3. REUBICACIÓN: cualquier palabra del stack o registro que apunte
+ *      dentro del stack original se desplaza al nuevo (frame records,
+ *      punteros a variables locales)
+ *   4. El contexto reubicado se deja bajo el SP y el proceso arranca en
+ *      ckpt_resume, que "vuelve" de ckpt_save_context con 1
+ *   5. Las páginas de la imagen se mapean de solo lectura en la tabla
+ *      base de la instancia: cada una tiene su espacio de direcciones y
+ *      su primera escritura crea una copia privada (COW)
+ *
+ *   La reubicación es conservadora: un entero que por casualidad caiga
+ *   en el rango del stack original también se desplazaría.
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ */
+
+#include "../../include/kernel/checkpoint.h"
+#include "../../include/kernel/process.h"
+#include "../../include/fs/vfs.h"
+#include "../../include/mm/malloc.h"
+#include "../../include/mm/mm.h"
+#include "../../include/mm/pmm.h"
+#include "../../include/mm/vmm.h"
+#include "../../include/mm/asid.h"
+#include "../../include/utils/kutils.h"
+#include "../../include/drivers/io.h"
+
+/* ========================================================================== */
+/* FUNCIONES EXTERNAS (Ensamblador)                                         */
+/* ========================================================================== */
+
+/* Captura de contexto (src/entry.S): 0 al guardar, 1 al restaurar */
+extern int ckpt_save_context(struct cpu_context *ctx) __attribute__((returns_twice));
+
+/* Punto de entrada de las instancias restauradas (src/entry.S) */
+extern void ckpt_resume(void);
+
+/* Tamaño del stack de cada proceso (ver process_alloc) */
+#define CKPT_STACK_SIZE 4096
+
+/* Hueco reservado bajo el SP para el contexto que lee ckpt_resume */
+#define CKPT_RESUME_FRAME ((sizeof(struct cpu_context) + 15) & ~15UL)
+
+/* Parte del descriptor L3 que es dirección física */
+#define CKPT_PHYS_MASK 0xFFFFFFFFF000UL
+
+/* ========================================================================== */
+/* FUNCIONES AUXILIARES                                                      */
+/* ========================================================================== */
+
+/**
+ * @brief Lee una imagen completa de RamFS a un buffer de kmalloc
+ * @return Cabecera (el stack va a continuación) o nullptr si no es válida
+ */
+static struct ckpt_header *ckpt_load(const char *name) {
+    struct ckpt_header *hdr = (struct ckpt_header *)kmalloc(MAX_FILE_SIZE);
+    if (!hdr) return nullptr;
+
+    int fd = vfs_open(name);
+    if (fd < 0) {
+        kfree(hdr);
+        return nullptr;
+    }
+
+    int n = vfs_read(fd, (char *)hdr, MAX_FILE_SIZE);
+    vfs_close(fd);
+
+    if (n < (int)sizeof(struct ckpt_header) || hdr->magic != CKPT_MAGIC ||
+        sizeof(struct ckpt_header) + hdr->stack_len != (unsigned long)n) {
+        kprintf("[CKPT] Error: '%s' no es una imagen válida\n", name);
+        kfree(hdr);
+        return nullptr;
+    }
+
+    return hdr;
+}
+
+/**
+ * @brief Desplaza 'val' si apunta dentro del stack original
+ */
+static inline unsigned long ckpt_relocate(unsigned long val, unsigned long old_top, long delta) {
+    if (val >= old_top - CKPT_STACK_SIZE && val <= old_top) {
+        return val + delta;
+    }
+    return val;
+}
+
+/**
+ * @brief Completa la imagen y la escribe (parte "no setjmp" del checkpoint)
+ *
+ * @details
+ *   Va en una función aparte (noinline) para que su frame quede POR
+ *   DEBAJO del SP capturado: así no modifica el stack que se guarda.
+ */
+static __attribute__((noinline)) long ckpt_write(struct ckpt_header *hdr, const char *name) {
+    struct pcb *me = current_process;
+
+    if (me->stack_addr == 0) {
+        kprintf("[CKPT] Error: El PID %d no tiene stack propio\n", me->pid);
+        return -1;
+    }
+
+    hdr->magic = CKPT_MAGIC;
+    hdr->priority = me->priority;
+    k_strncpy(hdr->name, me->name, 16);
+    hdr->stack_top = me->stack_addr + CKPT_STACK_SIZE;
+    hdr->stack_len = hdr->stack_top - hdr->ctx.sp;
+
+    unsigned long size = sizeof(struct ckpt_header) + hdr->stack_len;
+    if (size > MAX_FILE_SIZE || hdr->stack_len + CKPT_RESUME_FRAME > CKPT_STACK_SIZE) {
+        kprintf("[CKPT] Error: Stack demasiado grande (%d bytes)\n", hdr->stack_len);
+        return -1;
+    }
+
+    /* 1. Stack usado */
+    memcpy((char *)(hdr + 1), (void *)hdr->ctx.sp, hdr->stack_len);
+
+    /* 2. Páginas: compartir COW (solo lectura + referencia de la imagen) */
+    hdr->nr_pages = 0;
+    for (int i = 0; i < me->nr_vm_pages; i++) {
+        unsigned long *pte = vmm_get_pte(me->pgd, me->vm_pages[i]);
+        if (pte == nullptr || !(*pte & 1)) continue;
+
+        *pte |= MM_RO;
+        page_get(*pte & CKPT_PHYS_MASK);
+
+        hdr->page_va[hdr->nr_pages] = me->vm_pages[i];
+        hdr->page_desc[hdr->nr_pages] = *pte;
+        hdr->nr_pages++;
+    }
+    /* Páginas sueltas por todo el espacio del proceso: basta con su ASID */
+    flush_tlb_mm(me);
+
+    /* 3. Escribir en RamFS */
+    int fd = -1;
+    if (vfs_create(name) == 0) {
+        fd = vfs_open(name);
+    }
+    if (fd < 0 || vfs_write(fd, (const char *)hdr, (int)size) != (int)size) {
+        if (fd >= 0) {
+            vfs_close(fd);
+            vfs_remove(name);
+        }
+        for (int i = 0; i < hdr->nr_pages; i++) {
+            page_put(hdr->page_desc[i] & CKPT_PHYS_MASK);
+        }
+        return -1;
+    }
+    vfs_close(fd);
+
+    kprintf("[CKPT] Imagen '%s': %d bytes de stack, %d paginas COW\n",
+            name, hdr->stack_len, hdr->nr_pages);
+    return 0;
+}
+
+/* ========================================================================== */
+/* CHECKPOINT                                                                */
+/* ========================================================================== */
+
+/**
+ * @brief Guarda una imagen del proceso actual
+ *
+ * @details
+ *   Las instancias restauradas reanudan justo tras ckpt_save_context()
+ *   con valor 1 y retornan inmediatamente (no tocan 'hdr', que pertenece
+ *   al proceso original).
+ */
+long process_checkpoint(const char *name) {
+    struct ckpt_header *hdr = (struct ckpt_header *)kzalloc(MAX_FILE_SIZE);
+    if (!hdr) return -1;
+
+    if (ckpt_save_context(&hdr->ctx) != 0) {
+        return 1;
+    }
+
+    long ret = ckpt_write(hdr, name);
+    kfree(hdr);
+    return ret;
+}
+
+/* ========================================================================== */
+/* RESTORE                                                                   */
+/* ========================================================================== */
+
+/**
+ * @brief Crea una instancia a partir de una imagen
+ */
+long process_restore(const char *name) {
+    struct ckpt_header *hdr = ckpt_load(name);
+    if (!hdr) return -1;
+
+    long pid = process_alloc(hdr->priority, hdr->name);
+    if (pid < 0) {
+        kfree(hdr);
+        return -1;
+    }
+
+    struct pcb *p = &process[pid];
+    unsigned long new_top = p->stack_addr + CKPT_STACK_SIZE;
+    long delta = (long)(new_top - hdr->stack_top);
+
+    /* 1. Copiar el stack a la misma distancia de la cima y reubicarlo */
+    unsigned long new_sp = new_top - hdr->stack_len;
+    memcpy((void *)new_sp, (char *)(hdr + 1), hdr->stack_len);
+
+    unsigned long *word = (unsigned long *)new_sp;
+    for (unsigned long i = 0; i < hdr->stack_len / sizeof(unsigned long); i++) {
+        word[i] = ckpt_relocate(word[i], hdr->stack_top, delta);
+    }
+
+    /* 2. Contexto reubicado bajo el SP (lo consume ckpt_resume) */
+    struct cpu_context *ctx = (struct cpu_context *)(new_sp - CKPT_RESUME_FRAME);
+    *ctx = hdr->ctx;
+    unsigned long *reg = (unsigned long *)ctx;
+    for (int i = 0; i <= 10; i++) {   /* x19-x28 y fp */
+        reg[i] = ckpt_relocate(reg[i], hdr->stack_top, delta);
+    }
+    ctx->sp = new_sp;
+
+    p->context.sp = (unsigned long)ctx;
+    p->context.pc = (unsigned long)ckpt_resume;
+
+    /* 3. Páginas COW: el marco de la imagen, de solo lectura, en el
+          espacio de direcciones (vacío) de la instancia */
+    for (int i = 0; i < hdr->nr_pages; i++) {
+        unsigned long va = hdr->page_va[i];
+        unsigned long phys = hdr->page_desc[i] & CKPT_PHYS_MASK;
+
+        page_get(phys);
+        map_page(p->pgd, va, phys, (hdr->page_desc[i] & ~CKPT_PHYS_MASK) | MM_RO);
+        p->vm_pages[p->nr_vm_pages++] = va;
+    }
+
+    kfree(hdr);
+
+    p->state = PROCESS_READY;
+    return pid;
+}
+
+/**
+ * @brief Borra una imagen y suelta sus referencias a las páginas
+ */
+int ckpt_delete(const char *name) {
+    struct ckpt_header *hdr = ckpt_load(name);
+    if (!hdr) return -1;
+
+    for (int i = 0; i < hdr->nr_pages; i++) {
+        page_put(hdr->page_desc[i] & CKPT_PHYS_MASK);
+    }
+
+    kfree(hdr);
+    return vfs_remove(name);
+}
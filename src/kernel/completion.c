@@ -0,0 +1,122 @@
+/**
+ * @file completion.c
+ * @brief Implementación de completions y variables de condición
+ *
+ * @details
+ *   Ambas se apoyan en wait_queue_block() (wait.c) y comprueban su
+ *   estado con las IRQs deshabilitadas, igual que wait_event().
+ *
+ *   COMPLETION:
+ *   - 'done' cuenta avisos; quien espera consume uno
+ *   - complete_all() lo fija en COMPLETION_DONE_ALL, que no se consume
+ *
+ *   CONDVAR:
+ *   - cond_wait(): IRQs fuera -> mutex_unlock() -> bloquearse ->
+ *     IRQs como estaban -> mutex_lock(). mutex_unlock() no cede la CPU,
+ *     así que nadie puede señalizar entre soltar y bloquearse
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ * @see completion.h para interfaz pública
+ */
+
+#include "../../include/kernel/completion.h"
+
+/* ========================================================================== */
+/* COMPLETIONS                                                               */
+/* ========================================================================== */
+
+void init_completion(struct completion *c) {
+    c->done = 0;
+    init_waitqueue_head(&c->wait);
+}
+
+void reinit_completion(struct completion *c) {
+    c->done = 0;
+}
+
+/**
+ * @brief Espera común (IRQs deshabilitadas durante toda la comprobación)
+ */
+static long completion_wait(struct completion *c, long timeout) {
+    unsigned long flags = local_irq_save();
+
+    while (c->done == 0 && timeout > 0) {
+        timeout = wait_queue_block(&c->wait, timeout);
+    }
+
+    long ret = 0;
+    if (c->done > 0) {
+        if (c->done != COMPLETION_DONE_ALL) {
+            c->done--;
+        }
+        ret = (timeout > 0) ? timeout : 1;
+    }
+
+    local_irq_restore(flags);
+    return ret;
+}
+
+void wait_for_completion(struct completion *c) {
+    completion_wait(c, WAIT_FOREVER);
+}
+
+long wait_for_completion_timeout(struct completion *c, long timeout) {
+    return completion_wait(c, timeout);
+}
+
+int try_wait_for_completion(struct completion *c) {
+    unsigned long flags = local_irq_save();
+    int ok = (c->done > 0);
+    if (ok && c->done != COMPLETION_DONE_ALL) {
+        c->done--;
+    }
+    local_irq_restore(flags);
+    return ok;
+}
+
+void complete(struct completion *c) {
+    unsigned long flags = local_irq_save();
+    if (c->done != COMPLETION_DONE_ALL) {
+        c->done++;
+    }
+    wake_up_one(&c->wait);
+    local_irq_restore(flags);
+}
+
+void complete_all(struct completion *c) {
+    unsigned long flags = local_irq_save();
+    c->done = COMPLETION_DONE_ALL;
+    wake_up(&c->wait);
+    local_irq_restore(flags);
+}
+
+/* ========================================================================== */
+/* VARIABLES DE CONDICIÓN                                                    */
+/* ========================================================================== */
+
+void cond_init(struct condvar *cv) {
+    init_waitqueue_head(&cv->wait);
+}
+
+long cond_wait_timeout(struct condvar *cv, struct mutex *m, long timeout) {
+    unsigned long flags = local_irq_save();
+    mutex_unlock(m);
+    long left = wait_queue_block(&cv->wait, timeout);
+    local_irq_restore(flags);
+
+    mutex_lock(m);
+    return left;
+}
+
+void cond_wait(struct condvar *cv, struct mutex *m) {
+    cond_wait_timeout(cv, m, WAIT_FOREVER);
+}
+
+void cond_signal(struct condvar *cv) {
+    wake_up_one(&cv->wait);
+}
+
+void cond_broadcast(struct condvar *cv) {
+    wake_up(&cv->wait);
+}
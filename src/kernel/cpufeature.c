@@ -0,0 +1,89 @@
+/**
+ * @file cpufeature.c
+ * @brief Detección de características de la CPU y aplicación de alternativas
+ *
+ * @details
+ *   FLUJO (una vez, al principio de kernel()):
+ *   @code
+ *   cpufeature_init()
+ *     ID_AA64ISAR0_EL1.Atomic >= 2  -> CPU_FEATURE_LSE
+ *     ID_AA64ISAR0_EL1.TLB == 2     -> CPU_FEATURE_TLBIRANGE
+ *     apply_alternatives()          -> para cada entrada de .altinstr
+ *                                      cuya característica exista:
+ *                                      *site = insn; flush_icache_range()
+ *   @endcode
+ *
+ *   La sección .altinstr la delimitan __alt_start/__alt_end (link.ld).
+ *   El texto del kernel está mapeado con escritura, así que el parche
+ *   es una escritura normal seguida de mantenimiento de cachés.
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ * @see cpufeature.h para interfaz pública
+ */
+
+#include "../../include/kernel/cpufeature.h"
+#include "../../include/drivers/io.h"
+
+extern unsigned long get_id_aa64isar0_el1(void);
+extern void flush_icache_range(unsigned long start, unsigned long end);
+
+/* Límites de la tabla de alternativas (link.ld) */
+extern struct alt_entry __alt_start[];
+extern struct alt_entry __alt_end[];
+
+/* ========================================================================== */
+/* ESTADO GLOBAL                                                             */
+/* ========================================================================== */
+
+static int cpu_features[CPU_FEATURE_COUNT];
+
+/* ========================================================================== */
+/* ALTERNATIVAS                                                              */
+/* ========================================================================== */
+
+/**
+ * @brief Sustituye las instrucciones de las características presentes
+ * @return Número de instrucciones parcheadas
+ */
+static int apply_alternatives(void) {
+    int patched = 0;
+
+    for (struct alt_entry *alt = __alt_start; alt < __alt_end; alt++) {
+        if (alt->feature >= CPU_FEATURE_COUNT || !cpu_features[alt->feature]) {
+            continue;
+        }
+
+        *(volatile unsigned int *)alt->site = alt->insn;
+        flush_icache_range(alt->site, alt->site + sizeof(unsigned int));
+        patched++;
+    }
+    return patched;
+}
+
+/* ========================================================================== */
+/* API PÚBLICA                                                               */
+/* ========================================================================== */
+
+void cpufeature_init(void) {
+    unsigned long isar0 = get_id_aa64isar0_el1();
+    unsigned long atomic = (isar0 >> ID_AA64ISAR0_ATOMIC_SHIFT) & 0xF;
+
+    unsigned long tlb = (isar0 >> ID_AA64ISAR0_TLB_SHIFT) & 0xF;
+
+    cpu_features[CPU_FEATURE_LSE] = (atomic >= ID_AA64ISAR0_ATOMIC_LSE);
+    cpu_features[CPU_FEATURE_TLBIRANGE] = (tlb == ID_AA64ISAR0_TLB_RANGE);
+
+    int patched = apply_alternatives();
+
+    kprintf("[CPU] Atómicos: %s (%d instrucciones parcheadas)\n",
+            cpu_features[CPU_FEATURE_LSE] ? "LSE (ARMv8.1)" : "LL/SC (ARMv8.0)",
+            patched);
+    kprintf("[CPU] TLBI: %s\n",
+            cpu_features[CPU_FEATURE_TLBIRANGE] ? "por rangos (RVAE1IS, ARMv8.4)" : "por página (VAE1IS)");
+}
+
+int cpu_has_feature(int feature) {
+    if (feature < 0 || feature >= CPU_FEATURE_COUNT) return 0;
+    return cpu_features[feature];
+}
@@ -0,0 +1,196 @@
+/**
+ * @file fdt.c
+ * @brief Implementación de la lectura del Device Tree (FDT)
+ *
+ * @details
+ *   Recorrido lineal del bloque de estructura, sin copiar nada:
+ *   - FDT_BEGIN_NODE: nombre del nodo (terminado en 0, alineado a 4)
+ *   - FDT_PROP: {len, nameoff} + valor (alineado a 4); el nombre está
+ *     en el bloque de cadenas
+ *   - FDT_END_NODE / FDT_NOP / FDT_END
+ *
+ *   '#address-cells' y '#size-cells' de la raíz dicen cuántas palabras
+ *   de 32 bits ocupan la dirección y el tamaño de cada par de 'reg'
+ *   (2 y 2 en QEMU virt). Se usan en los nodos /memory de primer nivel.
+ *
+ *   Se llama antes de activar la MMU: todo acceso es a memoria física.
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ * @see fdt.h para interfaz pública
+ */
+
+#include "../../include/kernel/fdt.h"
+
+/* ========================================================================== */
+/* FORMATO                                                                   */
+/* ========================================================================== */
+
+/* Tokens del bloque de estructura */
+#define FDT_BEGIN_NODE  1
+#define FDT_END_NODE    2
+#define FDT_PROP        3
+#define FDT_NOP         4
+#define FDT_END         9
+
+/* Versión del formato que entendemos (v17) */
+#define FDT_VERSION     17
+
+/**
+ * @brief Cabecera del blob (campos big-endian)
+ */
+struct fdt_header {
+    unsigned int magic;
+    unsigned int totalsize;
+    unsigned int off_dt_struct;
+    unsigned int off_dt_strings;
+    unsigned int off_mem_rsvmap;
+    unsigned int version;
+    unsigned int last_comp_version;
+    unsigned int boot_cpuid_phys;
+    unsigned int size_dt_strings;
+    unsigned int size_dt_struct;
+};
+
+/* Escrita por _start (boot.s) después de limpiar el BSS */
+unsigned long boot_dtb = 0;
+
+static unsigned int be32(const void *p) {
+    return __builtin_bswap32(*(const unsigned int *)p);
+}
+
+static unsigned long be64(const void *p) {
+    return ((unsigned long)be32(p) << 32) | be32((const char *)p + 4);
+}
+
+/**
+ * @brief Lee un número de 'cells' palabras de 32 bits
+ */
+static unsigned long read_cells(const unsigned char *p, int cells) {
+    unsigned long v = 0;
+    for (int i = 0; i < cells; i++) {
+        v = (v << 32) | be32(p + 4 * i);
+    }
+    return v;
+}
+
+static int str_eq(const char *a, const char *b) {
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+/**
+ * @brief ¿Es 'name' un nodo "memory" o "memory@<dirección>"?
+ */
+static int is_memory_node(const char *name) {
+    const char *m = "memory";
+    while (*m && *name == *m) {
+        name++;
+        m++;
+    }
+    return *m == 0 && (*name == 0 || *name == '@');
+}
+
+/* ========================================================================== */
+/* API PÚBLICA                                                               */
+/* ========================================================================== */
+
+int fdt_valid(unsigned long dtb) {
+    if (dtb == 0 || (dtb & 3)) return 0;
+
+    const struct fdt_header *h = (const struct fdt_header *)dtb;
+    return be32(&h->magic) == FDT_MAGIC && be32(&h->last_comp_version) <= FDT_VERSION &&
+           be32(&h->off_dt_struct) < be32(&h->totalsize);
+}
+
+unsigned long fdt_find(void) {
+    if (fdt_valid(boot_dtb)) return boot_dtb;
+    if (fdt_valid(FDT_QEMU_RAM_BASE)) return FDT_QEMU_RAM_BASE;
+    return 0;
+}
+
+unsigned long fdt_total_size(unsigned long dtb) {
+    return be32(&((const struct fdt_header *)dtb)->totalsize);
+}
+
+/**
+ * @brief Recorre la estructura buscando 'reg' en los nodos /memory
+ *
+ * @details
+ *   Los '#address-cells'/'#size-cells' de la raíz aparecen antes que
+ *   sus nodos hijos (las propiedades van siempre primero).
+ */
+int fdt_memory_regions(unsigned long dtb, struct fdt_region *out, int max) {
+    const struct fdt_header *h = (const struct fdt_header *)dtb;
+    const unsigned char *p = (const unsigned char *)dtb + be32(&h->off_dt_struct);
+    const unsigned char *end = p + be32(&h->size_dt_struct);
+    const char *strings = (const char *)dtb + be32(&h->off_dt_strings);
+
+    int addr_cells = 2, size_cells = 1;   /* Valores por defecto del estándar */
+    int depth = 0;
+    int in_memory = 0;
+    int n = 0;
+
+    while (p < end) {
+        unsigned int token = be32(p);
+        p += 4;
+
+        if (token == FDT_BEGIN_NODE) {
+            const char *name = (const char *)p;
+            int len = 0;
+            while (name[len]) len++;
+            p += (len + 1 + 3) & ~3;
+
+            depth++;
+            in_memory = (depth == 2 && is_memory_node(name));
+        } else if (token == FDT_END_NODE) {
+            depth--;
+            in_memory = 0;
+        } else if (token == FDT_PROP) {
+            unsigned int len = be32(p);
+            const char *pname = strings + be32(p + 4);
+            const unsigned char *val = p + 8;
+            p += 8 + ((len + 3) & ~3U);
+
+            if (depth == 1 && str_eq(pname, "#address-cells")) {
+                addr_cells = (int)be32(val);
+            } else if (depth == 1 && str_eq(pname, "#size-cells")) {
+                size_cells = (int)be32(val);
+            } else if (in_memory && str_eq(pname, "reg")) {
+                unsigned int entry = 4 * (unsigned int)(addr_cells + size_cells);
+                for (unsigned int off = 0; off + entry <= len && n < max; off += entry) {
+                    out[n].base = read_cells(val + off, addr_cells);
+                    out[n].size = read_cells(val + off + 4 * addr_cells, size_cells);
+                    if (out[n].size != 0) n++;
+                }
+            }
+        } else if (token == FDT_NOP) {
+            continue;
+        } else {
+            break;   /* FDT_END o token desconocido */
+        }
+    }
+    return n;
+}
+
+int fdt_reserved_regions(unsigned long dtb, struct fdt_region *out, int max) {
+    const struct fdt_header *h = (const struct fdt_header *)dtb;
+    const unsigned char *p = (const unsigned char *)dtb + be32(&h->off_mem_rsvmap);
+    int n = 0;
+
+    /* Lista de pares de 64 bits terminada en {0, 0} */
+    while (n < max) {
+        unsigned long base = be64(p);
+        unsigned long size = be64(p + 8);
+        if (base == 0 && size == 0) break;
+
+        out[n].base = base;
+        out[n].size = size;
+        n++;
+        p += 16;
+    }
+    return n;
+}
@@ -0,0 +1,200 @@
+/**
+ * @file futex.c
+ * @brief Implementación de FUTEX_WAIT / FUTEX_WAKE
+ *
+ * @details
+ *   TABLA HASH DE COLAS:
+ *   - FUTEX_HASH_SIZE buckets, cada uno con su spinlock y una lista FIFO
+ *     de procesos (campo 'next' del PCB)
+ *   - Bucket = hash de la clave; varios futex pueden compartir
+ *     bucket, por eso cada waiter guarda su clave en pcb->futex_key
+ *   - Clave = dirección física de uaddr en la tabla del proceso actual
+ *
+ *   FUTEX_WAIT:
+ *   1. Tomar el lock del bucket (IRQs deshabilitadas)
+ *   2. Si *uaddr != val, retornar -1 (el valor cambió: no dormir)
+ *   3. Encolarse, BLOCKED (BLOCK_REASON_FUTEX) y schedule()
+ *
+ *   FUTEX_WAKE:
+ *   - Recorrer el bucket y pasar a READY hasta 'nr' waiters con la
+ *     misma clave
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ * @see futex.h para interfaz pública
+ */
+
+#include "../../include/kernel/futex.h"
+#include "../../include/kernel/process.h"
+#include "../../include/kernel/scheduler.h"
+#include "../../include/spinlock.h"
+#include "../../include/mm/vmm.h"
+
+/* ========================================================================== */
+/* TABLA HASH                                                                */
+/* ========================================================================== */
+
+struct futex_bucket {
+    volatile int lock;
+    struct pcb *head;
+    struct pcb *tail;
+};
+
+static struct futex_bucket futex_table[FUTEX_HASH_SIZE];
+
+/* Número de SYS_FUTEX atendidas (el camino rápido de usuario no llega aquí) */
+static unsigned long futex_syscalls = 0;
+
+/**
+ * @brief Clave de uaddr: su dirección física, o la VA si no está mapeada
+ */
+static inline unsigned long futex_key_of(volatile int *uaddr) {
+    (void)*uaddr;   /* Si es de demanda, que se mapee antes de traducir */
+    unsigned long phys = vmm_translate(current_process->pgd, (unsigned long)uaddr);
+    return phys ? phys : (unsigned long)uaddr;
+}
+
+/**
+ * @brief Bucket de una dirección (los 2 bits bajos son siempre 0)
+ */
+static inline struct futex_bucket *futex_hash(unsigned long key) {
+    unsigned long h = key >> 2;
+    h ^= h >> 7;
+    h ^= h >> 13;
+    return &futex_table[h & (FUTEX_HASH_SIZE - 1)];
+}
+
+/* ========================================================================== */
+/* OPERACIONES                                                               */
+/* ========================================================================== */
+
+/**
+ * @brief Duerme al proceso actual si *uaddr sigue valiendo 'val'
+ */
+long futex_wait(volatile int *uaddr, int val) {
+    unsigned long key = futex_key_of(uaddr);
+    struct futex_bucket *b = futex_hash(key);
+    struct pcb *me = current_process;
+
+    unsigned long flags = spin_lock_irqsave(&b->lock);
+
+    /* Comprobar con el lock tomado: un WAKE no se puede colar en medio */
+    if (*uaddr != val) {
+        spin_unlock_irqrestore(&b->lock, flags);
+        return -1;
+    }
+
+    me->futex_key = key;
+    me->next = nullptr;
+    if (b->tail == nullptr) {
+        b->head = me;
+    } else {
+        b->tail->next = me;
+    }
+    b->tail = me;
+
+    me->state = PROCESS_BLOCKED;
+    me->block_reason = BLOCK_REASON_FUTEX;
+
+    spin_unlock(&b->lock);
+    schedule();
+    local_irq_restore(flags);
+
+    return 0;
+}
+
+/**
+ * @brief Despierta hasta 'nr' procesos esperando en uaddr
+ */
+long futex_wake(volatile int *uaddr, int nr) {
+    unsigned long key = futex_key_of(uaddr);
+    struct futex_bucket *b = futex_hash(key);
+    long woken = 0;
+
+    unsigned long flags = spin_lock_irqsave(&b->lock);
+
+    struct pcb *prev = nullptr;
+    struct pcb *p = b->head;
+    while (p != nullptr && woken < nr) {
+        struct pcb *next = p->next;
+
+        if (p->futex_key == key) {
+            /* Desenlazar */
+            if (prev == nullptr) {
+                b->head = next;
+            } else {
+                prev->next = next;
+            }
+            if (b->tail == p) {
+                b->tail = prev;
+            }
+
+            p->next = nullptr;
+            p->futex_key = 0;
+            p->state = PROCESS_READY;
+            p->block_reason = BLOCK_REASON_NONE;
+            woken++;
+        } else {
+            prev = p;
+        }
+        p = next;
+    }
+
+    spin_unlock_irqrestore(&b->lock, flags);
+    return woken;
+}
+
+/* ========================================================================== */
+/* SYSCALL                                                                   */
+/* ========================================================================== */
+
+/**
+ * @brief Handler de SYS_FUTEX
+ *
+ * @details
+ *   x0 = dirección, x1 = operación, x2 = valor / número a despertar.
+ *   El resultado se deja en regs->x0. Desde EL0 la dirección debe estar
+ *   en [DEMAND_VA_BASE, USER_VA_END).
+ */
+void sys_futex(struct pt_regs *regs) {
+    volatile int *uaddr = (volatile int *)regs->x0;
+    int op = (int)regs->x1;
+    int val = (int)regs->x2;
+
+    futex_syscalls++;
+
+    /* Dirección nula o no alineada */
+    if (uaddr == nullptr || ((unsigned long)uaddr & 3)) {
+        regs->x0 = (unsigned long)-1;
+        return;
+    }
+
+    /* Desde EL0 solo vale el espacio privado del proceso: una dirección
+       del kernel se leería (y su valor se filtraría en el resultado de
+       FUTEX_WAIT). Los threads del kernel (SVC desde EL1) ya pueden leer
+       toda la memoria y usan futex sobre variables del kernel */
+    unsigned long addr = (unsigned long)uaddr;
+    if ((regs->pstate & 0xF) == 0 && (addr < DEMAND_VA_BASE || addr >= USER_VA_END)) {
+        regs->x0 = (unsigned long)-1;
+        return;
+    }
+
+    switch (op) {
+        case FUTEX_WAIT:
+            regs->x0 = (unsigned long)futex_wait(uaddr, val);
+            break;
+        case FUTEX_WAKE:
+            regs->x0 = (unsigned long)futex_wake(uaddr, val);
+            break;
+        default:
+            regs->x0 = (unsigned long)-1;
+            break;
+    }
+}
+
+/**
+ * @brief Número de SYS_FUTEX atendidas desde el arranque
+ */
+unsigned long futex_syscall_count(void) {
+    return futex_syscalls;
+}
@@ -0,0 +1,322 @@
+/**
+ * @file ipc.c
+ * @brief Implementación del IPC síncrono con hand-off directo
+ *
+ * @details
+ *   CAMINO RÁPIDO (ipc_call a un servidor en ipc_recv, o ipc_reply_recv
+ *   sin más clientes encolados):
+ *   1. Copiar tag + palabras usadas al buffer del receptor
+ *   2. Emisor -> BLOCKED, receptor -> RUNNING
+ *   3. cpu_switch_to() directo (sin aging, sin elección, sin quantum nuevo)
+ *
+ *   CAMINO LENTO (el servidor está ocupado):
+ *   - El cliente se encola en servidor->ipc_senders y llama a schedule()
+ *   - ipc_recv()/ipc_reply_recv() lo desencolan y copian su mensaje
+ *
+ *   SINCRONIZACIÓN:
+ *   - Todo con IRQs deshabilitadas (local_irq_save): el timer no puede
+ *     expropiar a mitad del hand-off. El proceso al que se cambia restaura
+ *     su propio estado de IRQs al volver de cpu_switch_to().
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ */
+
+#include "../../include/kernel/ipc.h"
+#include "../../include/kernel/process.h"
+#include "../../include/kernel/scheduler.h"
+#include "../../include/mm/asid.h"
+
+/* ========================================================================== */
+/* FUNCIONES EXTERNAS (Ensamblador)                                         */
+/* ========================================================================== */
+
+/* Context switch entre dos procesos (src/entry.S) */
+extern void cpu_switch_to(struct pcb *prev, struct pcb *next);
+
+extern unsigned long local_irq_save(void);
+extern void local_irq_restore(unsigned long flags);
+
+/* ========================================================================== */
+/* FUNCIONES AUXILIARES                                                      */
+/* ========================================================================== */
+
+/**
+ * @brief Copia un mensaje (solo las palabras indicadas en la etiqueta)
+ */
+static inline void ipc_copy(struct ipc_msg *dst, const struct ipc_msg *src) {
+    unsigned long words = IPC_TAG_WORDS(src->tag);
+    if (words > IPC_MR_WORDS) {
+        words = IPC_MR_WORDS;
+    }
+
+    dst->tag = (src->tag & ~0x3FUL) | words;
+    for (unsigned long i = 0; i < words; i++) {
+        dst->mr[i] = src->mr[i];
+    }
+}
+
+/**
+ * @brief Valida un PID como extremo de IPC
+ * @return PCB del proceso, o nullptr si no existe o está terminando
+ *
+ * @details
+ *   process_find() es una lectura RCU: aquí siempre se llama con IRQs
+ *   deshabilitadas, que ya impiden que el slot se recicle.
+ */
+static struct pcb *ipc_lookup(long pid) {
+    return process_find(pid);
+}
+
+/**
+ * @brief Cambia directamente al proceso 'next' (hand-off)
+ *
+ * @details
+ *   El llamador ya ha dejado a current_process en BLOCKED. Se salta la
+ *   elección de schedule() y se dona el quantum restante: el receptor
+ *   trabaja "a cuenta" del emisor, así una ráfaga de llamadas no puede
+ *   usarse para acaparar la CPU.
+ */
+static void ipc_switch_to(struct pcb *next) {
+    struct pcb *prev = current_process;
+
+    next->state = PROCESS_RUNNING;
+    next->block_reason = BLOCK_REASON_NONE;
+
+    if (prev->pid > 0) {
+        next->quantum = prev->quantum;
+    } else {
+        /* El kernel (PID 0) no gasta quantum: el receptor empieza uno nuevo */
+        next->quantum = DEFAULT_QUANTUM;
+    }
+
+    current_process = next;
+    switch_mm(next);
+    cpu_switch_to(prev, next);
+}
+
+/**
+ * @brief Desencola el primer cliente de un servidor y recoge su petición
+ * @return PID del cliente
+ *
+ * @details
+ *   El cliente pasa de IPC_SEND a IPC_REPLY (sigue bloqueado hasta la
+ *   respuesta). IRQs deshabilitadas.
+ */
+static long ipc_take_sender(struct pcb *server, struct ipc_msg *msg) {
+    struct pcb *client = server->ipc_senders;
+
+    server->ipc_senders = client->next;
+    client->next = nullptr;
+
+    ipc_copy(msg, client->ipc_buf);
+    client->block_reason = BLOCK_REASON_IPC_REPLY;
+
+    return client->pid;
+}
+
+/**
+ * @brief Entrega una respuesta a un cliente en IPC_REPLY
+ * @return 0 si se entregó, -1 si el cliente no nos esperaba
+ *
+ * @details
+ *   No cambia el estado del cliente (lo decide el llamador: READY o
+ *   hand-off directo). IRQs deshabilitadas.
+ */
+static long ipc_deliver_reply(struct pcb *client, struct ipc_msg *reply) {
+    if (client == nullptr ||
+        client->state != PROCESS_BLOCKED ||
+        client->block_reason != BLOCK_REASON_IPC_REPLY ||
+        client->ipc_partner != current_process->pid) {
+        return -1;
+    }
+
+    ipc_copy(client->ipc_buf, reply);
+    client->ipc_status = 0;
+    return 0;
+}
+
+/* ========================================================================== */
+/* LADO CLIENTE                                                              */
+/* ========================================================================== */
+
+/**
+ * @brief Envía una petición y espera la respuesta
+ *
+ * @details
+ *   Si el servidor está en ipc_recv() se le entrega el mensaje y se
+ *   cambia a él directamente; si no, el cliente se encola en él.
+ *   En ambos casos el cliente vuelve cuando el servidor responde.
+ */
+long ipc_call(long dest, struct ipc_msg *msg) {
+    unsigned long flags = local_irq_save();
+
+    struct pcb *me = current_process;
+    struct pcb *server = ipc_lookup(dest);
+
+    if (server == nullptr || server == me) {
+        local_irq_restore(flags);
+        return -1;
+    }
+
+    me->ipc_buf = msg;
+    me->ipc_partner = dest;
+    me->ipc_status = -1;
+    me->state = PROCESS_BLOCKED;
+
+    if (server->state == PROCESS_BLOCKED &&
+        server->block_reason == BLOCK_REASON_IPC_RECV) {
+        /* === CAMINO RÁPIDO: servidor esperando === */
+        ipc_copy(server->ipc_buf, msg);
+        server->ipc_partner = me->pid;
+
+        me->block_reason = BLOCK_REASON_IPC_REPLY;
+        ipc_switch_to(server);
+    } else {
+        /* === CAMINO LENTO: encolarse (FIFO) en el servidor === */
+        me->block_reason = BLOCK_REASON_IPC_SEND;
+        me->next = nullptr;
+
+        struct pcb **pp = &server->ipc_senders;
+        while (*pp) {
+            pp = &(*pp)->next;
+        }
+        *pp = me;
+
+        schedule();
+    }
+
+    /* Aquí ya tenemos la respuesta en *msg (o el servidor murió) */
+    local_irq_restore(flags);
+    return me->ipc_status;
+}
+
+/* ========================================================================== */
+/* LADO SERVIDOR                                                             */
+/* ========================================================================== */
+
+/**
+ * @brief Espera la siguiente petición
+ *
+ * @details
+ *   Si hay clientes encolados se atiende al primero sin bloquear. Si no,
+ *   el servidor se bloquea en IPC_RECV; el ipc_call() que lo despierte
+ *   le habrá copiado ya el mensaje y fijado ipc_partner.
+ */
+long ipc_recv(struct ipc_msg *msg) {
+    unsigned long flags = local_irq_save();
+
+    struct pcb *me = current_process;
+    long client;
+
+    me->ipc_buf = msg;
+
+    if (me->ipc_senders) {
+        client = ipc_take_sender(me, msg);
+    } else {
+        me->ipc_partner = IPC_ANY;
+        me->state = PROCESS_BLOCKED;
+        me->block_reason = BLOCK_REASON_IPC_RECV;
+        schedule();
+        client = me->ipc_partner;
+    }
+
+    local_irq_restore(flags);
+    return client;
+}
+
+/**
+ * @brief Responde a un cliente sin bloquearse
+ */
+long ipc_reply(long client, struct ipc_msg *msg) {
+    unsigned long flags = local_irq_save();
+
+    struct pcb *c = ipc_lookup(client);
+    long ret = ipc_deliver_reply(c, msg);
+
+    if (ret == 0) {
+        c->state = PROCESS_READY;
+        c->block_reason = BLOCK_REASON_NONE;
+    }
+
+    local_irq_restore(flags);
+    return ret;
+}
+
+/**
+ * @brief Responde al cliente actual y espera la siguiente petición
+ *
+ * @details
+ *   - Con clientes encolados: el que responde pasa a READY y se toma el
+ *     siguiente sin bloquear (el servidor sigue vaciando su cola)
+ *   - Sin clientes: el servidor se bloquea en IPC_RECV y cambia
+ *     directamente al cliente respondido (camino rápido de vuelta)
+ */
+long ipc_reply_recv(long client, struct ipc_msg *reply, struct ipc_msg *msg) {
+    unsigned long flags = local_irq_save();
+
+    struct pcb *me = current_process;
+    struct pcb *c = ipc_lookup(client);
+
+    if (ipc_deliver_reply(c, reply) < 0) {
+        local_irq_restore(flags);
+        return -1;
+    }
+
+    me->ipc_buf = msg;
+    long next_client;
+
+    if (me->ipc_senders) {
+        c->state = PROCESS_READY;
+        c->block_reason = BLOCK_REASON_NONE;
+        next_client = ipc_take_sender(me, msg);
+    } else {
+        me->ipc_partner = IPC_ANY;
+        me->state = PROCESS_BLOCKED;
+        me->block_reason = BLOCK_REASON_IPC_RECV;
+        ipc_switch_to(c);
+        next_client = me->ipc_partner;
+    }
+
+    local_irq_restore(flags);
+    return next_client;
+}
+
+/* ========================================================================== */
+/* TERMINACION                                                               */
+/* ========================================================================== */
+
+/**
+ * @brief Aborta el IPC pendiente contra un proceso que termina
+ *
+ * @details
+ *   Los clientes encolados (IPC_SEND) y los que esperaban respuesta
+ *   (IPC_REPLY) de 'p' vuelven de ipc_call() con -1.
+ */
+void ipc_exit(struct pcb *p) {
+    unsigned long flags = local_irq_save();
+
+    /* Clientes encolados que nunca fueron atendidos */
+    while (p->ipc_senders) {
+        struct pcb *c = p->ipc_senders;
+        p->ipc_senders = c->next;
+        c->next = nullptr;
+        c->ipc_status = -1;
+        c->state = PROCESS_READY;
+        c->block_reason = BLOCK_REASON_NONE;
+    }
+
+    /* Clientes cuya petición se recibió pero no se respondió */
+    for (int i = 0; i < MAX_PROCESS; i++) {
+        struct pcb *c = &process[i];
+        if (c->state == PROCESS_BLOCKED &&
+            c->block_reason == BLOCK_REASON_IPC_REPLY &&
+            c->ipc_partner == p->pid) {
+            c->ipc_status = -1;
+            c->state = PROCESS_READY;
+            c->block_reason = BLOCK_REASON_NONE;
+        }
+    }
+
+    local_irq_restore(flags);
+}
@@ -5,20 +5,25 @@
  * @details
  *   Inicializa el sistema operativo y arranca el scheduler.
  *   Este archivo coordina la inicialización de todos los subsistemas:
+ *   - Características de la CPU (atómicos LL/SC o LSE)
  *   - Sistema de memoria (MMU + PMM + VMM para Demand Paging)
  *   - Sistema de procesos (con quantum para Round-Robin)
  *   - Interrupciones de timer (para preemption)
  *   - Shell del sistema
  * 
  * @author Sistema Operativo Educativo BareMetalM4
- * @version 0.6
+ * @version 0.7
  */
 
 #include "../../include/drivers/io.h"
 #include "../../include/drivers/timer.h"
 #include "../../include/kernel/process.h"
+#include "../../include/kernel/workqueue.h"
+#include "../../include/kernel/rcu.h"
+#include "../../include/kernel/cpufeature.h"
 #include "../../include/shell/shell.h"
 #include "../../include/mm/mm.h"
+#include "../../include/mm/pmm.h"
 #include "../../include/fs/vfs.h"
 
 /* ========================================================================== */
@@ -34,15 +39,18 @@
  * 
  * @details
  *   Secuencia de inicialización:
- *   1. Sistema de memoria (MMU + Heap + PMM + VMM)
+ *   0. Características de la CPU (parcheo de alternativas)
+ *   1. Sistema de memoria (Device Tree + memblock + MMU + Heap + PMM + VMM)
  *      - Activa paginación y demand paging via Page Faults
  *   2. Sistema de procesos (PID 0 con quantum)
  *      - Inicializa estructuras PCB con soporte para Round-Robin
+ *      - Crea los kworkers de las workqueues
  *   3. Timer e interrupciones (GIC)
  *      - Configura IRQ periódicas que decrementan quantum
  *   4. Shell interactivo
  *      - Crea proceso de usuario con prioridad 1
  *   5. Loop IDLE principal (WFI)
+ *      - Rellena el pool de páginas a cero del PMM
  *      - Proceso 0 espera interrupciones en bajo consumo
  */
 void kernel(void) {
@@ -50,12 +58,14 @@ void kernel(void) {
     kprintf("Sistema Operativo BareMetalM4 v0.6 iniciando...\n");
     kprintf("Planificador Round-Robin con Quantum + Prioridades + Aging\n");
 
+    /* 0. Características de la CPU: parchea los atómicos (LSE) antes de usarlos */
+    cpufeature_init();
+
     /* 1. Inicializar Memoria (MMU y Heap) */
     init_memory_system();
 
-    /* Inicializar el RamDisk (Robamos 1MB de memoria virtual segura) */
-    /* Usaremos una dirección arbitraria pero mapeada: 0x41000000 */
-    ramfs_init(0x41000000, 1 * 1024 * 1024); /* 1MB de Disco Virtual */
+    /* Inicializar el RamDisk en la región que le reservó memblock */
+    ramfs_init(mm_layout()->ramdisk_start, RAMDISK_SIZE); /* 1MB de Disco Virtual */
 
     /* Crear archivos de prueba */
     vfs_create("readme.txt");
@@ -64,6 +74,12 @@ void kernel(void) {
     /* 2. Inicializar Gestión de Procesos (PID 0) */
     init_process_system();
 
+    /* 2b. Hilos worker para trabajo diferido (workqueues) */
+    init_workqueues();
+
+    /* 2c. RCU: los callbacks de call_rcu() se ejecutan en un kworker */
+    rcu_init();
+
     /* 3. Inicializar Timers e Interrupciones */
     timer_init();
 
@@ -84,6 +100,12 @@ void kernel(void) {
         /* Liberar procesos zombie */
         free_zombie();
 
+        /* Limpiar páginas para los próximos Page Faults; dormir solo
+           cuando el pool está lleno */
+        if (pmm_zero_pool_refill()) {
+            continue;
+        }
+
         /* Wait For Interrupt (bajo consumo) */
         asm volatile("wfi");
     }
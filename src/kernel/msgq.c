@@ -0,0 +1,278 @@
+/**
+ * @file msgq.c
+ * @brief Implementación de colas de mensajes con páginas sin copia
+ *
+ * @details
+ *   PROTOCOLO DE UN ENVÍO:
+ *   1. sem_wait(space)   -> bloquea si no hay slots libres
+ *   2. Rellenar slots[tail] y avanzar tail (IRQs deshabilitadas: el slot
+ *      se reserva y se completa de forma atómica, así el consumidor nunca
+ *      ve un slot a medio escribir)
+ *   3. sem_signal(items) -> despierta a un consumidor
+ *
+ *   La recepción es simétrica (items -> slots[head] -> space).
+ *
+ *   TRANSFERENCIA DE PÁGINAS:
+ *   - Envío: unmap_page() de cada página del emisor (se guarda su física)
+ *   - Recepción: map_page() de esas físicas en la VA del receptor
+ *   - Cada lado usa su propia tabla base (current_process->pgd): emisor y
+ *     receptor están en espacios de direcciones distintos
+ *   - El emisor invalida solo el rango cedido (tlb_invalidate_range(),
+ *     una TLBI por mensaje con FEAT_TLBIRANGE); el receptor mapea sobre
+ *     descriptores vacíos y no necesita invalidar nada
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ */
+
+#include "../../include/kernel/msgq.h"
+#include "../../include/mm/malloc.h"
+#include "../../include/mm/mm.h"
+#include "../../include/mm/pmm.h"
+#include "../../include/mm/vmm.h"
+#include "../../include/kernel/process.h"
+#include "../../include/utils/kutils.h"
+#include "../../include/drivers/io.h"
+
+/* ========================================================================== */
+/* FUNCIONES EXTERNAS (Ensamblador)                                         */
+/* ========================================================================== */
+
+extern unsigned long local_irq_save(void);
+extern void local_irq_restore(unsigned long flags);
+
+/* Bits del descriptor L3 que se conservan al re-mapear (permisos + MAIR) */
+#define MSGQ_PTE_ATTRS (MM_RO | MM_USER | MM_NG | MM_SH | MM_NOEXEC | (7 << 2))
+
+/* ========================================================================== */
+/* FUNCIONES AUXILIARES                                                      */
+/* ========================================================================== */
+
+/**
+ * @brief ¿Cabe [va, va + npages páginas) en el espacio privado del proceso?
+ *
+ * @details
+ *   Por debajo de DEMAND_VA_BASE las tablas L2/L3 son las de kernel_pgd,
+ *   compartidas por todos: mapear o desmapear ahí cambiaría el kernel de
+ *   todos los procesos.
+ */
+static int msgq_user_range(unsigned long va, unsigned int npages) {
+    return va >= DEMAND_VA_BASE && va < USER_VA_END &&
+           npages <= (USER_VA_END - va) / PAGE_SIZE;
+}
+
+/**
+ * @brief ¿Están vacíos todos los descriptores de la ventana de recepción?
+ *
+ * @details
+ *   map_page() sobre un descriptor válido perdería la página anterior
+ *   (sin page_put) y dejaría su traducción en la TLB.
+ */
+static int msgq_window_free(unsigned long *pgd, unsigned long va, unsigned int npages) {
+    for (unsigned int i = 0; i < npages; i++) {
+        unsigned long *pte = vmm_get_pte(pgd, va + i * PAGE_SIZE);
+        if (pte != nullptr && (*pte & 1)) return 0;
+    }
+    return 1;
+}
+
+/* ========================================================================== */
+/* CREACION Y DESTRUCCION                                                    */
+/* ========================================================================== */
+
+/**
+ * @brief Crea una cola de mensajes con 'size' slots
+ */
+struct msgq *msgq_create(unsigned int size) {
+    if (size == 0) return nullptr;
+
+    struct msgq *q = (struct msgq *)kmalloc(sizeof(struct msgq));
+    if (!q) return nullptr;
+
+    q->slots = (struct msg_slot *)kmalloc(size * sizeof(struct msg_slot));
+    if (!q->slots) {
+        kfree(q);
+        return nullptr;
+    }
+
+    q->size = size;
+    q->head = 0;
+    q->tail = 0;
+    sem_init(&q->items, 0);
+    sem_init(&q->space, size);
+
+    return q;
+}
+
+/**
+ * @brief Destruye una cola y libera las páginas de mensajes pendientes
+ */
+void msgq_destroy(struct msgq *q) {
+    while (q->items.count > 0) {
+        struct msg_slot *slot = &q->slots[q->head];
+        for (unsigned int i = 0; i < slot->npages; i++) {
+            page_put(slot->pages[i]);
+        }
+        q->head = (q->head + 1) % q->size;
+        q->items.count--;
+    }
+
+    kfree(q->slots);
+    kfree(q);
+}
+
+/* ========================================================================== */
+/* ENVIO                                                                     */
+/* ========================================================================== */
+
+/**
+ * @brief Envía un mensaje inline
+ */
+int msgq_send(struct msgq *q, const void *buf, unsigned int len) {
+    if (len > MSGQ_INLINE_MAX) return -1;
+
+    sem_wait(&q->space);
+
+    unsigned long flags = local_irq_save();
+    struct msg_slot *slot = &q->slots[q->tail];
+    slot->len = len;
+    slot->npages = 0;
+    memcpy(slot->data, buf, len);
+    q->tail = (q->tail + 1) % q->size;
+    local_irq_restore(flags);
+
+    sem_signal(&q->items);
+    return 0;
+}
+
+/**
+ * @brief Envía páginas por remapeo (sin copiar su contenido)
+ *
+ * @details
+ *   Antes de reservar slot se validan TODAS las páginas: si alguna no está
+ *   mapeada no se desmapea ninguna. Solo se ceden páginas del espacio
+ *   privado [DEMAND_VA_BASE, USER_VA_END), y todas con los mismos
+ *   atributos: el slot guarda uno solo para el receptor.
+ */
+int msgq_send_pages(struct msgq *q, unsigned long va, unsigned int npages, unsigned int len) {
+    if ((va & (PAGE_SIZE - 1)) || npages == 0 || npages > MSGQ_MAX_PAGES ||
+        len > npages * PAGE_SIZE || !msgq_user_range(va, npages)) {
+        return -1;
+    }
+
+    /* 1. Validar antes de bloquear */
+    unsigned long attrs = 0;
+    for (unsigned int i = 0; i < npages; i++) {
+        unsigned long addr = va + i * PAGE_SIZE;
+        unsigned long *pte = vmm_get_pte(current_process->pgd, addr);
+        if (pte == nullptr || !(*pte & 1)) {
+            kprintf("[MSGQ] Error: Página 0x%x no transferible\n", addr);
+            return -1;
+        }
+        if (i == 0) {
+            attrs = *pte & MSGQ_PTE_ATTRS;
+        } else if ((*pte & MSGQ_PTE_ATTRS) != attrs) {
+            kprintf("[MSGQ] Error: Página 0x%x con otros permisos que 0x%x\n", addr, va);
+            return -1;
+        }
+    }
+
+    sem_wait(&q->space);
+
+    /* 2. Ceder las páginas: desmapear y guardar sus físicas en el slot */
+    unsigned long flags = local_irq_save();
+    struct msg_slot *slot = &q->slots[q->tail];
+
+    unsigned long *pgd = current_process->pgd;
+    slot->flags = attrs;
+    for (unsigned int i = 0; i < npages; i++) {
+        slot->pages[i] = unmap_page(pgd, va + i * PAGE_SIZE);
+    }
+    slot->len = len;
+    slot->npages = npages;
+    q->tail = (q->tail + 1) % q->size;
+
+    tlb_invalidate_range(va, va + npages * PAGE_SIZE);
+    local_irq_restore(flags);
+
+    sem_signal(&q->items);
+    return 0;
+}
+
+/* ========================================================================== */
+/* RECEPCION                                                                 */
+/* ========================================================================== */
+
+/**
+ * @brief Recibe el siguiente mensaje
+ *
+ * @details
+ *   Inline: se copia a 'buf'. Por páginas: se mapea en 'map_va' (zero
+ *   copy) o, si el receptor no dio dirección, se copia a 'buf' y las
+ *   páginas se sueltan (page_put: pueden seguir compartidas en COW).
+ *
+ *   map_va solo vale si la ventana entera está en el espacio privado y
+ *   sin mapear; si no, se avisa y se usa la copia.
+ */
+long msgq_recv(struct msgq *q, void *buf, unsigned int buflen, unsigned long map_va) {
+    struct msg_slot local;
+
+    sem_wait(&q->items);
+
+    /* Sacar el slot (solo descriptores: como mucho MSGQ_INLINE_MAX bytes) */
+    unsigned long flags = local_irq_save();
+    local = q->slots[q->head];
+    q->head = (q->head + 1) % q->size;
+    local_irq_restore(flags);
+
+    sem_signal(&q->space);
+
+    unsigned int copy = (local.len < buflen) ? local.len : buflen;
+
+    unsigned long *pgd = current_process->pgd;
+    if (local.npages != 0 && map_va != 0 &&
+        ((map_va & (PAGE_SIZE - 1)) || !msgq_user_range(map_va, local.npages) ||
+         !msgq_window_free(pgd, map_va, local.npages))) {
+        kprintf("[MSGQ] Aviso: ventana 0x%x no válida o ya mapeada, se copia\n", map_va);
+        map_va = 0;
+    }
+
+    if (local.npages == 0) {
+        memcpy(buf, local.data, copy);
+    } else if (map_va != 0) {
+        /* === ZERO-COPY: mapear las físicas en el receptor === */
+        for (unsigned int i = 0; i < local.npages; i++) {
+            map_page(pgd, map_va + i * PAGE_SIZE, local.pages[i], local.flags);
+        }
+        /* Descriptores vacíos (msgq_window_free): nada que invalidar */
+        tlb_map_barrier();
+    } else {
+        /* Receptor sin ventana de mapeo: copia de respaldo */
+        unsigned char *dst = (unsigned char *)buf;
+        for (unsigned int i = 0; i < local.npages; i++) {
+            unsigned long off = i * PAGE_SIZE;
+            if (off < copy) {
+                unsigned long chunk = copy - off;
+                if (chunk > PAGE_SIZE) chunk = PAGE_SIZE;
+                /* Las físicas están accesibles por el mapa identidad */
+                memcpy(dst + off, (void *)local.pages[i], chunk);
+            }
+            page_put(local.pages[i]);
+        }
+    }
+
+    return local.len;
+}
+
+/**
+ * @brief Desmapea y suelta (page_put) las páginas recibidas por msgq_recv()
+ */
+void msgq_release_pages(unsigned long va, unsigned int npages) {
+    for (unsigned int i = 0; i < npages; i++) {
+        unsigned long phys = unmap_page(current_process->pgd, va + i * PAGE_SIZE);
+        if (phys) {
+            page_put(phys);
+        }
+    }
+    tlb_invalidate_range(va, va + npages * PAGE_SIZE);
+}
@@ -5,22 +5,43 @@
  * @details
  *   Implementa la gestión de procesos:
  *   - Creación de threads del kernel
+ *   - fork() con copy-on-write (process_fork)
  *   - Terminación de procesos
  *   - Process Control Blocks (PCB) con soporte para:
  *     * Quantum (Round-Robin scheduling)
  *     * Campos next para wait queues (semáforos)
  *     * wake_up_time para sleep() sin busy-wait
+ *
+ *   TABLA DE PROCESOS (process_table_lock, seqlock):
+ *   - Escritores: process_alloc() al ocupar un slot y free_zombie() al
+ *     liberarlo. El spinlock del seqlock además impide que dos
+ *     creaciones concurrentes elijan el mismo slot
+ *   - Lectores: process_get_info() (comando 'ps'), que copia un PCB sin
+ *     bloquear a nadie y reintenta si el slot cambió de dueño a mitad
+ *
+ *   BÚSQUEDA POR PID (process_find, RCU):
+ *   - free_zombie() pasa el slot a DEAD y lo devuelve a UNUSED con
+ *     call_rcu(): un lector que encontró el PCB dentro de
+ *     rcu_read_lock() no puede ver cómo se reutiliza para otro proceso
  * 
  * @author Sistema Operativo Educativo BareMetalM4
- * @version 0.6
+ * @version 0.7
  */
 
 #include "../../include/sched.h"
 #include "../../include/drivers/io.h"
 #include "../../include/kernel/process.h"
 #include "../../include/kernel/scheduler.h"
+#include "../../include/kernel/ipc.h"
 #include "../../include/utils/kutils.h"
 #include "../../include/mm/malloc.h"
+#include "../../include/mm/slab.h"
+#include "../../include/mm/vmm.h"
+#include "../../include/mm/pmm.h"
+#include "../../include/mm/asid.h"
+#include "../../include/seqlock.h"
+#include "../../include/kernel/rcu.h"
+#include "../../include/types.h"
 
 /* ========================================================================== */
 /* GESTION DE PROCESOS - ESTRUCTURAS GLOBALES                               */
@@ -35,9 +56,31 @@ struct pcb *current_process;
 /* Contador del número total de procesos creados */
 int num_process = 0;
 
+/* Protege la ocupación/liberación de slots de process[] */
+struct seqlock process_table_lock;
+
+/* Tamaño del stack de kernel de cada proceso */
+#define PROC_STACK_SIZE 4096
+
 /* Stacks de ejecución para cada proceso (256KB total) */
 // uint8_t process_stack[MAX_PROCESS][4096] __attribute__((aligned(16)));
 
+/**
+ * @brief Estructura de contexto para transición a modo usuario
+ * 
+ * @details
+ *   Almacena los registros necesarios para saltar de EL1 (Kernel) a EL0 (Usuario):
+ *   - pc: Program Counter donde inicia el código de usuario
+ *   - sp: Stack Pointer para el stack de usuario
+ */
+struct user_context {
+    unsigned long pc;
+    unsigned long sp;
+};
+
+/* Caché de contextos de arranque (init_process_system) */
+static struct kmem_cache *user_context_cache = nullptr;
+
 /* ========================================================================== */
 /* FUNCIONES EXTERNAS (Ensamblador)                                           */
 /* ========================================================================== */
@@ -48,6 +91,9 @@ extern void enable_interrupts(void);
 /* Punto de entrada para nuevos procesos (src/entry.S) */
 extern void ret_from_fork(void);
 
+/* Punto de entrada de los hijos de fork(): kernel_exit del frame copiado */
+extern void ret_from_sys_fork(void);
+
 extern void move_to_user_mode(unsigned long pc, unsigned long sp);
 
 /* ========================================================================== */
@@ -55,31 +101,41 @@ extern void move_to_user_mode(unsigned long pc, unsigned long sp);
 /* ========================================================================== */
 
 /**
- * @brief Crea un nuevo thread (hilo) del kernel
- * @param fn Función a ejecutar
- * @param arg Argumento para la función
+ * @brief Reserva un PCB y su stack para un proceso nuevo
  * @param priority Prioridad inicial del proceso
  * @param name Nombre descriptivo del proceso (máx. 15 chars)
- * @return PID del proceso creado, -1 en caso de error
+ * @return PID reservado, -1 en caso de error
  * 
  * @details
- *   Flujo de creación:
- *   1. Buscar slot UNUSED en process[] (reciclable)
- *   2. Asignar stack de 4KB mediante kmalloc()
+ *   Flujo de reserva:
+ *   1. Asignar stack de 4KB mediante kmalloc() y la tabla base del
+ *      espacio de direcciones con vmm_create_pgd() (fuera del lock)
+ *   2. Con process_table_lock como escritor, buscar slot UNUSED en
+ *      process[] (reciclable) y ocuparlo
  *   3. Configurar PCB:
  *      - quantum: Se inicializará en schedule() al ser elegido
- *      - state: PROCESS_READY
  *      - next: nullptr (para wait queues de semáforos)
  *      - block_reason: BLOCK_REASON_NONE
- *   4. Configurar contexto de ejecución (ret_from_fork)
  *   
- *   El proceso creado estará listo para ser elegido por el
- *   Round-Robin scheduler con asignación de quantum.
+ *   El PCB queda BLOCKED (en construcción) con el contexto sin rellenar:
+ *   el llamador configura p->context y lo pasa a PROCESS_READY.
  */
-long create_process(void (*fn)(void*), void *arg, int priority, const char *name) {
+long process_alloc(int priority, const char *name) {
     int pid = -1;
 
-    /* 1. Buscar hueco libre (Reciclable) */
+    /* 1. Asignar memoria (Heap) */
+    void *stack = kmalloc(PROC_STACK_SIZE);
+    unsigned long *pgd = vmm_create_pgd();
+    if (!stack || !pgd) {
+        kfree(stack);
+        if (pgd) free_page((unsigned long)pgd);
+        kprintf("[KERNEL] Error: Out of Memory\n");
+        return -1;
+    }
+
+    unsigned long flags = write_seqlock_irqsave(&process_table_lock);
+
+    /* 2. Buscar hueco libre (Reciclable) */
     /* Buscamos el primer slot que sea UNUSED (0) */
     for (int i = 0; i < MAX_PROCESS; i++) {
         if (process[i].state == PROCESS_UNUSED) {
@@ -90,46 +146,193 @@ long create_process(void (*fn)(void*), void *arg, int priority, const char *name
 
     /* Si no hay hueco, error */
     if (pid == -1) {
+        write_sequnlock_irqrestore(&process_table_lock, flags);
+        kfree(stack);
+        vmm_destroy_pgd(pgd);
         kprintf("[KERNEL] Error: Tabla de procesos llena \n");
         return -1;
     }
 
     struct pcb *p = &process[pid];
 
-    /* 2. Asignar memoria (Heap) */
-    void *stack = kmalloc(4096);
-    if (!stack) {
-        kprintf("[KERNEL] Error: Out of Memory (PID %d)\n", pid);
-        return -1;
-    }
-
     /* Guardamos la direccion para que free_zombie pueda liberarla luego */
     p->stack_addr = (unsigned long)stack;
 
-    /* 3. Configurar PCB */
+    /* 3. Configurar PCB (en construcción hasta que el llamador lo active) */
     p->pid = pid;
-    p->state = PROCESS_READY;
+    p->state = PROCESS_BLOCKED;
     p->priority = priority;
+    p->base_priority = -1;
     p->prempt_count = 0;
     p->wake_up_time = 0;
 
     p->cpu_time = 0;
     p->block_reason = BLOCK_REASON_NONE;
     p->exit_code = 0;
+    p->next = nullptr;
+    p->wait_queue = nullptr;
+
+    /* IPC: sin conversación ni clientes en espera */
+    p->ipc_buf = nullptr;
+    p->ipc_partner = IPC_ANY;
+    p->ipc_senders = nullptr;
+    p->ipc_status = 0;
+    p->futex_key = 0;
+    p->held_mutexes = nullptr;
+
+    p->nr_vm_pages = 0;
+
+    /* Espacio de direcciones propio; el ASID lo asigna switch_mm() */
+    p->pgd = pgd;
+    p->asid = 0;
+    p->is_user = 0;
 
     k_strncpy(p->name, name, 16);
 
-    /* 4. Configurar contexto */
+    num_process++;
+
+    write_sequnlock_irqrestore(&process_table_lock, flags);
+
+    return pid;
+}
+
+/**
+ * @brief Crea un nuevo thread (hilo) del kernel
+ * @param fn Función a ejecutar
+ * @param arg Argumento para la función
+ * @param priority Prioridad inicial del proceso
+ * @param name Nombre descriptivo del proceso (máx. 15 chars)
+ * @return PID del proceso creado, -1 en caso de error
+ * 
+ * @details
+ *   1. Reserva PCB y stack con process_alloc()
+ *   2. Configura el contexto de ejecución (ret_from_fork)
+ *   3. Marca el proceso como PROCESS_READY
+ *   
+ *   El proceso creado estará listo para ser elegido por el
+ *   Round-Robin scheduler con asignación de quantum.
+ */
+long create_process(void (*fn)(void*), void *arg, int priority, const char *name) {
+    long pid = process_alloc(priority, name);
+    if (pid < 0) {
+        return -1;
+    }
+
+    struct pcb *p = &process[pid];
+
+    /* Configurar contexto */
     p->context.x19 = (unsigned long)fn;
     p->context.x20 = (unsigned long)arg;
     p->context.pc = (unsigned long)ret_from_fork;
-    p->context.sp = (unsigned long)stack + 4096;
+    p->context.sp = p->stack_addr + PROC_STACK_SIZE;
 
-    num_process++;
+    p->state = PROCESS_READY;
 
     return pid;
 }
 
+/* ========================================================================== */
+/* FORK                                                                      */
+/* ========================================================================== */
+
+/**
+ * @brief Reubica la cadena de frame records en el stack del hijo
+ * @param child_regs Frame de la SVC ya copiado al stack del hijo
+ * @param low Dirección del frame de la SVC en el stack del padre
+ * @param old_top Cima del stack del padre (low..old_top se copió)
+ * @param delta Distancia entre los dos stacks
+ *
+ * @details
+ *   Un frame record es {x29 del llamador, x30} y x29 apunta al del
+ *   llamador. Se sigue la cadena desde el x29 guardado en pt_regs
+ *   mientras cada enlace caiga en [low, old_top), alineado a 16 y por
+ *   encima del anterior, y se desplaza cada uno 'delta'.
+ *
+ *   Solo se reubica esa cadena: cualquier otro puntero a variables
+ *   locales (en registros o en el stack) sigue apuntando al stack del
+ *   padre. Un thread que llame a fork() no debe usar en el hijo
+ *   punteros a sus variables locales tomados antes del fork().
+ */
+static void fork_relocate_frames(struct pt_regs *child_regs, unsigned long low,
+                                 unsigned long old_top, long delta) {
+    unsigned long *link = &child_regs->x29;
+    unsigned long fp = *link;
+
+    while (fp >= low && fp < old_top && !(fp & 15)) {
+        *link = fp + delta;
+        link = (unsigned long *)(fp + delta);   /* Record del hijo: [0] = x29 anterior */
+        if (*link <= fp) break;                 /* Fin de la cadena (0) o enlace roto */
+        fp = *link;
+    }
+}
+
+/**
+ * @brief Clona el proceso actual
+ *
+ * @details
+ *   1. process_alloc(): PCB, stack de kernel y tabla base vacía
+ *   2. Copiar la parte usada del stack [regs, cima) a la misma distancia
+ *      de la cima del hijo. Si la SVC vino de EL1, el thread sigue
+ *      ejecutando en ese stack tras volver: se reubica la cadena de
+ *      frame records (fork_relocate_frames). Desde EL0 solo hay el
+ *      frame de la SVC, con registros de usuario que no se tocan
+ *   3. x0 = 0 en el frame del hijo; arranca en ret_from_sys_fork
+ *   4. Espacio de usuario compartido en COW e invalidar el ASID del
+ *      padre (sus entradas de escritura ahora son de solo lectura)
+ */
+long process_fork(struct pt_regs *regs) {
+    struct pcb *me = current_process;
+
+    if (me->stack_addr == 0) {
+        kprintf("[FORK] Error: El PID %d no tiene stack propio\n", me->pid);
+        return -1;
+    }
+
+    long pid = process_alloc(me->priority, me->name);
+    if (pid < 0) {
+        return -1;
+    }
+    struct pcb *child = &process[pid];
+
+    /* 1-2. Stack de kernel */
+    unsigned long old_top = me->stack_addr + PROC_STACK_SIZE;
+    unsigned long new_top = child->stack_addr + PROC_STACK_SIZE;
+    long delta = (long)(new_top - old_top);
+    unsigned long used = old_top - (unsigned long)regs;
+
+    memcpy((void *)(new_top - used), regs, used);
+    struct pt_regs *child_regs = (struct pt_regs *)(new_top - used);
+
+    /* SPSR.M != EL0t: SVC desde EL1. regs->sp es SP_EL0, que un thread
+       del kernel no usa; su SP es el del propio frame (context.sp) */
+    if ((regs->pstate & 0xF) != 0) {
+        fork_relocate_frames(child_regs, (unsigned long)regs, old_top, delta);
+    }
+
+    /* 3. Vuelta del hijo */
+    child_regs->x0 = 0;
+    child->context.sp = (unsigned long)child_regs;
+    child->context.pc = (unsigned long)ret_from_sys_fork;
+
+    /* 4. Espacio de usuario */
+    if (vmm_fork_user_space(child->pgd, me->pgd) < 0) {
+        kprintf("[FORK] Error: Sin memoria para las tablas del hijo\n");
+        flush_tlb_mm(me);
+        child->state = PROCESS_ZOMBIE;    /* free_zombie() suelta todo */
+        return -1;
+    }
+    flush_tlb_mm(me);
+
+    for (int i = 0; i < me->nr_vm_pages; i++) {
+        child->vm_pages[i] = me->vm_pages[i];
+    }
+    child->nr_vm_pages = me->nr_vm_pages;
+    child->is_user = me->is_user;
+
+    child->state = PROCESS_READY;
+    return pid;
+}
+
 /**
  * @brief Crea un Hilo del Kernel (Kernel Thread)
  * @param fn Función a ejecutar
@@ -138,8 +341,9 @@ long create_process(void (*fn)(void*), void *arg, int priority, const char *name
  * @return PID del proceso creado, -1 en caso de error
  * 
  * @details
- *   En BareMetalM4 (v0.6), como no hay separación de memoria virtual por proceso,
- *   todos los procesos son técnicamente hilos del kernel que comparten espacio de direcciones.
+ *   Todos los procesos comparten el kernel (código, heap, mapa lineal),
+ *   pero cada uno tiene su propio espacio de usuario a partir de
+ *   DEMAND_VA_BASE (tabla base en TTBR0 etiquetada con su ASID).
  *   
  *   Esta función es un wrapper sobre create_process() que pasa nullptr como argumento.
  */
@@ -164,6 +368,7 @@ long create_thread(void (*fn)(void*), int priority, const char *name) {
 void init_process_system() {
     /* Limpiamos la tabla de procesos (opcional si está en .bss, pero seguro) */
     num_process = 0;
+    seqlock_init(&process_table_lock);
 
     /* Configurar Proceso 0 (IDLE/KERNEL) */
     /* Este proceso es especial: ya está ejecutándose y usa la pila de arranque */
@@ -172,15 +377,25 @@ void init_process_system() {
     kproc->pid = 0;
     kproc->state = PROCESS_RUNNING;
     kproc->priority = 0;
+    kproc->base_priority = -1;
+    kproc->held_mutexes = nullptr;
     kproc->stack_addr = 0;
     kproc->prempt_count = 0;
 
+    /* Sigue en la tabla del arranque (ASID 0) */
+    kproc->pgd = kernel_pgd;
+    kproc->asid = 0;
+    kproc->context.ttbr0 = (unsigned long)kernel_pgd;
+
     k_strncpy(kproc->name, "Kernel", 16);
 
     /* Apuntamos el puntero global al proceso 0 */
     current_process = kproc;
     num_process = 1;
 
+    /* Contextos de arranque de procesos de usuario */
+    user_context_cache = kmem_cache_create("user_context", sizeof(struct user_context), 0, nullptr);
+
     kprintf("   [PROC v0.6] Subsistema de procesos iniciado (Round-Robin + Quantum). PID 0 activo.\n");
 }
 
@@ -193,7 +408,8 @@ void init_process_system() {
  * @brief Termina el proceso actual y cede la CPU
  * 
  * @details
- *   Marca el proceso como ZOMBIE y llama a schedule().
+ *   Aborta el IPC pendiente contra él (ipc_exit), lo marca como
+ *   ZOMBIE y llama a schedule().
  *   El proceso ZOMBIE será limpiado posteriormente por free_zombie()
  *   en el loop principal del kernel, que liberará su stack y
  *   marcará el PCB como UNUSED para reutilización.
@@ -204,6 +420,9 @@ void exit(void) {
     kprintf("\n[KERNEL] Proceso %d (%d) ha terminado. Muriendo...\n",
             current_process->pid, current_process->priority);
 
+    /* Los clientes que esperaban a este proceso vuelven con error */
+    ipc_exit(current_process);
+
     /* Marcar como zombie (PCB persiste hasta implementar wait/reaper) */
     current_process->state = PROCESS_ZOMBIE;
 
@@ -227,17 +446,64 @@ void schedule_tail(void) {
     /* Placeholder para lógica post-context-switch */
 }
 
+/**
+ * @brief Devuelve un slot DEAD a UNUSED (callback de call_rcu)
+ *
+ * @details
+ *   Se ejecuta en un kworker tras el periodo de gracia: ya no queda
+ *   ningún lector de process_find() que pueda estar usando el PCB.
+ */
+static void process_free_rcu(struct rcu_head *head) {
+    struct pcb *p = container_of(head, struct pcb, rcu);
+
+    unsigned long flags = write_seqlock_irqsave(&process_table_lock);
+
+    /* 1. Desvincular la pila y el espacio de direcciones (se liberan
+          fuera del lock) */
+    void *stack = (void *)p->stack_addr;
+    p->stack_addr = 0;
+    unsigned long *pgd = p->pgd;
+    p->pgd = nullptr;
+
+    /* 2. Limpiar el resto de la estructura para evitar datos residuales */
+    p->pid = 0;
+    p->priority = 0;
+    p->cpu_time = 0;
+    p->wake_up_time = 0;
+    p->quantum = 0;
+    memset(p->name, 0, sizeof(p->name));
+
+    /* 3. Marcarlo como libre para que create_process() pueda reutilizarlo */
+    p->state = PROCESS_UNUSED;
+
+    write_sequnlock_irqrestore(&process_table_lock, flags);
+
+    /* 4. Liberar la memoria dinámica de la pila del proceso */
+    if (stack != nullptr) {
+        kfree(stack);
+    }
+
+    /* 5. Páginas de usuario y tablas (su ASID no se reutiliza en esta
+          generación: no hace falta invalidar la TLB) */
+    if (pgd != nullptr) {
+        vmm_destroy_pgd(pgd);
+    }
+
+    /* Nota: Si el proceso tuviera archivos abiertos, los cerraríamos aquí */
+}
+
 /**
  * @brief Libera recursos de procesos terminados (ZOMBIE reaper)
  * 
  * @details
  *   Función invocada periódicamente desde el loop principal del kernel.
  *   Recorre la tabla de procesos y para cada ZOMBIE:
- *   1. Libera su stack mediante kfree()
- *   2. Marca el PCB como UNUSED (reciclable)
- *   3. Decrementa num_process
+ *   1. Lo marca DEAD (process_find() deja de encontrarlo)
+ *   2. Encola process_free_rcu() con call_rcu(): tras el periodo de
+ *      gracia libera su stack y marca el PCB como UNUSED (reciclable)
  *   
- *   Esto completa el ciclo de vida: UNUSED → READY → RUNNING/BLOCKED → ZOMBIE → UNUSED
+ *   Esto completa el ciclo de vida:
+ *   UNUSED → READY → RUNNING/BLOCKED → ZOMBIE → DEAD → UNUSED
  */
 void free_zombie() {
     /* Recorremos toda la tabla de procesos */
@@ -245,44 +511,69 @@ void free_zombie() {
         if (process[i].state == PROCESS_ZOMBIE) {
             // kprintf("[REAPER] Limpiando PID %d\n", process[i].pid); // Debug opcional
 
-            /* 1. Liberar la memoria dinámica de la pila del proceso */
-            if (process[i].stack_addr != 0) {
-                kfree((void *)process[i].stack_addr);
-                process[i].stack_addr = 0;
-            }
-
-            /* 2. Limpiar el resto de la estructura para evitar datos residuales */
-            process[i].pid = 0;
-            process[i].priority = 0;
-            process[i].cpu_time = 0;
-            process[i].wake_up_time = 0;
-            process[i].quantum = 0;
-            memset(process[i].name, 0, sizeof(process[i].name));
-
-            /* 3. Marcarlo como libre para que create_process() pueda reutilizarlo */
-            process[i].state = PROCESS_UNUSED;
+            unsigned long flags = write_seqlock_irqsave(&process_table_lock);
+            process[i].state = PROCESS_DEAD;
+            write_sequnlock_irqrestore(&process_table_lock, flags);
 
-            /* Nota: Si el proceso tuviera archivos abiertos, los cerraríamos aquí */
+            call_rcu(&process[i].rcu, process_free_rcu);
         }
     }
 }
 
-/* ========================================================================== */
-/* SOPORTE PARA MODO USUARIO (EL0)                                          */
-/* ========================================================================== */
+/**
+ * @brief Busca un proceso vivo por PID sin tomar locks
+ *
+ * @details
+ *   Solo lee: ni locks ni escrituras atómicas. El llamador debe estar en
+ *   rcu_read_lock() (o con IRQs deshabilitadas) mientras use el PCB.
+ */
+struct pcb *process_find(long pid) {
+    if (pid < 0 || pid >= MAX_PROCESS) return nullptr;
+
+    struct pcb *p = &process[pid];
+    long state = READ_ONCE(p->state);
+    if (state == PROCESS_UNUSED || state == PROCESS_ZOMBIE || state == PROCESS_DEAD) {
+        return nullptr;
+    }
+    return p;
+}
 
 /**
- * @brief Estructura de contexto para transición a modo usuario
- * 
+ * @brief Copia coherente de un slot de la tabla de procesos
+ *
  * @details
- *   Almacena los registros necesarios para saltar de EL1 (Kernel) a EL0 (Usuario):
- *   - pc: Program Counter donde inicia el código de usuario
- *   - sp: Stack Pointer para el stack de usuario
+ *   Lectura con process_table_lock (seqlock): si process_alloc() o
+ *   free_zombie() cambian el slot durante la copia, se repite. Así pid
+ *   y nombre son siempre del mismo proceso. state, priority y
+ *   cpu_time los cambia el scheduler sin el seqlock: se toman como una
+ *   foto de ese instante.
  */
-struct user_context {
-    unsigned long pc;
-    unsigned long sp;
-};
+int process_get_info(int slot, struct proc_info *info) {
+    if (slot < 0 || slot >= MAX_PROCESS) return 0;
+
+    struct pcb *p = &process[slot];
+    unsigned long seq;
+
+    do {
+        seq = read_seqbegin(&process_table_lock);
+
+        info->pid = p->pid;
+        info->state = p->state;
+        info->priority = p->priority;
+        info->block_reason = p->block_reason;
+        info->cpu_time = p->cpu_time;
+        for (int i = 0; i < 16; i++) {
+            info->name[i] = p->name[i];
+        }
+    } while (read_seqretry(&process_table_lock, seq));
+
+    info->name[15] = '\0';
+    return info->state != PROCESS_UNUSED;
+}
+
+/* ========================================================================== */
+/* SOPORTE PARA MODO USUARIO (EL0)                                          */
+/* ========================================================================== */
 
 /**
  * @brief Función wrapper que realiza la transición a modo usuario
@@ -293,7 +584,7 @@ struct user_context {
  *   para procesos que necesitan ejecutarse en modo usuario (EL0).
  *   
  *   Flujo:
- *   1. Recibe el contexto de usuario (pc y sp)
+ *   1. Recibe el contexto de usuario (pc y sp) y lo devuelve a su caché
  *   2. Llama a move_to_user_mode() (ensamblador) que:
  *      - Configura SPSR_EL1 para retornar a EL0
  *      - Carga pc y sp en los registros correspondientes
@@ -301,9 +592,15 @@ struct user_context {
  */
 void kernel_to_user_wrapper(void *arg) {
     struct user_context *ctx = (struct user_context *)arg;
+    unsigned long pc = ctx->pc;
+    unsigned long sp = ctx->sp;
+
+    /* move_to_user_mode() no vuelve: devolver antes el contexto */
+    kmem_cache_free(user_context_cache, ctx);
+    current_process->is_user = 1;
 
     kprintf("[KERNEL] Saltando a Modo Usuario (EL0)...\n");
-    move_to_user_mode(ctx->pc, ctx->sp);
+    move_to_user_mode(pc, sp);
 }
 
 /**
@@ -320,8 +617,11 @@ void kernel_to_user_wrapper(void *arg) {
  *   - Menor privilegio (el usuario no puede ejecutar instrucciones sensibles)
  *   
  *   Flujo de creación:
- *   1. Asigna un stack de 4KB para el usuario
- *   2. Crea una estructura user_context con pc y sp
+ *   1. El stack de usuario es la cima de su espacio privado
+ *      (USER_VA_END): sus páginas llegan por demand paging con
+ *      permisos de EL0 (EC 0x24 en handle_fault, o is_user si el
+ *      fallo lo provoca el kernel en una syscall)
+ *   2. Toma un user_context de su caché slab con pc y sp
  *   3. Crea un proceso kernel que ejecuta kernel_to_user_wrapper()
  *   4. El wrapper realizará la transición a EL0 mediante move_to_user_mode()
  *   
@@ -331,14 +631,18 @@ void kernel_to_user_wrapper(void *arg) {
  *   por handle_fault() en sys.c.
  */
 long create_user_process(void (*user_fn)(void), const char *name) {
-    /* 1. Stack de Usuario */
-    void *user_stack = kmalloc(4096);
-
-    /* 2. Contexto de arranque */
-    struct user_context *ctx = (struct user_context *)kmalloc(sizeof(struct user_context));
+    /* 1-2. Contexto de arranque (slab: sin cabecera de kmalloc) */
+    struct user_context *ctx = (struct user_context *)kmem_cache_alloc(user_context_cache);
+    if (ctx == nullptr) {
+        return -1;
+    }
     ctx->pc = (unsigned long)user_fn;
-    ctx->sp = (unsigned long)user_stack + 4096;
+    ctx->sp = USER_VA_END;
 
     /* 3. Crear proceso Kernel que saltara a User */
-    return create_process(kernel_to_user_wrapper, ctx, 10, name);
+    long pid = create_process(kernel_to_user_wrapper, ctx, 10, name);
+    if (pid < 0) {
+        kmem_cache_free(user_context_cache, ctx);
+    }
+    return pid;
 }
\ No newline at end of file
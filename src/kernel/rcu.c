@@ -0,0 +1,133 @@
+/**
+ * @file rcu.c
+ * @brief Implementación de periodos de gracia y callbacks RCU
+ *
+ * @details
+ *   ESTADO:
+ *   - rcu_gp_seq: número de estados quiescentes (pasos por schedule())
+ *   - rcu_wait: callbacks encolados desde el último estado quiescente
+ *   - rcu_ready: callbacks cuyo periodo de gracia ya terminó
+ *
+ *   FLUJO DE call_rcu():
+ *   @code
+ *   call_rcu()                    -> rcu_wait
+ *   schedule()
+ *     rcu_note_context_switch()   -> rcu_wait pasa a rcu_ready,
+ *                                    schedule_work(&rcu_work)
+ *   kworker: rcu_do_callbacks()   -> ejecuta rcu_ready
+ *   @endcode
+ *
+ *   Las listas se tocan desde schedule() (IRQs deshabilitadas) y desde
+ *   cualquier contexto en call_rcu(): todo entre local_irq_save() y
+ *   local_irq_restore().
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ * @see rcu.h para interfaz pública
+ */
+
+#include "../../include/kernel/rcu.h"
+#include "../../include/kernel/workqueue.h"
+
+extern unsigned long local_irq_save(void);
+extern void local_irq_restore(unsigned long flags);
+
+/* ========================================================================== */
+/* ESTADO GLOBAL                                                             */
+/* ========================================================================== */
+
+/* Estados quiescentes registrados (cada paso por schedule()) */
+static volatile unsigned long rcu_gp_seq = 0;
+
+/* Callbacks esperando el próximo estado quiescente */
+static struct rcu_head *rcu_wait_head = nullptr;
+static struct rcu_head **rcu_wait_tail = &rcu_wait_head;
+
+/* Callbacks con el periodo de gracia completado */
+static struct rcu_head *rcu_ready_head = nullptr;
+static struct rcu_head **rcu_ready_tail = &rcu_ready_head;
+
+static struct work_struct rcu_work;
+static unsigned long rcu_cb_done = 0;
+
+/* ========================================================================== */
+/* CALLBACKS                                                                 */
+/* ========================================================================== */
+
+/**
+ * @brief Ejecuta los callbacks listos (work en un kworker)
+ */
+static void rcu_do_callbacks(struct work_struct *work) {
+    (void)work;
+
+    unsigned long flags = local_irq_save();
+    struct rcu_head *list = rcu_ready_head;
+    rcu_ready_head = nullptr;
+    rcu_ready_tail = &rcu_ready_head;
+    local_irq_restore(flags);
+
+    while (list != nullptr) {
+        struct rcu_head *next = list->next;
+        list->func(list);
+        rcu_cb_done++;
+        list = next;
+    }
+}
+
+void rcu_init(void) {
+    init_work(&rcu_work, rcu_do_callbacks);
+}
+
+void call_rcu(struct rcu_head *head, void (*func)(struct rcu_head *head)) {
+    head->func = func;
+    head->next = nullptr;
+
+    unsigned long flags = local_irq_save();
+    *rcu_wait_tail = head;
+    rcu_wait_tail = &head->next;
+    local_irq_restore(flags);
+}
+
+/* ========================================================================== */
+/* PERIODOS DE GRACIA                                                        */
+/* ========================================================================== */
+
+/**
+ * @brief Registra un estado quiescente (schedule(), IRQs deshabilitadas)
+ *
+ * @details
+ *   Los lectores no pueden ser expropiados, así que quien llama a
+ *   schedule() no está en una sección de lectura y ningún otro proceso
+ *   se quedó a mitad de una: los callbacks encolados hasta ahora ya
+ *   pueden ejecutarse.
+ */
+void rcu_note_context_switch(void) {
+    rcu_gp_seq++;
+
+    if (rcu_wait_head != nullptr) {
+        *rcu_ready_tail = rcu_wait_head;
+        rcu_ready_tail = rcu_wait_tail;
+        rcu_wait_head = nullptr;
+        rcu_wait_tail = &rcu_wait_head;
+
+        schedule_work(&rcu_work);
+    }
+}
+
+void synchronize_rcu(void) {
+    unsigned long start = rcu_gp_seq;
+
+    while (rcu_gp_seq == start) {
+        unsigned long flags = local_irq_save();
+        schedule();
+        local_irq_restore(flags);
+    }
+}
+
+unsigned long rcu_gp_count(void) {
+    return rcu_gp_seq;
+}
+
+unsigned long rcu_callbacks_done(void) {
+    return rcu_cb_done;
+}
@@ -20,15 +20,27 @@
  *   SLEEP Y WAKE-UP EFICIENTES:
  *   - Procesos durmiendo entran en estado BLOCKED
  *   - NO consumen CPU mientras duermen
- *   - timer_tick() despierta procesos cuando wake_up_time llega
+ *   - timer_tick() (IRQ) solo detecta que hay un evento vencido y marca
+ *     SOFTIRQ_TIMER; timer_softirq() los despierta fuera del hard-IRQ
+ *
+ *   BASE DE TIEMPOS:
+ *   - sys_timer_count (ticks) y el CNTPCT del último tick se publican
+ *     juntos bajo un seqcount (único escritor: timer_tick() en el IRQ).
+ *     sys_time_read() devuelve siempre una pareja coherente
  * 
  * @author Sistema Operativo Educativo BareMetalM4
- * @version 0.6
+ * @version 0.7
  */
 
 #include "../../include/sched.h"
 #include "../../include/kernel/process.h"
 #include "../../include/kernel/scheduler.h"
+#include "../../include/kernel/softirq.h"
+#include "../../include/kernel/workqueue.h"
+#include "../../include/seqlock.h"
+#include "../../include/kernel/rcu.h"
+#include "../../include/kernel/wait.h"
+#include "../../include/mm/asid.h"
 
 /* ========================================================================== */
 /* FUNCIONES EXTERNAS (Ensamblador)                                         */
@@ -38,6 +50,14 @@
 extern void cpu_switch_to(struct pcb *prev, struct pcb *next);
 
 extern void enable_interrupts(void);
+extern unsigned long local_irq_save(void);
+extern void local_irq_restore(unsigned long flags);
+
+/* Valor del contador del sistema CNTPCT (src/utils.S) */
+extern unsigned long timer_get_count(void);
+
+/* Bit I de DAIF (IRQs enmascaradas) en el valor de local_irq_save() */
+#define DAIF_IRQ_BIT (1UL << 7)
 
 /* Bandera global para indicar que se debe llamar a schedule()
    Marcada cuando un proceso agota su quantum o debe ceder la CPU */
@@ -46,9 +66,36 @@ volatile int need_reschedule = 0;
 /**
  * @brief Verifica si hay un cambio de contexto pendiente
  * @return 1 si need_reschedule está activo, 0 en caso contrario
+ *
+ * @details
+ *   Si el IRQ llegó mientras se ejecutaban softirqs, no se cambia de
+ *   contexto aquí: la bandera se mantiene y el IRQ exterior llamará a
+ *   schedule() al terminar do_softirq().
+ *
+ *   Tampoco si el proceso interrumpido está en una sección sin
+ *   expropiación (preempt_disable / rcu_read_lock): preempt_enable()
+ *   atenderá la bandera al salir de ella.
  */
-int is_reschedule_pending () {
-    return need_reschedule;
+int is_reschedule_pending(void) {
+    return need_reschedule && !in_softirq() && current_process->prempt_count == 0;
+}
+
+/**
+ * @brief Cede la CPU al cerrar una sección sin expropiación
+ *
+ * @details
+ *   Solo desde contexto de proceso con IRQs habilitadas. Si se llega
+ *   desde un IRQ o una softirq (DAIF.I activo o in_softirq()), no se
+ *   hace nada: la salida del IRQ volverá a consultar la bandera.
+ */
+void preempt_schedule(void) {
+    unsigned long flags = local_irq_save();
+
+    if (!(flags & DAIF_IRQ_BIT) && !in_softirq() && need_reschedule) {
+        schedule();
+    }
+
+    local_irq_restore(flags);
 }
 
 /* ========================================================================== */
@@ -78,11 +125,15 @@ int is_reschedule_pending () {
  *      - Se le asigna un nuevo quantum completo
  *   
  *   4. CONTEXT SWITCH:
- *      - Si prev != next, se cambia el contexto con cpu_switch_to()
+ *      - Si prev != next, switch_mm() prepara el TTBR0 (tabla + ASID)
+ *        de next y se cambia el contexto con cpu_switch_to()
  *      - Guarda registros del proceso anterior
  *      - Restaura registros del proceso siguiente
  */
 void schedule(void) {
+    /* Pasar por aquí es un estado quiescente para RCU */
+    rcu_note_context_switch();
+
     need_reschedule = 0;
 
     /* 1. Fase de Envejecimiento */
@@ -137,7 +188,12 @@ void schedule(void) {
         next->state = PROCESS_RUNNING;
         current_process = next;
 
+        /* Sin IRQs entre preparar el TTBR0 de 'next' y cargarlo: un
+           cambio de generación de ASIDs en medio lo dejaría obsoleto */
+        unsigned long flags = local_irq_save();
+        switch_mm(next);
         cpu_switch_to(prev, next);
+        local_irq_restore(flags);
     }
 }
 
@@ -148,6 +204,55 @@ void schedule(void) {
 /* Contador global de ticks del sistema */
 volatile unsigned long sys_timer_count = 0;
 
+/* CNTPCT en el último tick y seqcount que lo une a sys_timer_count */
+static volatile unsigned long sys_timer_stamp = 0;
+static struct seqcount sys_time_seq;
+
+/**
+ * @brief Lee de forma coherente el tick actual y su instante CNTPCT
+ * @param stamp Si no es nullptr, recibe el CNTPCT del último tick
+ * @return sys_timer_count
+ *
+ * @details
+ *   Lector del seqcount: no deshabilita IRQs. Si un tick llega a mitad
+ *   de la lectura, se repite. No debe llamarse desde el IRQ del timer.
+ */
+unsigned long sys_time_read(unsigned long *stamp) {
+    unsigned long seq, ticks, cycles;
+
+    do {
+        seq = read_seqcount_begin(&sys_time_seq);
+        ticks = sys_timer_count;
+        cycles = sys_timer_stamp;
+    } while (read_seqcount_retry(&sys_time_seq, seq));
+
+    if (stamp != nullptr) {
+        *stamp = cycles;
+    }
+    return ticks;
+}
+
+/* Tick del próximo evento temporal (sleep o delayed work) más cercano.
+   timer_tick() solo marca SOFTIRQ_TIMER cuando se alcanza, así los ticks
+   sin eventos no recorren process[]. */
+static volatile unsigned long next_timer_event = ~0UL;
+
+/**
+ * @brief Registra un evento temporal futuro
+ * @param when Tick absoluto en el que el evento debe procesarse
+ *
+ * @details
+ *   Adelanta next_timer_event si 'when' es anterior. Seguro desde
+ *   cualquier contexto.
+ */
+void timer_schedule_event(unsigned long when) {
+    unsigned long flags = local_irq_save();
+    if (when < next_timer_event) {
+        next_timer_event = when;
+    }
+    local_irq_restore(flags);
+}
+
 /**
  * @brief Manejador de ticks del timer
  * 
@@ -165,13 +270,16 @@ volatile unsigned long sys_timer_count = 0;
  *      - Incrementa cpu_time del proceso actual
  *      - Incrementa sys_timer_count (reloj global del sistema)
  *   
- *   3. WAKE-UP DE PROCESOS DURMIENDO:
- *      - Recorre todos los procesos BLOCKED
- *      - Si block_reason = SLEEP y wake_up_time <= now, los despierta
- *      - Los marca como READY para que schedule() pueda elegirlos
+ *   3. EVENTOS TEMPORALES (diferidos):
+ *      - Si se alcanzó next_timer_event, marca SOFTIRQ_TIMER
+ *      - El recorrido de process[] se hace en timer_softirq(), ya con
+ *        las IRQs habilitadas, acortando la latencia de interrupción
  */
 void timer_tick(void) {
+    write_seqcount_begin(&sys_time_seq);
     sys_timer_count++;
+    sys_timer_stamp = timer_get_count();
+    write_seqcount_end(&sys_time_seq);
 
     if (current_process->state == PROCESS_RUNNING) {
         current_process->cpu_time++;
@@ -195,23 +303,69 @@ void timer_tick(void) {
         }
     }
 
+    /* === EVENTOS TEMPORALES: SE DIFIEREN A LA SOFTIRQ === */
+    if (sys_timer_count >= next_timer_event) {
+        raise_softirq(SOFTIRQ_TIMER);
+    }
+}
+
+/**
+ * @brief Softirq del timer: despierta procesos y expira delayed work
+ *
+ * @details
+ *   Se ejecuta en do_softirq() (IRQs habilitadas):
+ *   1. Recorre los procesos BLOCKED por SLEEP con wake_up_time vencido
+ *      y los marca como READY; los que esperan en una wait queue con
+ *      timeout vencido salen de ella (wait_queue_timeout)
+ *   2. Recalcula next_timer_event con los que siguen durmiendo
+ *   3. Expira el delayed work vencido (delayed_work_tick)
+ *
+ *   El estado de cada PCB se modifica con IRQs deshabilitadas, porque
+ *   sleep() puede estar tocando el mismo PCB desde contexto de proceso.
+ */
+void timer_softirq(void) {
+    unsigned long now = sys_timer_count;
+    unsigned long next = ~0UL;
+
+    unsigned long flags = local_irq_save();
+    next_timer_event = ~0UL;
+    local_irq_restore(flags);
+
     /* === WAKE-UP DE PROCESOS DURMIENDO === */
-    /* Recorremos todos los procesos para despertar los que ya deben levantarse */
     for (int i = 0; i < MAX_PROCESS; i++) {
-        if (process[i].state == PROCESS_BLOCKED) {
-            /* Solo despertamos procesos que están durmiendo (sleep) */
-            if (process[i].block_reason == BLOCK_REASON_SLEEP) {
-                /* Verificamos si ya pasó su tiempo de despertar */
-                if (process[i].wake_up_time <= sys_timer_count) {
-                    process[i].state = PROCESS_READY;
-                    process[i].block_reason = BLOCK_REASON_NONE;
-                    // kprintf(" [KERNEL] Despertando proceso %d en tick %d\n", i, sys_timer_count);    // DEBUG
-                }
+        flags = local_irq_save();
+        /* Solo despertamos procesos que están durmiendo (sleep) */
+        if (process[i].state == PROCESS_BLOCKED &&
+            process[i].block_reason == BLOCK_REASON_SLEEP) {
+            /* Verificamos si ya pasó su tiempo de despertar */
+            if (process[i].wake_up_time <= now) {
+                process[i].state = PROCESS_READY;
+                process[i].block_reason = BLOCK_REASON_NONE;
+            } else if (process[i].wake_up_time < next) {
+                next = process[i].wake_up_time;
             }
-            /* Nota: Los procesos BLOCKED por semáforos (BLOCK_REASON_WAIT)
-               se despiertan en sem_signal(), NO aquí */
         }
+        /* Esperando en una wait queue con timeout (wait_event_timeout) */
+        else if (process[i].state == PROCESS_BLOCKED &&
+                 process[i].wait_queue != nullptr &&
+                 process[i].wake_up_time != 0) {
+            if (process[i].wake_up_time <= now) {
+                wait_queue_timeout(&process[i]);
+            } else if (process[i].wake_up_time < next) {
+                next = process[i].wake_up_time;
+            }
+        }
+        /* Nota: Los procesos BLOCKED por semáforos (BLOCK_REASON_WAIT)
+           se despiertan en sem_signal(), NO aquí */
+        local_irq_restore(flags);
     }
+
+    if (next != ~0UL) {
+        timer_schedule_event(next);
+    }
+
+    /* === DELAYED WORK VENCIDO === */
+    delayed_work_tick(now);
 }
 
 /* ========================================================================== */
@@ -227,9 +381,10 @@ void timer_tick(void) {
  *   
  *   1. Calcula wake_up_time = sys_timer_count + ticks
  *   2. Marca el proceso como BLOCKED con block_reason = SLEEP
- *   3. Llama a schedule() para ceder la CPU inmediatamente
- *   4. El proceso NO consume CPU mientras duerme
- *   5. timer_tick() lo despertará cuando wake_up_time llegue
+ *   3. Registra el evento con timer_schedule_event()
+ *   4. Llama a schedule() para ceder la CPU inmediatamente
+ *   5. El proceso NO consume CPU mientras duerme
+ *   6. timer_softirq() lo despertará cuando wake_up_time llegue
  *   
  *   VENTAJA vs BUSY-WAIT:
  *   - En busy-wait: El proceso sigue consumiendo CPU en un bucle
@@ -240,6 +395,7 @@ void sleep(unsigned int ticks) {
     current_process->wake_up_time = sys_timer_count + ticks;
     current_process->state = PROCESS_BLOCKED;
     current_process->block_reason = BLOCK_REASON_SLEEP;
+    timer_schedule_event(current_process->wake_up_time);
     schedule();
 
     enable_interrupts();
@@ -0,0 +1,102 @@
+/**
+ * @file softirq.c
+ * @brief Implementación de softirqs (mitad "soft" de las interrupciones)
+ *
+ * @details
+ *   FLUJO DE UN IRQ CON SOFTIRQS:
+ *   @code
+ *   irq_handler_stub:
+ *     kernel_entry
+ *     handle_timer_irq()   <- IRQs deshabilitadas, trabajo mínimo
+ *       timer_tick()       <- raise_softirq(SOFTIRQ_TIMER)
+ *     do_softirq()         <- IRQs habilitadas, trabajo caro
+ *       timer_softirq()    <- despierta procesos, expira delayed work
+ *     schedule() si need_reschedule
+ *     kernel_exit
+ *   @endcode
+ *
+ *   Mientras do_softirq() ejecuta handlers, las IRQs están habilitadas, por lo
+ *   que la latencia de interrupción queda acotada por la mitad "hard" y no
+ *   por el trabajo diferido.
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ */
+
+#include "../../include/kernel/softirq.h"
+#include "../../include/drivers/timer.h"
+
+/* Tabla de handlers registrados con open_softirq() */
+static void (*softirq_vec[NR_SOFTIRQS])(void);
+
+/* Máscara de softirqs pendientes (bit N = softirq N) */
+static volatile unsigned long softirq_pending = 0;
+
+/* 1 mientras do_softirq() está ejecutando handlers (evita anidamiento) */
+static volatile int softirq_running = 0;
+
+/**
+ * @brief Registra el handler de una softirq
+ * @param nr Número de softirq
+ * @param handler Función a ejecutar
+ */
+void open_softirq(int nr, void (*handler)(void)) {
+    if (nr < 0 || nr >= NR_SOFTIRQS) return;
+    softirq_vec[nr] = handler;
+}
+
+/**
+ * @brief Marca una softirq como pendiente
+ * @param nr Número de softirq
+ *
+ * @details
+ *   La actualización de la máscara se hace con IRQs enmascaradas para que
+ *   un IRQ no pueda perder un bit a mitad de la lectura-modificación-escritura.
+ */
+void raise_softirq(int nr) {
+    unsigned long flags = local_irq_save();
+    softirq_pending |= (1UL << nr);
+    local_irq_restore(flags);
+}
+
+/**
+ * @brief Indica si estamos ejecutando softirqs
+ */
+int in_softirq(void) {
+    return softirq_running;
+}
+
+/**
+ * @brief Ejecuta las softirqs pendientes
+ *
+ * @details
+ *   1. Si ya estamos dentro (IRQ anidado) o no hay nada pendiente, salir
+ *   2. Capturar y limpiar la máscara pendiente (con IRQs deshabilitadas)
+ *   3. Habilitar IRQs y ejecutar cada handler marcado, en orden de número
+ *   4. Repetir si los handlers (o nuevos IRQs) marcaron más trabajo,
+ *      hasta MAX_SOFTIRQ_RESTART pasadas
+ *   5. Volver con IRQs deshabilitadas (kernel_exit las restaurará vía SPSR)
+ */
+void do_softirq(void) {
+    if (softirq_running || softirq_pending == 0) return;
+
+    softirq_running = 1;
+
+    int restart = MAX_SOFTIRQ_RESTART;
+    unsigned long pending;
+
+    while (restart-- > 0 && (pending = softirq_pending) != 0) {
+        softirq_pending = 0;
+        enable_interrupts();
+
+        for (int nr = 0; pending != 0; nr++, pending >>= 1) {
+            if ((pending & 1) && softirq_vec[nr]) {
+                softirq_vec[nr]();
+            }
+        }
+
+        disable_interrupts();
+    }
+
+    softirq_running = 0;
+}
@@ -8,6 +8,8 @@
  *   SYSCALLS BÁSICAS:
  *   - SYS_WRITE (0): Escritura en consola desde procesos de usuario
  *   - SYS_EXIT (1): Terminación de proceso con código de salida
+ *   - SYS_FUTEX (4): Espera/despertar por dirección (kernel/futex.c)
+ *   - SYS_FORK (5): Clona el proceso con copy-on-write (process_fork)
  *   - Dispatcher central para manejo de SVC (Supervisor Call)
  *   
  *   DEMAND PAGING (Paginación por Demanda):
@@ -22,12 +24,13 @@
  *   - Terminación segura de procesos con fallos inválidos
  * 
  * @author Sistema Operativo Educativo BareMetalM4
- * @version 0.6
+ * @version 0.7
  */
 
 #include "../../include/kernel/sys.h"
 #include "../../include/drivers/io.h"
 #include "../../include/kernel/process.h"
+#include "../../include/kernel/futex.h"
 #include "../../include/mm/vmm.h"
 #include "../../include/mm/pmm.h"
 #include "../../include/mm/mm.h"
@@ -74,6 +77,9 @@ void sys_exit(int code) {
  *   Este handler es llamado desde sync_handler en entry.S cuando
  *   se ejecuta una instrucción SVC. Despacha la syscall apropiada
  *   según el número en el registro x8.
+ *
+ *   Las syscalls con resultado lo escriben en regs->x0: kernel_exit lo
+ *   restaura en x0 al volver al proceso.
  */
 void syscall_handler(struct pt_regs *regs, int syscall) {
     switch (syscall) {
@@ -96,6 +102,15 @@ void syscall_handler(struct pt_regs *regs, int syscall) {
             /* sys_read((int)regs->x0, (char*)regs->x1, (int)regs->x2); */
             break;
 
+        case SYS_FUTEX:
+            sys_futex(regs);
+            break;
+
+        case SYS_FORK:
+            /* Padre: PID del hijo (-1 si falla). El hijo vuelve con 0 */
+            regs->x0 = (unsigned long)process_fork(regs);
+            break;
+
         default:
             kprintf("Syscall desconocida: %d\n", syscall);
             break;
@@ -113,10 +128,10 @@ void syscall_handler(struct pt_regs *regs, int syscall) {
  *   Handler principal para excepciones Data Abort. Implementa:
  *   
  *   PAGINACIÓN POR DEMANDA (Demand Paging):
- *   - Detecta Page Faults legítimos (EC=0x24 kernel, EC=0x25 usuario)
+ *   - Detecta Page Faults legítimos (EC=0x24 desde EL0, EC=0x25 desde EL1)
  *   - Asigna página física bajo demanda con get_free_page()
  *   - Mapea la página en las tablas de páginas (L1/L2/L3)
- *   - Invalida TLB para que la MMU vea la nueva entrada
+ *   - Publica la entrada (tlb_map_barrier()): sin invalidar la TLB
  *   - Reintenta la instrucción → ¡Éxito!
  *   
  *   VENTAJAS DEL DEMAND PAGING:
@@ -126,14 +141,14 @@ void syscall_handler(struct pt_regs *regs, int syscall) {
  *   - ✅ Transparente: El proceso no sabe que hubo un page fault
  *   
  *   FLUJO DEL DEMAND PAGING:
- *   1. Proceso intenta acceder a dirección no mapeada (ej: 0x50000000)
+ *   1. Proceso intenta acceder a dirección no mapeada (ej: DEMAND_VA_BASE)
  *   2. CPU genera Data Abort (Page Fault)
  *   3. Se ejecuta este handler
  *   4. Leemos FAR_EL1 (dirección que falló) y ESR_EL1 (causa)
  *   5. Si es page fault legítimo:
  *      a. Asignamos página física del PMM
  *      b. Mapeamos virtual→física en tablas de páginas
- *      c. Invalidamos TLB
+ *      c. Barrera: la TLB no tenía la entrada, no se invalida
  *      d. Retornamos → CPU reintenta la instrucción → Éxito
  *   6. Si no hay RAM o es acceso inválido:
  *      - Imprimimos error
@@ -143,12 +158,21 @@ void syscall_handler(struct pt_regs *regs, int syscall) {
  *   - FAR_EL1: Fault Address Register (qué dirección falló)
  *   - ESR_EL1: Exception Syndrome Register (por qué falló)
  *     - EC (bits 31:26): Exception Class
- *       - 0x24: Data Abort desde EL1 (kernel)
- *       - 0x25: Data Abort desde EL0 (usuario)
+ *       - 0x24: Data Abort desde un nivel inferior (EL0, usuario)
+ *       - 0x25: Data Abort desde el mismo nivel (EL1, kernel)
+ * 
+ *   COPY-ON-WRITE:
+ *   - Un fallo de permisos en escritura sobre una página de solo lectura
+ *     compartida (checkpoints) se resuelve con vmm_cow_fault()
+ *   
+ *   ESPACIO DE DIRECCIONES:
+ *   - Solo se resuelven fallos en [DEMAND_VA_BASE, USER_VA_END), y se
+ *     mapean en la tabla base del proceso actual (current_process->pgd)
+ *   - Cualquier otra dirección pertenece a las entradas del kernel que
+ *     comparten todos los procesos: el fallo termina el proceso
  * 
  * @note En un SO real, aquí también se verificaría:
  *   - Límites del heap/stack del proceso
- *   - Copy-on-Write para fork()
  *   - Swap a disco si no hay RAM
  */
 void handle_fault(void) {
@@ -165,13 +189,32 @@ void handle_fault(void) {
     unsigned long ec = esr >> 26;
 
     /* === 2. VERIFICAR SI ES UN PAGE FAULT === */
-    /* EC = 0x24 (Data Abort en Kernel - EL1) */
-    /* EC = 0x25 (Data Abort en Usuario - EL0) */
-    if (ec == 0x24 || ec == 0x25) {
-        kprintf("\n[MMU] Page Fault (Demand Paging) en dir: 0x%x\n", far);
+    /* EC = 0x24 (Data Abort desde EL0 - Usuario) */
+    /* EC = 0x25 (Data Abort desde EL1 - Kernel) */
+    /* Solo el espacio privado del proceso se pagina por demanda: un fallo
+       en el kernel o en las entradas compartidas (NULL incluido) es un error */
+    unsigned long *pgd = current_process->pgd;
+    int in_user_space = (far >= DEMAND_VA_BASE && far < USER_VA_END);
 
-        /* === 3. ASIGNAR PÁGINA FÍSICA DEL PMM === */
-        unsigned long phys_page = get_free_page();
+    if ((ec == 0x24 || ec == 0x25) && in_user_space) {
+        /* === 2b. ESCRITURA EN PÁGINA COPY-ON-WRITE === */
+        /* DFSC 0b0011xx = Permission fault; WnR (bit 6) = fue una escritura */
+        if ((esr & 0x3C) == 0x0C && (esr & (1 << 6))) {
+            if (vmm_cow_fault(pgd, far) == 0) {
+                return;
+            }
+        }
+
+        /* === 2c. SOLO FALLOS DE TRADUCCIÓN (DFSC 0b0001xx) === */
+        /* Con la página ya mapeada (permisos) no hay nada que asignar, y
+           tlb_map_barrier() del paso 6 solo vale sobre entradas vacías */
+        unsigned long phys_page = 0;
+        if ((esr & 0x3C) == 0x04) {
+            kprintf("\n[MMU] Page Fault (Demand Paging) en dir: 0x%x\n", far);
+
+            /* === 3. ASIGNAR PÁGINA FÍSICA DEL PMM === */
+            phys_page = get_free_page();
+        }
         if (phys_page) {
             kprintf("      -> Resolviendo: Asignando página física 0x%x\n", phys_page);
 
@@ -179,17 +222,28 @@ void handle_fault(void) {
             unsigned long virt_aligned = far & ~(PAGE_SIZE - 1);
 
             /* === 4. CONFIGURAR PERMISOS SEGÚN NIVEL DE PRIVILEGIO === */
-            /* Si el fallo vino de EL0 (Usuario), damos permisos de usuario */
-            unsigned long flags = (ec == 0x25) ? (MM_RW | MM_USER | MM_SH | (ATTR_NORMAL << 2))
-                                               : (MM_RW | MM_KERNEL | MM_SH | (ATTR_NORMAL << 2));
+            /* Si el fallo vino de EL0 (Usuario), damos permisos de usuario.
+               También si el kernel toca la memoria de un proceso de EL0
+               (p. ej. dentro de una syscall): la página es suya.
+               MM_NG: la entrada es del proceso y en la TLB va con su ASID */
+            int user = (ec == 0x24) || current_process->is_user;
+            unsigned long flags = user ? (MM_RW | MM_USER | MM_SH | MM_NG | (ATTR_NORMAL << 2))
+                                       : (MM_RW | MM_KERNEL | MM_SH | MM_NG | (ATTR_NORMAL << 2));
+
+            /* === 5. MAPEAR EN LAS TABLAS DEL PROCESO (L1/L2/L3) === */
+            map_page(pgd, virt_aligned, phys_page, flags);
 
-            /* === 5. MAPEAR EN TABLAS DE PÁGINAS (L1/L2/L3) === */
-            map_page(kernel_pgd, virt_aligned, phys_page, flags);
+            /* Registrar la página en el proceso (para checkpoint) */
+            if (current_process->nr_vm_pages < PROC_MAX_VM_PAGES) {
+                current_process->vm_pages[current_process->nr_vm_pages++] = virt_aligned;
+            }
 
-            /* === 6. INVALIDAR TLB === */
-            /* La TLB cachea traducciones. Hay que invalidarla para que
-               la MMU vea la nueva entrada en las tablas de páginas */
-            tlb_invalidate_all();
+            /* === 6. PUBLICAR LA ENTRADA (SIN INVALIDAR LA TLB) === */
+            /* Fue un fallo de traducción: la TLB nunca guarda entradas
+               inválidas, así que no hay nada viejo que invalidar. Basta con
+               que el recorrido de tablas vea el descriptor nuevo; el resto
+               de traducciones del proceso y del kernel siguen en la TLB */
+            tlb_map_barrier();
 
             /* === 7. RETORNAR Y REINTENTAR === */
             /* ÉXITO: Al hacer 'return', la CPU automáticamente reintentará
@@ -197,7 +251,7 @@ void handle_fault(void) {
                y el acceso funcionará correctamente. El proceso continúa
                sin saber que hubo un page fault (transparente). */
             return;
-        } else {
+        } else if ((esr & 0x3C) == 0x04) {
             /* ERROR CRÍTICO: No hay RAM disponible */
             kprintf("[PMM] CRITICAL: Out of Memory. Imposible resolver Page Fault.\n");
         }
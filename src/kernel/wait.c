@@ -0,0 +1,170 @@
+/**
+ * @file wait.c
+ * @brief Implementación de las wait queues genéricas
+ *
+ * @details
+ *   CICLO DE UNA ESPERA:
+ *   @code
+ *   wait_event_timeout(wq, cond, t)       (IRQs deshabilitadas)
+ *     cond falsa -> wait_queue_block()
+ *                     encolar, BLOCKED, wake_up_time = ahora + t
+ *                     schedule()
+ *                                         wake_up(): desencola, READY
+ *                                      o  timer_softirq(): vence t,
+ *                                         wait_queue_timeout()
+ *                     devuelve ticks restantes
+ *     volver a comprobar cond
+ *   @endcode
+ *
+ *   Quien despierta siempre saca al proceso de la cola y pone
+ *   p->wait_queue a nullptr, así una espera no puede despertarse dos
+ *   veces (wake_up y timeout a la vez).
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ * @see wait.h para interfaz pública
+ */
+
+#include "../../include/kernel/wait.h"
+#include "../../include/barrier.h"
+#include "../../include/kernel/process.h"
+#include "../../include/kernel/scheduler.h"
+
+/* ========================================================================== */
+/* FUNCIONES AUXILIARES                                                      */
+/* ========================================================================== */
+
+/**
+ * @brief Quita 'p' de la cola (lock de la cola tomado)
+ */
+static void wait_queue_remove(struct wait_queue_head *wq, struct pcb *p) {
+    struct pcb *prev = nullptr;
+
+    for (struct pcb *it = wq->head; it != nullptr; prev = it, it = it->next) {
+        if (it != p) continue;
+
+        if (prev == nullptr) {
+            wq->head = p->next;
+        } else {
+            prev->next = p->next;
+        }
+        if (wq->tail == p) {
+            wq->tail = prev;
+        }
+        break;
+    }
+    p->next = nullptr;
+    p->wait_queue = nullptr;
+}
+
+/**
+ * @brief Pasa a READY un proceso ya fuera de la cola
+ */
+static void wait_queue_wake(struct pcb *p) {
+    p->wake_up_time = 0;
+    p->state = PROCESS_READY;
+    p->block_reason = BLOCK_REASON_NONE;
+}
+
+/* ========================================================================== */
+/* API PÚBLICA                                                               */
+/* ========================================================================== */
+
+void init_waitqueue_head(struct wait_queue_head *wq) {
+    wq->lock = 0;
+    wq->head = nullptr;
+    wq->tail = nullptr;
+}
+
+long wait_queue_block(struct wait_queue_head *wq, long timeout) {
+    struct pcb *me = current_process;
+    unsigned long deadline = 0;
+
+    spin_lock(&wq->lock);
+
+    me->next = nullptr;
+    if (wq->tail == nullptr) {
+        wq->head = me;
+    } else {
+        wq->tail->next = me;
+    }
+    wq->tail = me;
+    me->wait_queue = wq;
+
+    if (timeout != WAIT_FOREVER) {
+        deadline = sys_timer_count + (unsigned long)timeout;
+        me->wake_up_time = deadline;
+        timer_schedule_event(deadline);
+    } else {
+        me->wake_up_time = 0;
+    }
+
+    me->state = PROCESS_BLOCKED;
+    me->block_reason = BLOCK_REASON_WAIT;
+
+    /* Soltar el lock antes de dormir; IRQs deshabilitadas hasta el
+       cambio de contexto */
+    spin_unlock(&wq->lock);
+    schedule();
+
+    /* Despertado por otra vía (no debería ocurrir): salir de la cola */
+    if (me->wait_queue != nullptr) {
+        spin_lock(&wq->lock);
+        wait_queue_remove(wq, me);
+        spin_unlock(&wq->lock);
+    }
+    me->wake_up_time = 0;
+
+    if (timeout == WAIT_FOREVER) {
+        return WAIT_FOREVER;
+    }
+    unsigned long now = sys_timer_count;
+    return (deadline > now) ? (long)(deadline - now) : 0;
+}
+
+int wake_up_one(struct wait_queue_head *wq) {
+    unsigned long flags = spin_lock_irqsave(&wq->lock);
+
+    struct pcb *p = wq->head;
+    if (p != nullptr) {
+        wait_queue_remove(wq, p);
+        wait_queue_wake(p);
+        need_reschedule = 1;
+    }
+
+    spin_unlock_irqrestore(&wq->lock, flags);
+    return p != nullptr;
+}
+
+int wake_up(struct wait_queue_head *wq) {
+    int woken = 0;
+    unsigned long flags = spin_lock_irqsave(&wq->lock);
+
+    while (wq->head != nullptr) {
+        struct pcb *p = wq->head;
+        wait_queue_remove(wq, p);
+        wait_queue_wake(p);
+        woken++;
+    }
+    if (woken > 0) {
+        need_reschedule = 1;
+    }
+
+    spin_unlock_irqrestore(&wq->lock, flags);
+    return woken;
+}
+
+int waitqueue_active(struct wait_queue_head *wq) {
+    return READ_ONCE(wq->head) != nullptr;
+}
+
+void wait_queue_timeout(struct pcb *p) {
+    struct wait_queue_head *wq = p->wait_queue;
+    if (wq == nullptr) return;
+
+    spin_lock(&wq->lock);
+    wait_queue_remove(wq, p);
+    spin_unlock(&wq->lock);
+
+    wait_queue_wake(p);
+}
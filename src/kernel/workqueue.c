@@ -0,0 +1,266 @@
+/**
+ * @file workqueue.c
+ * @brief Implementación de workqueues con hilos worker por prioridad
+ *
+ * @details
+ *   Cada workqueue es una cola FIFO de work_struct atendida por un hilo
+ *   del kernel dedicado (kworker). Cuando la cola está vacía el worker se
+ *   BLOQUEA (no consume CPU); queue_work() lo despierta.
+ *
+ *   DELAYED WORK:
+ *   - Lista ordenada por 'expires' (el primero es el que vence antes)
+ *   - timer_softirq() llama a delayed_work_tick(), que solo mira la cabeza
+ *   - El próximo vencimiento se registra con timer_schedule_event(), así
+ *     los ticks sin trabajo no cuestan nada
+ *
+ *   SINCRONIZACIÓN:
+ *   - Las colas se tocan desde IRQ, softirq y proceso: todas las
+ *     modificaciones van entre local_irq_save()/local_irq_restore()
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ */
+
+#include "../../include/kernel/workqueue.h"
+#include "../../include/kernel/process.h"
+#include "../../include/kernel/scheduler.h"
+#include "../../include/drivers/timer.h"
+#include "../../include/drivers/io.h"
+
+/* ========================================================================== */
+/* ESTRUCTURAS INTERNAS                                                      */
+/* ========================================================================== */
+
+/**
+ * @brief Cola de trabajo atendida por un worker
+ */
+struct workqueue {
+    const char *name;            /* Nombre del hilo worker */
+    int priority;                /* Prioridad inicial del worker */
+    struct work_struct *head;    /* Primer work pendiente */
+    struct work_struct *tail;    /* Último work pendiente */
+    struct pcb *worker;          /* Hilo que atiende la cola */
+};
+
+static struct workqueue workqueues[NR_WORKQUEUES] = {
+    [WQ_HIGH]   = { "kworker/H", 0,  nullptr, nullptr, nullptr },
+    [WQ_NORMAL] = { "kworker/N", 5,  nullptr, nullptr, nullptr },
+    [WQ_LOW]    = { "kworker/L", 15, nullptr, nullptr, nullptr },
+};
+
+/* Lista de delayed work en espera, ordenada por 'expires' */
+static struct delayed_work *delayed_head = nullptr;
+
+/* ========================================================================== */
+/* INICIALIZACION DE WORKS                                                   */
+/* ========================================================================== */
+
+void init_work(struct work_struct *work, void (*func)(struct work_struct *)) {
+    work->func = func;
+    work->next = nullptr;
+    work->pending = 0;
+}
+
+void init_delayed_work(struct delayed_work *dwork, void (*func)(struct work_struct *)) {
+    init_work(&dwork->work, func);
+    dwork->expires = 0;
+    dwork->wq = WQ_NORMAL;
+    dwork->next = nullptr;
+}
+
+/* ========================================================================== */
+/* ENCOLADO                                                                  */
+/* ========================================================================== */
+
+/**
+ * @brief Añade un work a la cola y despierta al worker (IRQs ya deshabilitadas)
+ */
+static void __queue_work(struct workqueue *wq, struct work_struct *work) {
+    work->next = nullptr;
+    if (wq->tail == nullptr) {
+        wq->head = work;
+    } else {
+        wq->tail->next = work;
+    }
+    wq->tail = work;
+
+    /* Despertar al worker si estaba esperando trabajo */
+    struct pcb *w = wq->worker;
+    if (w && w->state == PROCESS_BLOCKED && w->block_reason == BLOCK_REASON_WAIT) {
+        w->state = PROCESS_READY;
+        w->block_reason = BLOCK_REASON_NONE;
+
+        /* El worker de alta prioridad debe correr en cuanto salgamos del IRQ */
+        if (wq == &workqueues[WQ_HIGH]) {
+            need_reschedule = 1;
+        }
+    }
+}
+
+/**
+ * @brief Encola un work
+ * @return 1 si se encoló, 0 si ya estaba pendiente
+ */
+int queue_work(int wq, struct work_struct *work) {
+    if (wq < 0 || wq >= NR_WORKQUEUES) return 0;
+
+    int queued = 0;
+    unsigned long flags = local_irq_save();
+
+    if (!work->pending) {
+        work->pending = 1;
+        __queue_work(&workqueues[wq], work);
+        queued = 1;
+    }
+
+    local_irq_restore(flags);
+    return queued;
+}
+
+int schedule_work(struct work_struct *work) {
+    return queue_work(WQ_NORMAL, work);
+}
+
+/**
+ * @brief Programa un work para dentro de 'delay' ticks
+ *
+ * @details
+ *   Inserción ordenada en la lista de espera: O(n) al programar, pero
+ *   O(1) en cada tick (solo se mira la cabeza).
+ */
+int queue_delayed_work(int wq, struct delayed_work *dwork, unsigned long delay) {
+    if (wq < 0 || wq >= NR_WORKQUEUES) return 0;
+    if (delay == 0) return queue_work(wq, &dwork->work);
+
+    unsigned long flags = local_irq_save();
+
+    if (dwork->work.pending) {
+        local_irq_restore(flags);
+        return 0;
+    }
+
+    dwork->work.pending = 1;
+    dwork->wq = wq;
+    dwork->expires = sys_timer_count + delay;
+
+    /* Insertar ordenado por 'expires' */
+    struct delayed_work **pp = &delayed_head;
+    while (*pp && (*pp)->expires <= dwork->expires) {
+        pp = &(*pp)->next;
+    }
+    dwork->next = *pp;
+    *pp = dwork;
+
+    local_irq_restore(flags);
+
+    timer_schedule_event(dwork->expires);
+    return 1;
+}
+
+/**
+ * @brief Cancela un delayed work en espera
+ * @return 1 si se canceló, 0 si no estaba en la lista (ya encolado o inactivo)
+ */
+int cancel_delayed_work(struct delayed_work *dwork) {
+    int cancelled = 0;
+    unsigned long flags = local_irq_save();
+
+    for (struct delayed_work **pp = &delayed_head; *pp; pp = &(*pp)->next) {
+        if (*pp == dwork) {
+            *pp = dwork->next;
+            dwork->next = nullptr;
+            dwork->work.pending = 0;
+            cancelled = 1;
+            break;
+        }
+    }
+
+    local_irq_restore(flags);
+    return cancelled;
+}
+
+/**
+ * @brief Pasa a su workqueue todo el delayed work vencido
+ * @param now Tick actual
+ */
+void delayed_work_tick(unsigned long now) {
+    unsigned long flags = local_irq_save();
+
+    while (delayed_head && delayed_head->expires <= now) {
+        struct delayed_work *dwork = delayed_head;
+        delayed_head = dwork->next;
+        dwork->next = nullptr;
+
+        /* Sigue 'pending': pasa directamente de la espera a la cola */
+        __queue_work(&workqueues[dwork->wq], &dwork->work);
+    }
+
+    unsigned long next = delayed_head ? delayed_head->expires : 0;
+    local_irq_restore(flags);
+
+    if (next) {
+        timer_schedule_event(next);
+    }
+}
+
+/* ========================================================================== */
+/* HILOS WORKER                                                              */
+/* ========================================================================== */
+
+/**
+ * @brief Bucle principal de un kworker
+ * @param arg Puntero a su struct workqueue
+ *
+ * @details
+ *   1. Extrae el primer work de la cola (con IRQs deshabilitadas)
+ *   2. Si no hay, se bloquea (BLOCK_REASON_WAIT) hasta que queue_work()
+ *      lo despierte
+ *   3. Si hay, limpia 'pending' ANTES de ejecutarlo: el propio work
+ *      puede volver a encolarse desde su función
+ */
+static void worker_thread(void *arg) {
+    struct workqueue *wq = (struct workqueue *)arg;
+
+    enable_interrupts();
+
+    while (1) {
+        unsigned long flags = local_irq_save();
+
+        struct work_struct *work = wq->head;
+        if (work == nullptr) {
+            /* Nada que hacer: dormir hasta el próximo queue_work() */
+            current_process->state = PROCESS_BLOCKED;
+            current_process->block_reason = BLOCK_REASON_WAIT;
+            schedule();
+            local_irq_restore(flags);
+            continue;
+        }
+
+        wq->head = work->next;
+        if (wq->head == nullptr) {
+            wq->tail = nullptr;
+        }
+        work->next = nullptr;
+        work->pending = 0;
+
+        local_irq_restore(flags);
+
+        work->func(work);
+    }
+}
+
+/**
+ * @brief Crea un hilo worker por cada prioridad
+ */
+void init_workqueues(void) {
+    for (int i = 0; i < NR_WORKQUEUES; i++) {
+        struct workqueue *wq = &workqueues[i];
+        long pid = create_process(worker_thread, wq, wq->priority, wq->name);
+        if (pid < 0) {
+            kprintf("[WQ] Error: No se pudo crear %s\n", wq->name);
+            continue;
+        }
+        wq->worker = &process[pid];
+    }
+    kprintf("   [WQ] Workqueues listas (kworker/H, kworker/N, kworker/L).\n");
+}
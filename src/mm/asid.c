@@ -0,0 +1,103 @@
+/**
+ * @file asid.c
+ * @brief Asignación de ASIDs por generaciones
+ *
+ * @details
+ *   Un único core: basta con deshabilitar las IRQs mientras se toca el
+ *   estado. El cambio de generación se hace con TTBR0_EL1 apuntando a
+ *   kernel_pgd (ASID 0): mientras se invalida la TLB ningún proceso de
+ *   la generación vieja puede volver a cargar traducciones suyas.
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ * @see asid.h para interfaz pública
+ */
+
+#include "../../include/mm/asid.h"
+#include "../../include/mm/vmm.h"
+#include "../../include/mm/mm.h"
+#include "../../include/drivers/io.h"
+
+extern unsigned long get_id_aa64mmfr0_el1(void);
+extern unsigned long local_irq_save(void);
+extern void local_irq_restore(unsigned long flags);
+
+/* ========================================================================== */
+/* ESTADO GLOBAL                                                             */
+/* ========================================================================== */
+
+static unsigned int asid_bits = 8;
+static unsigned long asid_generation = 1UL << 8;   /* Múltiplo de 1 << asid_bits */
+static unsigned long asid_next = ASID_FIRST;
+static unsigned long asid_allocs = 0;
+static unsigned long asid_rollovers = 0;
+
+#define ASID_MASK ((1UL << asid_bits) - 1)
+
+/**
+ * @brief Da a 'p' el siguiente ASID, empezando generación si no quedan
+ */
+static void new_context(struct pcb *p) {
+    if (asid_next > ASID_MASK) {
+        asid_generation += 1UL << asid_bits;
+        asid_next = ASID_FIRST;
+        asid_rollovers++;
+
+        set_ttbr0_el1((unsigned long)kernel_pgd);
+        tlb_invalidate_all();
+    }
+
+    p->asid = asid_generation | asid_next++;
+    asid_allocs++;
+}
+
+/* ========================================================================== */
+/* API PÚBLICA                                                               */
+/* ========================================================================== */
+
+unsigned int asid_init(void) {
+    unsigned long mmfr0 = get_id_aa64mmfr0_el1();
+    unsigned long field = (mmfr0 >> ID_AA64MMFR0_ASID_SHIFT) & 0xF;
+
+    asid_bits = (field == ID_AA64MMFR0_ASID_16) ? 16 : 8;
+    asid_generation = 1UL << asid_bits;
+    asid_next = ASID_FIRST;
+
+    kprintf("   [MMU] ASIDs de %d bits (%d espacios por generación)\n",
+            (long)asid_bits, (long)ASID_MASK);
+    return asid_bits;
+}
+
+void switch_mm(struct pcb *next) {
+    unsigned long flags = local_irq_save();
+
+    if (next->pgd != kernel_pgd && (next->asid & ~ASID_MASK) != asid_generation) {
+        new_context(next);
+    }
+    next->context.ttbr0 = (unsigned long)next->pgd | ((next->asid & ASID_MASK) << TTBR_ASID_SHIFT);
+
+    local_irq_restore(flags);
+}
+
+void flush_tlb_mm(struct pcb *p) {
+    unsigned long flags = local_irq_save();
+
+    if (p->pgd == kernel_pgd) {
+        tlb_invalidate_asid(0);
+    } else if ((p->asid & ~ASID_MASK) == asid_generation) {
+        tlb_invalidate_asid(p->asid & ASID_MASK);
+    }
+
+    local_irq_restore(flags);
+}
+
+void asid_get_stats(struct asid_stats *out) {
+    unsigned long flags = local_irq_save();
+
+    out->bits = asid_bits;
+    out->generation = asid_generation >> asid_bits;
+    out->allocs = asid_allocs;
+    out->rollovers = asid_rollovers;
+
+    local_irq_restore(flags);
+}
@@ -1,136 +1,946 @@
 /**
  * @file malloc.c
- * @brief Gestor de heap sencillo (First Fit)
+ * @brief Gestor de heap del kernel (segregated fit + boundary tags)
  *
  * @details
- *   Implementa un asignador dinámico minimalista para el kernel:
- *   - Lista enlazada simple de bloques (first-fit)
+ *   Implementa el asignador dinámico del kernel:
+ *   - Listas libres segregadas por clase de tamaño (doblemente enlazadas)
+ *   - Un bitmap de listas no vacías: encontrar hueco es O(1)
+ *   - Boundary tags: cada bloque libre repite su tamaño al final
+ *     (footer), así kfree() fusiona con el vecino anterior y con el
+ *     siguiente en O(1)
  *   - Alineación a 16 bytes (ARM64)
- *   - Sin coalescencia (pendiente de mejora)
+ *   - Peticiones grandes (>= KMALLOC_LARGE) van directas al buddy
  *
- *   Diseñado para fines educativos: código claro y corto.
+ *   FORMATO DE UN BLOQUE:
+ *   @code
+ *   ocupado: [size|flags][magic] datos...........................
+ *   libre:   [size|flags][magic] [next][prev] .......... [size]
+ *            <------- cabecera 16 B ------->             footer
+ *   @endcode
+ *   'size' incluye la cabecera. Bits bajos de 'size':
+ *   - BLOCK_USED: el bloque está asignado
+ *   - PREV_USED: el bloque anterior está asignado (si no, su footer
+ *     está justo antes de esta cabecera)
+ *   Los bits 48-63 guardan el sitio de llamada de un bloque ocupado.
+ *
+ *   CLASES DE TAMAÑO:
+ *   - Menos de 1KB: una lista por múltiplo de 16 bytes (clase exacta)
+ *   - Desde 1KB: 4 listas por potencia de 2. La petición se redondea
+ *     al inicio de la siguiente subclase, así cualquier bloque de la
+ *     clase encontrada sirve sin recorrer la lista
+ *
+ *   CONCURRENCIA (procesos expropiables + IRQs):
+ *   - El heap (listas, bitmap, split y fusión) se toca solo con
+ *     heap_lock tomado y las IRQs deshabilitadas: ni el timer puede
+ *     expropiar a mitad de una fusión ni un IRQ reentrar
+ *   - Delante hay una caché por CPU de "magazines" (Bonwick): pilas de
+ *     MAG_ROUNDS bloques libres por clase hasta MAG_MAX_BLOCK bytes. El
+ *     camino rápido de kmalloc()/kfree() solo deshabilita IRQs; no toma
+ *     ningún lock compartido
+ *   - Un depósito con depot_lock guarda magazines llenos y vacíos para
+ *     cuando los dos de la CPU se agotan o se llenan
+ *   - Sin memoria, kheap_drain() devuelve todos los magazines al heap
+ *
+ *   ESTADÍSTICAS ('meminfo'):
+ *   - Bytes en uso (y máximo), bytes retenidos en magazines y bloques
+ *     grandes del buddy se cuentan en kmalloc()/kfree() con las IRQs
+ *     deshabilitadas; bloques y bytes libres, en las listas libres
+ *   - Con kheap_trace(1) cada asignación se apunta a su sitio de
+ *     llamada (dirección de retorno) en una tabla de MEMTRACE_SITES
+ *     entradas. El índice del sitio se guarda en los bits altos de
+ *     'size' de la cabecera, así kfree() descuenta del sitio correcto
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
  */
 
 #include "../../include/mm/malloc.h"
+#include "../../include/mm/pmm.h"
 #include "../../include/drivers/io.h"
 #include "../../include/utils/kutils.h"
+#include "../../include/spinlock.h"
+
+/* ========================================================================== */
+/* FORMATO DE BLOQUES                                                        */
+/* ========================================================================== */
 
-// Algoritmo: Lista Enlazada Simple (First Fit)
+#define HEAP_ALIGN      16
+#define BLOCK_USED      0x1UL
+#define PREV_USED       0x2UL
+#define SIZE_MASK       0x0000FFFFFFFFFFF0UL
 
-/* Cabecera de los bloques de datos */
+/* Bits 48-63 de 'size': sitio de llamada + 1 (0 = sin rastrear) */
+#define SITE_SHIFT      48
+#define SITE_MASK       (~0UL << SITE_SHIFT)
+
+/* Marca de bloque asignado: detecta kfree() de punteros inválidos o dobles */
+#define HEAP_MAGIC      0x4B4D414C4C4F4321UL
+#define HEAP_FREE_MAGIC 0x4B46524545424C4BUL
+#define HEAP_CACHED_MAGIC 0x4B4D4147415A494EUL   /* Ocupado, en un magazine */
+
+/* Cabecera de todos los bloques */
 struct block_header {
-    unsigned long size;     // Tamaño de DATOS (sin contar el header)
-    struct block_header *next; // Puntero al siguiente bloque
-    uint8_t is_free;            // 1 = Libre; 0 = Ocupado
-    uint8_t padding[7];         // Relleno para alinear a 16 bytes (importante en ARM64)
+    unsigned long size;         /* Tamaño total (con cabecera) | flags */
+    unsigned long magic;
+};
+
+/* Bloque libre: enlaces en la zona de datos; footer al final */
+struct free_block {
+    struct block_header hdr;
+    struct free_block *next;
+    struct free_block *prev;
+};
+
+/* Cabecera + enlaces + footer, redondeado a 16 */
+#define MIN_BLOCK       48
+
+/* ========================================================================== */
+/* CLASES DE TAMAÑO                                                          */
+/* ========================================================================== */
+
+#define SMALL_LIMIT     1024                    /* Clases exactas por debajo */
+#define SMALL_CLASSES   (SMALL_LIMIT / HEAP_ALIGN)
+#define SL_BITS         2                       /* 4 subclases por potencia de 2 */
+#define FL_MIN          10                      /* log2(SMALL_LIMIT) */
+#define FL_MAX          31
+#define NUM_CLASSES     (SMALL_CLASSES + (FL_MAX - FL_MIN + 1) * (1 << SL_BITS))
+#define BITMAP_WORDS    ((NUM_CLASSES + 63) / 64)
+
+static struct free_block *free_lists[NUM_CLASSES];
+static unsigned long class_bitmap[BITMAP_WORDS];
+
+static unsigned long heap_start = 0;
+static unsigned long heap_end = 0;
+
+/* Contadores de 'meminfo' (IRQs deshabilitadas; un solo core) */
+static unsigned long heap_in_use = 0;       /* Bytes entregados (con cabecera) */
+static unsigned long heap_peak = 0;
+static unsigned long heap_cached = 0;       /* Bytes retenidos en magazines */
+static unsigned long heap_large = 0;        /* Bytes en bloques del buddy */
+static unsigned long heap_allocs = 0;
+static unsigned long heap_frees = 0;
+
+/* Listas libres (heap_lock) */
+static unsigned long free_blocks = 0;
+static unsigned long free_bytes = 0;
+
+static int fls_long(unsigned long x) {
+    return 63 - __builtin_clzl(x);
+}
+
+/**
+ * @brief Clase a la que pertenece un bloque libre de 'size' bytes
+ */
+static int size_class(unsigned long size) {
+    if (size < SMALL_LIMIT) {
+        return (int)(size / HEAP_ALIGN);
+    }
+    int fl = fls_long(size);
+    if (fl > FL_MAX) fl = FL_MAX;
+    int sl = (int)((size >> (fl - SL_BITS)) & ((1 << SL_BITS) - 1));
+    return SMALL_CLASSES + (fl - FL_MIN) * (1 << SL_BITS) + sl;
+}
+
+/**
+ * @brief Primera clase cuyos bloques tienen todos al menos 'size' bytes
+ */
+static int search_class(unsigned long size) {
+    if (size >= SMALL_LIMIT) {
+        unsigned long step = 1UL << (fls_long(size) - SL_BITS);
+        size = (size + step - 1) & ~(step - 1);
+    }
+    return size_class(size);
+}
+
+/**
+ * @brief Primera clase no vacía >= cls (-1 si no hay)
+ */
+static int find_class(int cls) {
+    int word = cls / 64;
+    if (word >= BITMAP_WORDS) return -1;
+
+    unsigned long bits = class_bitmap[word] & (~0UL << (cls % 64));
+    while (bits == 0) {
+        if (++word >= BITMAP_WORDS) return -1;
+        bits = class_bitmap[word];
+    }
+    return word * 64 + __builtin_ctzl(bits);
+}
+
+/* ========================================================================== */
+/* MANIPULACIÓN DE BLOQUES                                                   */
+/* ========================================================================== */
+
+static unsigned long block_size(struct block_header *b) {
+    return b->size & SIZE_MASK;
+}
+
+static struct block_header *next_block(struct block_header *b) {
+    return (struct block_header *)((char *)b + block_size(b));
+}
+
+static void set_footer(struct block_header *b) {
+    *(unsigned long *)((char *)b + block_size(b) - sizeof(unsigned long)) = block_size(b);
+}
+
+static void free_list_insert(struct block_header *b) {
+    struct free_block *fb = (struct free_block *)b;
+    int cls = size_class(block_size(b));
+
+    fb->hdr.magic = HEAP_FREE_MAGIC;
+    fb->prev = nullptr;
+    fb->next = free_lists[cls];
+    if (fb->next != nullptr) {
+        fb->next->prev = fb;
+    }
+    free_lists[cls] = fb;
+    class_bitmap[cls / 64] |= 1UL << (cls % 64);
+
+    free_blocks++;
+    free_bytes += block_size(b);
+}
+
+static void free_list_remove(struct block_header *b) {
+    struct free_block *fb = (struct free_block *)b;
+    int cls = size_class(block_size(b));
+
+    if (fb->prev != nullptr) {
+        fb->prev->next = fb->next;
+    } else {
+        free_lists[cls] = fb->next;
+        if (fb->next == nullptr) {
+            class_bitmap[cls / 64] &= ~(1UL << (cls % 64));
+        }
+    }
+    if (fb->next != nullptr) {
+        fb->next->prev = fb->prev;
+    }
+
+    free_blocks--;
+    free_bytes -= block_size(b);
+}
+
+/**
+ * @brief Marca un bloque libre con el tamaño dado, lo encola y avisa al
+ *        siguiente de que su anterior está libre
+ */
+static void make_free(struct block_header *b, unsigned long size, unsigned long prev_flag) {
+    b->size = size | prev_flag;
+    set_footer(b);
+    free_list_insert(b);
+    next_block(b)->size &= ~PREV_USED;
+}
+
+/* ========================================================================== */
+/* NÚCLEO DEL HEAP (heap_lock tomado)                                        */
+/* ========================================================================== */
+
+/**
+ * @brief Saca del heap un bloque de al menos 'need' bytes (con cabecera)
+ * @return Cabecera del bloque, ya marcado como ocupado, o nullptr
+ */
+static struct block_header *heap_alloc(unsigned long need) {
+    int cls = find_class(search_class(need));
+    if (cls < 0) return nullptr;
+
+    struct block_header *b = &free_lists[cls]->hdr;
+    free_list_remove(b);
+
+    unsigned long total = block_size(b);
+    unsigned long prev_flag = b->size & PREV_USED;
+
+    if (total - need >= MIN_BLOCK) {
+        /* Split: el sobrante vuelve a su lista */
+        b->size = need | BLOCK_USED | prev_flag;
+        make_free(next_block(b), total - need, PREV_USED);
+    } else {
+        b->size = total | BLOCK_USED | prev_flag;
+        next_block(b)->size |= PREV_USED;
+    }
+    b->magic = HEAP_MAGIC;
+
+    return b;
+}
+
+/**
+ * @brief Devuelve un bloque al heap fusionándolo con sus vecinos
+ *
+ * @details
+ *   Fusiona con el bloque siguiente (si está libre) y con el anterior
+ *   (si PREV_USED está a 0, su footer da su tamaño). Ambos en O(1).
+ */
+static void heap_free(struct block_header *b) {
+    unsigned long size = block_size(b);
+    unsigned long prev_flag = b->size & PREV_USED;
+
+    /* Hacia delante */
+    struct block_header *next = next_block(b);
+    if (!(next->size & BLOCK_USED)) {
+        free_list_remove(next);
+        size += block_size(next);
+    }
+
+    /* Hacia atrás */
+    if (!prev_flag) {
+        unsigned long prev_size = *((unsigned long *)b - 1);
+        struct block_header *prev = (struct block_header *)((char *)b - prev_size);
+        free_list_remove(prev);
+        size += prev_size;
+        prev_flag = prev->size & PREV_USED;
+        b = prev;
+    }
+
+    make_free(b, size, prev_flag);
+}
+
+/* ========================================================================== */
+/* MAGAZINES (caché por CPU) Y DEPÓSITO                                      */
+/* ========================================================================== */
+
+/* Bloques de hasta MAG_MAX_BLOCK bytes (con cabecera) pasan por magazines */
+#define MAG_MAX_BLOCK   512
+#define MAG_CLASSES     (MAG_MAX_BLOCK / HEAP_ALIGN + 1)
+#define MAG_ROUNDS      16      /* Bloques por magazine */
+#define MAG_POOL        (MAG_CLASSES * 6)
+
+/* Un solo core: únicamente existe la caché de la CPU 0 */
+#define HEAP_NR_CPUS    1
+
+/**
+ * @brief Magazine: pila de bloques libres de una misma clase
+ */
+struct magazine {
+    struct magazine *next;          /* Listas del depósito */
+    unsigned int rounds;            /* Bloques guardados */
+    void *objs[MAG_ROUNDS];
+};
+
+/**
+ * @brief Caché de una CPU: dos magazines por clase (Bonwick)
+ *
+ * @details
+ *   'loaded' es del que se asigna y al que se libera; 'previous' está
+ *   siempre lleno o vacío. Intercambiarlos absorbe ráfagas de
+ *   MAG_ROUNDS asignaciones o liberaciones sin tocar el depósito.
+ */
+struct heap_cpu_cache {
+    struct magazine *loaded[MAG_CLASSES];
+    struct magazine *previous[MAG_CLASSES];
 };
 
-// Inicio de la lista
-static struct block_header *head = nullptr;
+static struct magazine mag_pool[MAG_POOL];
+static struct heap_cpu_cache cpu_cache[HEAP_NR_CPUS];
+
+/* Depósito: magazines llenos por clase y vacíos compartidos (depot_lock) */
+static struct magazine *depot_full[MAG_CLASSES];
+static struct magazine *depot_empty = nullptr;
+
+static volatile int heap_lock = 0;
+static volatile int depot_lock = 0;
+
+static struct magazine *mag_pop(struct magazine **list) {
+    struct magazine *m = *list;
+    if (m != nullptr) {
+        *list = m->next;
+        m->next = nullptr;
+    }
+    return m;
+}
+
+static void mag_push(struct magazine **list, struct magazine *m) {
+    m->next = *list;
+    *list = m;
+}
+
+/**
+ * @brief Clase de magazine de un bloque de 'size' bytes (-1 si no usa)
+ */
+static int mag_class(unsigned long size) {
+    return (size <= MAG_MAX_BLOCK) ? (int)(size / HEAP_ALIGN) : -1;
+}
+
+/**
+ * @brief Toma un bloque de la caché de la CPU (IRQs deshabilitadas)
+ * @return Cabecera del bloque o nullptr si CPU y depósito están vacíos
+ */
+static struct block_header *mag_alloc(struct heap_cpu_cache *cc, int cls) {
+    struct magazine *m = cc->loaded[cls];
+
+    if (m->rounds == 0) {
+        if (cc->previous[cls]->rounds > 0) {
+            cc->loaded[cls] = cc->previous[cls];
+            cc->previous[cls] = m;
+        } else {
+            /* Cambiar el magazine vacío por uno lleno del depósito */
+            spin_lock(&depot_lock);
+            struct magazine *full = mag_pop(&depot_full[cls]);
+            if (full != nullptr) {
+                mag_push(&depot_empty, cc->previous[cls]);
+                cc->previous[cls] = m;
+                cc->loaded[cls] = full;
+            }
+            spin_unlock(&depot_lock);
+            if (full == nullptr) return nullptr;
+        }
+        m = cc->loaded[cls];
+    }
+
+    struct block_header *b = m->objs[--m->rounds];
+    b->magic = HEAP_MAGIC;
+    heap_cached -= block_size(b);
+    return b;
+}
+
+/**
+ * @brief Guarda un bloque en la caché de la CPU (IRQs deshabilitadas)
+ * @return 0 si se guardó, -1 si no hay sitio (liberarlo al heap)
+ */
+static int mag_free(struct heap_cpu_cache *cc, int cls, struct block_header *b) {
+    struct magazine *m = cc->loaded[cls];
+
+    if (m->rounds == MAG_ROUNDS) {
+        if (cc->previous[cls]->rounds == 0) {
+            cc->loaded[cls] = cc->previous[cls];
+            cc->previous[cls] = m;
+        } else {
+            /* Cambiar el magazine lleno por uno vacío del depósito */
+            spin_lock(&depot_lock);
+            struct magazine *empty = mag_pop(&depot_empty);
+            if (empty != nullptr) {
+                mag_push(&depot_full[cls], cc->previous[cls]);
+                cc->previous[cls] = m;
+                cc->loaded[cls] = empty;
+            }
+            spin_unlock(&depot_lock);
+            if (empty == nullptr) return -1;
+        }
+        m = cc->loaded[cls];
+    }
+
+    b->magic = HEAP_CACHED_MAGIC;
+    m->objs[m->rounds++] = b;
+    heap_cached += block_size(b);
+    return 0;
+}
+
+/**
+ * @brief Devuelve al heap los bloques de un magazine (heap_lock tomado)
+ */
+static void mag_flush(struct magazine *m) {
+    while (m->rounds > 0) {
+        struct block_header *b = m->objs[--m->rounds];
+        heap_cached -= block_size(b);
+        heap_free(b);
+    }
+}
+
+/* ========================================================================== */
+/* CONTABILIDAD Y SITIOS DE LLAMADA                                          */
+/* ========================================================================== */
+
+static struct alloc_site sites[MEMTRACE_SITES];
+static unsigned long sites_dropped = 0;     /* Asignaciones sin entrada libre */
+static int trace_enabled = 0;
+static volatile int trace_lock = 0;
+
+/**
+ * @brief Entrada de la tabla para 'site' (direccionamiento abierto)
+ * @return Índice o -1 si la tabla está llena
+ */
+static int site_lookup(unsigned long site) {
+    unsigned int h = (unsigned int)((site >> 2) * 0x9E3779B97F4A7C15UL >> 57);
+
+    for (int i = 0; i < MEMTRACE_SITES; i++) {
+        int idx = (int)((h + i) % MEMTRACE_SITES);
+        if (sites[idx].site == site) return idx;
+        if (sites[idx].site == 0) {
+            sites[idx].site = site;
+            return idx;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Cuenta un bloque entregado por kmalloc() (IRQs deshabilitadas)
+ */
+static void account_alloc(struct block_header *b, unsigned long site) {
+    unsigned long size = block_size(b);
+
+    heap_in_use += size;
+    if (heap_in_use > heap_peak) {
+        heap_peak = heap_in_use;
+    }
+    heap_allocs++;
+
+    b->size &= ~SITE_MASK;
+    if (!trace_enabled) return;
+
+    spin_lock(&trace_lock);
+    int idx = site_lookup(site);
+    if (idx >= 0) {
+        sites[idx].allocs++;
+        sites[idx].live_bytes += size;
+        sites[idx].total_bytes += size;
+        b->size |= (unsigned long)(idx + 1) << SITE_SHIFT;
+    } else {
+        sites_dropped++;
+    }
+    spin_unlock(&trace_lock);
+}
+
+/**
+ * @brief Descuenta un bloque devuelto a kfree() (IRQs deshabilitadas)
+ */
+static void account_free(struct block_header *b) {
+    unsigned long size = block_size(b);
+    unsigned long id = b->size >> SITE_SHIFT;
+
+    heap_in_use -= size;
+    heap_frees++;
+
+    if (id != 0) {
+        spin_lock(&trace_lock);
+        sites[id - 1].frees++;
+        sites[id - 1].live_bytes -= size;
+        spin_unlock(&trace_lock);
+        b->size &= ~SITE_MASK;
+    }
+}
+
+/* ========================================================================== */
+/* API PÚBLICA                                                               */
+/* ========================================================================== */
 
 /**
  * @brief Inicializa el heap del kernel
  * @param start_addr Dirección inicial del heap
  * @param end_addr   Dirección final (exclusiva) del heap
  *
- * Alinea el inicio a 16 bytes y crea un bloque libre único
- * que cubre todo el rango disponible.
+ * Crea un bloque libre único que cubre todo el rango y una cabecera
+ * centinela ocupada al final para que la fusión hacia delante pare.
  */
 void kheap_init(unsigned long start_addr, unsigned long end_addr) {
-    // Ajustamos el inicio para que esté alineado a 16 bytes
-    if (start_addr % 16 != 0) {
-        start_addr = start_addr + (16 - (start_addr % 16));
+    start_addr = (start_addr + HEAP_ALIGN - 1) & ~(unsigned long)(HEAP_ALIGN - 1);
+    end_addr &= ~(unsigned long)(HEAP_ALIGN - 1);
+
+    heap_start = start_addr;
+    heap_end = end_addr;
+
+    for (int i = 0; i < NUM_CLASSES; i++) free_lists[i] = nullptr;
+    for (int i = 0; i < BITMAP_WORDS; i++) class_bitmap[i] = 0;
+
+    /* Dos magazines vacíos por clase y CPU; el resto al depósito */
+    int next_mag = 0;
+    depot_empty = nullptr;
+    for (int c = 0; c < MAG_CLASSES; c++) {
+        depot_full[c] = nullptr;
+        for (int cpu = 0; cpu < HEAP_NR_CPUS; cpu++) {
+            cpu_cache[cpu].loaded[c] = &mag_pool[next_mag++];
+            cpu_cache[cpu].previous[c] = &mag_pool[next_mag++];
+        }
+    }
+    for (; next_mag < MAG_POOL; next_mag++) {
+        mag_pool[next_mag].rounds = 0;
+        mag_push(&depot_empty, &mag_pool[next_mag]);
     }
 
-    head = (struct block_header *)start_addr;
+    /* Centinela: bloque "ocupado" de tamaño 0 */
+    struct block_header *sentinel = (struct block_header *)(end_addr - sizeof(struct block_header));
+    sentinel->size = BLOCK_USED;
+    sentinel->magic = HEAP_MAGIC;
 
-    // El primer bloque ocupa TODA la RAM disponible
-    // Tamaño total - Tamaño del header
-    head->size = (end_addr - start_addr) - sizeof(struct block_header);
-    head->next = nullptr; // No hay siguiente
-    head->is_free = 1; // Está libre
+    /* El primer bloque no tiene anterior: PREV_USED evita mirar atrás */
+    struct block_header *first = (struct block_header *)start_addr;
+    unsigned long size = (unsigned long)sentinel - start_addr;
+    make_free(first, size, PREV_USED);
 
-    kprintf("   [HEAD] Iniciando en 0x%x. Tamaño inicial: %d bytes\n", start_addr, head->size);
+    kprintf("   [HEAP] Iniciando en 0x%x. Tamaño inicial: %d bytes (%d clases)\n",
+            start_addr, size, (long)NUM_CLASSES);
 }
 
 /**
- * @brief Reserva memoria del heap (first-fit)
+ * @brief Reserva memoria del heap
  * @param size Tamaño solicitado en bytes
- * @return Puntero a la región asignada o nullptr si no hay espacio
+ * @return Puntero a la región asignada (sin inicializar) o nullptr
+ *
+ * @details
+ *   1. Peticiones grandes: bloque del buddy (alineado a página)
+ *   2. Bloques pequeños: magazine de la CPU, sin lock global
+ *   3. Si no: heap bajo heap_lock (clase de búsqueda -> bitmap)
+ *   4. Sin memoria: vaciar magazines al heap y reintentar una vez
+ *
+ *   'site' es la dirección de retorno de kmalloc()/kzalloc(), para el
+ *   rastreo por sitio de llamada.
  */
-void *kmalloc(uint32_t size) {
-    struct block_header *curr = head;
-
-    // Alineamos 16 bytes
-    if (size % 16 != 0) {
-        size = size + (16 - (size % 16));
-    }
-
-    /* 1. Recorrer la lista buscando un hueco */
-    while (curr) {
-        if (curr->is_free && curr->size >= size) {
-            /* Encontrado */
-
-            /* 2. Podemos dividir el bloque? (Split) */
-            /* Solo dividimos si sobra espacio para otro header + algo de datos (ej. 16 bytes) */
-            if (curr->size > size + sizeof(struct block_header) + 16) {
-                /* Calculamos donde empieza el nuevo bloque sobrante */
-                /* Direccion actual + Header + Tamaño que nos han pedido */
-                struct block_header *new_block = (struct block_header *)(
-                    (char *)curr + sizeof(struct block_header) + size
-                );
-
-                /* Configurar el nuevo bloque (el sobrante) */
-                new_block->size = curr->size - size - sizeof(struct block_header);
-                new_block->is_free = 1;
-                new_block->next = curr->next;
-
-                /* Ajustar el bloque actual (el que vamos a entregar) */
-                curr->size = size;
-                curr->next = new_block;
+static void *heap_kmalloc(uint32_t size, unsigned long site) {
+    if (size == 0) return nullptr;
+
+    if (size >= KMALLOC_LARGE) {
+        unsigned int order = 0;
+        while (((unsigned long)PAGE_SIZE << order) < size) order++;
+        if (order <= MAX_ORDER) {
+            unsigned long pages = alloc_pages(order);
+            if (pages != 0) {
+                unsigned long flags = local_irq_save();
+                heap_large += (unsigned long)PAGE_SIZE << order;
+                heap_allocs++;
+                local_irq_restore(flags);
+                return (void *)pages;
             }
+        }
+        /* El buddy no puede: probar en el heap */
+    }
 
-            /* 3. Marcar como ocupado */
-            curr->is_free = 0;
+    unsigned long need = (size + sizeof(struct block_header) + HEAP_ALIGN - 1)
+                         & ~(unsigned long)(HEAP_ALIGN - 1);
+    if (need < MIN_BLOCK) need = MIN_BLOCK;
 
-            /* 4. Calcular puntero, LIMPIAR y devolver */
-            void *ptr = (void *)(curr + 1); // Puntero a los datos
+    unsigned long flags = local_irq_save();
+    struct block_header *b = nullptr;
 
-            /* Limpiamos 'size' bytes con 0 */
-            memset(ptr, 0, size);
+    int mcls = mag_class(need);
+    if (mcls >= 0) {
+        b = mag_alloc(&cpu_cache[0], mcls);
+    }
+    if (b == nullptr) {
+        spin_lock(&heap_lock);
+        b = heap_alloc(need);
+        spin_unlock(&heap_lock);
+    }
+    if (b != nullptr) {
+        account_alloc(b, site);
+    }
+    local_irq_restore(flags);
 
-            /* 4. Devolver puntero a LOS DATOS (justo después del header) */
-            return ptr;
+    if (b == nullptr && kheap_drain() > 0) {
+        flags = spin_lock_irqsave(&heap_lock);
+        b = heap_alloc(need);
+        if (b != nullptr) {
+            account_alloc(b, site);
         }
-        curr = curr->next;
+        spin_unlock_irqrestore(&heap_lock, flags);
+    }
+    if (b == nullptr) {
+        kprintf("[HEAP] Error: Out of Memory! (%d bytes)\n", (long)size);
+        return nullptr;
+    }
+
+    return (void *)(b + 1);
+}
+
+void *kmalloc(uint32_t size) {
+    return heap_kmalloc(size, (unsigned long)__builtin_return_address(0));
+}
+
+/**
+ * @brief Reserva memoria puesta a cero
+ */
+void *kzalloc(uint32_t size) {
+    void *ptr = heap_kmalloc(size, (unsigned long)__builtin_return_address(0));
+    if (ptr) {
+        memset(ptr, 0, size);
     }
-    kprintf("[HEAP] Error: Out of Memory!\n");
-    return nullptr; // NULL
+    return ptr;
 }
 
 /**
  * @brief Libera un bloque previamente asignado
  * @param ptr Puntero devuelto por kmalloc
  *
- * Marca el bloque como libre. No realiza coalescencia aún.
+ * Los bloques pequeños van al magazine de la CPU; el resto (o si el
+ * depósito no tiene magazines vacíos) se fusionan en el heap.
  */
 void kfree(void *ptr) {
     if (!ptr) return;
 
-    /* Obtenemos el header del bloque a liberar */
-    struct block_header *curr = (struct block_header *)ptr - 1;
+    unsigned long addr = (unsigned long)ptr;
+    if (addr < heap_start || addr >= heap_end) {
+        /* Bloque grande del buddy */
+        if (page_refcount(addr) > 0) {
+            if (page_refcount(addr) == 1) {
+                unsigned long flags = local_irq_save();
+                heap_large -= (unsigned long)PAGE_SIZE << page_order(addr);
+                heap_frees++;
+                local_irq_restore(flags);
+            }
+            page_put(addr);
+        } else {
+            kprintf("[HEAP] Error: kfree(0x%x) fuera del heap\n", addr);
+        }
+        return;
+    }
+
+    struct block_header *b = (struct block_header *)ptr - 1;
+    if (b->magic != HEAP_MAGIC || !(b->size & BLOCK_USED)) {
+        kprintf("[HEAP] Error: kfree(0x%x) inválido o doble\n", addr);
+        return;
+    }
+
+    unsigned long flags = local_irq_save();
+    account_free(b);
+
+    int mcls = mag_class(block_size(b));
+    if (mcls < 0 || mag_free(&cpu_cache[0], mcls, b) < 0) {
+        spin_lock(&heap_lock);
+        heap_free(b);
+        spin_unlock(&heap_lock);
+    }
+
+    local_irq_restore(flags);
+}
+
+/**
+ * @brief Devuelve al heap todos los bloques guardados en magazines
+ * @return Número de bloques devueltos
+ */
+int kheap_drain(void) {
+    int drained = 0;
+    unsigned long flags = local_irq_save();
+
+    spin_lock(&depot_lock);
+    spin_lock(&heap_lock);
+
+    for (int c = 0; c < MAG_CLASSES; c++) {
+        for (int cpu = 0; cpu < HEAP_NR_CPUS; cpu++) {
+            drained += cpu_cache[cpu].loaded[c]->rounds + cpu_cache[cpu].previous[c]->rounds;
+            mag_flush(cpu_cache[cpu].loaded[c]);
+            mag_flush(cpu_cache[cpu].previous[c]);
+        }
+        struct magazine *m;
+        while ((m = mag_pop(&depot_full[c])) != nullptr) {
+            drained += m->rounds;
+            mag_flush(m);
+            mag_push(&depot_empty, m);
+        }
+    }
+
+    spin_unlock(&heap_lock);
+    spin_unlock(&depot_lock);
+    local_irq_restore(flags);
+    return drained;
+}
 
-    curr->is_free = 1;
+/**
+ * @brief Anota una inconsistencia de kheap_check() (se imprime la primera)
+ */
+static void check_fail(int *errors, const char **why, unsigned long *where,
+                       const char *reason, struct block_header *b) {
+    if (*errors == 0) {
+        *why = reason;
+        *where = (unsigned long)b;
+    }
+    (*errors)++;
+}
 
-    /* Fusion (Coalescing) */
-    /* Miramos hacia adelante: El siguiente bloque existe y es libre?? */
-    while (curr->next != 0 && curr->next->is_free) {
-        /* Sumamos el tamaño del siguiente bloque + su cabecera actual */
-        curr->size += curr->next->size + sizeof(struct block_header);
+/**
+ * @brief Recorre el heap entero comprobando su consistencia
+ * @return Número de inconsistencias encontradas (0 = correcto)
+ *
+ * @details
+ *   Para cada bloque: tamaño alineado y dentro del heap, magic válido,
+ *   footer igual al tamaño si está libre y PREV_USED coherente con el
+ *   bloque anterior. Dos bloques libres seguidos indican una fusión
+ *   perdida. Recorrido O(bloques): solo para tests y depuración.
+ *
+ *   kprintf() puede dormir en el mutex de la consola: bajo heap_lock
+ *   solo se anota el primer bloque malo y el motivo, y se informa al
+ *   soltarlo.
+ */
+int kheap_check(void) {
+    int errors = 0;
+    int prev_free = 0;
+    const char *why = nullptr;
+    unsigned long where = 0;
+    unsigned long bad_size = 0;
+    struct block_header *b = (struct block_header *)heap_start;
+    unsigned long flags = spin_lock_irqsave(&heap_lock);
+
+    while (block_size(b) != 0) {
+        unsigned long size = block_size(b);
+        int is_free = !(b->size & BLOCK_USED);
+
+        if (size < MIN_BLOCK || (unsigned long)b + size > heap_end) {
+            if (errors == 0) bad_size = size;
+            check_fail(&errors, &why, &where, "tamaño inválido", b);
+            break;
+        }
+        if (is_free ? b->magic != HEAP_FREE_MAGIC
+                    : (b->magic != HEAP_MAGIC && b->magic != HEAP_CACHED_MAGIC)) {
+            check_fail(&errors, &why, &where, "magic corrupto", b);
+        }
+        if (is_free && *(unsigned long *)((char *)b + size - sizeof(unsigned long)) != size) {
+            check_fail(&errors, &why, &where, "footer corrupto", b);
+        }
+        if (prev_free == !!(b->size & PREV_USED)) {
+            check_fail(&errors, &why, &where, "PREV_USED incoherente", b);
+        }
+        if (is_free && prev_free) {
+            check_fail(&errors, &why, &where, "bloques libres sin fusionar", b);
+        }
 
-        /* Saltamos el siguiente bloque  (lo engullimos) */
-        curr->next = curr->next->next;
+        prev_free = is_free;
+        b = next_block(b);
+    }
+    spin_unlock_irqrestore(&heap_lock, flags);
+
+    if (errors > 0) {
+        if (bad_size != 0) {
+            kprintf("[HEAP] Check: %s (%d) en 0x%x\n", why, (long)bad_size, where);
+        } else {
+            kprintf("[HEAP] Check: %s en 0x%x\n", why, where);
+        }
+        if (errors > 1) {
+            kprintf("[HEAP] Check: %d inconsistencias en total\n", (long)errors);
+        }
+    }
+    return errors;
+}
+
+/**
+ * @brief Foto de los contadores del heap
+ *
+ * @details El mayor bloque libre sale de la clase no vacía más alta
+ *   del bitmap: solo se recorre esa lista.
+ */
+void kheap_get_stats(struct kheap_stats *st) {
+    unsigned long flags = spin_lock_irqsave(&heap_lock);
+
+    st->total_bytes = heap_end - heap_start;
+    st->in_use_bytes = heap_in_use;
+    st->peak_bytes = heap_peak;
+    st->cached_bytes = heap_cached;
+    st->large_bytes = heap_large;
+    st->free_bytes = free_bytes;
+    st->free_blocks = free_blocks;
+    st->allocs = heap_allocs;
+    st->frees = heap_frees;
+
+    st->largest_free = 0;
+    for (int w = BITMAP_WORDS - 1; w >= 0; w--) {
+        if (class_bitmap[w] == 0) continue;
+
+        int cls = w * 64 + fls_long(class_bitmap[w]);
+        for (struct free_block *fb = free_lists[cls]; fb != nullptr; fb = fb->next) {
+            if (block_size(&fb->hdr) > st->largest_free) {
+                st->largest_free = block_size(&fb->hdr);
+            }
+        }
+        break;
+    }
+
+    spin_unlock_irqrestore(&heap_lock, flags);
+}
+
+/**
+ * @brief Activa o desactiva el rastreo por sitio de llamada
+ * @return Estado anterior
+ *
+ * @details La tabla no se vacía: los bloques aún vivos siguen
+ *   apuntando a su entrada y se descuentan al liberarlos.
+ */
+int kheap_trace(int enable) {
+    unsigned long flags = spin_lock_irqsave(&trace_lock);
+    int old = trace_enabled;
+    trace_enabled = enable;
+    spin_unlock_irqrestore(&trace_lock, flags);
+    return old;
+}
+
+/**
+ * @brief Copia los sitios con más bytes vivos, de mayor a menor
+ * @return Número de entradas copiadas (<= max)
+ */
+int kheap_trace_top(struct alloc_site *out, int max) {
+    unsigned char taken[MEMTRACE_SITES];
+    int n = 0;
+
+    for (int i = 0; i < MEMTRACE_SITES; i++) taken[i] = 0;
+
+    unsigned long flags = spin_lock_irqsave(&trace_lock);
+    while (n < max) {
+        int best = -1;
+        for (int i = 0; i < MEMTRACE_SITES; i++) {
+            if (sites[i].site == 0 || taken[i]) continue;
+            if (best < 0 || sites[i].live_bytes > sites[best].live_bytes ||
+                (sites[i].live_bytes == sites[best].live_bytes &&
+                 sites[i].total_bytes > sites[best].total_bytes)) {
+                best = i;
+            }
+        }
+        if (best < 0) break;
+
+        taken[best] = 1;
+        out[n++] = sites[best];
+    }
+    spin_unlock_irqrestore(&trace_lock, flags);
+    return n;
+}
+
+/**
+ * @brief Muestra los contadores del heap y del PMM (comando 'meminfo')
+ */
+void meminfo_print(void) {
+    struct kheap_stats hs;
+    struct pmm_stats ps;
+    kheap_get_stats(&hs);
+    pmm_get_stats(&ps);
+
+    long frag = 0;
+    if (hs.free_bytes > 0) {
+        frag = (long)(100 - hs.largest_free * 100 / hs.free_bytes);
+    }
+
+    kprintf("\n=== HEAP (kmalloc) ===\n");
+    kprintf(" Tamaño:        %d KB\n", (long)(hs.total_bytes / 1024));
+    kprintf(" En uso:        %d KB (máximo %d KB)\n",
+            (long)(hs.in_use_bytes / 1024), (long)(hs.peak_bytes / 1024));
+    kprintf(" En magazines:  %d KB\n", (long)(hs.cached_bytes / 1024));
+    kprintf(" Libre:         %d KB en %d bloques\n",
+            (long)(hs.free_bytes / 1024), (long)hs.free_blocks);
+    kprintf(" Mayor libre:   %d KB (fragmentación %d%c)\n",
+            (long)(hs.largest_free / 1024), frag, '%');
+    kprintf(" Grandes:       %d KB (buddy)\n", (long)(hs.large_bytes / 1024));
+    kprintf(" kmalloc/kfree: %d / %d\n", (long)hs.allocs, (long)hs.frees);
+
+    /* Con bloques de MAX_ORDER libres no hay fragmentación que medir */
+    frag = 0;
+    if (ps.free_pages > 0 && ps.largest_order >= 0 && ps.largest_order < MAX_ORDER) {
+        unsigned long largest = 1UL << ps.largest_order;
+        if (largest < ps.free_pages) {
+            frag = (long)(100 - largest * 100 / ps.free_pages);
+        }
+    }
+
+    kprintf("\n=== PMM (páginas de %d bytes) ===\n", (long)PAGE_SIZE);
+    kprintf(" Total:         %d\n", (long)ps.total_pages);
+    kprintf(" Libres:        %d (pool a cero %d, fallos %d)\n",
+            (long)ps.free_pages, (long)ps.zero_pool_pages, (long)ps.zero_pool_misses);
+    kprintf(" En uso:        %d (máximo %d)\n",
+            (long)(ps.total_pages - ps.free_pages), (long)ps.peak_used_pages);
+    kprintf(" Mayor libre:   orden %d (fragmentación %d%c)\n",
+            (long)ps.largest_order, frag, '%');
+    kprintf(" Allocs/frees:  %d / %d\n", (long)ps.allocs, (long)ps.frees);
+
+    if (!trace_enabled) {
+        kprintf("\n Rastreo por sitio desactivado ('meminfo on')\n\n");
+        return;
+    }
+
+    struct alloc_site top[MEMTRACE_TOP];
+    int n = kheap_trace_top(top, MEMTRACE_TOP);
+
+    kprintf("\n=== SITIOS DE LLAMADA (por bytes vivos) ===\n");
+    kprintf(" Sitio      | Vivos (B) | Allocs | Frees | Total (B)\n");
+    kprintf("------------|-----------|--------|-------|----------\n");
+    for (int i = 0; i < n; i++) {
+        kprintf(" 0x%x | %d | %d | %d | %d\n",
+                top[i].site, (long)top[i].live_bytes, (long)top[i].allocs,
+                (long)top[i].frees, (long)top[i].total_bytes);
+    }
+    if (sites_dropped > 0) {
+        kprintf(" (%d asignaciones sin entrada: tabla llena)\n", (long)sites_dropped);
     }
-    /* Nota: Para un coalescing perfecto necesitaríamos una lista doblemente
-       enlazada para mirar también hacia ATRÁS (prev), pero esto ya mejora un 80% */
+    kprintf("\n");
 }
@@ -0,0 +1,203 @@
+/**
+ * @file memblock.c
+ * @brief Implementación del asignador de regiones de arranque
+ *
+ * @details
+ *   Cada lista es un array ordenado por dirección de rangos que no se
+ *   solapan: al añadir uno se inserta en su sitio y se fusiona con los
+ *   vecinos que toque o solape. Los huecos libres son 'memory' menos
+ *   'reserved', calculados al vuelo en un solo recorrido de ambas.
+ *
+ *   Solo se usa durante init_memory_system(), con un único core y sin
+ *   interrupciones: no necesita locks.
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ * @see memblock.h para interfaz pública
+ */
+
+#include "../../include/mm/memblock.h"
+#include "../../include/mm/pmm.h"
+#include "../../include/drivers/io.h"
+
+/* ========================================================================== */
+/* LISTAS DE RANGOS                                                          */
+/* ========================================================================== */
+
+struct memblock_type {
+    int cnt;
+    struct memblock_region regions[MEMBLOCK_MAX_REGIONS];
+    const char *name;
+};
+
+static struct memblock_type memory = { 0, {{0, 0}}, "memory" };
+static struct memblock_type reserved = { 0, {{0, 0}}, "reserved" };
+
+/* El PMM ya es dueño de la RAM libre */
+static int memblock_retired = 0;
+
+/**
+ * @brief Inserta [base, base + size) y fusiona con lo que solape o toque
+ */
+static int memblock_insert(struct memblock_type *type, unsigned long base, unsigned long size) {
+    if (size == 0) return 0;
+
+    unsigned long end = base + size;
+    int i = 0;
+
+    /* Primer rango que termina en o después de 'base' */
+    while (i < type->cnt && type->regions[i].base + type->regions[i].size < base) {
+        i++;
+    }
+
+    /* Absorber todos los que empiezan antes de 'end' */
+    int j = i;
+    while (j < type->cnt && type->regions[j].base <= end) {
+        unsigned long r_end = type->regions[j].base + type->regions[j].size;
+        if (type->regions[j].base < base) base = type->regions[j].base;
+        if (r_end > end) end = r_end;
+        j++;
+    }
+
+    if (j == i) {
+        /* Sin vecinos: abrir un hueco en i */
+        if (type->cnt == MEMBLOCK_MAX_REGIONS) {
+            kprintf("[MEMBLOCK] Error: tabla '%s' llena\n", type->name);
+            return -1;
+        }
+        for (int k = type->cnt; k > i; k--) {
+            type->regions[k] = type->regions[k - 1];
+        }
+        type->cnt++;
+    } else {
+        /* Quedarse con una entrada de las [i, j) fusionadas */
+        int removed = j - i - 1;
+        for (int k = i + 1; k + removed < type->cnt; k++) {
+            type->regions[k] = type->regions[k + removed];
+        }
+        type->cnt -= removed;
+    }
+
+    type->regions[i].base = base;
+    type->regions[i].size = end - base;
+    return 0;
+}
+
+/**
+ * @brief Hueco libre número 'idx' (RAM no reservada), por dirección
+ * @return 0 si existe, -1 si no hay más
+ */
+static int memblock_free_range(int idx, unsigned long *start, unsigned long *end) {
+    for (int m = 0; m < memory.cnt; m++) {
+        unsigned long cur = memory.regions[m].base;
+        unsigned long m_end = cur + memory.regions[m].size;
+
+        for (int r = 0; r <= reserved.cnt && cur < m_end; r++) {
+            unsigned long r_base = (r < reserved.cnt) ? reserved.regions[r].base : m_end;
+            unsigned long r_end = (r < reserved.cnt) ? r_base + reserved.regions[r].size : m_end;
+
+            if (r_end <= cur) continue;
+            if (r_base > m_end) r_base = m_end;
+
+            if (r_base > cur) {
+                if (idx-- == 0) {
+                    *start = cur;
+                    *end = r_base;
+                    return 0;
+                }
+            }
+            cur = r_end;
+        }
+    }
+    return -1;
+}
+
+/* ========================================================================== */
+/* API PÚBLICA                                                               */
+/* ========================================================================== */
+
+int memblock_add(unsigned long base, unsigned long size) {
+    return memblock_insert(&memory, base, size);
+}
+
+int memblock_reserve(unsigned long base, unsigned long size) {
+    return memblock_insert(&reserved, base, size);
+}
+
+unsigned long memblock_alloc(unsigned long size, unsigned long align) {
+    if (memblock_retired) {
+        kprintf("[MEMBLOCK] Error: memblock_alloc() después de pasar la RAM al PMM\n");
+        return 0;
+    }
+    if (align == 0) align = 1;
+
+    unsigned long start, end;
+    for (int i = 0; memblock_free_range(i, &start, &end) == 0; i++) {
+        unsigned long base = (start + align - 1) & ~(align - 1);
+        if (base >= start && base + size <= end) {
+            if (memblock_reserve(base, size) < 0) return 0;
+            return base;
+        }
+    }
+
+    kprintf("[MEMBLOCK] Error: no hay %d bytes libres\n", (long)size);
+    return 0;
+}
+
+int memblock_memory_region(int i, struct memblock_region *out) {
+    if (i < 0 || i >= memory.cnt) return -1;
+
+    *out = memory.regions[i];
+    return 0;
+}
+
+unsigned long memblock_start_of_dram(void) {
+    return memory.cnt ? memory.regions[0].base : 0;
+}
+
+unsigned long memblock_end_of_dram(void) {
+    if (memory.cnt == 0) return 0;
+
+    struct memblock_region *last = &memory.regions[memory.cnt - 1];
+    return last->base + last->size;
+}
+
+unsigned long memblock_phys_mem_size(void) {
+    unsigned long total = 0;
+    for (int i = 0; i < memory.cnt; i++) {
+        total += memory.regions[i].size;
+    }
+    return total;
+}
+
+unsigned long memblock_reserved_size(void) {
+    unsigned long total = 0;
+    for (int i = 0; i < reserved.cnt; i++) {
+        total += reserved.regions[i].size;
+    }
+    return total;
+}
+
+unsigned long memblock_free_all(void) {
+    unsigned long pages = 0;
+    unsigned long start, end;
+
+    for (int i = 0; memblock_free_range(i, &start, &end) == 0; i++) {
+        pages += pmm_free_range(start, end);
+    }
+    memblock_retired = 1;
+    return pages;
+}
+
+void memblock_dump(void) {
+    struct memblock_type *types[2] = { &memory, &reserved };
+
+    for (int t = 0; t < 2; t++) {
+        kprintf("   [MEMBLOCK] %s:\n", types[t]->name);
+        for (int i = 0; i < types[t]->cnt; i++) {
+            struct memblock_region *r = &types[t]->regions[i];
+            kprintf("      [0x%x - 0x%x) %d KB\n",
+                    r->base, r->base + r->size, (long)(r->size / 1024));
+        }
+    }
+}
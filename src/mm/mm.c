@@ -4,7 +4,8 @@
  * 
  * @details
  *   Configura la MMU de ARM64 con:
- *   - Tablas de páginas L1 (bloques de 1 GB)
+ *   - Tablas de páginas L1/L2/L3 (map_range elige bloques de 1GB/2MB
+ *     y grupos contiguos donde encajan)
  *   - Identity mapping para periféricos y RAM
  *   - Activación de MMU y caches
  *   - Fundamento para Demand Paging: La MMU gestiona Page Faults
@@ -12,16 +13,29 @@
  * 
  *   MAPA DE MEMORIA (QEMU virt):
  *   - 0x00000000 - 0x3FFFFFFF: Periféricos (Device memory)
- *   - 0x40000000 - 0x7FFFFFFF: RAM del kernel (Normal memory)
+ *   - 0x40000000 - ...:        RAM (Normal memory); el tamaño sale del
+ *                              Device Tree ('-m 2G' = 2GB)
+ *
+ *   REPARTO DE LA RAM (memblock):
+ *   @code
+ *   0x40000000  DTB (lo deja QEMU; se reserva su tamaño real)
+ *   0x40200000  imagen del kernel (link.ld) ... _end
+ *   ...         heap, RamDisk y mapa de páginas del PMM: memblock_alloc()
+ *   resto       buddy del PMM (memblock_free_all())
+ *   @endcode
  * 
  * @author Sistema Operativo Educativo BareMetalM4
- * @version 0.6
+ * @version 0.7
  */
 
 #include "../../include/mm/mm.h"
 #include "../../include/mm/vmm.h"
 #include "../../include/mm/pmm.h"
 #include "../../include/mm/malloc.h"
+#include "../../include/mm/slab.h"
+#include "../../include/mm/memblock.h"
+#include "../../include/mm/asid.h"
+#include "../../include/kernel/fdt.h"
 #include "../../include/drivers/io.h"
 
 /* ========================================================================== */
@@ -40,6 +54,7 @@
 #define TCR_SH_IS       ((3UL << 12) | (3UL << 28))
 #define TCR_ORGN_WB     ((1UL << 10) | (1UL << 26))
 #define TCR_IRGN_WB     ((1UL << 8)  | (1UL << 24))
+#define TCR_AS          (1UL << 36)     /* ASIDs de 16 bits */
 
 #define TCR_VALUE       (TCR_T0SZ | TCR_T1SZ | TCR_TG0_4K | TCR_TG1_4K | \
 TCR_SH_IS | TCR_ORGN_WB | TCR_IRGN_WB)
@@ -52,7 +67,18 @@ TCR_SH_IS | TCR_ORGN_WB | TCR_IRGN_WB)
 #define FLAGS_NORMAL (MM_SH | MM_RW | MM_KERNEL | (ATTR_NORMAL << 2))
 #define FLAGS_DEVICE (MM_SH | MM_RW | MM_KERNEL | (ATTR_DEVICE << 2))
 
-extern char _end; /* Símbolo del linker donde termina el kernel */
+extern char __kernel_start; /* Símbolos del linker: imagen del kernel */
+extern char _end;
+
+/* RAM por defecto si no hay Device Tree (QEMU virt sin '-m') */
+#define DEFAULT_RAM_BASE 0x40000000UL
+#define DEFAULT_RAM_SIZE (128UL * 1024 * 1024)
+
+/* Heap: la mitad de la RAM, como mucho KHEAP_MAX_SIZE */
+#define KHEAP_MAX_SIZE   (64UL * 1024 * 1024)
+
+/* Reparto hecho en init_memory_system() */
+static struct mem_layout layout;
 
 /* ========================================================================== */
 /* INICIALIZACION DE LA MMU (NUEVA VERSION VMM)                             */
@@ -62,32 +88,36 @@ extern char _end; /* Símbolo del linker donde termina el kernel */
  * @brief Inicializa la MMU y activa memoria virtual
  * 
  * Secuencia:
- * 1. Crear tabla de páginas L1 (bloques de 1GB)
- * 2. Mapear perifericos (Device) y RAM (Normal)
- * 3. Configurar registros (MAIR, TCR, TTBR)
+ * 1. Mapear perifericos (Device) con páginas de 4KB
+ * 2. Mapear cada rango de RAM de memblock (Normal) con map_range():
+ *    128MB alineados son bloques de 2MB en grupos contiguos de 32MB
+ *    (una sola tabla L2); 2GB son dos bloques de 1GB
+ * 3. Configurar registros (MAIR, TCR, TTBR); TCR.AS si la CPU tiene
+ *    ASIDs de 16 bits
  * 4. Activar MMU y caches
  */
 void mem_init(unsigned long heap_start, unsigned long heap_size) {
-    kprintf("   [MMU] Mapeando Kernel y Perifericos con paginas de 4KB...\n");
+    kprintf("   [MMU] Mapeando Kernel y Perifericos con bloques de 2MB/1GB...\n");
+    unsigned long free_before = pmm_nr_free_pages();
 
     /* 1. Mapear Periféricos (UART y Controlador de Interrupciones) */
-    map_page(kernel_pgd, 0x09000000, 0x09000000, FLAGS_DEVICE); /* UART */
-    map_page(kernel_pgd, 0x08000000, 0x08000000, FLAGS_DEVICE); /* GIC Distrib */
-    map_page(kernel_pgd, 0x08010000, 0x08010000, FLAGS_DEVICE); /* GIC CPU IF */
+    map_range(kernel_pgd, 0x09000000, 0x09000000, PAGE_SIZE, FLAGS_DEVICE); /* UART */
+    map_range(kernel_pgd, 0x08000000, 0x08000000, PAGE_SIZE, FLAGS_DEVICE); /* GIC Distrib */
+    map_range(kernel_pgd, 0x08010000, 0x08010000, PAGE_SIZE, FLAGS_DEVICE); /* GIC CPU IF */
 
     /* 2. Mapear TODA la RAM (Identity mapping 1:1) */
-    /* QEMU virt nos da 128MB de RAM empezando en 0x40000000 */
-    unsigned long start_ram = 0x40000000;
-    unsigned long total_ram_size = 128 * 1024 * 1024; /* 128MB */
-    unsigned long end_ram = start_ram + total_ram_size;
-
-    for (unsigned long addr = start_ram; addr < end_ram; addr += PAGE_SIZE) {
-        map_page(kernel_pgd, addr, addr, FLAGS_NORMAL);
+    struct memblock_region ram;
+    for (int i = 0; memblock_memory_region(i, &ram) == 0; i++) {
+        if (map_range(kernel_pgd, ram.base, ram.base, ram.size, FLAGS_NORMAL) < 0) {
+            kprintf("   [MMU] Error: no se pudo mapear la RAM en 0x%x\n", ram.base);
+        }
     }
+    kprintf("   [MMU] Mapa lineal listo: %d paginas de tablas\n",
+            (long)(free_before - pmm_nr_free_pages()));
 
     /* 3. Configurar Registros con la nueva tabla MAESTRA (kernel_pgd) */
     set_mair_el1(MAIR_VALUE);
-    set_tcr_el1(TCR_VALUE);
+    set_tcr_el1(TCR_VALUE | ((asid_init() == 16) ? TCR_AS : 0));
     set_ttbr0_el1((unsigned long)kernel_pgd);
     set_ttbr1_el1((unsigned long)kernel_pgd);
 
@@ -104,31 +134,98 @@ void mem_init(unsigned long heap_start, unsigned long heap_size) {
     kprintf("   [MMU] Sistema estable en modo 39-bits/4KB.\n");
 }
 
+/**
+ * @brief Declara la RAM en memblock a partir del Device Tree
+ *
+ * @details Sin DTB válido se usa la RAM por defecto de QEMU virt.
+ */
+static void memblock_setup_ram(void) {
+    struct fdt_region regions[FDT_MAX_REGIONS];
+    unsigned long dtb = fdt_find();
+    int n = 0;
+
+    if (dtb != 0) {
+        n = fdt_memory_regions(dtb, regions, FDT_MAX_REGIONS);
+    }
+    if (n == 0) {
+        kprintf("   [MEM] Sin Device Tree: se asumen %d MB en 0x%x\n",
+                (long)(DEFAULT_RAM_SIZE / (1024 * 1024)), DEFAULT_RAM_BASE);
+        memblock_add(DEFAULT_RAM_BASE, DEFAULT_RAM_SIZE);
+        return;
+    }
+
+    kprintf("   [MEM] Device Tree en 0x%x (%d bytes)\n", dtb, (long)fdt_total_size(dtb));
+    for (int i = 0; i < n; i++) {
+        memblock_add(regions[i].base, regions[i].size);
+    }
+
+    /* El propio blob y las reservas que declare */
+    layout.dtb_start = dtb;
+    layout.dtb_end = dtb + fdt_total_size(dtb);
+    memblock_reserve(dtb, fdt_total_size(dtb));
+
+    n = fdt_reserved_regions(dtb, regions, FDT_MAX_REGIONS);
+    for (int i = 0; i < n; i++) {
+        memblock_reserve(regions[i].base, regions[i].size);
+    }
+}
+
 /**
  * @brief Inicializa el sistema completo de memoria
  * 
  * Configura:
- * 1. MMU (paginación y memoria virtual)
- * 2. Heap del kernel (gestor de memoria dinámica)
+ * 1. memblock: RAM del Device Tree menos kernel y DTB; reparte heap,
+ *    RamDisk y el mapa de páginas del PMM sin solapes
+ * 2. PMM con el resto de la RAM
+ * 3. MMU (paginación y memoria virtual)
+ * 4. Heap del kernel (gestor de memoria dinámica)
+ * 5. Cachés de objetos (slab) sobre el PMM
  */
 void init_memory_system() {
-    unsigned long heap_start = (unsigned long)&_end;
-    unsigned long heap_size  = 64 * 1024 * 1024; /* 64MB para Heap */
-    unsigned long mem_total  = 128 * 1024 * 1024; /* 128MB RAM QEMU */
+    /* 1. Qué RAM hay y qué está ocupado */
+    memblock_setup_ram();
+
+    layout.kernel_start = (unsigned long)&__kernel_start;
+    layout.kernel_end = (unsigned long)&_end;
+    memblock_reserve(layout.kernel_start, layout.kernel_end - layout.kernel_start);
+
+    layout.ram_start = memblock_start_of_dram();
+    layout.ram_end = memblock_end_of_dram();
+
+    unsigned long heap_size = memblock_phys_mem_size() / 2;
+    if (heap_size > KHEAP_MAX_SIZE) heap_size = KHEAP_MAX_SIZE;
 
-    /* El PMM gestionará la memoria libre que queda DESPUÉS del Heap */
-    unsigned long pmm_start = heap_start + heap_size;
-    unsigned long pmm_size  = mem_total - (pmm_start - 0x40000000);
+    layout.heap_start = memblock_alloc(heap_size, PAGE_SIZE);
+    layout.heap_end = layout.heap_start + heap_size;
+    layout.ramdisk_start = memblock_alloc(RAMDISK_SIZE, PAGE_SIZE);
+    layout.ramdisk_end = layout.ramdisk_start + RAMDISK_SIZE;
+
+    /* 2. El PMM describe toda la RAM y recibe lo que nadie reservó */
+    pmm_init(layout.ram_start, layout.ram_end - layout.ram_start);
+    memblock_dump();
+    unsigned long pmm_pages = memblock_free_all();
+    kprintf("   [MEM] RAM: %d MB; heap %d MB; PMM %d MB\n",
+            (long)(memblock_phys_mem_size() / (1024 * 1024)),
+            (long)(heap_size / (1024 * 1024)),
+            (long)(pmm_pages * PAGE_SIZE / (1024 * 1024)));
 
-    /* 1. Iniciar estructuras */
-    pmm_init(pmm_start, pmm_size);
     init_vmm(); /* Limpia el kernel_pgd */
 
-    /* 2. Mapear y Activar MMU */
-    mem_init(heap_start, heap_size);
+    /* 3. Mapear y Activar MMU */
+    mem_init(layout.heap_start, heap_size);
+
+    /* 4. Iniciar HEAP ya con la MMU encendida */
+    kheap_init(layout.heap_start, layout.heap_end);
+
+    /* 5. Cachés de objetos de tamaño fijo (slabs del buddy) */
+    kmem_cache_init();
 
-    /* 3. Iniciar HEAP ya con la MMU encendida */
-    kheap_init(heap_start, heap_start + heap_size);
+    kprintf("   [MEM] Subsistema de memoria (PMM + VMM + MMU + Heap + Slab) listo.\n");
+}
 
-    kprintf("   [MEM] Subsistema de memoria (PMM + VMM + MMU + Heap) listo.\n");
+/**
+ * @brief Reparto de la RAM hecho en el arranque
+ */
+const struct mem_layout *mm_layout(void) {
+    return &layout;
 }
@@ -1,102 +1,596 @@
 /**
  * @file pmm.c
  * @brief Gestor de memoria física (Physical Memory Manager)
- * 
+ *
  * @details
- *   Implementa el gestor de memoria física del kernel:
- *   - Asignación de páginas físicas mediante bitmap
- *   - Algoritmo First-Fit para búsqueda de páginas libres
- *   - Gestión de 128MB de RAM
- *   - Integración con Demand Paging: get_free_page() es invocado por
- *     handle_fault() cuando se produce un Page Fault y se necesita
- *     asignar una página física bajo demanda
- * 
+ *   Implementa el gestor de memoria física del kernel con un allocator
+ *   buddy binario:
+ *   - Bloques de 2^order páginas contiguas (order 0..MAX_ORDER)
+ *   - Una lista libre doblemente enlazada por orden
+ *   - Asignación: primer orden no vacío >= pedido, partiendo a mitades
+ *   - Liberación: fusión con el buddy (índice ^ 2^order) mientras esté
+ *     libre y sea del mismo orden -> O(MAX_ORDER)
+ *   - Integración con Demand Paging: get_free_page() (orden 0) es
+ *     invocado por handle_fault() cuando se produce un Page Fault y se
+ *     necesita asignar una página física bajo demanda
+ *
+ *   POOL DE PÁGINAS A CERO:
+ *   get_free_page() saca una página ya limpia de 'zero_pool' (una pila
+ *   enlazada a través de la primera palabra de cada página). El bucle
+ *   IDLE la rellena con pmm_zero_pool_refill(): pide páginas al buddy
+ *   (incluidas las recién liberadas) y las limpia con clear_page() fuera
+ *   del lock. Solo si el pool está vacío se limpia en el camino del fallo.
+ *
+ *   ALINEACIÓN:
+ *   Los índices de página cuentan desde 'mem_base', la dirección inicial
+ *   redondeada hacia abajo a PAGE_SIZE << MAX_ORDER. Así un bloque de
+ *   orden n está alineado físicamente a PAGE_SIZE << n (necesario para
+ *   block mappings de 2MB).
+ *
+ *   MAPA DE PÁGINAS:
+ *   pmm_init() recibe el rango completo de RAM y toma de memblock un
+ *   struct page_frame por página (12 bytes: 6MB con 2GB de RAM). Todas
+ *   empiezan reservadas; memblock_free_all() entrega al buddy con
+ *   pmm_free_range() solo los huecos que nadie reservó (kernel, DTB,
+ *   heap, RamDisk, el propio mapa).
+ *
  * @author Sistema Operativo Educativo BareMetalM4
- * @version 0.6
+ * @version 0.7
  */
 
 #include "../../include/mm/pmm.h"
 #include "../../include/utils/kutils.h"
 #include "../../include/drivers/io.h"
+#include "../../include/spinlock.h"
+#include "../../include/barrier.h"
+#include "../../include/mm/memblock.h"
 
-/* Gestionaremos 128MB de RAM para usuarios por ahora */
-#define MEMORY_SIZE (128 * 1024 * 1024)
-#define TOTAL_PAGES (MEMORY_SIZE / PAGE_SIZE)
+/* Fin de lista (índice de página inválido) */
+#define PAGE_NONE (-1)
 
-/*
- * Mapa de bits: Cada bit representa una página de 4KB.
- * Si TOTAL_PAGES = 32768 (128MB), necesitamos 32768 bits.
- * 32768 bits / 8 bits/byte = 4096 bytes para el mapa.
+/* Flags de struct page_frame */
+#define PAGE_FLAG_FREE      0x01    /* Cabeza de un bloque en una lista libre */
+#define PAGE_FLAG_RESERVED  0x02    /* Nunca entregada al buddy (kernel, heap...) */
+
+/**
+ * @brief Metadatos de una página física
+ *
+ * @details
+ *   Solo la primera página de cada bloque (cabeza) tiene 'order' y
+ *   'flags' válidos. Las listas libres se enlazan por índice.
  */
-static unsigned char mem_map[TOTAL_PAGES / 8];
-static unsigned long phys_mem_start = 0;
+struct page_frame {
+    int next;                   /* Siguiente bloque libre del mismo orden */
+    int prev;                   /* Anterior bloque libre del mismo orden */
+    unsigned short refs;        /* Referencias (copy-on-write) */
+    unsigned char order;        /* Orden del bloque (libre o asignado) */
+    unsigned char flags;
+};
+
+static struct page_frame *pages = nullptr;   /* Mapa de páginas (memblock) */
+static int nr_pages = 0;                     /* Entradas del mapa */
+
+/* Listas libres por orden (índice de la primera cabeza o PAGE_NONE) */
+static int free_area[MAX_ORDER + 1];
+static unsigned long nr_free[MAX_ORDER + 1];
+static unsigned long nr_free_total = 0;    /* Páginas en las listas */
+
+/* Estadísticas (pmm_lock) */
+static unsigned long pmm_allocs = 0;
+static unsigned long pmm_frees = 0;
+static unsigned long peak_used = 0;        /* Máximo de páginas asignadas */
+
+static unsigned long mem_base = 0;     /* Dirección del índice 0 */
+static unsigned long managed_pages = 0; /* Entregadas al buddy por pmm_free_range() */
+
+static volatile int pmm_lock = 0;
+
+/* Pool de páginas a cero (pmm_lock) */
+static unsigned long zero_pool = 0;         /* Primera página o 0 */
+static unsigned long zero_pool_count = 0;
+static unsigned long zero_pool_pending = 0; /* Fuera del buddy, limpiándose */
+static unsigned long zero_pool_misses = 0;  /* get_free_page() con pool vacío */
+
+/* Pone a cero una página con DC ZVA (mm_utils.S) */
+extern void clear_page(unsigned long addr);
+
+/**
+ * @brief Índice de página de una dirección física (-1 si no es del PMM)
+ */
+static int page_index(unsigned long p) {
+    if (p < mem_base) return -1;
+
+    unsigned long index = (p - mem_base) / PAGE_SIZE;
+    if (index >= (unsigned long)nr_pages) return -1;
+
+    return (int)index;
+}
+
+static unsigned long page_address(int index) {
+    return mem_base + ((unsigned long)index << PAGE_SHIFT);
+}
+
+/* ========================================================================== */
+/* LISTAS LIBRES (pmm_lock tomado)                                           */
+/* ========================================================================== */
+
+static void free_list_add(int index, unsigned int order) {
+    struct page_frame *pg = &pages[index];
+
+    pg->order = order;
+    pg->flags |= PAGE_FLAG_FREE;
+    pg->prev = PAGE_NONE;
+    pg->next = free_area[order];
+    if (free_area[order] != PAGE_NONE) {
+        pages[free_area[order]].prev = index;
+    }
+    free_area[order] = index;
+    nr_free[order]++;
+    nr_free_total += 1UL << order;
+}
+
+static void free_list_del(int index, unsigned int order) {
+    struct page_frame *pg = &pages[index];
+
+    if (pg->prev != PAGE_NONE) {
+        pages[pg->prev].next = pg->next;
+    } else {
+        free_area[order] = pg->next;
+    }
+    if (pg->next != PAGE_NONE) {
+        pages[pg->next].prev = pg->prev;
+    }
+    pg->flags &= ~PAGE_FLAG_FREE;
+    pg->next = pg->prev = PAGE_NONE;
+    nr_free[order]--;
+    nr_free_total -= 1UL << order;
+}
+
+/**
+ * @brief Cuenta una asignación y actualiza el máximo de páginas usadas
+ */
+static void note_alloc(void) {
+    unsigned long used = managed_pages - nr_free_total - zero_pool_count - zero_pool_pending;
+    pmm_allocs++;
+    if (used > peak_used) {
+        peak_used = used;
+    }
+}
+
+/**
+ * @brief Devuelve un bloque a las listas fusionándolo con sus buddies
+ */
+static void buddy_free(int index, unsigned int order) {
+    while (order < MAX_ORDER) {
+        int buddy = index ^ (1 << order);
+
+        /* El buddy debe existir y ser la cabeza libre de un bloque igual */
+        if (buddy + (1 << order) > nr_pages) break;
+        if (!(pages[buddy].flags & PAGE_FLAG_FREE) || pages[buddy].order != order) break;
+
+        free_list_del(buddy, order);
+        index &= buddy;   /* Cabeza del bloque fusionado: el menor de los dos */
+        order++;
+    }
+    free_list_add(index, order);
+}
+
+/**
+ * @brief Saca un bloque de 2^order páginas de las listas
+ * @return Índice de su primera página o PAGE_NONE
+ *
+ * @details
+ *   1. Busca el primer orden >= 'order' con bloques libres
+ *   2. Lo saca de su lista y, mientras sobre, devuelve la mitad
+ *      superior a la lista del orden inferior
+ */
+static int buddy_alloc(unsigned int order) {
+    unsigned int current = order;
+    while (current <= MAX_ORDER && free_area[current] == PAGE_NONE) {
+        current++;
+    }
+    if (current > MAX_ORDER) return PAGE_NONE;
+
+    int index = free_area[current];
+    free_list_del(index, current);
+
+    while (current > order) {
+        current--;
+        free_list_add(index + (1 << current), current);
+    }
+
+    pages[index].order = order;
+    pages[index].refs = 1;
+    return index;
+}
+
+/* ========================================================================== */
+/* INICIALIZACIÓN                                                            */
+/* ========================================================================== */
 
 /**
  * @brief Inicializa el gestor de memoria física
- * @param start Dirección donde empieza la RAM libre (después del Kernel)
+ * @param start Primera dirección de RAM
+ * @param size Bytes de RAM desde 'start' (incluidos los huecos ocupados)
+ *
+ * @details
+ *   El mapa cubre [mem_base, fin redondeado a bloque de MAX_ORDER): así
+ *   el buddy de cualquier bloque cae dentro del mapa. Ninguna página
+ *   queda libre hasta pmm_free_range().
  */
 void pmm_init(unsigned long start, unsigned long size) {
-    phys_mem_start = start;
+    unsigned long block = (unsigned long)PAGE_SIZE << MAX_ORDER;
+    unsigned long end = (start + size + block - 1) & ~(block - 1);
+
+    mem_base = start & ~(block - 1);
+    nr_pages = (int)((end - mem_base) / PAGE_SIZE);
+
+    unsigned long map_size = (unsigned long)nr_pages * sizeof(struct page_frame);
+    pages = (struct page_frame *)memblock_alloc(map_size, PAGE_SIZE);
+    if (pages == nullptr) {
+        kprintf("[PMM] CRITICAL: sin memoria para el mapa de %d páginas\n", (long)nr_pages);
+        nr_pages = 0;
+        return;
+    }
+
+    memset(pages, 0, map_size);
+    for (int i = 0; i < nr_pages; i++) {
+        pages[i].flags = PAGE_FLAG_RESERVED;
+    }
+    for (int o = 0; o <= MAX_ORDER; o++) {
+        free_area[o] = PAGE_NONE;
+        nr_free[o] = 0;
+    }
+    nr_free_total = 0;
+    managed_pages = 0;
+    pmm_allocs = pmm_frees = peak_used = 0;
+    zero_pool = 0;
+    zero_pool_count = 0;
+
+    kprintf("[PMM v0.7] Buddy allocator: mapa de %d páginas desde 0x%x (%d KB, orden máx. %d)\n",
+            (long)nr_pages, mem_base, (long)(map_size / 1024), (long)MAX_ORDER);
+}
+
+/**
+ * @brief Entrega al buddy las páginas de [start, end)
+ * @return Páginas añadidas
+ *
+ * @details
+ *   Trocea el rango en los bloques alineados más grandes; buddy_free()
+ *   los fusiona con rangos vecinos ya entregados.
+ */
+unsigned long pmm_free_range(unsigned long start, unsigned long end) {
+    start = (start + PAGE_SIZE - 1) & ~((unsigned long)PAGE_SIZE - 1);
+    end &= ~((unsigned long)PAGE_SIZE - 1);
+    if (end <= start || start < mem_base) return 0;
+
+    int index = (int)((start - mem_base) / PAGE_SIZE);
+    int last = (int)((end - mem_base) / PAGE_SIZE);
+    if (last > nr_pages) last = nr_pages;
+
+    unsigned long added = 0;
+    unsigned long flags = spin_lock_irqsave(&pmm_lock);
 
-    /* Inicializamos enteramente a 0 (Libre) */
-    memset(mem_map, 0, sizeof(mem_map));
+    while (index < last) {
+        unsigned int order = MAX_ORDER;
+        while (order > 0 &&
+               ((index & ((1 << order) - 1)) != 0 || index + (1 << order) > last)) {
+            order--;
+        }
+        for (int i = 0; i < (1 << order); i++) {
+            pages[index + i].flags &= ~PAGE_FLAG_RESERVED;
+        }
+        buddy_free(index, order);
+        added += 1UL << order;
+        index += 1 << order;
+    }
+    managed_pages += added;
 
-    kprintf("[PMM v0.6] Gestionando %d MB de RAM física desde 0x%x (Demand Paging)\n",
-            MEMORY_SIZE / (1024*1024), phys_mem_start);
+    spin_unlock_irqrestore(&pmm_lock, flags);
+    return added;
+}
+
+/* ========================================================================== */
+/* ASIGNACIÓN Y LIBERACIÓN                                                   */
+/* ========================================================================== */
+
+/**
+ * @brief Reserva 2^order páginas físicas contiguas
+ * @return Dirección física del bloque (alineada a su tamaño) o 0
+ *
+ * @details
+ *   No limpia la memoria: get_free_page() sí lo hace.
+ */
+unsigned long alloc_pages(unsigned int order) {
+    if (order > MAX_ORDER) {
+        kprintf("[PMM] Error: orden %d mayor que MAX_ORDER\n", (long)order);
+        return 0;
+    }
+
+    unsigned long flags = spin_lock_irqsave(&pmm_lock);
+
+    int index = buddy_alloc(order);
+    if (index == PAGE_NONE && order == 0 && zero_pool != 0) {
+        /* Sin bloques libres: la última reserva es el pool */
+        unsigned long page = zero_pool;
+        zero_pool = *(unsigned long *)page;
+        zero_pool_count--;
+        note_alloc();
+        spin_unlock_irqrestore(&pmm_lock, flags);
+        return page;
+    }
+    if (index != PAGE_NONE) {
+        note_alloc();
+    }
+
+    spin_unlock_irqrestore(&pmm_lock, flags);
+
+    if (index == PAGE_NONE) {
+        kprintf("[PMM] CRITICAL: Out of Memory (OOM) pidiendo orden %d!\n", (long)order);
+        return 0;
+    }
+    return page_address(index);
+}
+
+/**
+ * @brief Libera un bloque de alloc_pages()
+ */
+void free_pages(unsigned long addr, unsigned int order) {
+    int index = page_index(addr);
+    if (index < 0) return;
+
+    unsigned long flags = spin_lock_irqsave(&pmm_lock);
+
+    struct page_frame *pg = &pages[index];
+    if (pg->flags & PAGE_FLAG_FREE) {
+        spin_unlock_irqrestore(&pmm_lock, flags);
+        kprintf("[PMM] Error: doble liberación de 0x%x\n", addr);
+        return;
+    }
+    if (pg->flags & PAGE_FLAG_RESERVED) {
+        spin_unlock_irqrestore(&pmm_lock, flags);
+        kprintf("[PMM] Error: 0x%x no pertenece al buddy\n", addr);
+        return;
+    }
+    if (pg->refs > 1) {
+        /* Compartida (COW): otros procesos la siguen mapeando */
+        int refs = pg->refs;
+        spin_unlock_irqrestore(&pmm_lock, flags);
+        kprintf("[PMM] Error: 0x%x tiene %d referencias, usar page_put()\n", addr, (long)refs);
+        return;
+    }
+    /* Con el lock tomado no se puede imprimir (kprintf duerme en el
+       mutex de la consola): se anota y se avisa al soltarlo */
+    unsigned int given = order;
+    if (pg->order != order) {
+        order = pg->order;
+    }
+
+    pg->refs = 0;
+    buddy_free(index, order);
+    pmm_frees++;
+
+    spin_unlock_irqrestore(&pmm_lock, flags);
+
+    if (given != order) {
+        kprintf("[PMM] Aviso: 0x%x liberada con orden %d, asignada con %d\n",
+                addr, (long)given, (long)order);
+    }
 }
 
 /**
  * @brief Busca y reserva una página física libre
  * @return Dirección física de la página (o 0 si no hay memoria)
- * 
+ *
  * @details
- *   Implementa un algoritmo First-Fit sobre el bitmap:
- *   1. Busca el primer bit en 0 (página libre)
- *   2. Marca el bit como 1 (ocupado)
- *   3. Calcula la dirección física real
- *   4. Realiza security zeroing (limpia la página con 0s)
- *   
+ *   Página a cero (security zeroing): normalmente un pop del pool; si
+ *   está vacío, alloc_pages(0) + clear_page().
+ *
  *   INTEGRACIÓN CON DEMAND PAGING:
  *   Esta función es llamada por handle_fault() en sys.c cuando
  *   se produce un Page Fault y se necesita asignar memoria bajo demanda.
  */
 unsigned long get_free_page(void) {
-    /* Algoritmo First-Fit sobre Bitmap: Buscar el primer bit a 0 */
-    for (int i = 0; i < TOTAL_PAGES; i++) {
-        int byte_index = i / 8;
-        int bit_index = i % 8;
+    unsigned long flags = spin_lock_irqsave(&pmm_lock);
 
-        /* Comprobamos si el bit está libre (0) */
-        if (! (mem_map[byte_index] & (1 << bit_index))) {
-            /* ¡Encontrado! Lo marcamos como ocupado */
-            mem_map[byte_index] |= (1 << bit_index);
+    unsigned long page_addr = zero_pool;
+    if (page_addr != 0) {
+        zero_pool = *(unsigned long *)page_addr;
+        zero_pool_count--;
+        note_alloc();
+    } else {
+        zero_pool_misses++;
+    }
 
-            /* Calculamos la dirección física real */
-            unsigned long page_addr = phys_mem_start + (i * PAGE_SIZE);
+    spin_unlock_irqrestore(&pmm_lock, flags);
 
-            /* Importante: Limpiamos la página (security zeroing) */
-            memset((void*)page_addr, 0, PAGE_SIZE);
+    if (page_addr != 0) {
+        /* Borrar el enlace: la página queda entera a cero */
+        *(unsigned long *)page_addr = 0;
+        pages[page_index(page_addr)].refs = 1;
+        return page_addr;
+    }
 
-            return page_addr;
-        }
+    page_addr = alloc_pages(0);
+    if (page_addr) {
+        clear_page(page_addr);
+    }
+
+    return page_addr;
+}
+
+/**
+ * @brief Limpia una página libre y la añade al pool
+ * @return 1 si añadió una página, 0 si el pool está lleno o no hay memoria
+ *
+ * @details
+ *   Llamada desde el bucle IDLE. Las páginas liberadas vuelven al buddy
+ *   y de ahí, limpias, al pool. Si el buddy se agota, alloc_pages(0)
+ *   tira del pool, así que rellenarlo no adelanta un OOM.
+ */
+int pmm_zero_pool_refill(void) {
+    unsigned long flags = spin_lock_irqsave(&pmm_lock);
+
+    int index = PAGE_NONE;
+    if (zero_pool_count + zero_pool_pending < ZERO_POOL_TARGET) {
+        index = buddy_alloc(0);
+    }
+    if (index != PAGE_NONE) {
+        zero_pool_pending++;
     }
 
-    kprintf("[PMM] CRITICAL: Out of Memory (OOM)!\n");
-    return 0;
+    spin_unlock_irqrestore(&pmm_lock, flags);
+
+    if (index == PAGE_NONE) return 0;
+
+    /* Limpiar sin el lock: no retrasa a quien asigna o libera */
+    unsigned long page = page_address(index);
+    clear_page(page);
+
+    flags = spin_lock_irqsave(&pmm_lock);
+    *(unsigned long *)page = zero_pool;
+    zero_pool = page;
+    zero_pool_count++;
+    zero_pool_pending--;
+    spin_unlock_irqrestore(&pmm_lock, flags);
+
+    return 1;
 }
 
 /**
  * @brief Libera una página física
  */
 void free_page(unsigned long p) {
-    unsigned long offset = p - phys_mem_start;
-    int index = offset / PAGE_SIZE;
+    free_pages(p, 0);
+}
+
+/**
+ * @brief Muestra los bloques libres por orden (estilo /proc/buddyinfo)
+ */
+void pmm_buddyinfo(void) {
+    unsigned long total = 0;
+
+    kprintf("   [PMM] Bloques libres por orden:");
+    for (int o = 0; o <= MAX_ORDER; o++) {
+        unsigned long n = READ_ONCE(nr_free[o]);
+        kprintf(" %d", n);
+        total += n << o;
+    }
+    kprintf("\n   [PMM] Páginas libres: %d de %d (pool a cero: %d, fallos de pool: %d)\n",
+            total + READ_ONCE(zero_pool_count), (long)managed_pages,
+            READ_ONCE(zero_pool_count), READ_ONCE(zero_pool_misses));
+}
+
+/**
+ * @brief Páginas libres en total (buddy + pool a cero)
+ */
+unsigned long pmm_nr_free_pages(void) {
+    unsigned long flags = spin_lock_irqsave(&pmm_lock);
+    unsigned long total = nr_free_total + zero_pool_count + zero_pool_pending;
+    spin_unlock_irqrestore(&pmm_lock, flags);
+    return total;
+}
+
+/**
+ * @brief Foto de los contadores del PMM
+ */
+void pmm_get_stats(struct pmm_stats *st) {
+    unsigned long flags = spin_lock_irqsave(&pmm_lock);
+
+    st->total_pages = managed_pages;
+    st->free_pages = nr_free_total + zero_pool_count + zero_pool_pending;
+    st->peak_used_pages = peak_used;
+    st->zero_pool_pages = zero_pool_count;
+    st->zero_pool_misses = zero_pool_misses;
+    st->allocs = pmm_allocs;
+    st->frees = pmm_frees;
+    st->largest_order = -1;
+    for (int o = MAX_ORDER; o >= 0; o--) {
+        if (free_area[o] != PAGE_NONE) {
+            st->largest_order = o;
+            break;
+        }
+    }
+
+    spin_unlock_irqrestore(&pmm_lock, flags);
+}
+
+/* ========================================================================== */
+/* CONTADORES DE REFERENCIA (COPY-ON-WRITE)                                  */
+/* ========================================================================== */
+
+/**
+ * @brief Añade una referencia a una página ya asignada
+ */
+void page_get(unsigned long p) {
+    int index = page_index(p);
+    if (index < 0) return;
+
+    unsigned long flags = spin_lock_irqsave(&pmm_lock);
+    pages[index].refs++;
+    spin_unlock_irqrestore(&pmm_lock, flags);
+}
+
+/**
+ * @brief Quita una referencia; libera el bloque al llegar a 0
+ *
+ * @details
+ *   Decremento y liberación son un solo paso bajo pmm_lock: dos
+ *   page_put() a la vez no pueden ver ambos el contador a 0.
+ */
+void page_put(unsigned long p) {
+    int index = page_index(p);
+    if (index < 0) return;
+
+    unsigned long flags = spin_lock_irqsave(&pmm_lock);
+
+    struct page_frame *pg = &pages[index];
+    if (pg->refs != 0 && --pg->refs == 0) {
+        buddy_free(index, pg->order);
+        pmm_frees++;
+    }
+
+    spin_unlock_irqrestore(&pmm_lock, flags);
+}
+
+/**
+ * @brief Quita una referencia solo si la página está compartida
+ * @return 1 si se soltó (quedan otras), 0 si era la única (no cambia)
+ */
+int page_put_shared(unsigned long p) {
+    int index = page_index(p);
+    if (index < 0) return 0;
+
+    unsigned long flags = spin_lock_irqsave(&pmm_lock);
 
-    if (index < 0 || index >= TOTAL_PAGES) return;
+    int shared = (pages[index].refs > 1);
+    if (shared) {
+        pages[index].refs--;
+    }
+
+    spin_unlock_irqrestore(&pmm_lock, flags);
+    return shared;
+}
+
+/**
+ * @brief Orden del bloque asignado que empieza en 'p' (0 si no es del PMM)
+ */
+unsigned int page_order(unsigned long p) {
+    int index = page_index(p);
+    if (index < 0) return 0;
+
+    return pages[index].order;
+}
 
-    int byte_index = index / 8;
-    int bit_index = index % 8;
+/**
+ * @brief Número de referencias de una página (0 si libre o fuera del PMM)
+ */
+int page_refcount(unsigned long p) {
+    int index = page_index(p);
+    if (index < 0) return 0;
 
-    /* Ponemos el bit a 0 */
-    mem_map[byte_index] &= ~(1 << bit_index);
+    unsigned long flags = spin_lock_irqsave(&pmm_lock);
+    int refs = pages[index].refs;
+    spin_unlock_irqrestore(&pmm_lock, flags);
+    return refs;
 }
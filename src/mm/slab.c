@@ -0,0 +1,399 @@
+/**
+ * @file slab.c
+ * @brief Implementación de las cachés de objetos (slab allocator)
+ *
+ * @details
+ *   ESTRUCTURA DE UN SLAB (bloque de 2^order páginas del buddy):
+ *   @code
+ *   +-------------+-------+-------+-------+-----+--------+
+ *   | struct slab | obj 0 | obj 1 | obj 2 | ... | (resto)|
+ *   +-------------+-------+-------+-------+-----+--------+
+ *   ^ alineado a PAGE_SIZE << order
+ *   @endcode
+ *   Los objetos libres forman una lista enlazada a través de un puntero
+ *   guardado dentro del propio objeto, en 'cache->offset'. Sin
+ *   constructor va al principio del objeto; con constructor va en una
+ *   palabra extra al final, para no romper el estado construido.
+ *
+ *   CICLO DE UN SLAB:
+ *   vacío --alloc--> parcial --alloc--> lleno --free--> parcial
+ *   --free--> vacío. Se guarda un slab vacío de reserva; los demás
+ *   vuelven al buddy con free_pages().
+ *
+ *   Crear un slab (alloc_pages + constructores) se hace sin el lock de
+ *   la caché.
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ * @see slab.h para interfaz pública
+ */
+
+#include "../../include/mm/slab.h"
+#include "../../include/mm/pmm.h"
+#include "../../include/drivers/io.h"
+#include "../../include/utils/kutils.h"
+#include "../../include/spinlock.h"
+
+/* ========================================================================== */
+/* ESTRUCTURAS INTERNAS                                                      */
+/* ========================================================================== */
+
+/* Mínimo de objetos por slab antes de probar un orden mayor */
+#define SLAB_MIN_OBJS 8
+
+/**
+ * @brief Cabecera de un slab (al principio del bloque)
+ */
+struct slab {
+    struct kmem_cache *cache;
+    struct slab *next;
+    struct slab *prev;
+    void *freelist;              /* Primer objeto libre o nullptr */
+    unsigned int inuse;          /* Objetos asignados */
+};
+
+/* Caché de descriptores de caché (arranque) y lista global */
+static struct kmem_cache cache_cache;
+static struct kmem_cache *cache_list = nullptr;
+static volatile int cache_list_lock = 0;
+
+/* Filas que slabinfo_print() copia por cada vez que toma cache_list_lock */
+#define SLABINFO_BATCH 4
+
+struct slabinfo_row {
+    char name[SLAB_NAME_LEN];
+    unsigned long object_size;
+    unsigned long active_objs;
+    unsigned long total_objs;
+    unsigned long nr_slabs;
+    unsigned long pages;
+    unsigned long allocs;
+    unsigned long frees;
+};
+
+static unsigned long align_up(unsigned long x, unsigned long a) {
+    return (x + a - 1) & ~(a - 1);
+}
+
+/* ========================================================================== */
+/* FUNCIONES AUXILIARES                                                      */
+/* ========================================================================== */
+
+static void *slab_get_free(struct kmem_cache *c, void *obj) {
+    return *(void **)((char *)obj + c->offset);
+}
+
+static void slab_set_free(struct kmem_cache *c, void *obj, void *next) {
+    *(void **)((char *)obj + c->offset) = next;
+}
+
+static unsigned long slab_first_obj(struct kmem_cache *c) {
+    return align_up(sizeof(struct slab), c->align);
+}
+
+static struct slab *obj_to_slab(struct kmem_cache *c, void *obj) {
+    unsigned long mask = ((unsigned long)PAGE_SIZE << c->order) - 1;
+    return (struct slab *)((unsigned long)obj & ~mask);
+}
+
+static void slab_list_add(struct slab **list, struct slab *s) {
+    s->prev = nullptr;
+    s->next = *list;
+    if (*list != nullptr) {
+        (*list)->prev = s;
+    }
+    *list = s;
+}
+
+static void slab_list_del(struct slab **list, struct slab *s) {
+    if (s->prev != nullptr) {
+        s->prev->next = s->next;
+    } else {
+        *list = s->next;
+    }
+    if (s->next != nullptr) {
+        s->next->prev = s->prev;
+    }
+    s->next = s->prev = nullptr;
+}
+
+/**
+ * @brief Calcula la disposición de los objetos de la caché
+ * @return 0 si cabe al menos un objeto en un slab de SLAB_MAX_ORDER
+ */
+static int cache_layout(struct kmem_cache *c, unsigned long size, unsigned long align) {
+    if (align < SLAB_MIN_ALIGN) align = SLAB_MIN_ALIGN;
+    while (align & (align - 1)) align++;   /* Potencia de 2 */
+
+    c->align = align;
+    c->object_size = size;
+    if (c->ctor != nullptr) {
+        /* El enlace libre no puede pisar el objeto construido */
+        c->offset = align_up(size, sizeof(void *));
+        size = c->offset + sizeof(void *);
+    } else {
+        c->offset = 0;
+        if (size < sizeof(void *)) size = sizeof(void *);
+    }
+    c->size = align_up(size, align);
+
+    unsigned long header = slab_first_obj(c);
+    for (unsigned int order = 0; order <= SLAB_MAX_ORDER; order++) {
+        unsigned long bytes = (unsigned long)PAGE_SIZE << order;
+        if (bytes < header + c->size) continue;
+
+        unsigned long objs = (bytes - header) / c->size;
+        if (objs >= SLAB_MIN_OBJS || order == SLAB_MAX_ORDER) {
+            c->order = order;
+            c->objs_per_slab = (unsigned int)objs;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Reserva un slab nuevo y construye sus objetos (sin lock)
+ */
+static struct slab *slab_create(struct kmem_cache *c) {
+    unsigned long base = alloc_pages(c->order);
+    if (base == 0) return nullptr;
+
+    struct slab *s = (struct slab *)base;
+    s->cache = c;
+    s->next = s->prev = nullptr;
+    s->inuse = 0;
+    s->freelist = nullptr;
+
+    /* Enlazar de atrás hacia delante: se asigna en orden de dirección */
+    unsigned long first = base + slab_first_obj(c);
+    for (int i = (int)c->objs_per_slab - 1; i >= 0; i--) {
+        void *obj = (void *)(first + (unsigned long)i * c->size);
+        if (c->ctor != nullptr) {
+            c->ctor(obj);
+        }
+        slab_set_free(c, obj, s->freelist);
+        s->freelist = obj;
+    }
+    return s;
+}
+
+/* ========================================================================== */
+/* API PÚBLICA                                                               */
+/* ========================================================================== */
+
+void kmem_cache_init(void) {
+    memset(&cache_cache, 0, sizeof(cache_cache));
+    k_strncpy(cache_cache.name, "kmem_cache", SLAB_NAME_LEN);
+    cache_layout(&cache_cache, sizeof(struct kmem_cache), 0);
+
+    cache_list = &cache_cache;
+
+    kprintf("   [SLAB] Cachés de objetos listas (%d descriptores por slab)\n",
+            (long)cache_cache.objs_per_slab);
+}
+
+struct kmem_cache *kmem_cache_create(const char *name, unsigned long size,
+                                     unsigned long align, void (*ctor)(void *)) {
+    struct kmem_cache *c = (struct kmem_cache *)kmem_cache_alloc(&cache_cache);
+    if (c == nullptr) return nullptr;
+
+    memset(c, 0, sizeof(*c));
+    k_strncpy(c->name, name, SLAB_NAME_LEN);
+    c->ctor = ctor;
+
+    if (cache_layout(c, size, align) < 0) {
+        kprintf("[SLAB] Error: objetos de %d bytes no caben en un slab (%s)\n",
+                (long)size, name);
+        kmem_cache_free(&cache_cache, c);
+        return nullptr;
+    }
+
+    unsigned long flags = spin_lock_irqsave(&cache_list_lock);
+    c->next = cache_list;
+    cache_list = c;
+    spin_unlock_irqrestore(&cache_list_lock, flags);
+
+    return c;
+}
+
+int kmem_cache_destroy(struct kmem_cache *cache) {
+    if (cache == nullptr || cache == &cache_cache) return -1;
+
+    unsigned long flags = spin_lock_irqsave(&cache->lock);
+    unsigned long active = cache->active_objs;
+    spin_unlock_irqrestore(&cache->lock, flags);
+
+    if (active != 0) {
+        kprintf("[SLAB] Error: %s aún tiene %d objetos asignados\n",
+                cache->name, (long)active);
+        return -1;
+    }
+
+    kmem_cache_shrink(cache);
+
+    flags = spin_lock_irqsave(&cache_list_lock);
+    for (struct kmem_cache **it = &cache_list; *it != nullptr; it = &(*it)->next) {
+        if (*it == cache) {
+            *it = cache->next;
+            break;
+        }
+    }
+    spin_unlock_irqrestore(&cache_list_lock, flags);
+
+    kmem_cache_free(&cache_cache, cache);
+    return 0;
+}
+
+void *kmem_cache_alloc(struct kmem_cache *cache) {
+    unsigned long flags = spin_lock_irqsave(&cache->lock);
+
+    struct slab *s = cache->partial;
+    if (s == nullptr && cache->empty != nullptr) {
+        s = cache->empty;
+        slab_list_del(&cache->empty, s);
+        slab_list_add(&cache->partial, s);
+        cache->nr_empty--;
+    }
+
+    if (s == nullptr) {
+        /* Sin objetos libres: crear un slab fuera del lock */
+        spin_unlock_irqrestore(&cache->lock, flags);
+        struct slab *fresh = slab_create(cache);
+        if (fresh == nullptr) {
+            kprintf("[SLAB] Error: sin memoria para un slab de %s\n", cache->name);
+            return nullptr;
+        }
+        flags = spin_lock_irqsave(&cache->lock);
+
+        slab_list_add(&cache->partial, fresh);
+        cache->nr_slabs++;
+        s = cache->partial;
+    }
+
+    void *obj = s->freelist;
+    s->freelist = slab_get_free(cache, obj);
+    s->inuse++;
+
+    if (s->inuse == cache->objs_per_slab) {
+        slab_list_del(&cache->partial, s);
+        slab_list_add(&cache->full, s);
+    }
+
+    cache->active_objs++;
+    cache->allocs++;
+
+    spin_unlock_irqrestore(&cache->lock, flags);
+    return obj;
+}
+
+void kmem_cache_free(struct kmem_cache *cache, void *obj) {
+    if (obj == nullptr) return;
+
+    struct slab *s = obj_to_slab(cache, obj);
+    if (s->cache != cache) {
+        kprintf("[SLAB] Error: 0x%x no pertenece a %s\n", (unsigned long)obj, cache->name);
+        return;
+    }
+
+    struct slab *release = nullptr;
+    unsigned long flags = spin_lock_irqsave(&cache->lock);
+
+    if (s->inuse == cache->objs_per_slab) {
+        slab_list_del(&cache->full, s);
+        slab_list_add(&cache->partial, s);
+    }
+
+    slab_set_free(cache, obj, s->freelist);
+    s->freelist = obj;
+    s->inuse--;
+
+    if (s->inuse == 0) {
+        slab_list_del(&cache->partial, s);
+        if (cache->nr_empty == 0) {
+            /* Reserva para la próxima ráfaga de asignaciones */
+            slab_list_add(&cache->empty, s);
+            cache->nr_empty++;
+        } else {
+            cache->nr_slabs--;
+            release = s;
+        }
+    }
+
+    cache->active_objs--;
+    cache->frees++;
+
+    spin_unlock_irqrestore(&cache->lock, flags);
+
+    if (release != nullptr) {
+        free_pages((unsigned long)release, cache->order);
+    }
+}
+
+int kmem_cache_shrink(struct kmem_cache *cache) {
+    int released = 0;
+
+    for (;;) {
+        unsigned long flags = spin_lock_irqsave(&cache->lock);
+        struct slab *s = cache->empty;
+        if (s != nullptr) {
+            slab_list_del(&cache->empty, s);
+            cache->nr_empty--;
+            cache->nr_slabs--;
+        }
+        spin_unlock_irqrestore(&cache->lock, flags);
+
+        if (s == nullptr) break;
+        free_pages((unsigned long)s, cache->order);
+        released++;
+    }
+    return released;
+}
+
+void slabinfo_print(void) {
+    kprintf("\nCaché            | Tam. | Activos | Total | Slabs | Pág/slab | Allocs | Frees\n");
+    kprintf("-----------------|------|---------|-------|-------|----------|--------|------\n");
+
+    /* kprintf() puede dormir en el mutex de la consola: cada tanda de
+       filas se copia con cache_list_lock tomado y se imprime al soltarlo
+       (la pila del proceso es pequeña para copiar todas de una vez) */
+    struct slabinfo_row rows[SLABINFO_BATCH];
+    int first = 0;
+    int n;
+
+    do {
+        n = 0;
+        int pos = 0;
+        unsigned long flags = spin_lock_irqsave(&cache_list_lock);
+        for (struct kmem_cache *c = cache_list; c != nullptr && n < SLABINFO_BATCH; c = c->next) {
+            if (pos++ < first) continue;
+
+            struct slabinfo_row *r = &rows[n++];
+            memcpy(r->name, c->name, SLAB_NAME_LEN);
+            r->object_size = c->object_size;
+            r->active_objs = c->active_objs;
+            r->total_objs = c->nr_slabs * c->objs_per_slab;
+            r->nr_slabs = c->nr_slabs;
+            r->pages = 1UL << c->order;
+            r->allocs = c->allocs;
+            r->frees = c->frees;
+        }
+        spin_unlock_irqrestore(&cache_list_lock, flags);
+
+        for (int i = 0; i < n; i++) {
+            struct slabinfo_row *r = &rows[i];
+            kprintf(" %s | %d | %d | %d | %d | %d | %d | %d\n",
+                    r->name,
+                    (long)r->object_size,
+                    (long)r->active_objs,
+                    (long)r->total_objs,
+                    (long)r->nr_slabs,
+                    (long)r->pages,
+                    (long)r->allocs,
+                    (long)r->frees);
+        }
+        first += n;
+    } while (n == SLABINFO_BATCH);
+
+    kprintf("\n");
+}
@@ -10,6 +10,8 @@
  *   - Gestión de tablas multinivel (L1/L2/L3)
  *   - Asignación automática de tablas intermedias
  *   - Configuración de permisos (RW, User/Kernel, Exec/NoExec)
+ *   - map_range(): bloques de 1GB/2MB y contiguous hint para rangos
+ *     grandes (el mapa lineal del kernel)
  *   
  *   TABLAS DE PÁGINAS ARM64 (4KB pages):
  *   - L1 (PGD): Page Global Directory (bits 38-30 de VA)
@@ -21,15 +23,181 @@
  *   - map_page() es llamado por handle_fault() cuando hay Page Fault
  *   - Crea tablas intermedias automáticamente si no existen
  *   - Configura permisos según nivel de privilegio (EL0/EL1)
+ *   
+ *   BLOQUES Y CONTIGÜIDAD:
+ *   - Una entrada L1/L2 puede ser un bloque: cubre 1GB/2MB sin tablas
+ *     debajo, y la TLB lo guarda como una sola traducción
+ *   - Si map_page() necesita una página dentro de un bloque, el bloque
+ *     se parte en una tabla del nivel siguiente equivalente, con
+ *     break-before-make (entrada inválida, TLBI del bloque, tabla)
+ *   - Tocar una entrada de un grupo MM_CONTIG quita la marca a todo el
+ *     grupo: la arquitectura exige que el grupo sea uniforme
+ *   
+ *   ESPACIOS POR PROCESO:
+ *   - Cada proceso tiene su tabla base (vmm_create_pgd) en TTBR0: las
+ *     entradas del kernel se comparten y el espacio de usuario
+ *     [DEMAND_VA_BASE, USER_VA_END) es privado, con entradas MM_NG
+ *   - fork(): vmm_fork_user_space() copia solo descriptores; las páginas
+ *     quedan compartidas de solo lectura hasta la primera escritura
  * 
  * @author Sistema Operativo Educativo BareMetalM4
- * @version 0.6
+ * @version 0.7
  */
 
 #include "../../include/mm/vmm.h"
 #include "../../include/mm/pmm.h"
 #include "../../include/utils/kutils.h"
 #include "../../include/drivers/io.h"
+#include "../../include/mm/mm.h"
+
+/* ========================================================================== */
+/* FUNCIONES AUXILIARES                                                      */
+/* ========================================================================== */
+
+/**
+ * @brief Quita MM_CONTIG al grupo de la entrada 'idx' (si lo tenía)
+ */
+static void clear_contig(unsigned long *table, unsigned long idx) {
+    if (!(table[idx] & MM_CONTIG)) return;
+
+    unsigned long first = idx & ~(unsigned long)(CONT_ENTRIES - 1);
+    for (unsigned long i = 0; i < CONT_ENTRIES; i++) {
+        table[first + i] &= ~MM_CONTIG;
+    }
+}
+
+/* Se pone a 1 con la primera copia de kernel_pgd (vmm_create_pgd) */
+static int kernel_root_shared = 0;
+
+/**
+ * @brief ¿Es table[idx] una entrada del kernel que ya no se puede cambiar?
+ *
+ * @details
+ *   Las entradas del kernel de kernel_pgd se copian en cada tabla base
+ *   al crearla: una vez hecha la primera copia, crear o partir una
+ *   entrada de la raíz ya no llegaría a los procesos.
+ */
+static int kernel_root_frozen(unsigned long *table, unsigned long idx) {
+    return table == kernel_pgd && idx < USER_PGD_FIRST && kernel_root_shared;
+}
+
+/**
+ * @brief Break-before-make de table[idx] (y de su grupo MM_CONTIG)
+ * @param va Dirección virtual que cubre table[idx]
+ * @param block_size Tamaño que cubre una entrada de 'table'
+ *
+ * @details
+ *   Una traducción válida no puede cambiar de tamaño en sitio: la TLB
+ *   podría quedarse con el bloque viejo y las páginas nuevas a la vez
+ *   (TLB conflict abort). Se deja la entrada inválida, se invalida todo
+ *   lo que cubría y solo entonces se escribe el descriptor nuevo. Si
+ *   estaba en un grupo MM_CONTIG, el grupo entero pierde la marca y pasa
+ *   por lo mismo. Al volver table[idx] queda a 0 para quien llama.
+ */
+static void break_entry(unsigned long *table, unsigned long idx,
+                        unsigned long va, unsigned long block_size) {
+    unsigned long first = idx;
+    unsigned long n = 1;
+    unsigned long saved[CONT_ENTRIES];
+
+    if (table[idx] & MM_CONTIG) {
+        first = idx & ~(unsigned long)(CONT_ENTRIES - 1);
+        n = CONT_ENTRIES;
+    }
+
+    for (unsigned long i = 0; i < n; i++) {
+        saved[i] = table[first + i] & ~MM_CONTIG;
+        table[first + i] = 0;
+    }
+
+    unsigned long start = (va & ~(block_size - 1)) - (idx - first) * block_size;
+    tlb_invalidate_range(start, start + n * block_size);
+
+    for (unsigned long i = 0; i < n; i++) {
+        if (first + i != idx) table[first + i] = saved[i];
+    }
+}
+
+/**
+ * @brief Tabla del siguiente nivel bajo table[idx], creándola si falta
+ * @param virt Dirección virtual que se está mapeando (dentro de table[idx])
+ * @param block_size Tamaño que cubre table[idx] (L1_BLOCK_SIZE o L2_BLOCK_SIZE)
+ * @return Tabla hija, o nullptr si no hay memoria o no se puede cambiar
+ *
+ * @details
+ *   Si table[idx] es un bloque, la tabla nueva reproduce el bloque con
+ *   512 entradas del nivel siguiente y los mismos atributos, y se
+ *   instala con break-before-make (break_entry). Rechaza cambiar las
+ *   entradas del kernel de kernel_pgd ya copiadas (kernel_root_frozen).
+ */
+static unsigned long *next_table(unsigned long *table, unsigned long idx,
+                                 unsigned long virt, unsigned long block_size) {
+    unsigned long entry = table[idx];
+    if ((entry & 3) == PT_TABLE) {
+        return (unsigned long *)(entry & PTE_ADDR_MASK);
+    }
+
+    if (kernel_root_frozen(table, idx)) {
+        kprintf("[VMM] Error: la raíz del kernel ya está copiada en los procesos (0x%x)\n", virt);
+        return nullptr;
+    }
+
+    unsigned long new_page = get_free_page();
+    if (!new_page) return nullptr;
+    unsigned long *child = (unsigned long *)new_page;
+
+    if (entry & 1) {
+        /* Partir el bloque: misma física y atributos, entradas más pequeñas */
+        unsigned long base = entry & PTE_ADDR_MASK & ~(block_size - 1);
+        unsigned long attrs = entry & ~(PTE_ADDR_MASK | MM_CONTIG | 3UL);
+        unsigned long step = block_size / 512;
+        unsigned long type = (step == PAGE_SIZE) ? PT_PAGE : PT_BLOCK;
+
+        for (unsigned long i = 0; i < 512; i++) {
+            child[i] = (base + i * step) | attrs | type;
+        }
+        break_entry(table, idx, virt, block_size);
+    }
+
+    table[idx] = new_page | PT_TABLE;
+    tlb_map_barrier();
+    return child;
+}
+
+/**
+ * @brief Escribe entradas de un nivel a partir de table[idx]
+ * @param span virt | phys (para comprobar alineación)
+ * @param step Tamaño de una entrada en este nivel
+ * @param desc Tipo + atributos del descriptor (sin dirección)
+ * @return Bytes mapeados: un grupo MM_CONTIG o una sola entrada
+ */
+static unsigned long map_entries(unsigned long *table, unsigned long idx,
+                                 unsigned long phys, unsigned long span,
+                                 unsigned long size, unsigned long step,
+                                 unsigned long desc) {
+    unsigned long group = step * CONT_ENTRIES;
+
+    if (!(span & (group - 1)) && size >= group) {
+        int empty = 1;
+        for (unsigned long i = 0; i < CONT_ENTRIES; i++) {
+            if (table[idx + i] & 1) empty = 0;
+        }
+        if (empty) {
+            for (unsigned long i = 0; i < CONT_ENTRIES; i++) {
+                table[idx + i] = (phys + i * step) | desc | MM_CONTIG;
+            }
+            return group;
+        }
+    }
+
+    clear_contig(table, idx);
+    table[idx] = phys | desc;
+    return step;
+}
+
+/* ========================================================================== */
+/* MAPEO DE PÁGINAS Y RANGOS                                                 */
+/* ========================================================================== */
 
 /**
  * @brief Mapea una página virtual a una física
@@ -45,9 +213,11 @@
  *   1. Extraer índices L1/L2/L3 de la dirección virtual
  *   2. Navegar L1 (PGD):
  *      - Si no existe entrada, crear nueva tabla L2
+ *      - Si es un bloque de 1GB, partirlo en una tabla L2
  *      - Si existe, extraer puntero a L2
  *   3. Navegar L2 (PMD):
  *      - Si no existe entrada, crear nueva tabla L3
+ *      - Si es un bloque de 2MB, partirlo en una tabla L3
  *      - Si existe, extraer puntero a L3
  *   4. Escribir en L3 (PTE):
  *      - Crear descriptor de página: phys | flags | PT_PAGE | MM_ACCESS
@@ -58,7 +228,8 @@
  *   - PT_PAGE (L3): Página física final
  *   - MM_ACCESS: Access Flag (debe estar en 1)
  *   
- *   NOTA: Tras mapear, debe invalidarse la TLB con tlb_invalidate_all()
+ *   NOTA: Si el descriptor ya era válido, hay que invalidar su entrada
+ *   con tlb_invalidate_page(); si estaba vacío basta tlb_map_barrier()
  */
 void map_page(unsigned long *root_table, unsigned long virt, unsigned long phys, unsigned long flags) {
     /* === 1. EXTRAER ÍNDICES DE LA DIRECCIÓN VIRTUAL === */
@@ -67,50 +238,321 @@ void map_page(unsigned long *root_table, unsigned long virt, unsigned long phys,
     unsigned long l3_idx = L3_INDEX(virt);  // Bits 20-12
 
     /* === 2. NAVEGAR/CREAR TABLA L1 (PGD) === */
-    unsigned long *l2_table;
-    if (!(root_table[l1_idx] & 1)) {
-        /* No existe entrada L1 → Crear nueva tabla L2 */
-        unsigned long new_page = get_free_page();
-        if (!new_page) {
-            kprintf("[VMM] Error: No hay memoria para tabla L2\n");
-            return;
-        }
-
-        /* Apuntar L1 → L2 (descriptor tipo TABLE) */
-        root_table[l1_idx] = new_page | PT_TABLE | 1; // Bit válido
-        l2_table = (unsigned long*)new_page;
-    } else {
-        /* Ya existe, extraer dirección física de L2 (limpiando flags) */
-        l2_table = (unsigned long*)(root_table[l1_idx] & 0xFFFFFFFFF000);
+    /* Apuntar L1 → L2 (descriptor tipo TABLE) */
+    unsigned long *l2_table = next_table(root_table, l1_idx, virt, L1_BLOCK_SIZE);
+    if (!l2_table) {
+        kprintf("[VMM] Error: No se pudo obtener la tabla L2 de 0x%x\n", virt);
+        return;
     }
 
     /* === 3. NAVEGAR/CREAR TABLA L2 (PMD) === */
-    unsigned long *l3_table;
-    if (!(l2_table[l2_idx] & 1)) {
-        /* No existe entrada L2 → Crear nueva tabla L3 */
-        unsigned long new_page = get_free_page();
-        if (!new_page) {
-            kprintf("[VMM] Error: No hay memoria para tabla L3\n");
-            return;
-        }
-
-        /* Apuntar L2 → L3 (descriptor tipo TABLE) */
-        l2_table[l2_idx] = new_page | PT_TABLE | 1;
-        l3_table = (unsigned long *)new_page;
-    } else {
-        /* Ya existe, extraer dirección física de L3 */
-        l3_table = (unsigned long *)(l2_table[l2_idx] & 0xFFFFFFFFF000);
+    unsigned long *l3_table = next_table(l2_table, l2_idx, virt, L2_BLOCK_SIZE);
+    if (!l3_table) {
+        kprintf("[VMM] Error: No se pudo obtener la tabla L3 de 0x%x\n", virt);
+        return;
     }
 
     /* === 4. ESCRIBIR DESCRIPTOR FINAL EN L3 (PTE) === */
     /* Este descriptor conecta la dirección virtual con la física */
     unsigned long descriptor = phys | PT_PAGE | MM_ACCESS | flags;
+    clear_contig(l3_table, l3_idx);
     l3_table[l3_idx] = descriptor;
 
     /* IMPORTANTE: Tras modificar tablas de páginas, se debe invalidar TLB
        La TLB cachea traducciones. Si no se invalida, la MMU puede seguir
        usando la traducción antigua (página no mapeada) → Page Fault */
-    /* Nota: tlb_invalidate_all() debe llamarse desde handle_fault() */
+    /* Nota: quien llama decide: tlb_map_barrier() si el descriptor era
+       inválido (handle_fault), tlb_invalidate_page() si cambia uno válido */
+}
+
+/**
+ * @brief Mapea un rango con bloques, grupos contiguos y páginas
+ *
+ * @details
+ *   En cada vuelta se elige la entrada más grande posible para 'virt':
+ *   1. Bloque L1 de 1GB: virt/phys alineadas a 1GB, queda >= 1GB y la
+ *      entrada L1 está vacía
+ *   2. Bloque(s) L2 de 2MB, en grupos de 16 (32MB) con MM_CONTIG si
+ *      la alineación y el tamaño lo permiten
+ *   3. Páginas L3 de 4KB, en grupos de 16 (64KB) con MM_CONTIG
+ *   Mapear 128MB alineados son 4 grupos de bloques de 2MB: 1 tabla L2
+ *   en lugar de 64 tablas L3 y 32768 recorridos desde la raíz.
+ */
+int map_range(unsigned long *root_table, unsigned long virt, unsigned long phys,
+              unsigned long size, unsigned long flags) {
+    if ((virt | phys | size) & (PAGE_SIZE - 1)) {
+        kprintf("[VMM] Error: map_range(0x%x) sin alinear a página\n", virt);
+        return -1;
+    }
+
+    while (size > 0) {
+        unsigned long span = virt | phys;
+        unsigned long l1_idx = L1_INDEX(virt);
+        unsigned long done;
+
+        if (!(span & (L1_BLOCK_SIZE - 1)) && size >= L1_BLOCK_SIZE &&
+            !(root_table[l1_idx] & 1) && !kernel_root_frozen(root_table, l1_idx)) {
+            root_table[l1_idx] = phys | PT_BLOCK | MM_ACCESS | flags;
+            done = L1_BLOCK_SIZE;
+        } else {
+            unsigned long *l2_table = next_table(root_table, l1_idx, virt, L1_BLOCK_SIZE);
+            if (!l2_table) goto oom;
+
+            unsigned long l2_idx = L2_INDEX(virt);
+            if (!(span & (L2_BLOCK_SIZE - 1)) && size >= L2_BLOCK_SIZE &&
+                !(l2_table[l2_idx] & 1)) {
+                done = map_entries(l2_table, l2_idx, phys, span, size, L2_BLOCK_SIZE,
+                                   PT_BLOCK | MM_ACCESS | flags);
+            } else {
+                unsigned long *l3_table = next_table(l2_table, l2_idx, virt, L2_BLOCK_SIZE);
+                if (!l3_table) goto oom;
+
+                done = map_entries(l3_table, L3_INDEX(virt), phys, span, size, PAGE_SIZE,
+                                   PT_PAGE | MM_ACCESS | flags);
+            }
+        }
+
+        virt += done;
+        phys += done;
+        size -= done;
+    }
+    return 0;
+
+oom:
+    kprintf("[VMM] Error: No se pudieron obtener las tablas (map_range en 0x%x)\n", virt);
+    return -1;
+}
+
+/**
+ * @brief Traduce una dirección virtual recorriendo las tablas
+ *
+ * @details Entiende bloques de 1GB/2MB, a diferencia de vmm_get_pte().
+ */
+unsigned long vmm_translate(unsigned long *root_table, unsigned long virt) {
+    unsigned long entry = root_table[L1_INDEX(virt)];
+    if (!(entry & 1)) return 0;
+    if ((entry & 3) == PT_BLOCK) {
+        return (entry & PTE_ADDR_MASK & ~(L1_BLOCK_SIZE - 1)) | (virt & (L1_BLOCK_SIZE - 1));
+    }
+
+    entry = ((unsigned long *)(entry & PTE_ADDR_MASK))[L2_INDEX(virt)];
+    if (!(entry & 1)) return 0;
+    if ((entry & 3) == PT_BLOCK) {
+        return (entry & PTE_ADDR_MASK & ~(L2_BLOCK_SIZE - 1)) | (virt & (L2_BLOCK_SIZE - 1));
+    }
+
+    entry = ((unsigned long *)(entry & PTE_ADDR_MASK))[L3_INDEX(virt)];
+    if (!(entry & 1)) return 0;
+    return (entry & PTE_ADDR_MASK) | (virt & (PAGE_SIZE - 1));
+}
+
+/**
+ * @brief Libera las tablas L2/L3 bajo una tabla base y la deja vacía
+ */
+void vmm_free_tables(unsigned long *root_table) {
+    for (int i = 0; i < 512; i++) {
+        unsigned long l1_entry = root_table[i];
+        root_table[i] = 0;
+        if ((l1_entry & 3) != PT_TABLE) continue;
+
+        unsigned long *l2_table = (unsigned long *)(l1_entry & PTE_ADDR_MASK);
+        for (int j = 0; j < 512; j++) {
+            if ((l2_table[j] & 3) == PT_TABLE) {
+                free_page(l2_table[j] & PTE_ADDR_MASK);
+            }
+        }
+        free_page((unsigned long)l2_table);
+    }
+}
+
+/* ========================================================================== */
+/* ESPACIOS DE DIRECCIONES POR PROCESO                                       */
+/* ========================================================================== */
+
+/**
+ * @brief Tabla base nueva con las entradas del kernel de kernel_pgd
+ *
+ * @details
+ *   Solo se copian las entradas de la raíz: las tablas L2/L3 del kernel
+ *   son las mismas para todos. Desde la primera copia next_table() no
+ *   deja cambiar esas entradas en kernel_pgd, así que ninguna copia se
+ *   queda atrás.
+ */
+unsigned long *vmm_create_pgd(void) {
+    unsigned long page = get_free_page();
+    if (!page) return nullptr;
+
+    unsigned long *pgd = (unsigned long *)page;
+    kernel_root_shared = 1;
+    for (unsigned long i = 0; i < USER_PGD_FIRST; i++) {
+        pgd[i] = kernel_pgd[i];
+    }
+    return pgd;
+}
+
+/**
+ * @brief Suelta las páginas y tablas del espacio de usuario y la raíz
+ */
+void vmm_destroy_pgd(unsigned long *pgd) {
+    for (unsigned long i = USER_PGD_FIRST; i < 512; i++) {
+        if ((pgd[i] & 3) != PT_TABLE) continue;
+
+        unsigned long *l2_table = (unsigned long *)(pgd[i] & PTE_ADDR_MASK);
+        for (int j = 0; j < 512; j++) {
+            if ((l2_table[j] & 3) != PT_TABLE) continue;
+
+            unsigned long *l3_table = (unsigned long *)(l2_table[j] & PTE_ADDR_MASK);
+            for (int k = 0; k < 512; k++) {
+                if (l3_table[k] & 1) {
+                    page_put(l3_table[k] & PTE_ADDR_MASK);
+                }
+            }
+            free_page((unsigned long)l3_table);
+        }
+        free_page((unsigned long)l2_table);
+    }
+    free_page((unsigned long)pgd);
+}
+
+/**
+ * @brief Comparte el espacio de usuario de 'src' con 'dst' (COW)
+ *
+ * @details
+ *   Solo se copian descriptores: cada página pasa a solo lectura en
+ *   ambas tablas y gana una referencia. La primera escritura de
+ *   cualquiera de los dos la resuelve vmm_cow_fault().
+ */
+long vmm_fork_user_space(unsigned long *dst, unsigned long *src) {
+    long shared = 0;
+
+    for (unsigned long i = USER_PGD_FIRST; i < 512; i++) {
+        if ((src[i] & 3) != PT_TABLE) continue;
+
+        unsigned long *l2_table = (unsigned long *)(src[i] & PTE_ADDR_MASK);
+        for (unsigned long j = 0; j < 512; j++) {
+            if ((l2_table[j] & 3) != PT_TABLE) continue;
+
+            unsigned long *l3_table = (unsigned long *)(l2_table[j] & PTE_ADDR_MASK);
+            for (unsigned long k = 0; k < 512; k++) {
+                if (!(l3_table[k] & 1)) continue;
+
+                unsigned long va = (i * L1_BLOCK_SIZE) + (j * L2_BLOCK_SIZE) + (k * PAGE_SIZE);
+                unsigned long phys = l3_table[k] & PTE_ADDR_MASK;
+
+                l3_table[k] |= MM_RO;
+                page_get(phys);
+                map_page(dst, va, phys, l3_table[k] & ~(PTE_ADDR_MASK | 3UL));
+
+                unsigned long *pte = vmm_get_pte(dst, va);
+                if (pte == nullptr || !(*pte & 1)) {
+                    page_put(phys);     /* map_page() sin memoria para tablas */
+                    return -1;
+                }
+                shared++;
+            }
+        }
+    }
+    return shared;
+}
+
+/* ========================================================================== */
+/* CONSULTA Y MODIFICACIÓN DE ENTRADAS L3                                    */
+/* ========================================================================== */
+
+/**
+ * @brief Busca la entrada L3 (PTE) de una dirección virtual
+ * @param root_table Tabla base (L1/PGD)
+ * @param virt Dirección virtual
+ * @return Puntero a la entrada L3, o nullptr si falta L2 o L3
+ *
+ * @details
+ *   A diferencia de map_page(), NUNCA crea tablas intermedias ni parte
+ *   bloques: una dirección dentro de un bloque no tiene entrada L3.
+ */
+unsigned long *vmm_get_pte(unsigned long *root_table, unsigned long virt) {
+    unsigned long l1_entry = root_table[L1_INDEX(virt)];
+    if ((l1_entry & 3) != PT_TABLE) return nullptr;
+
+    unsigned long *l2_table = (unsigned long *)(l1_entry & 0xFFFFFFFFF000);
+    unsigned long l2_entry = l2_table[L2_INDEX(virt)];
+    if ((l2_entry & 3) != PT_TABLE) return nullptr;
+
+    unsigned long *l3_table = (unsigned long *)(l2_entry & 0xFFFFFFFFF000);
+    return &l3_table[L3_INDEX(virt)];
+}
+
+/**
+ * @brief Elimina el mapeo de una página virtual
+ * @param root_table Tabla base (L1/PGD)
+ * @param virt Dirección virtual (alineada a 4KB)
+ * @return Dirección física que estaba mapeada, o 0 si no había mapeo
+ *
+ * @details
+ *   Solo borra el descriptor L3; NO libera la página física (el llamador
+ *   decide si la transfiere o la devuelve con free_page()).
+ *   Como en map_page(), el llamador debe invalidar la TLB.
+ */
+unsigned long unmap_page(unsigned long *root_table, unsigned long virt) {
+    unsigned long *pte = vmm_get_pte(root_table, virt);
+    if (pte == nullptr || !(*pte & 1)) return 0;
+
+    unsigned long phys = *pte & 0xFFFFFFFFF000;
+    clear_contig(pte - L3_INDEX(virt), L3_INDEX(virt));
+    *pte = 0;
+    return phys;
+}
+
+/**
+ * @brief Resuelve un fallo de escritura sobre una página copy-on-write
+ * @param root_table Tabla base (L1/PGD)
+ * @param virt Dirección que provocó el fallo de permisos
+ * @return 0 si se resolvió, -1 si no era una página COW
+ *
+ * @details
+ *   Una página COW es una página de solo lectura del PMM:
+ *   - Compartida (refcount > 1): se copia a una página nueva, se mapea
+ *     RW en lugar de la original y se suelta la referencia a la original
+ *   - Única (refcount == 1): basta con devolverle el permiso de escritura
+ *
+ *   La copia se prepara antes de soltar la referencia, y page_put_shared()
+ *   decide en un solo paso bajo pmm_lock: si entretanto la original quedó
+ *   solo para nosotros, la copia sobra y se devuelve.
+ *
+ *   Cambiar la física de una entrada válida exige break-before-make:
+ *   entrada a 0, TLBI de la página y solo entonces la copia RW.
+ */
+int vmm_cow_fault(unsigned long *root_table, unsigned long virt) {
+    unsigned long va = virt & ~(PAGE_SIZE - 1);
+    unsigned long *pte = vmm_get_pte(root_table, va);
+
+    if (pte == nullptr || !(*pte & 1) || !(*pte & MM_RO)) return -1;
+
+    unsigned long phys = *pte & 0xFFFFFFFFF000;
+    int refs = page_refcount(phys);
+    if (refs == 0) return -1;
+
+    unsigned long copy = 0;
+    if (refs > 1) {
+        copy = get_free_page();
+        if (!copy) return -1;
+        memcpy((void *)copy, (void *)phys, PAGE_SIZE);
+    }
+
+    if (copy && page_put_shared(phys)) {
+        unsigned long entry = (*pte & ~(0xFFFFFFFFF000UL | MM_RO)) | copy;
+        *pte = 0;
+        tlb_invalidate_page(va);
+        *pte = entry;
+        tlb_map_barrier();
+        return 0;
+    }
+
+    if (copy) free_page(copy);
+    *pte &= ~MM_RO;
+
+    /* Solo cae la entrada de solo lectura: el resto de la TLB sigue caliente */
+    tlb_invalidate_page(va);
+    return 0;
 }
 
 /* Tabla de páginas principal del kernel (L1/PGD)
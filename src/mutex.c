@@ -0,0 +1,273 @@
+/**
+ * @file mutex.c
+ * @brief Implementación de mutex con herencia de prioridad
+ *
+ * @details
+ *   ADQUISICIÓN (mutex_lock):
+ *   1. Espera adaptativa: mientras el propietario esté RUNNING (en otra
+ *      CPU) se reintenta hasta MUTEX_SPIN_MAX veces. En un solo core el
+ *      propietario nunca está RUNNING si nosotros ejecutamos, así que se
+ *      pasa directamente al paso 2
+ *   2. Si está libre, el llamador pasa a ser el propietario
+ *   3. Si no, se encola, presta su prioridad al propietario si es más
+ *      urgente y se bloquea (BLOCK_REASON_WAIT)
+ *
+ *   LIBERACIÓN (mutex_unlock):
+ *   1. El mutex sale de la lista held_mutexes del propietario
+ *   2. Se entrega el mutex al waiter con menor priority (hand-off: ya es
+ *      el propietario al despertar, nadie se lo puede "robar")
+ *   3. Si quedan waiters más urgentes que el nuevo propietario, éste
+ *      hereda su prioridad
+ *   4. El antiguo propietario recalcula la suya: la más urgente entre
+ *      base_priority y los waiters de los mutex que sigue teniendo
+ *
+ *   Todo el estado se modifica con el spinlock interno y las IRQs
+ *   deshabilitadas (mismo esquema que src/semaphore.c). Las colas de
+ *   los otros mutex del propietario se leen sin su spinlock: en un solo
+ *   core nadie las modifica mientras las IRQs están deshabilitadas.
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ * @see mutex.h para interfaz pública
+ */
+
+#include "../include/mutex.h"
+#include "../include/spinlock.h"
+
+#include "../include/kernel/process.h"
+#include "../include/kernel/scheduler.h"
+
+/* ========================================================================== */
+/* FUNCIONES AUXILIARES                                                      */
+/* ========================================================================== */
+
+/**
+ * @brief Prioridad más urgente (menor valor) entre los waiters
+ * @return Prioridad mínima, o -1 si la cola está vacía
+ */
+static int mutex_top_waiter_prio(struct mutex *m) {
+    int best = -1;
+    for (struct pcb *p = m->head; p != nullptr; p = p->next) {
+        if (best < 0 || p->priority < best) {
+            best = p->priority;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Presta 'prio' al propietario si es más urgente que la suya
+ *
+ * @details Guarda la prioridad propia solo la primera vez.
+ */
+static void mutex_boost_owner(struct mutex *m, int prio) {
+    struct pcb *owner = m->owner;
+    if (prio < 0 || prio >= owner->priority) return;
+
+    if (owner->base_priority < 0) {
+        owner->base_priority = owner->priority;
+    }
+    owner->priority = prio;
+}
+
+/**
+ * @brief Hace a 'p' propietario de 'm' y lo añade a su lista de mutex
+ */
+static void mutex_set_owner(struct mutex *m, struct pcb *p) {
+    m->owner = p;
+    m->held_next = p->held_mutexes;
+    p->held_mutexes = m;
+}
+
+/**
+ * @brief Quita 'm' de la lista de mutex de su propietario 'p'
+ */
+static void mutex_drop_held(struct mutex *m, struct pcb *p) {
+    struct mutex **link = &p->held_mutexes;
+    while (*link != nullptr && *link != m) {
+        link = &(*link)->held_next;
+    }
+    if (*link == m) {
+        *link = m->held_next;
+    }
+    m->held_next = nullptr;
+}
+
+/**
+ * @brief Recalcula la prioridad heredada de 'p'
+ *
+ * @details
+ *   La prioridad efectiva es la más urgente entre base_priority y los
+ *   waiters de todos los mutex que 'p' sigue teniendo. Si no queda
+ *   ninguno más urgente, la herencia termina (base_priority = -1).
+ */
+static void mutex_update_prio(struct pcb *p) {
+    if (p->base_priority < 0) return;   /* No hay herencia activa */
+
+    int prio = p->base_priority;
+    for (struct mutex *m = p->held_mutexes; m != nullptr; m = m->held_next) {
+        int top = mutex_top_waiter_prio(m);
+        if (top >= 0 && top < prio) {
+            prio = top;
+        }
+    }
+
+    p->priority = prio;
+    if (prio == p->base_priority) {
+        p->base_priority = -1;
+    }
+}
+
+/* ========================================================================== */
+/* OPERACIONES DE MUTEX                                                      */
+/* ========================================================================== */
+
+/**
+ * @brief Inicializa un mutex libre
+ */
+void mutex_init(struct mutex *m, const char *name) {
+    m->lock = 0;
+    m->owner = nullptr;
+    m->head = nullptr;
+    m->tail = nullptr;
+    m->held_next = nullptr;
+    m->name = name;
+}
+
+/**
+ * @brief Intenta adquirir el mutex sin esperar
+ */
+int mutex_trylock(struct mutex *m) {
+    struct pcb *me = current_process;
+    if (me == nullptr) return 1;   /* Arranque: aún no hay procesos */
+
+    unsigned long flags = spin_lock_irqsave(&m->lock);
+    int ok = (m->owner == nullptr);
+    if (ok) {
+        mutex_set_owner(m, me);
+    }
+    spin_unlock_irqrestore(&m->lock, flags);
+    return ok;
+}
+
+/**
+ * @brief Adquiere el mutex (espera activa corta o bloqueo)
+ *
+ * @details
+ *   Antes de init_process_system() (current_process == nullptr) solo
+ *   existe el hilo de arranque: lock/unlock no hacen nada.
+ */
+void mutex_lock(struct mutex *m) {
+    struct pcb *me = current_process;
+    if (me == nullptr) return;
+
+    /* 1. ESPERA ADAPTATIVA: el propietario está ejecutando, lo soltará pronto */
+    for (int spin = 0; spin < MUTEX_SPIN_MAX; spin++) {
+        struct pcb *owner = m->owner;
+        if (owner == nullptr || owner == me || owner->state != PROCESS_RUNNING) {
+            break;
+        }
+        asm volatile("yield");
+    }
+
+    unsigned long flags = spin_lock_irqsave(&m->lock);
+
+    /* 2. Libre: somos el propietario */
+    if (m->owner == nullptr) {
+        mutex_set_owner(m, me);
+        spin_unlock_irqrestore(&m->lock, flags);
+        return;
+    }
+
+    /* 3. Ocupado: encolarse (FIFO) */
+    me->next = nullptr;
+    if (m->tail == nullptr) {
+        m->head = me;
+    } else {
+        m->tail->next = me;
+    }
+    m->tail = me;
+
+    /* HERENCIA: el propietario no puede ser menos urgente que nosotros */
+    mutex_boost_owner(m, me->priority);
+
+    me->state = PROCESS_BLOCKED;
+    me->block_reason = BLOCK_REASON_WAIT;
+
+    /* Liberar el spinlock antes de dormir; IRQs siguen deshabilitadas
+       hasta el cambio de contexto */
+    spin_unlock(&m->lock);
+    schedule();
+
+    /* mutex_unlock() nos entregó el mutex antes de despertarnos */
+    local_irq_restore(flags);
+}
+
+/**
+ * @brief Libera el mutex y lo entrega al waiter más urgente
+ *
+ * @details Si el llamador no es el propietario, no hace nada.
+ */
+void mutex_unlock(struct mutex *m) {
+    struct pcb *me = current_process;
+    if (me == nullptr) return;
+
+    unsigned long flags = spin_lock_irqsave(&m->lock);
+
+    if (m->owner != me) {
+        spin_unlock_irqrestore(&m->lock, flags);
+        return;
+    }
+
+    /* 1. Ya no lo tenemos: sus waiters dejan de contar para nosotros */
+    mutex_drop_held(m, me);
+
+    /* 2. Elegir el waiter más urgente */
+    struct pcb *best = nullptr;
+    struct pcb *best_prev = nullptr;
+    struct pcb *prev = nullptr;
+    for (struct pcb *p = m->head; p != nullptr; prev = p, p = p->next) {
+        if (best == nullptr || p->priority < best->priority) {
+            best = p;
+            best_prev = prev;
+        }
+    }
+
+    if (best == nullptr) {
+        m->owner = nullptr;
+        mutex_update_prio(me);
+        spin_unlock_irqrestore(&m->lock, flags);
+        return;
+    }
+
+    /* Sacarlo de la cola */
+    if (best_prev == nullptr) {
+        m->head = best->next;
+    } else {
+        best_prev->next = best->next;
+    }
+    if (m->tail == best) {
+        m->tail = best_prev;
+    }
+    best->next = nullptr;
+
+    /* 3. HAND-OFF: el despertado ya es el propietario */
+    mutex_set_owner(m, best);
+    best->state = PROCESS_READY;
+    best->block_reason = BLOCK_REASON_NONE;
+
+    /* Los waiters restantes pueden necesitar elevar al nuevo propietario */
+    mutex_boost_owner(m, mutex_top_waiter_prio(m));
+
+    /* 4. Nuestra prioridad, con los mutex que nos quedan */
+    mutex_update_prio(me);
+
+    spin_unlock_irqrestore(&m->lock, flags);
+}
+
+/**
+ * @brief Indica si el proceso actual tiene el mutex
+ */
+int mutex_is_owner(struct mutex *m) {
+    return m->owner != nullptr && m->owner == current_process;
+}
@@ -0,0 +1,221 @@
+/**
+ * @file ring.c
+ * @brief Implementación de las colas circulares SPSC y MPMC
+ *
+ * @details
+ *   ORDEN DE MEMORIA (SPSC):
+ *   @code
+ *   productor                         consumidor
+ *   slots[h] = v                      h = LDAR(head)       (acquire)
+ *   STLR(head, h + 1)   (release) --> v = slots[t]
+ *                                     STLR(tail, t + 1)    (release)
+ *   t = LDAR(tail)      (acquire) <--
+ *   (ya puede reutilizar slots[t])
+ *   @endcode
+ *
+ *   ORDEN DE MEMORIA (MPMC): igual, pero la publicación es por slot
+ *   (seq) y la reserva de posiciones con cmpxchg_relaxed() sobre
+ *   head/tail (atomic.h: CAS con LSE, LDXR/STXR sin él). El CAS no
+ *   necesita orden propio: lo dan el acquire/release de seq.
+ *
+ *   LOTES MPMC: se cuentan los k slots consecutivos listos desde pos y
+ *   se reclaman todos con un único CAS pos -> pos + k. Es correcto
+ *   porque el seq de un slot libre solo lo cambia quien gane su
+ *   posición, y para eso head tendría que haber avanzado (el CAS
+ *   fallaría).
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ * @see ring.h para interfaz pública
+ */
+
+#include "../include/ring.h"
+#include "../include/barrier.h"
+#include "../include/atomic.h"
+#include "../include/drivers/io.h"
+
+/* ========================================================================== */
+/* FUNCIONES AUXILIARES                                                      */
+/* ========================================================================== */
+
+static int ring_size_ok(unsigned long size) {
+    if (size == 0 || (size & (size - 1)) != 0) {
+        kprintf("[RING] Error: Tamaño %d no es potencia de 2\n", size);
+        return 0;
+    }
+    return 1;
+}
+
+/* ========================================================================== */
+/* SPSC                                                                      */
+/* ========================================================================== */
+
+int spsc_ring_init(struct spsc_ring *r, unsigned long *slots, unsigned long size) {
+    if (!ring_size_ok(size)) return -1;
+
+    r->head = 0;
+    r->tail_cache = 0;
+    r->tail = 0;
+    r->head_cache = 0;
+    r->mask = size - 1;
+    r->slots = slots;
+    return 0;
+}
+
+unsigned long spsc_ring_enqueue_burst(struct spsc_ring *r, const unsigned long *vals, unsigned long n) {
+    unsigned long head = r->head;
+    unsigned long size = r->mask + 1;
+
+    /* Releer tail solo si la copia dice que no cabe */
+    unsigned long free = size - (head - r->tail_cache);
+    if (free < n) {
+        r->tail_cache = smp_load_acquire(&r->tail);
+        free = size - (head - r->tail_cache);
+    }
+    if (n > free) n = free;
+
+    for (unsigned long i = 0; i < n; i++) {
+        r->slots[(head + i) & r->mask] = vals[i];
+    }
+
+    if (n > 0) {
+        smp_store_release(&r->head, head + n);
+    }
+    return n;
+}
+
+unsigned long spsc_ring_dequeue_burst(struct spsc_ring *r, unsigned long *vals, unsigned long n) {
+    unsigned long tail = r->tail;
+
+    /* Releer head solo si la copia dice que no hay suficientes */
+    unsigned long avail = r->head_cache - tail;
+    if (avail < n) {
+        r->head_cache = smp_load_acquire(&r->head);
+        avail = r->head_cache - tail;
+    }
+    if (n > avail) n = avail;
+
+    for (unsigned long i = 0; i < n; i++) {
+        vals[i] = r->slots[(tail + i) & r->mask];
+    }
+
+    if (n > 0) {
+        smp_store_release(&r->tail, tail + n);
+    }
+    return n;
+}
+
+int spsc_ring_enqueue(struct spsc_ring *r, unsigned long val) {
+    return spsc_ring_enqueue_burst(r, &val, 1) ? 0 : -1;
+}
+
+int spsc_ring_dequeue(struct spsc_ring *r, unsigned long *val) {
+    return spsc_ring_dequeue_burst(r, val, 1) ? 0 : -1;
+}
+
+unsigned long spsc_ring_count(struct spsc_ring *r) {
+    return smp_load_acquire(&r->head) - smp_load_acquire(&r->tail);
+}
+
+/* ========================================================================== */
+/* MPMC                                                                      */
+/* ========================================================================== */
+
+int mpmc_ring_init(struct mpmc_ring *r, struct mpmc_slot *slots, unsigned long size) {
+    if (!ring_size_ok(size)) return -1;
+
+    for (unsigned long i = 0; i < size; i++) {
+        slots[i].seq = i;
+        slots[i].val = 0;
+    }
+    r->head = 0;
+    r->tail = 0;
+    r->mask = size - 1;
+    r->slots = slots;
+    smp_wmb();
+    return 0;
+}
+
+unsigned long mpmc_ring_enqueue_burst(struct mpmc_ring *r, const unsigned long *vals, unsigned long n) {
+    if (n == 0) return 0;
+
+    unsigned long pos = READ_ONCE(r->head);
+    unsigned long k;
+
+    for (;;) {
+        /* 1. Contar slots consecutivos libres para pos, pos+1... */
+        long diff = 0;
+        for (k = 0; k < n; k++) {
+            unsigned long seq = smp_load_acquire(&r->slots[(pos + k) & r->mask].seq);
+            diff = (long)(seq - (pos + k));
+            if (diff != 0) break;
+        }
+
+        if (k == 0) {
+            /* Slot aún ocupado de la vuelta anterior: llena */
+            if (diff < 0) return 0;
+            /* Otro productor avanzó head: reintentar desde el actual */
+            pos = READ_ONCE(r->head);
+            continue;
+        }
+
+        /* 2. Reclamar las k posiciones */
+        unsigned long prev = cmpxchg_relaxed(&r->head, pos, pos + k);
+        if (prev == pos) break;
+        pos = prev;
+    }
+
+    /* 3. Escribir y publicar cada slot */
+    for (unsigned long i = 0; i < k; i++) {
+        struct mpmc_slot *slot = &r->slots[(pos + i) & r->mask];
+        slot->val = vals[i];
+        smp_store_release(&slot->seq, pos + i + 1);
+    }
+    return k;
+}
+
+unsigned long mpmc_ring_dequeue_burst(struct mpmc_ring *r, unsigned long *vals, unsigned long n) {
+    if (n == 0) return 0;
+
+    unsigned long pos = READ_ONCE(r->tail);
+    unsigned long k;
+
+    for (;;) {
+        /* 1. Contar slots consecutivos publicados para pos, pos+1... */
+        long diff = 0;
+        for (k = 0; k < n; k++) {
+            unsigned long seq = smp_load_acquire(&r->slots[(pos + k) & r->mask].seq);
+            diff = (long)(seq - (pos + k + 1));
+            if (diff != 0) break;
+        }
+
+        if (k == 0) {
+            /* Slot sin publicar: vacía (o productor a mitad) */
+            if (diff < 0) return 0;
+            /* Otro consumidor avanzó tail: reintentar desde el actual */
+            pos = READ_ONCE(r->tail);
+            continue;
+        }
+
+        /* 2. Reclamar las k posiciones */
+        unsigned long prev = cmpxchg_relaxed(&r->tail, pos, pos + k);
+        if (prev == pos) break;
+        pos = prev;
+    }
+
+    /* 3. Leer y devolver cada slot a los productores de la vuelta siguiente */
+    for (unsigned long i = 0; i < k; i++) {
+        struct mpmc_slot *slot = &r->slots[(pos + i) & r->mask];
+        vals[i] = slot->val;
+        smp_store_release(&slot->seq, pos + i + r->mask + 1);
+    }
+    return k;
+}
+
+int mpmc_ring_enqueue(struct mpmc_ring *r, unsigned long val) {
+    return mpmc_ring_enqueue_burst(r, &val, 1) ? 0 : -1;
+}
+
+int mpmc_ring_dequeue(struct mpmc_ring *r, unsigned long *val) {
+    return mpmc_ring_dequeue_burst(r, val, 1) ? 0 : -1;
+}
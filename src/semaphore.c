@@ -32,8 +32,11 @@
  *   - Procesos en estado BLOCKED no aparecen en schedule()
  * 
  *   PROTECCIÓN CONTRA RACE CONDITIONS:
- *   - spin_lock() adquiere un spinlock atómico (LDXR/STXR en ARM64)
- *   - Solo un proceso puede modificar el semáforo simultáneamente
+ *   - Cada semáforo tiene su propio spinlock (s->lock): semáforos no
+ *     relacionados (console_mutex, locks de aplicación) no compiten
+ *   - spin_lock_irqsave() deshabilita IRQs y adquiere el lock; al salir
+ *     spin_unlock_irqrestore() deja DAIF como estaba, así que se puede
+ *     llamar con IRQs ya deshabilitadas (secciones anidadas)
  *   - Se libera el spinlock ANTES de dormir (evita deadlock)
  * 
  *   VENTAJAS vs BUSY-WAIT:
@@ -48,25 +51,15 @@
  *   - ❌ Solo para sistemas simples/educativos
  * 
  * @author Sistema Operativo Educativo BareMetalM4
- * @version 0.6
+ * @version 0.7
  * @see semaphore.h para interfaz pública
  */
 
 #include "../include/semaphore.h"
+#include "../include/spinlock.h"
 
-#include "../include/drivers/timer.h"
 #include "../include/kernel/process.h"
-
-/* ========================================================================== */
-/* FUNCIONES EXTERNAS (Ensamblador)                                         */
-/* ========================================================================== */
-
-/* Spinlocks atómicos implementados en ARM64 assembly (locks.S) */
-extern void spin_lock(volatile int *lock);
-extern void spin_unlock(volatile int *lock);
-
-/* Spinlock global para proteger operaciones de semáforo */
-volatile int sem_lock = 0;
+#include "../include/kernel/scheduler.h"
 
 /* ========================================================================== */
 /* OPERACIONES DE SEMAFORO                                                   */
@@ -78,6 +71,7 @@ volatile int sem_lock = 0;
  * @param value Valor inicial del contador
  */
 void sem_init(struct semaphore *s, int value) {
+    s->lock = 0;
     s->count = value;
     s->head = nullptr;
     s->tail = nullptr;
@@ -92,15 +86,17 @@ void sem_init(struct semaphore *s, int value) {
  *   
  *   CASO A - Semáforo disponible (count > 0):
  *   1. Decrementa count
- *   2. Libera spinlock
+ *   2. Libera spinlock y restaura el estado de IRQs
  *   3. Retorna inmediatamente (acceso concedido)
  *   
  *   CASO B - Semáforo ocupado (count = 0):
  *   1. Añade el proceso a la wait queue (lista enlazada)
  *   2. Marca el proceso como BLOCKED (block_reason = BLOCK_REASON_WAIT)
  *   3. Libera el spinlock ANTES de dormir (crítico para evitar deadlock)
- *   4. Llama a schedule() - El proceso NO consume CPU mientras espera
- *   5. Cuando sem_signal() lo despierte, retorna (acceso concedido)
+ *   4. Llama a schedule() con IRQs aún deshabilitadas: el timer no puede
+ *      colarse entre el bloqueo y el cambio de contexto
+ *   5. Cuando sem_signal() lo despierte, restaura el estado de IRQs que
+ *      tenía el llamador y retorna (acceso concedido)
  *   
  *   ESTRUCTURA DE LA WAIT QUEUE:
  *   - Lista enlazada simple usando campo 'next' del PCB
@@ -109,16 +105,13 @@ void sem_init(struct semaphore *s, int value) {
  *   - FIFO: Fairness - Primero en llegar, primero en ser atendido
  */
 void sem_wait(struct semaphore *s) {
-    /* 1. ESCUDO: Apagamos interrupciones para que el Timer no nos corte */
-    disable_interrupts();
-
-    /* 2. Adquirir spinlock para proteger el semáforo */
-    spin_lock(&sem_lock);
+    /* 1. ESCUDO: IRQs fuera (guardando su estado) + lock del semáforo */
+    unsigned long flags = spin_lock_irqsave(&s->lock);
 
     if (s->count > 0) {
         /* CASO A: Semáforo libre - Acceso concedido inmediatamente */
         s->count--;
-        spin_unlock(&sem_lock);
+        spin_unlock_irqrestore(&s->lock, flags);
     } else {
         /* CASO B: Semáforo ocupado - Bloquearse en wait queue */
         
@@ -140,15 +133,14 @@ void sem_wait(struct semaphore *s) {
 
         /* CRÍTICO: Liberar el spinlock ANTES de dormir
            Si no liberamos aquí, nadie más puede hacer sem_signal() -> deadlock */
-        spin_unlock(&sem_lock);
-        enable_interrupts();
+        spin_unlock(&s->lock);
 
         /* Ceder la CPU - El scheduler nos ignorará hasta que nos despierten
            NO consumimos CPU mientras esperamos (NO busy-wait) */
         schedule();
 
-        /* Al despertar, habilitamos interrupciones */
-        enable_interrupts();
+        /* Al despertar, volvemos al estado de IRQs del llamador */
+        local_irq_restore(flags);
     }
 }
 
@@ -175,8 +167,7 @@ void sem_wait(struct semaphore *s) {
  *   - Esto evita race conditions: El despertado tiene el recurso garantizado
  */
 void sem_signal(struct semaphore *s) {
-    disable_interrupts();
-    spin_lock(&sem_lock);
+    unsigned long flags = spin_lock_irqsave(&s->lock);
 
     if (s->head != nullptr) {
         /* CASO A: Hay procesos esperando - Despertar el primero */
@@ -204,6 +195,5 @@ void sem_signal(struct semaphore *s) {
         s->count++;
     }
     
-    spin_unlock(&sem_lock);
-    enable_interrupts();
+    spin_unlock_irqrestore(&s->lock, flags);
 }
\ No newline at end of file
@@ -23,6 +23,9 @@
 #include "../../include/shell/shell.h"
 #include "../../include/utils/tests.h"
 #include "../../include/fs/vfs.h"
+#include "../../include/spinlock.h"
+#include "../../include/mm/slab.h"
+#include "../../include/mm/malloc.h"
 
 /* ========================================================================== */
 /* FUNCIONES EXTERNAS                                                        */
@@ -52,8 +55,8 @@ extern void system_off(void);
  *   - panic: Provoca un kernel panic
  *   - poweroff: Apaga el sistema
  *   
- *   El shell usa sleep(1) para ceder CPU eficientemente mientras
- *   espera entrada del usuario (NO busy-wait).
+ *   El shell duerme en uart_getc() mientras espera entrada del usuario
+ *   (NO busy-wait): el IRQ de la UART lo despierta con cada tecla.
  */
 void shell_task(void) {
     enable_interrupts();
@@ -66,15 +69,9 @@ void shell_task(void) {
     kprintf("> "); // Prompt
 
     while (1) {
-        /* 1. Intentamos leer una tecla */
-        const char c = uart_getc_nonblocking();
-
-        if (c == 0) {
-            /* Si no hay tecla, dormimos un poco para no quemar CPU */
-            /* Esto hace que el shell sea eficiente */
-            sleep(1); 
-            continue;
-        }
+        /* 1. Esperamos una tecla: el IRQ de la UART nos despierta al
+              llegar (sin sondeo ni espera hasta el siguiente tick) */
+        const char c = uart_getc();
 
         /* 2. Eco local (mostrar lo que escribes) */
         /* Si es Enter (Carriage Return '\r'), procesamos */
@@ -113,7 +110,10 @@ void shell_task(void) {
                 kprintf("  ls                 - Lista los archivos\n");
                 kprintf("  cat [archivo]      - Lee el contenido de un archivo\n");
                 kprintf("  write [archivo]    - Escribe texto en un archivo\n");
-                kprintf("  test [modulo]      - Ejecuta tests. Modulos: all, rr, sem, pf\n");
+                kprintf("  test [modulo]      - Ejecuta tests. Modulos: all, rr, sem, pf, wq, ipc, mq, ckpt, lock, mutex, futex, rw, rcu, ring, atomic, wait, buddy, slab, heap, meminfo, map, memblock, asid, tlb, fork, user\n");
+                kprintf("  lockstat [reset]   - Estadisticas de contencion de locks\n");
+                kprintf("  slabinfo           - Estadisticas de las caches de objetos\n");
+                kprintf("  meminfo [on|off]   - Uso del heap y del PMM; on/off rastrea por sitio\n");
                 kprintf("  clear              - Limpia la pantalla\n");
                 kprintf("  panic              - Provoca un Kernel Panic\n");
                 kprintf("  poweroff           - Apaga el sistema\n");
@@ -122,37 +122,46 @@ void shell_task(void) {
                 kprintf("\nPID   | Prio   |  State  |   Time   | Name\n");
                 kprintf("------|--------|---------|----------|------\n");
                 for(int i = 0; i < MAX_PROCESS; i++) {
-                    /* 1. Si el hueco está VACÍO (0), no lo mostramos */
-                    if (process[i].state == PROCESS_UNUSED) {
+                    /* 1. Foto coherente del slot (seqlock); si está VACÍO no lo mostramos */
+                    struct proc_info info;
+                    if (!process_get_info(i, &info)) {
                         continue;
                     }
 
                     /* 2. Decodificar el estado correctamente */
                     const char *estado_str;
-                    switch (process[i].state) {
+                    switch (info.state) {
                         case PROCESS_RUNNING: estado_str = "RUN "; break; /* 1 */
                         case PROCESS_READY:   estado_str = "RDY "; break; /* 2 */
                         case PROCESS_BLOCKED:
-                            if (process[i].block_reason == BLOCK_REASON_SLEEP) {
+                            if (info.block_reason == BLOCK_REASON_SLEEP) {
                                 estado_str = "SLEEP ";
                                 break;
-                            } else if (process[i].block_reason == BLOCK_REASON_WAIT) {
+                            } else if (info.block_reason == BLOCK_REASON_WAIT) {
                                 estado_str = "WAIT ";
                                 break;
+                            } else if (info.block_reason >= BLOCK_REASON_IPC_SEND &&
+                                       info.block_reason <= BLOCK_REASON_IPC_REPLY) {
+                                estado_str = "IPC  ";
+                                break;
+                            } else if (info.block_reason == BLOCK_REASON_FUTEX) {
+                                estado_str = "FUTX ";
+                                break;
                             } else {
                                 estado_str = "BLK ";
                                 break;
                             }
                         case PROCESS_ZOMBIE:  estado_str = "ZOMB"; break; /* 4 */
+                        case PROCESS_DEAD:    estado_str = "DEAD"; break; /* 5 */
                         default:              estado_str = "????"; break;
                     }
 
                     kprintf(" %d    |  %d    | %s    | %d      | %s\n",
-                            process[i].pid,
-                            process[i].priority,
+                            info.pid,
+                            info.priority,
                             estado_str,
-                            process[i].cpu_time,
-                            process[i].name);
+                            info.cpu_time,
+                            info.name);
                 }
                 kprintf("\n");
             }
@@ -215,12 +224,99 @@ void shell_task(void) {
                 else if (k_strcmp(arg, "pf") == 0) {
                     create_process((void(*)(void*)) test_demand, nullptr, 0, "test_page_fault");
                 }
+                /* Trabajo diferido: Softirqs y Workqueues */
+                else if (k_strcmp(arg, "wq") == 0) {
+                    test_workqueue();
+                }
+                /* IPC síncrono cliente/servidor */
+                else if (k_strcmp(arg, "ipc") == 0) {
+                    test_ipc();
+                }
+                /* Colas de mensajes con páginas sin copia */
+                else if (k_strcmp(arg, "mq") == 0) {
+                    test_msgq();
+                }
+                /* Checkpoint/restore con páginas copy-on-write */
+                else if (k_strcmp(arg, "ckpt") == 0) {
+                    test_checkpoint();
+                }
+                /* Ticket locks y MCS con estadísticas de contención */
+                else if (k_strcmp(arg, "lock") == 0) {
+                    test_locks();
+                }
+                /* Mutex con propietario y herencia de prioridad */
+                else if (k_strcmp(arg, "mutex") == 0) {
+                    test_mutex();
+                }
+                /* Futex: mutex de usuario con syscall solo si hay contención */
+                else if (k_strcmp(arg, "futex") == 0) {
+                    test_futex();
+                }
+                /* RWLock y seqlock para datos que se leen mucho */
+                else if (k_strcmp(arg, "rw") == 0) {
+                    test_rwlock();
+                }
+                /* RCU: búsquedas de PID y de archivos sin locks */
+                else if (k_strcmp(arg, "rcu") == 0) {
+                    test_rcu();
+                }
+                else if (k_strcmp(arg, "ring") == 0) {
+                    test_ring();
+                }
+                else if (k_strcmp(arg, "atomic") == 0) {
+                    test_atomic();
+                }
+                else if (k_strcmp(arg, "wait") == 0) {
+                    test_wait();
+                }
+                else if (k_strcmp(arg, "buddy") == 0) {
+                    test_buddy();
+                }
+                else if (k_strcmp(arg, "slab") == 0) {
+                    test_slab();
+                }
+                else if (k_strcmp(arg, "heap") == 0) {
+                    test_heap();
+                }
+                else if (k_strcmp(arg, "meminfo") == 0) {
+                    test_meminfo();
+                }
+                else if (k_strcmp(arg, "map") == 0) {
+                    test_map();
+                }
+                else if (k_strcmp(arg, "memblock") == 0) {
+                    test_memblock();
+                }
+                else if (k_strcmp(arg, "asid") == 0) {
+                    test_asid();
+                }
+                else if (k_strcmp(arg, "tlb") == 0) {
+                    test_tlb();
+                }
+                else if (k_strcmp(arg, "fork") == 0) {
+                    test_fork();
+                }
+                else if (k_strcmp(arg, "user") == 0) {
+                    test_user();
+                }
                 /* Argumento no reconocido */
                 else {
                     kprintf("Error: Modulo de test '%s' no existe.\n", arg);
-                    kprintf("Opciones válidas: all, rr, sem, pf\n");
+                    kprintf("Opciones válidas: all, rr, sem, pf, wq, ipc, mq, ckpt, lock, mutex, futex, rw, rcu, ring, atomic, wait, buddy, slab, heap, meminfo, map, memblock, asid, tlb, fork, user\n");
                 }
             }
+            else if (k_strcmp(cmd, "lockstat") == 0) {
+                if (k_strcmp(arg, "reset") == 0) lockstat_reset();
+                else lockstat_print();
+            }
+            else if (k_strcmp(command_buf, "slabinfo") == 0) {
+                slabinfo_print();
+            }
+            else if (k_strcmp(cmd, "meminfo") == 0) {
+                if (k_strcmp(arg, "on") == 0) kheap_trace(1);
+                else if (k_strcmp(arg, "off") == 0) kheap_trace(0);
+                meminfo_print();
+            }
             else if (k_strcmp(command_buf, "clear") == 0) {
                 /* Código ANSI para limpiar terminal */
                 kprintf("\033[2J\033[H");
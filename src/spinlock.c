@@ -0,0 +1,253 @@
+/**
+ * @file spinlock.c
+ * @brief Ticket locks, locks MCS y rwlocks con estadísticas de contención
+ *
+ * @details
+ *   Las primitivas atómicas están en src/locks.S (arch_ticket_lock,
+ *   arch_mcs_lock, arch_read_lock...). Aquí se añade la contabilidad:
+ *
+ *   - Se lee CNTPCT antes de intentar adquirir
+ *   - Si arch_*_lock() indica contención, la espera es CNTPCT - inicio
+ *   - Los contadores se actualizan YA con el lock tomado, así que no
+ *     necesitan operaciones atómicas. En un rwlock varios lectores
+ *     pueden contabilizar a la vez: en multicore los contadores de
+ *     lectura son aproximados
+ *
+ *   Todos los locks desactivan la expropiación (preempt_disable) antes
+ *   de intentar adquirir y la reactivan al soltar: el propietario no
+ *   pierde la CPU con el lock tomado, y los demás procesos no se quedan
+ *   girando una rodaja entera esperando a alguien que no puede correr.
+ *
+ *   Los *_trylock() no esperan nunca: se pueden usar desde softirqs. Un intento fallido no es una adquisición; se cuenta aparte
+ *   en 'failed' sin tener el lock (en un solo core las softirqs no se
+ *   anidan, así que tampoco necesita operaciones atómicas).
+ *
+ *   Los locks inicializados con nombre se enlazan en una lista global
+ *   que recorre lockstat_print() (comando 'lockstat' del shell).
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ * @see spinlock.h para interfaz pública
+ */
+
+#include "../include/spinlock.h"
+
+#include "../include/drivers/io.h"
+#include "../include/drivers/timer.h"
+#include "../include/kernel/preempt.h"
+
+/* ========================================================================== */
+/* FUNCIONES EXTERNAS (Ensamblador)                                         */
+/* ========================================================================== */
+
+/* src/locks.S: *_lock devuelven 1 si tuvieron que esperar, *_trylock 1
+   si adquirieron */
+extern int arch_ticket_lock(volatile unsigned int *val);
+extern void arch_ticket_unlock(volatile unsigned int *val);
+extern int arch_mcs_lock(struct mcs_node *volatile *tail, struct mcs_node *node);
+extern void arch_mcs_unlock(struct mcs_node *volatile *tail, struct mcs_node *node);
+extern int arch_read_lock(volatile unsigned int *val);
+extern void arch_read_unlock(volatile unsigned int *val);
+extern int arch_write_lock(volatile unsigned int *val);
+extern int arch_ticket_trylock(volatile unsigned int *val);
+extern int arch_mcs_trylock(struct mcs_node *volatile *tail, struct mcs_node *node);
+extern int arch_read_trylock(volatile unsigned int *val);
+extern int arch_write_trylock(volatile unsigned int *val);
+extern void arch_write_unlock(volatile unsigned int *val);
+
+/* Lista de locks registrados (para 'lockstat') */
+static struct lock_stat *lockstat_list = nullptr;
+
+/* ========================================================================== */
+/* ESTADÍSTICAS                                                              */
+/* ========================================================================== */
+
+static void lockstat_register(struct lock_stat *stat, const char *name) {
+    stat->name = name;
+    stat->acquisitions = 0;
+    stat->contended = 0;
+    stat->failed = 0;
+    stat->max_spin = 0;
+    stat->total_spin = 0;
+    stat->next = nullptr;
+
+    if (name == nullptr) return;
+
+    unsigned long flags = local_irq_save();
+    stat->next = lockstat_list;
+    lockstat_list = stat;
+    local_irq_restore(flags);
+}
+
+/**
+ * @brief Contabiliza una adquisición (se llama con el lock tomado)
+ */
+static inline void lockstat_account(struct lock_stat *stat, int contended, unsigned long start) {
+    stat->acquisitions++;
+    if (contended) {
+        unsigned long spin = timer_get_count() - start;
+        stat->contended++;
+        stat->total_spin += spin;
+        if (spin > stat->max_spin) {
+            stat->max_spin = spin;
+        }
+    }
+}
+
+/**
+ * @brief Imprime la tabla de estadísticas de los locks registrados
+ *
+ * @details Los tiempos se muestran en microsegundos (CNTFRQ).
+ */
+void lockstat_print(void) {
+    unsigned long mhz = timer_get_freq() / 1000000;
+    if (mhz == 0) mhz = 1;
+
+    kprintf("\nLock             | Adquis.  | Contend. | Fallidos | Max us   | Total us\n");
+    kprintf("-----------------|----------|----------|----------|----------|---------\n");
+
+    for (struct lock_stat *s = lockstat_list; s != nullptr; s = s->next) {
+        kprintf(" %s | %d | %d | %d | %d | %d\n",
+                s->name,
+                (long)s->acquisitions,
+                (long)s->contended,
+                (long)s->failed,
+                (long)(s->max_spin / mhz),
+                (long)(s->total_spin / mhz));
+    }
+    kprintf("\n");
+}
+
+/**
+ * @brief Pone a cero las estadísticas de todos los locks registrados
+ */
+void lockstat_reset(void) {
+    unsigned long flags = local_irq_save();
+    for (struct lock_stat *s = lockstat_list; s != nullptr; s = s->next) {
+        s->acquisitions = 0;
+        s->contended = 0;
+        s->failed = 0;
+        s->max_spin = 0;
+        s->total_spin = 0;
+    }
+    local_irq_restore(flags);
+}
+
+/* ========================================================================== */
+/* TICKET LOCK                                                               */
+/* ========================================================================== */
+
+void ticket_lock_init(struct ticket_lock *lock, const char *name) {
+    lock->val = 0;
+    lockstat_register(&lock->stat, name);
+}
+
+void ticket_lock(struct ticket_lock *lock) {
+    preempt_disable();
+    unsigned long start = timer_get_count();
+    int contended = arch_ticket_lock(&lock->val);
+    lockstat_account(&lock->stat, contended, start);
+}
+
+void ticket_unlock(struct ticket_lock *lock) {
+    arch_ticket_unlock(&lock->val);
+    preempt_enable();
+}
+
+int ticket_trylock(struct ticket_lock *lock) {
+    preempt_disable();
+    if (!arch_ticket_trylock(&lock->val)) {
+        lock->stat.failed++;
+        preempt_enable();
+        return 0;
+    }
+    lockstat_account(&lock->stat, 0, 0);
+    return 1;
+}
+
+/* ========================================================================== */
+/* MCS LOCK                                                                  */
+/* ========================================================================== */
+
+void mcs_lock_init(struct mcs_lock *lock, const char *name) {
+    lock->tail = nullptr;
+    lockstat_register(&lock->stat, name);
+}
+
+void mcs_lock(struct mcs_lock *lock, struct mcs_node *node) {
+    preempt_disable();
+    unsigned long start = timer_get_count();
+    int contended = arch_mcs_lock(&lock->tail, node);
+    lockstat_account(&lock->stat, contended, start);
+}
+
+void mcs_unlock(struct mcs_lock *lock, struct mcs_node *node) {
+    arch_mcs_unlock(&lock->tail, node);
+    preempt_enable();
+}
+
+int mcs_trylock(struct mcs_lock *lock, struct mcs_node *node) {
+    preempt_disable();
+    if (!arch_mcs_trylock(&lock->tail, node)) {
+        lock->stat.failed++;
+        preempt_enable();
+        return 0;
+    }
+    lockstat_account(&lock->stat, 0, 0);
+    return 1;
+}
+
+/* ========================================================================== */
+/* RWLOCK                                                                    */
+/* ========================================================================== */
+
+void rwlock_init(struct rwlock *lock, const char *name) {
+    lock->val = 0;
+    lockstat_register(&lock->stat, name);
+}
+
+void read_lock(struct rwlock *lock) {
+    preempt_disable();
+    unsigned long start = timer_get_count();
+    int contended = arch_read_lock(&lock->val);
+    lockstat_account(&lock->stat, contended, start);
+}
+
+void read_unlock(struct rwlock *lock) {
+    arch_read_unlock(&lock->val);
+    preempt_enable();
+}
+
+void write_lock(struct rwlock *lock) {
+    preempt_disable();
+    unsigned long start = timer_get_count();
+    int contended = arch_write_lock(&lock->val);
+    lockstat_account(&lock->stat, contended, start);
+}
+
+void write_unlock(struct rwlock *lock) {
+    arch_write_unlock(&lock->val);
+    preempt_enable();
+}
+
+int read_trylock(struct rwlock *lock) {
+    preempt_disable();
+    if (!arch_read_trylock(&lock->val)) {
+        lock->stat.failed++;
+        preempt_enable();
+        return 0;
+    }
+    lockstat_account(&lock->stat, 0, 0);
+    return 1;
+}
+
+int write_trylock(struct rwlock *lock) {
+    preempt_disable();
+    if (!arch_write_trylock(&lock->val)) {
+        lock->stat.failed++;
+        preempt_enable();
+        return 0;
+    }
+    lockstat_account(&lock->stat, 0, 0);
+    return 1;
+}
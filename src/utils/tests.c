@@ -30,6 +30,28 @@
 #include "../../include/kernel/process.h"
 #include "../../include/mm/malloc.h"
 #include "../../include/semaphore.h"
+#include "../../include/kernel/workqueue.h"
+#include "../../include/kernel/softirq.h"
+#include "../../include/kernel/ipc.h"
+#include "../../include/kernel/msgq.h"
+#include "../../include/kernel/checkpoint.h"
+#include "../../include/mm/vmm.h"
+#include "../../include/drivers/timer.h"
+#include "../../include/spinlock.h"
+#include "../../include/mutex.h"
+#include "../../include/seqlock.h"
+#include "../../include/kernel/rcu.h"
+#include "../../include/fs/vfs.h"
+#include "../../include/kernel/futex.h"
+#include "../../include/ring.h"
+#include "../../include/atomic.h"
+#include "../../include/kernel/cpufeature.h"
+#include "../../include/kernel/completion.h"
+#include "../../include/mm/pmm.h"
+#include "../../include/mm/slab.h"
+#include "../../include/mm/mm.h"
+#include "../../include/mm/memblock.h"
+#include "../../include/mm/asid.h"
 
 /* ========================================================================== */
 /* FUNCIONES EXTERNAS (Ensamblador)                                         */
@@ -363,6 +385,8 @@ void tarea_waiter(void) {
  *   - Waiter es despertado automáticamente cuando Holder libera
  *   - Sincronización correcta sin busy-wait
  *   - Eficiencia: Los procesos bloqueados no aparecen en schedule()
+ *   - Anidamiento: sem_signal()/sem_wait() con IRQs ya deshabilitadas
+ *     no las vuelven a habilitar al salir
  *   
  *   Mejora significativa vs. implementaciones antiguas con busy-wait.
  */
@@ -372,6 +396,19 @@ void test_semaphores_efficiency(void) {
     /* Inicializamos semáforo a 1 */
     sem_init(&sem_prueba, 1);
 
+    /* Llamadas desde una sección con IRQs deshabilitadas (sin bloquear) */
+    unsigned long outer = local_irq_save();
+    sem_signal(&sem_prueba);
+    sem_wait(&sem_prueba);
+    unsigned long inner = local_irq_save();
+    local_irq_restore(outer);
+
+    if (inner & (1 << 7)) {
+        kprintf("   [SEM] OK: IRQs siguen deshabilitadas tras sem_signal/sem_wait\n");
+    } else {
+        kprintf("   [SEM] FALLO: sem_signal/sem_wait rehabilitaron las IRQs\n");
+    }
+
     /* Lanzamos al que tiene el candado */
     create_process((void(*)(void*))tarea_holder, (void*)nullptr, 10, "Holder");
 
@@ -388,7 +425,7 @@ void test_semaphores_efficiency(void) {
  * @brief Prueba de paginación por demanda (Demand Paging)
  * 
  * @details
- *   Intenta escribir en memoria no mapeada (0x50000000).
+ *   Intenta escribir en memoria no mapeada (DEMAND_VA_BASE).
  *   
  *   CON DEMAND PAGING IMPLEMENTADO:
  *   1. Se produce un Page Fault (Data Abort) controlado
@@ -407,8 +444,2717 @@ void test_semaphores_efficiency(void) {
  */
 void test_demand(void) {
     kprintf("Escribiendo en memoria no mapeada...\n");
-    unsigned long *peligro = (unsigned long *)0x50000000;
+    unsigned long *peligro = (unsigned long *)DEMAND_VA_BASE;
     *peligro = 42; /* ¡BUM! Esto lanzará un Page Fault */
     kprintf("Exito! El valor guardado es: %d\n", *peligro);
 }
 
+
+/* ========================================================================== */
+/* PRUEBAS DE TRABAJO DIFERIDO - WORKQUEUES                                 */
+/* ========================================================================== */
+
+static struct work_struct test_work;
+static struct delayed_work test_dwork;
+
+/**
+ * @brief Función ejecutada por los kworkers en la prueba
+ * @param work Work que se está ejecutando
+ *
+ * @details
+ *   Imprime el proceso que la ejecuta (debe ser un kworker) y el tick
+ *   actual, para comprobar que el delayed work respeta su retardo.
+ */
+static void test_work_fn(struct work_struct *work) {
+    kprintf("   [WQ] Work %s ejecutado por '%s' en tick %d\n",
+            (work == &test_dwork.work) ? "retardado" : "inmediato",
+            current_process->name, sys_timer_count);
+}
+
+/**
+ * @brief Lanza prueba de workqueues y delayed work
+ *
+ * @details
+ *   - Encola un work inmediato en WQ_HIGH (dos veces: el segundo
+ *     queue_work() debe devolver 0 porque ya está pendiente)
+ *   - Programa un delayed work en WQ_LOW para dentro de 20 ticks
+ *
+ *   RESULTADO ESPERADO:
+ *   - El work inmediato lo ejecuta kworker/H una sola vez
+ *   - El retardado lo ejecuta kworker/L ~20 ticks después
+ */
+void test_workqueue(void) {
+    kprintf("\n[TEST] --- Probando Workqueues (Trabajo Diferido) ---\n");
+
+    init_work(&test_work, test_work_fn);
+    init_delayed_work(&test_dwork, test_work_fn);
+
+    int first = queue_work(WQ_HIGH, &test_work);
+    int second = queue_work(WQ_HIGH, &test_work);
+    kprintf("   [WQ] queue_work: %d, re-encolado: %d (esperado 1, 0)\n", first, second);
+
+    queue_delayed_work(WQ_LOW, &test_dwork, 20);
+    kprintf("   [WQ] Delayed work programado en tick %d para tick %d\n",
+            sys_timer_count, test_dwork.expires);
+}
+
+/* ========================================================================== */
+/* PRUEBAS DE IPC SINCRONO (CLIENTE/SERVIDOR)                               */
+/* ========================================================================== */
+
+#define IPC_TEST_ROUNDS  1000
+#define IPC_OP_ECHO      1
+#define IPC_OP_STOP      2
+
+static long ipc_server_pid = -1;
+
+/**
+ * @brief Servidor de eco: devuelve mr[0] + 1
+ *
+ * @details
+ *   Bucle clásico ipc_recv() + ipc_reply_recv(). Termina al recibir
+ *   IPC_OP_STOP (tras responder).
+ */
+static void ipc_echo_server(void *arg) {
+    (void)arg;
+    struct ipc_msg m;
+
+    long client = ipc_recv(&m);
+    while (IPC_TAG_LABEL(m.tag) != IPC_OP_STOP) {
+        m.mr[0] = m.mr[0] + 1;
+        m.tag = IPC_TAG(0, 1);
+        client = ipc_reply_recv(client, &m, &m);
+    }
+
+    m.tag = IPC_TAG(0, 0);
+    ipc_reply(client, &m);
+}
+
+/**
+ * @brief Cliente: mide el coste medio de una ida y vuelta
+ */
+static void ipc_echo_client(void *arg) {
+    (void)arg;
+    enable_interrupts();
+
+    struct ipc_msg m;
+    unsigned long value = 0;
+    int errors = 0;
+
+    unsigned long start = timer_get_count();
+    for (int i = 0; i < IPC_TEST_ROUNDS; i++) {
+        m.tag = IPC_TAG(IPC_OP_ECHO, 1);
+        m.mr[0] = value;
+        if (ipc_call(ipc_server_pid, &m) < 0 || m.mr[0] != value + 1) {
+            errors++;
+        }
+        value = m.mr[0];
+    }
+    unsigned long elapsed = timer_get_count() - start;
+
+    m.tag = IPC_TAG(IPC_OP_STOP, 0);
+    ipc_call(ipc_server_pid, &m);
+
+    unsigned long freq = timer_get_freq();
+    unsigned long ns = (freq > 0) ? (elapsed * 1000000000UL / freq) / IPC_TEST_ROUNDS : 0;
+
+    kprintf("   [IPC] %d llamadas, %d errores, valor final %d\n",
+            IPC_TEST_ROUNDS, errors, value);
+    kprintf("   [IPC] Ida y vuelta: %d ticks de contador totales, ~%d ns/llamada\n",
+            elapsed, ns);
+}
+
+/**
+ * @brief Lanza prueba de IPC síncrono
+ *
+ * @details
+ *   Crea un servidor de eco y un cliente que hace IPC_TEST_ROUNDS
+ *   llamadas. Con el servidor esperando en ipc_recv(), cada llamada es
+ *   un hand-off directo en ambos sentidos (sin pasar por schedule()).
+ *
+ *   RESULTADO ESPERADO:
+ *   - 0 errores y valor final == IPC_TEST_ROUNDS
+ *   - El servidor termina al recibir IPC_OP_STOP
+ */
+void test_ipc(void) {
+    kprintf("\n[TEST] --- Probando IPC Síncrono (Hand-off Directo) ---\n");
+
+    /* El servidor con más prioridad: llega antes a ipc_recv() */
+    ipc_server_pid = create_process(ipc_echo_server, nullptr, 1, "ipc_server");
+    if (ipc_server_pid < 0) return;
+
+    create_process(ipc_echo_client, nullptr, 5, "ipc_client");
+}
+
+/* ========================================================================== */
+/* PRUEBAS DE COLAS DE MENSAJES (ZERO-COPY)                                 */
+/* ========================================================================== */
+
+#define MQ_TEST_TX_VA   (DEMAND_VA_BASE)             /* Buffer del productor (demand paging) */
+#define MQ_TEST_RX_VA   (DEMAND_VA_BASE + 0x100000)  /* Ventana de recepción del consumidor */
+#define MQ_TEST_PAGES   2
+#define MQ_TEST_ROUNDS  3
+
+static struct msgq *mq_test_queue;
+static unsigned long mq_sent_phys[MQ_TEST_ROUNDS];
+
+/**
+ * @brief Productor: rellena 2 páginas y las cede sin copiarlas
+ */
+static void mq_producer(void *arg) {
+    (void)arg;
+    enable_interrupts();
+
+    for (int r = 0; r < MQ_TEST_ROUNDS; r++) {
+        /* Cada ronda el VA está desmapeado: el primer acceso da Page Fault */
+        unsigned long *buf = (unsigned long *)MQ_TEST_TX_VA;
+        for (unsigned long i = 0; i < (MQ_TEST_PAGES * PAGE_SIZE) / sizeof(unsigned long); i++) {
+            buf[i] = r * 1000 + i;
+        }
+        mq_sent_phys[r] = *vmm_get_pte(current_process->pgd, MQ_TEST_TX_VA) & 0xFFFFFFFFF000;
+
+        msgq_send_pages(mq_test_queue, MQ_TEST_TX_VA, MQ_TEST_PAGES, MQ_TEST_PAGES * PAGE_SIZE);
+
+        char note[16] = "fin de ronda";
+        msgq_send(mq_test_queue, note, sizeof(note));
+    }
+}
+
+/**
+ * @brief Consumidor: recibe las páginas mapeadas y verifica contenido
+ */
+static void mq_consumer(void *arg) {
+    (void)arg;
+    enable_interrupts();
+
+    int errors = 0;
+    for (int r = 0; r < MQ_TEST_ROUNDS; r++) {
+        long len = msgq_recv(mq_test_queue, nullptr, 0, MQ_TEST_RX_VA);
+
+        unsigned long *buf = (unsigned long *)MQ_TEST_RX_VA;
+        unsigned long words = len / sizeof(unsigned long);
+        for (unsigned long i = 0; i < words; i++) {
+            if (buf[i] != r * 1000 + i) {
+                errors++;
+                break;
+            }
+        }
+
+        unsigned long phys = *vmm_get_pte(current_process->pgd, MQ_TEST_RX_VA) & 0xFFFFFFFFF000;
+        kprintf("   [MQ] Ronda %d: %d bytes, fisica 0x%x (%s)\n", r, len, phys,
+                (phys == mq_sent_phys[r]) ? "misma pagina, sin copia" : "DISTINTA");
+        msgq_release_pages(MQ_TEST_RX_VA, MQ_TEST_PAGES);
+
+        char note[MSGQ_INLINE_MAX];
+        msgq_recv(mq_test_queue, note, sizeof(note), 0);
+        kprintf("   [MQ] Mensaje inline: '%s'\n", note);
+    }
+
+    kprintf("   [MQ] Prueba terminada: %d errores de contenido\n", errors);
+    msgq_destroy(mq_test_queue);
+}
+
+/**
+ * @brief Lanza prueba de colas de mensajes con transferencia de páginas
+ *
+ * @details
+ *   Un productor cede 2 páginas por ronda y un consumidor las recibe
+ *   mapeadas en otra dirección. La cola tiene solo 2 slots, así que el
+ *   productor se bloquea en 'space' hasta que el consumidor avanza.
+ *
+ *   RESULTADO ESPERADO:
+ *   - La física recibida coincide con la enviada en cada ronda
+ *   - 0 errores de contenido
+ */
+void test_msgq(void) {
+    kprintf("\n[TEST] --- Probando Colas de Mensajes (Zero-Copy) ---\n");
+
+    mq_test_queue = msgq_create(2);
+    if (!mq_test_queue) {
+        kprintf("   [MQ] Error: No se pudo crear la cola\n");
+        return;
+    }
+
+    create_process(mq_consumer, nullptr, 5, "mq_consumer");
+    create_process(mq_producer, nullptr, 5, "mq_producer");
+}
+
+/* ========================================================================== */
+/* PRUEBAS DE CHECKPOINT/RESTORE                                            */
+/* ========================================================================== */
+
+#define CKPT_TEST_VA     (DEMAND_VA_BASE + 0x200000) /* Tabla inicializada por la plantilla */
+#define CKPT_TEST_IMAGE  "worker.ckpt"
+#define CKPT_TEST_COPIES 3
+
+static struct semaphore ckpt_ready;
+
+/**
+ * @brief Worker con inicialización "cara" que se checkpointea a sí mismo
+ *
+ * @details
+ *   La plantilla rellena una tabla (demand paging) y simula una espera de
+ *   arranque; después guarda la imagen. Las instancias restauradas
+ *   empiezan directamente tras process_checkpoint() con la tabla lista,
+ *   y su primera escritura en ella provoca una copia COW.
+ */
+static void ckpt_worker(void *arg) {
+    (void)arg;
+    enable_interrupts();
+
+    unsigned long *table = (unsigned long *)CKPT_TEST_VA;
+
+    /* === Inicialización en frío (solo la plantilla) === */
+    for (unsigned long i = 0; i < 512; i++) {
+        table[i] = i * i;
+    }
+    sleep(30);
+
+    long r = process_checkpoint(CKPT_TEST_IMAGE);
+    if (r == 1) {
+        /* === Instancia restaurada === */
+        unsigned long before = table[7];
+        table[0] = current_process->pid;    /* Escritura -> fallo COW */
+        kprintf("   [CKPT] PID %d restaurado: tabla[7]=%d, escritura COW %s\n",
+                current_process->pid, before,
+                (table[0] == (unsigned long)current_process->pid) ? "ok" : "FALLO");
+        return;
+    }
+
+    kprintf("   [CKPT] Plantilla PID %d: checkpoint %s\n",
+            current_process->pid, (r == 0) ? "guardado" : "FALLIDO");
+    sem_signal(&ckpt_ready);
+}
+
+/**
+ * @brief Espera a la plantilla y lanza instancias desde la imagen
+ */
+static void ckpt_launcher(void *arg) {
+    (void)arg;
+    enable_interrupts();
+
+    sem_wait(&ckpt_ready);
+
+    unsigned long start = timer_get_count();
+    int ok = 0;
+    for (int i = 0; i < CKPT_TEST_COPIES; i++) {
+        if (process_restore(CKPT_TEST_IMAGE) >= 0) ok++;
+    }
+    unsigned long elapsed = timer_get_count() - start;
+
+    kprintf("   [CKPT] %d instancias restauradas en %d ticks de contador\n", ok, elapsed);
+
+    /* Dejar que las instancias terminen antes de soltar la imagen */
+    sleep(20);
+    ckpt_delete(CKPT_TEST_IMAGE);
+}
+
+/**
+ * @brief Lanza prueba de checkpoint/restore
+ *
+ * @details
+ *   RESULTADO ESPERADO:
+ *   - La plantilla guarda la imagen tras su inicialización
+ *   - CKPT_TEST_COPIES instancias arrancan sin repetirla (tabla[7] = 49)
+ *   - Su escritura en la tabla se resuelve con copy-on-write
+ */
+void test_checkpoint(void) {
+    kprintf("\n[TEST] --- Probando Checkpoint/Restore de Procesos ---\n");
+
+    sem_init(&ckpt_ready, 0);
+    create_process(ckpt_worker, nullptr, 5, "ckpt_worker");
+    create_process(ckpt_launcher, nullptr, 5, "ckpt_launcher");
+}
+
+/* ========================================================================== */
+/* SONDAS EN SOFTIRQ                                                        */
+/* ========================================================================== */
+
+/**
+ * @brief Dispara la sonda de SOFTIRQ_TEST y espera a que corra
+ * @param runs Contador que la sonda incrementa en cada ejecución
+ *
+ * @details
+ *   Se llama con un lock tomado (expropiación desactivada, IRQs
+ *   habilitadas): la sonda corre en la siguiente salida de IRQ, encima
+ *   de este proceso, y lo encuentra tomado. Es la única contención real
+ *   posible en un solo core, donde ningún otro proceso corre mientras
+ *   tanto. Si la sonda no llega en unos ticks se deja de esperar.
+ */
+static void test_probe_wait(volatile unsigned long *runs) {
+    unsigned long seen = *runs;
+    unsigned long start = timer_get_count();
+
+    raise_softirq(SOFTIRQ_TEST);
+    while (*runs == seen && timer_get_count() - start < 4 * TIMER_INTERVAL) {
+        delay(100);
+    }
+}
+
+/* ========================================================================== */
+/* PRUEBAS DE LOCKS JUSTOS (TICKET / MCS)                                   */
+/* ========================================================================== */
+
+#define LOCK_TEST_WORKERS 3
+#define LOCK_TEST_ITERS   200
+#define LOCK_PROBE_EVERY  50
+
+static struct ticket_lock test_ticket;
+static struct mcs_lock test_mcs;
+static volatile unsigned long ticket_counter;
+static volatile unsigned long mcs_counter;
+static volatile int lock_workers_done;
+
+/* Marcas de "hay alguien dentro" y sonda en softirq */
+static volatile int ticket_inside;
+static volatile int mcs_inside;
+static volatile unsigned long lock_probe_runs;
+static volatile unsigned long lock_probe_busy;
+static volatile unsigned long lock_probe_overlap;
+
+/**
+ * @brief Sonda (SOFTIRQ_TEST): intenta tomar ambos locks sin esperar
+ *
+ * @details
+ *   Corre encima del worker interrumpido, que tiene uno de los dos
+ *   locks: ese trylock tiene que fallar. Si entra en un lock con su
+ *   marca de "dentro" puesta, la exclusión está rota.
+ */
+static void lock_probe(void) {
+    if (ticket_trylock(&test_ticket)) {
+        if (ticket_inside) lock_probe_overlap++;
+        ticket_unlock(&test_ticket);
+    } else {
+        lock_probe_busy++;
+    }
+
+    struct mcs_node node;
+    if (mcs_trylock(&test_mcs, &node)) {
+        if (mcs_inside) lock_probe_overlap++;
+        mcs_unlock(&test_mcs, &node);
+    } else {
+        lock_probe_busy++;
+    }
+    lock_probe_runs++;
+}
+
+/**
+ * @brief Worker que incrementa dos contadores bajo ticket lock y MCS
+ *
+ * @details
+ *   El incremento es no atómico (leer, esperar, escribir). El lock
+ *   desactiva la expropiación, así que ningún otro worker corre con él
+ *   tomado. Cada LOCK_PROBE_EVERY vueltas el worker espera dentro de la
+ *   sección crítica a la sonda en softirq, que sí corre y lo encuentra
+ *   tomado (contención).
+ */
+static void lock_worker(void *arg) {
+    (void)arg;
+    enable_interrupts();
+
+    for (int i = 0; i < LOCK_TEST_ITERS; i++) {
+        int probe = (i % LOCK_PROBE_EVERY == 0);
+
+        ticket_lock(&test_ticket);
+        ticket_inside = 1;
+        unsigned long v = ticket_counter;
+        delay(2000);
+        if (probe) test_probe_wait(&lock_probe_runs);
+        ticket_counter = v + 1;
+        ticket_inside = 0;
+        ticket_unlock(&test_ticket);
+
+        struct mcs_node node;
+        mcs_lock(&test_mcs, &node);
+        mcs_inside = 1;
+        v = mcs_counter;
+        delay(2000);
+        if (probe) test_probe_wait(&lock_probe_runs);
+        mcs_counter = v + 1;
+        mcs_inside = 0;
+        mcs_unlock(&test_mcs, &node);
+    }
+
+    /* El último en terminar imprime el resultado */
+    ticket_lock(&test_ticket);
+    int last = (++lock_workers_done == LOCK_TEST_WORKERS);
+    ticket_unlock(&test_ticket);
+
+    if (last) {
+        unsigned long expected = LOCK_TEST_WORKERS * LOCK_TEST_ITERS;
+        kprintf("   [LOCK] sonda softirq: %d intentos, %d con el lock tomado, %d solapes\n",
+                lock_probe_runs, lock_probe_busy, lock_probe_overlap);
+        kprintf("   [LOCK] ticket: %d/%d  mcs: %d/%d (%s)\n",
+                ticket_counter, expected, mcs_counter, expected,
+                (ticket_counter == expected && mcs_counter == expected &&
+                 lock_probe_busy > 0 && lock_probe_overlap == 0) ? "OK" : "FALLO");
+        lockstat_print();
+    }
+}
+
+/**
+ * @brief Lanza prueba de ticket locks y locks MCS
+ *
+ * @details
+ *   RESULTADO ESPERADO:
+ *   - Ningún incremento perdido en ninguno de los dos contadores
+ *   - La sonda encuentra los locks tomados y nunca entra con alguien
+ *     dentro
+ *   - 'lockstat' muestra en test_ticket y test_mcs los trylocks
+ *     fallidos de la sonda (en un solo core un proceso no encuentra
+ *     nunca el lock tomado: el propietario no se expropia con él)
+ */
+void test_locks(void) {
+    kprintf("\n[TEST] --- Probando Ticket Locks y MCS ---\n");
+
+    static int initialized = 0;
+    if (!initialized) {
+        ticket_lock_init(&test_ticket, "test_ticket");
+        mcs_lock_init(&test_mcs, "test_mcs");
+        initialized = 1;
+    }
+    lockstat_reset();
+
+    ticket_counter = 0;
+    mcs_counter = 0;
+    lock_workers_done = 0;
+    ticket_inside = 0;
+    mcs_inside = 0;
+    lock_probe_runs = 0;
+    lock_probe_busy = 0;
+    lock_probe_overlap = 0;
+    open_softirq(SOFTIRQ_TEST, lock_probe);
+
+    for (int i = 0; i < LOCK_TEST_WORKERS; i++) {
+        create_process(lock_worker, nullptr, 5, "lock_worker");
+    }
+}
+
+/* ========================================================================== */
+/* PRUEBAS DE MUTEX CON HERENCIA DE PRIORIDAD                               */
+/* ========================================================================== */
+
+static struct mutex pi_mutex;
+static struct mutex pi_mutex2;
+
+/**
+ * @brief Proceso poco urgente que retiene los dos mutex
+ *
+ * @details
+ *   Trabaja con ambos mutex tomados hasta que los dos procesos urgentes
+ *   se encolan (o se agota el tiempo). En ese momento debe tener la
+ *   prioridad heredada de H. Al soltar solo el de H debe quedarse con
+ *   la más urgente entre la suya y la de H2, que aún espera el otro.
+ */
+static void pi_low(void *arg) {
+    (void)arg;
+    enable_interrupts();
+
+    mutex_lock(&pi_mutex);
+    mutex_lock(&pi_mutex2);
+    int original = current_process->priority;
+
+    for (int i = 0; i < 200 && (pi_mutex.head == nullptr || pi_mutex2.head == nullptr); i++) {
+        delay(100000);
+    }
+
+    int boosted = current_process->priority;
+    int base = current_process->base_priority;
+    int inherited = (base >= 0);
+
+    /* Tras soltar el de H: la más urgente entre la propia y la de H2 */
+    int h2 = (pi_mutex2.head != nullptr) ? pi_mutex2.head->priority : base;
+    int expected = (h2 < base) ? h2 : base;
+    mutex_unlock(&pi_mutex);
+
+    int partial = current_process->priority;
+    mutex_unlock(&pi_mutex2);
+
+    kprintf("   [MUTEX] L: prioridad %d al soltar (%s), %d tras restaurar (tomado con %d)\n",
+            boosted, inherited ? "heredada" : "SIN herencia",
+            current_process->priority, original);
+    if (inherited) {
+        kprintf("   [MUTEX] L: prioridad %d tras soltar solo el de H (%s: propia %d, H2 %d)\n",
+                partial, (partial == expected) ? "OK" : "FALLO", base, h2);
+    }
+}
+
+/**
+ * @brief Proceso de prioridad media que solo consume CPU
+ */
+static void pi_medium(void *arg) {
+    (void)arg;
+    enable_interrupts();
+
+    for (int i = 0; i < 50; i++) {
+        delay(100000);
+    }
+}
+
+/**
+ * @brief Proceso urgente que necesita el mutex
+ */
+static void pi_high(void *arg) {
+    (void)arg;
+    enable_interrupts();
+
+    sleep(2);   /* Dejar que L tome el mutex primero */
+
+    unsigned long start = sys_timer_count;
+    mutex_lock(&pi_mutex);
+    unsigned long waited = sys_timer_count - start;
+    int owner_ok = mutex_is_owner(&pi_mutex);
+    mutex_unlock(&pi_mutex);
+
+    kprintf("   [MUTEX] H: mutex obtenido tras %d ticks (%s)\n",
+            waited, owner_ok ? "propietario" : "FALLO: no es propietario");
+}
+
+/**
+ * @brief Segundo proceso urgente: espera el otro mutex de L
+ */
+static void pi_high2(void *arg) {
+    (void)arg;
+    enable_interrupts();
+
+    sleep(2);
+
+    mutex_lock(&pi_mutex2);
+    int owner_ok = mutex_is_owner(&pi_mutex2);
+    mutex_unlock(&pi_mutex2);
+
+    kprintf("   [MUTEX] H2: %s\n", owner_ok ? "propietario" : "FALLO: no es propietario");
+}
+
+/**
+ * @brief Lanza prueba de mutex con herencia de prioridad
+ *
+ * @details
+ *   Escenario clásico de inversión de prioridad:
+ *   - L (poco urgente) toma dos mutex
+ *   - H y H2 (urgentes) se bloquean esperando uno cada uno
+ *   - M (media) compite por la CPU con L
+ *
+ *   RESULTADO ESPERADO:
+ *   - L tiene la prioridad de H mientras H espera
+ *   - Al soltar solo el mutex de H, L sigue heredando la de H2 si es
+ *     más urgente que la suya (no vuelve sin más a la propia)
+ *   - Al soltar los dos, L pierde la herencia
+ *   - H y H2 obtienen su mutex por hand-off y son los propietarios al
+ *     despertar
+ */
+void test_mutex(void) {
+    kprintf("\n[TEST] --- Probando Mutex con Herencia de Prioridad ---\n");
+
+    mutex_init(&pi_mutex, "pi_test");
+    mutex_init(&pi_mutex2, "pi_test2");
+    create_process(pi_low, nullptr, 9, "pi_low");
+    create_process(pi_high, nullptr, 0, "pi_high");
+    create_process(pi_high2, nullptr, 1, "pi_high2");
+    create_process(pi_medium, nullptr, 4, "pi_medium");
+}
+
+/* ========================================================================== */
+/* PRUEBAS DE FUTEX                                                         */
+/* ========================================================================== */
+
+#define FUTEX_TEST_WORKERS 3
+#define FUTEX_TEST_ITERS   2000
+
+static volatile int futex_test_lock;
+static volatile unsigned long futex_test_counter;
+static volatile int futex_workers_done;
+static unsigned long futex_syscalls_start;
+
+/* Mitad de EL0 de la prueba (con los procesos de usuario, más abajo) */
+static void futex_user_start(void);
+
+/**
+ * @brief Worker que usa un mutex de usuario (umutex) sobre SYS_FUTEX
+ *
+ * @details
+ *   Entra al kernel con SVC, igual que un proceso EL0: el camino rápido
+ *   (CAS sin contención) no hace ninguna syscall. Cada cierto número de
+ *   iteraciones alarga la sección crítica para que el timer expropie al
+ *   propietario y los demás tengan que dormir en FUTEX_WAIT.
+ */
+static void futex_worker(void *arg) {
+    (void)arg;
+    enable_interrupts();
+
+    for (int i = 0; i < FUTEX_TEST_ITERS; i++) {
+        umutex_lock(&futex_test_lock);
+        unsigned long v = futex_test_counter;
+        if ((i & 63) == 0) {
+            delay(50000);
+        }
+        futex_test_counter = v + 1;
+        umutex_unlock(&futex_test_lock);
+    }
+
+    umutex_lock(&futex_test_lock);
+    int last = (++futex_workers_done == FUTEX_TEST_WORKERS);
+    umutex_unlock(&futex_test_lock);
+
+    if (last) {
+        unsigned long expected = FUTEX_TEST_WORKERS * FUTEX_TEST_ITERS;
+        unsigned long syscalls = futex_syscall_count() - futex_syscalls_start;
+        kprintf("   [FUTEX] contador %d/%d (%s), %d syscalls para %d adquisiciones\n",
+                futex_test_counter, expected,
+                (futex_test_counter == expected) ? "OK" : "FALLO",
+                syscalls, expected + FUTEX_TEST_WORKERS);
+    }
+}
+
+/**
+ * @brief Lanza prueba de futex con mutex de usuario
+ *
+ * @details
+ *   RESULTADO ESPERADO:
+ *   - Ningún incremento perdido
+ *   - Muchas menos syscalls que adquisiciones (solo con contención)
+ *   - EL0 (futex_user_start): ningún incremento perdido entre procesos
+ *     de usuario, y ninguna comprobación de EL0 fallida
+ */
+void test_futex(void) {
+    kprintf("\n[TEST] --- Probando Futex (mutex de usuario) ---\n");
+
+    futex_test_lock = 0;
+    futex_test_counter = 0;
+    futex_workers_done = 0;
+    futex_syscalls_start = futex_syscall_count();
+
+    for (int i = 0; i < FUTEX_TEST_WORKERS; i++) {
+        create_process(futex_worker, nullptr, 5, "futex_worker");
+    }
+    futex_user_start();
+}
+
+/* ========================================================================== */
+/* PRUEBAS DE RWLOCK Y SEQLOCK                                              */
+/* ========================================================================== */
+
+#define RW_TEST_READERS 2
+#define RW_TEST_ITERS   300
+#define RW_PROBE_EVERY  50
+
+static struct rwlock rw_test_lock;
+static struct seqlock test_seqlock;
+
+/* Dos parejas con el invariante a == b (el escritor las deja a medias) */
+static volatile unsigned long rw_a, rw_b;
+static volatile unsigned long seq_a, seq_b;
+
+static volatile int rw_workers_done;
+static volatile unsigned long rw_torn;
+static volatile unsigned long seq_torn;
+static volatile unsigned long seq_retries;
+static volatile unsigned long time_backwards;
+
+/* Sonda en softirq sobre rw_test_lock */
+static volatile unsigned long rw_probe_runs;
+static volatile unsigned long rw_probe_busy;
+static volatile unsigned long rw_probe_torn;
+
+/**
+ * @brief Sonda (SOFTIRQ_TEST): lee la pareja del rwlock sin esperar
+ *
+ * @details
+ *   Corre encima del proceso interrumpido. Si es el escritor con la
+ *   pareja a medias, read_trylock() tiene que fallar; si es un lector,
+ *   la sonda entra como segundo lector y la pareja debe estar completa.
+ */
+static void rw_probe(void) {
+    if (read_trylock(&rw_test_lock)) {
+        if (rw_a != rw_b) rw_probe_torn++;
+        read_unlock(&rw_test_lock);
+    } else {
+        rw_probe_busy++;
+    }
+    rw_probe_runs++;
+}
+
+/**
+ * @brief Escritor: actualiza ambas parejas con una espera en medio
+ *
+ * @details
+ *   El lock desactiva la expropiación, así que ningún lector de proceso
+ *   llega a correr con la pareja a medias. Cada RW_PROBE_EVERY vueltas
+ *   el escritor espera en ese punto a la sonda en softirq, que sí corre
+ *   y encuentra el lock tomado.
+ */
+static void rw_writer(void *arg) {
+    (void)arg;
+    enable_interrupts();
+
+    for (int i = 0; i < RW_TEST_ITERS; i++) {
+        write_lock(&rw_test_lock);
+        rw_a++;
+        delay(2000);
+        if (i % RW_PROBE_EVERY == 0) {
+            test_probe_wait(&rw_probe_runs);
+        }
+        rw_b++;
+        write_unlock(&rw_test_lock);
+
+        unsigned long flags = write_seqlock_irqsave(&test_seqlock);
+        seq_a++;
+        seq_b++;
+        write_sequnlock_irqrestore(&test_seqlock, flags);
+
+        delay(2000);
+    }
+
+    write_lock(&rw_test_lock);
+    rw_workers_done++;
+    write_unlock(&rw_test_lock);
+}
+
+/**
+ * @brief Lector: comprueba el invariante con rwlock, seqlock y la base
+ *        de tiempos
+ */
+static void rw_reader(void *arg) {
+    (void)arg;
+    enable_interrupts();
+
+    unsigned long last_us = timer_uptime_us();
+
+    for (int i = 0; i < RW_TEST_ITERS; i++) {
+        read_lock(&rw_test_lock);
+        unsigned long a = rw_a;
+        delay(1000);
+        if (i % RW_PROBE_EVERY == 0) {
+            test_probe_wait(&rw_probe_runs);
+        }
+        unsigned long b = rw_b;
+        read_unlock(&rw_test_lock);
+        if (a != b) rw_torn++;
+
+        unsigned long seq;
+        int tries = 0;
+        do {
+            seq = read_seqbegin(&test_seqlock);
+            a = seq_a;
+            b = seq_b;
+            tries++;
+        } while (read_seqretry(&test_seqlock, seq));
+        if (a != b) seq_torn++;
+        seq_retries += tries - 1;
+
+        unsigned long now_us = timer_uptime_us();
+        if (now_us < last_us) time_backwards++;
+        last_us = now_us;
+    }
+
+    write_lock(&rw_test_lock);
+    int last = (++rw_workers_done == RW_TEST_READERS + 1);
+    write_unlock(&rw_test_lock);
+
+    if (last) {
+        kprintf("   [RW] rwlock: %d lecturas rotas  seqlock: %d rotas, %d reintentos\n",
+                rw_torn, seq_torn, seq_retries);
+        kprintf("   [RW] sonda softirq: %d intentos, %d con el escritor dentro, %d rotas\n",
+                rw_probe_runs, rw_probe_busy, rw_probe_torn);
+        kprintf("   [RW] uptime: %d us, %d retrocesos (%s)\n",
+                timer_uptime_us(), time_backwards,
+                (rw_torn == 0 && seq_torn == 0 && time_backwards == 0 &&
+                 rw_probe_torn == 0 && rw_probe_busy > 0) ? "OK" : "FALLO");
+        lockstat_print();
+    }
+}
+
+/**
+ * @brief Lanza prueba de rwlock, seqlock y base de tiempos
+ *
+ * @details
+ *   RESULTADO ESPERADO:
+ *   - Ninguna lectura ve la pareja a medias (a != b), tampoco la sonda
+ *   - La sonda encuentra al escritor dentro (read_trylock falla)
+ *   - timer_uptime_us() nunca retrocede
+ *   - 'lockstat' muestra en rw_test los trylocks fallidos de la sonda
+ *     (en un solo core un proceso no encuentra nunca el lock tomado:
+ *     el propietario no se expropia con él)
+ */
+void test_rwlock(void) {
+    kprintf("\n[TEST] --- Probando RWLock y Seqlock ---\n");
+
+    static int initialized = 0;
+    if (!initialized) {
+        rwlock_init(&rw_test_lock, "rw_test");
+        seqlock_init(&test_seqlock);
+        initialized = 1;
+    }
+    lockstat_reset();
+
+    rw_a = rw_b = 0;
+    seq_a = seq_b = 0;
+    rw_workers_done = 0;
+    rw_torn = 0;
+    seq_torn = 0;
+    seq_retries = 0;
+    time_backwards = 0;
+    rw_probe_runs = 0;
+    rw_probe_busy = 0;
+    rw_probe_torn = 0;
+    open_softirq(SOFTIRQ_TEST, rw_probe);
+
+    create_process(rw_writer, nullptr, 5, "rw_writer");
+    for (int i = 0; i < RW_TEST_READERS; i++) {
+        create_process(rw_reader, nullptr, 5, "rw_reader");
+    }
+}
+
+/* ========================================================================== */
+/* PRUEBAS DE RCU                                                           */
+/* ========================================================================== */
+
+#define RCU_TEST_READERS 2
+#define RCU_TEST_ITERS   200
+#define RCU_OBJ_ALIVE    0xA11CEUL
+#define RCU_OBJ_DEAD     0xDEADUL
+
+struct rcu_test_obj {
+    unsigned long magic;
+    unsigned long value;
+    struct rcu_head rcu;
+};
+
+static struct rcu_test_obj *rcu_test_ptr;
+static volatile int rcu_workers_done;
+static volatile unsigned long rcu_bad_reads;
+static volatile unsigned long rcu_lookups_failed;
+static volatile unsigned long rcu_freed;
+static unsigned long rcu_gp_start;
+
+/**
+ * @brief Callback de call_rcu(): marca el objeto como muerto y lo libera
+ */
+static void rcu_test_free(struct rcu_head *head) {
+    struct rcu_test_obj *obj = container_of(head, struct rcu_test_obj, rcu);
+    obj->magic = RCU_OBJ_DEAD;
+    kfree(obj);
+    rcu_freed++;
+}
+
+/**
+ * @brief Escritor: sustituye el objeto publicado y libera el viejo
+ *
+ * @details
+ *   Alterna call_rcu() (liberación diferida) y synchronize_rcu() +
+ *   liberación directa.
+ */
+static void rcu_writer(void *arg) {
+    (void)arg;
+    enable_interrupts();
+
+    for (int i = 0; i < RCU_TEST_ITERS; i++) {
+        struct rcu_test_obj *obj = kmalloc(sizeof(*obj));
+        if (obj == nullptr) break;
+        obj->magic = RCU_OBJ_ALIVE;
+        obj->value = i;
+
+        struct rcu_test_obj *old = rcu_test_ptr;
+        rcu_assign_pointer(rcu_test_ptr, obj);
+
+        if (old != nullptr) {
+            if (i & 1) {
+                call_rcu(&old->rcu, rcu_test_free);
+            } else {
+                synchronize_rcu();
+                rcu_test_free(&old->rcu);
+            }
+        }
+        delay(5000);
+    }
+
+    unsigned long flags = local_irq_save();
+    rcu_workers_done++;
+    local_irq_restore(flags);
+}
+
+/**
+ * @brief Lector: usa el objeto publicado y busca PIDs y archivos sin locks
+ *
+ * @details
+ *   La espera dentro de la sección de lectura deja que el timer pida un
+ *   cambio de contexto: se aplaza hasta rcu_read_unlock() y el objeto
+ *   leído no puede liberarse mientras tanto.
+ */
+static void rcu_reader(void *arg) {
+    (void)arg;
+    enable_interrupts();
+
+    for (int i = 0; i < RCU_TEST_ITERS; i++) {
+        rcu_read_lock();
+        struct rcu_test_obj *obj = rcu_dereference(rcu_test_ptr);
+        if (obj != nullptr) {
+            delay(2000);
+            if (obj->magic != RCU_OBJ_ALIVE) rcu_bad_reads++;
+        }
+
+        if (process_find(current_process->pid) != current_process) {
+            rcu_lookups_failed++;
+        }
+        rcu_read_unlock();
+
+        int fd = vfs_open("readme.txt");
+        if (fd < 0) {
+            rcu_lookups_failed++;
+        } else {
+            vfs_close(fd);
+        }
+    }
+
+    unsigned long flags = local_irq_save();
+    int last = (++rcu_workers_done == RCU_TEST_READERS + 1);
+    local_irq_restore(flags);
+
+    if (last) {
+        sleep(2);   /* Dejar que el kworker ejecute los últimos callbacks */
+        kprintf("   [RCU] lecturas de objetos liberados: %d, búsquedas fallidas: %d\n",
+                rcu_bad_reads, rcu_lookups_failed);
+        kprintf("   [RCU] %d objetos liberados, %d periodos de gracia (%s)\n",
+                rcu_freed, rcu_gp_count() - rcu_gp_start,
+                (rcu_bad_reads == 0 && rcu_lookups_failed == 0) ? "OK" : "FALLO");
+    }
+}
+
+/**
+ * @brief Lanza prueba de RCU
+ *
+ * @details
+ *   RESULTADO ESPERADO:
+ *   - Ningún lector ve un objeto ya liberado (magic == DEAD)
+ *   - process_find() y vfs_open() encuentran siempre su objetivo
+ *   - Se liberan RCU_TEST_ITERS - 1 objetos
+ */
+void test_rcu(void) {
+    kprintf("\n[TEST] --- Probando RCU (lecturas sin locks) ---\n");
+
+    rcu_test_ptr = nullptr;
+    rcu_workers_done = 0;
+    rcu_bad_reads = 0;
+    rcu_lookups_failed = 0;
+    rcu_freed = 0;
+    rcu_gp_start = rcu_gp_count();
+
+    create_process(rcu_writer, nullptr, 5, "rcu_writer");
+    for (int i = 0; i < RCU_TEST_READERS; i++) {
+        create_process(rcu_reader, nullptr, 5, "rcu_reader");
+    }
+}
+
+/* ========================================================================== */
+/* PRUEBAS DE COLAS SIN LOCKS (SPSC / MPMC)                                 */
+/* ========================================================================== */
+
+#define RING_TEST_ITEMS     2000
+#define RING_TEST_BURST     8
+#define RING_TEST_PRODUCERS 2
+#define RING_TEST_CONSUMERS 2
+#define RING_TEST_WORKERS   (2 + RING_TEST_PRODUCERS + RING_TEST_CONSUMERS)
+
+static unsigned long spsc_test_slots[16];
+static struct spsc_ring spsc_test_ring;
+static struct mpmc_slot mpmc_test_slots[32];
+static struct mpmc_ring mpmc_test_ring;
+
+static volatile unsigned long spsc_out_of_order;
+static volatile unsigned long mpmc_out_of_order;
+static volatile unsigned long mpmc_consumed;
+static volatile unsigned long mpmc_sum;
+static volatile int ring_workers_done;
+
+/**
+ * @brief Cuenta un worker terminado; el último imprime el resultado
+ */
+static void ring_worker_done(void) {
+    unsigned long flags = local_irq_save();
+    int last = (++ring_workers_done == RING_TEST_WORKERS);
+    local_irq_restore(flags);
+
+    if (last) {
+        unsigned long n = RING_TEST_ITEMS;
+        unsigned long expected_sum = RING_TEST_PRODUCERS * (n * (n - 1) / 2);
+        kprintf("   [RING] SPSC: %d elementos, %d fuera de orden (%s)\n",
+                n, spsc_out_of_order, spsc_out_of_order == 0 ? "OK" : "FALLO");
+        kprintf("   [RING] MPMC: %d/%d elementos, %d fuera de orden, suma %s (%s)\n",
+                mpmc_consumed, RING_TEST_PRODUCERS * n, mpmc_out_of_order,
+                mpmc_sum == expected_sum ? "correcta" : "incorrecta",
+                (mpmc_consumed == RING_TEST_PRODUCERS * n && mpmc_out_of_order == 0 &&
+                 mpmc_sum == expected_sum) ? "OK" : "FALLO");
+    }
+}
+
+/**
+ * @brief Productor SPSC: encola 0..N-1 en lotes
+ */
+static void spsc_producer(void *arg) {
+    (void)arg;
+    enable_interrupts();
+
+    unsigned long next = 0;
+    while (next < RING_TEST_ITEMS) {
+        unsigned long batch[RING_TEST_BURST];
+        unsigned long n = RING_TEST_ITEMS - next;
+        if (n > RING_TEST_BURST) n = RING_TEST_BURST;
+        for (unsigned long i = 0; i < n; i++) batch[i] = next + i;
+
+        unsigned long done = spsc_ring_enqueue_burst(&spsc_test_ring, batch, n);
+        next += done;
+        if (done < n) delay(500);   /* Llena: esperar al consumidor */
+    }
+    ring_worker_done();
+}
+
+/**
+ * @brief Consumidor SPSC: comprueba que recibe 0..N-1 en orden
+ */
+static void spsc_consumer(void *arg) {
+    (void)arg;
+    enable_interrupts();
+
+    unsigned long expected = 0;
+    while (expected < RING_TEST_ITEMS) {
+        unsigned long batch[RING_TEST_BURST];
+        unsigned long n = spsc_ring_dequeue_burst(&spsc_test_ring, batch, RING_TEST_BURST);
+        for (unsigned long i = 0; i < n; i++) {
+            if (batch[i] != expected) spsc_out_of_order++;
+            expected++;
+        }
+        if (n == 0) delay(500);     /* Vacía: esperar al productor */
+    }
+    ring_worker_done();
+}
+
+/**
+ * @brief Productor MPMC: encola (id << 32 | seq) con seq = 0..N-1
+ */
+static void mpmc_producer(void *arg) {
+    unsigned long id = (unsigned long)arg;
+    enable_interrupts();
+
+    unsigned long next = 0;
+    while (next < RING_TEST_ITEMS) {
+        unsigned long batch[RING_TEST_BURST];
+        unsigned long n = RING_TEST_ITEMS - next;
+        if (n > RING_TEST_BURST) n = RING_TEST_BURST;
+        for (unsigned long i = 0; i < n; i++) batch[i] = (id << 32) | (next + i);
+
+        unsigned long done = mpmc_ring_enqueue_burst(&mpmc_test_ring, batch, n);
+        next += done;
+        if (done < n) delay(500);
+    }
+    ring_worker_done();
+}
+
+/**
+ * @brief Consumidor MPMC: cada productor debe verse en orden creciente
+ */
+static void mpmc_consumer(void *arg) {
+    (void)arg;
+    enable_interrupts();
+
+    long last_seq[RING_TEST_PRODUCERS];
+    for (int i = 0; i < RING_TEST_PRODUCERS; i++) last_seq[i] = -1;
+
+    while (READ_ONCE(mpmc_consumed) < RING_TEST_PRODUCERS * RING_TEST_ITEMS) {
+        unsigned long batch[RING_TEST_BURST];
+        unsigned long n = mpmc_ring_dequeue_burst(&mpmc_test_ring, batch, RING_TEST_BURST);
+        if (n == 0) {
+            delay(500);
+            continue;
+        }
+
+        unsigned long sum = 0;
+        unsigned long bad = 0;
+        for (unsigned long i = 0; i < n; i++) {
+            unsigned long id = batch[i] >> 32;
+            long seq = (long)(batch[i] & 0xFFFFFFFFUL);
+            if (id >= RING_TEST_PRODUCERS || seq <= last_seq[id]) {
+                bad++;
+            } else {
+                last_seq[id] = seq;
+            }
+            sum += (unsigned long)seq;
+        }
+
+        unsigned long flags = local_irq_save();
+        mpmc_consumed += n;
+        mpmc_sum += sum;
+        mpmc_out_of_order += bad;
+        local_irq_restore(flags);
+    }
+    ring_worker_done();
+}
+
+/**
+ * @brief Lanza prueba de las colas SPSC y MPMC
+ *
+ * @details
+ *   Colas pequeñas (16 y 32) para que productores y consumidores se
+ *   encuentren a menudo llenas y vacías y el timer los expropie a mitad
+ *   de una operación.
+ *
+ *   RESULTADO ESPERADO:
+ *   - SPSC: los N elementos llegan en orden
+ *   - MPMC: llegan todos los elementos de ambos productores, la suma de
+ *     secuencias es la esperada y cada consumidor ve a cada productor
+ *     en orden creciente
+ */
+void test_ring(void) {
+    kprintf("\n[TEST] --- Probando colas sin locks (SPSC / MPMC) ---\n");
+
+    spsc_ring_init(&spsc_test_ring, spsc_test_slots, 16);
+    mpmc_ring_init(&mpmc_test_ring, mpmc_test_slots, 32);
+
+    spsc_out_of_order = 0;
+    mpmc_out_of_order = 0;
+    mpmc_consumed = 0;
+    mpmc_sum = 0;
+    ring_workers_done = 0;
+
+    create_process(spsc_producer, nullptr, 5, "spsc_prod");
+    create_process(spsc_consumer, nullptr, 5, "spsc_cons");
+    for (unsigned long i = 0; i < RING_TEST_PRODUCERS; i++) {
+        create_process(mpmc_producer, (void *)i, 5, "mpmc_prod");
+    }
+    for (int i = 0; i < RING_TEST_CONSUMERS; i++) {
+        create_process(mpmc_consumer, nullptr, 5, "mpmc_cons");
+    }
+}
+
+/* ========================================================================== */
+/* PRUEBAS DE OPERACIONES ATÓMICAS (LL/SC / LSE)                            */
+/* ========================================================================== */
+
+#define ATOMIC_TEST_WORKERS 3
+#define ATOMIC_TEST_ITERS   2000
+#define ATOMIC_TEST_BITS    8
+#define ATOMIC_BENCH_OPS    10000
+
+static atomic_t atomic_test_counter;
+static volatile unsigned long cas_test_counter;
+static volatile unsigned long atomic_test_bitmap;
+static volatile int atomic_bit_owner[ATOMIC_TEST_BITS];
+static volatile unsigned long atomic_bit_collisions;
+static atomic_t atomic_workers_done;
+
+/**
+ * @brief Worker: contador atómico, contador por CAS y reparto de bits
+ *
+ * @details
+ *   Cada bit del bitmap es un recurso: quien lo gana con
+ *   test_and_set_bit_lock() debe encontrar libre su atomic_bit_owner[].
+ *   Las esperas dentro de la sección dejan que el timer expropie.
+ */
+static void atomic_worker(void *arg) {
+    int id = (int)(unsigned long)arg + 1;
+    enable_interrupts();
+
+    for (int i = 0; i < ATOMIC_TEST_ITERS; i++) {
+        atomic_inc(&atomic_test_counter);
+
+        unsigned long old;
+        do {
+            old = READ_ONCE(cas_test_counter);
+        } while (cmpxchg(&cas_test_counter, old, old + 1) != old);
+
+        unsigned long bit = (unsigned long)(i + id) % ATOMIC_TEST_BITS;
+        if (!test_and_set_bit_lock(bit, &atomic_test_bitmap)) {
+            if (atomic_bit_owner[bit] != 0) atomic_bit_collisions++;
+            atomic_bit_owner[bit] = id;
+            delay(200);
+            if (atomic_bit_owner[bit] != id) atomic_bit_collisions++;
+            atomic_bit_owner[bit] = 0;
+            clear_bit_unlock(bit, &atomic_test_bitmap);
+        }
+    }
+
+    if (atomic_inc_return(&atomic_workers_done) == ATOMIC_TEST_WORKERS) {
+        unsigned long expected = ATOMIC_TEST_WORKERS * ATOMIC_TEST_ITERS;
+        long counter = atomic_read(&atomic_test_counter);
+        kprintf("   [ATOMIC] atomic_inc: %d/%d  cmpxchg: %d/%d  colisiones de bits: %d  bitmap final: %x (%s)\n",
+                counter, expected, cas_test_counter, expected,
+                atomic_bit_collisions, atomic_test_bitmap,
+                ((unsigned long)counter == expected && cas_test_counter == expected &&
+                 atomic_bit_collisions == 0 && atomic_test_bitmap == 0) ? "OK" : "FALLO");
+    }
+}
+
+/**
+ * @brief Lanza prueba de atomic.h
+ *
+ * @details
+ *   Primero mide el coste sin contención de atomic_inc() y cmpxchg()
+ *   con la implementación activa (LSE o LL/SC, ver 'make run
+ *   QEMU_CPU=max'); después lanza los workers.
+ *
+ *   RESULTADO ESPERADO:
+ *   - Ningún incremento perdido en ninguno de los dos contadores
+ *   - Ningún bit con dos propietarios; bitmap a 0 al terminar
+ */
+void test_atomic(void) {
+    kprintf("\n[TEST] --- Probando operaciones atómicas (%s) ---\n",
+            cpu_has_feature(CPU_FEATURE_LSE) ? "LSE" : "LL/SC");
+
+    atomic_t bench = ATOMIC_INIT(0);
+    volatile unsigned long bench_cas = 0;
+
+    unsigned long start = timer_get_count();
+    for (int i = 0; i < ATOMIC_BENCH_OPS; i++) {
+        atomic_inc(&bench);
+    }
+    unsigned long inc_ticks = timer_get_count() - start;
+
+    start = timer_get_count();
+    for (unsigned long i = 0; i < ATOMIC_BENCH_OPS; i++) {
+        cmpxchg(&bench_cas, i, i + 1);
+    }
+    unsigned long cas_ticks = timer_get_count() - start;
+
+    unsigned long freq = timer_get_freq();
+    if (freq > 0) {
+        kprintf("   [ATOMIC] Sin contención: atomic_inc ~%d ns, cmpxchg ~%d ns\n",
+                inc_ticks * 1000000000UL / freq / ATOMIC_BENCH_OPS,
+                cas_ticks * 1000000000UL / freq / ATOMIC_BENCH_OPS);
+    }
+
+    atomic_set(&atomic_test_counter, 0);
+    atomic_set(&atomic_workers_done, 0);
+    cas_test_counter = 0;
+    atomic_test_bitmap = 0;
+    atomic_bit_collisions = 0;
+    for (int i = 0; i < ATOMIC_TEST_BITS; i++) atomic_bit_owner[i] = 0;
+
+    for (unsigned long i = 0; i < ATOMIC_TEST_WORKERS; i++) {
+        create_process(atomic_worker, (void *)i, 5, "atomic_worker");
+    }
+}
+
+/* ========================================================================== */
+/* PRUEBAS DE WAIT QUEUES, COMPLETIONS Y CONDVARS                           */
+/* ========================================================================== */
+
+#define WAIT_TEST_TIMEOUT  5     /* Ticks del timeout sin despertador */
+#define WAIT_TEST_ITEMS    200
+#define WAIT_TEST_BUF      4
+
+static struct wait_queue_head wait_test_wq;
+static volatile int wait_test_flag;
+static struct completion wait_test_done;
+static struct completion wait_test_gate;
+static volatile int wait_test_gate_passed;
+
+/* Búfer acotado protegido por mutex + dos condvars */
+static struct mutex cv_test_mutex;
+static struct condvar cv_not_empty;
+static struct condvar cv_not_full;
+static unsigned long cv_buf[WAIT_TEST_BUF];
+static int cv_count, cv_in, cv_out;
+static volatile unsigned long cv_sum;
+
+/**
+ * @brief Despierta wait_test_wq tras dormir un poco
+ */
+static void wait_test_waker(void *arg) {
+    (void)arg;
+    enable_interrupts();
+
+    sleep(2);
+    wait_test_flag = 1;
+    wake_up(&wait_test_wq);
+}
+
+/**
+ * @brief Espera en la puerta (complete_all) y avisa al terminar
+ */
+static void wait_test_gate_waiter(void *arg) {
+    (void)arg;
+    enable_interrupts();
+
+    wait_for_completion(&wait_test_gate);
+
+    unsigned long flags = local_irq_save();
+    wait_test_gate_passed++;
+    local_irq_restore(flags);
+    complete(&wait_test_done);
+}
+
+/**
+ * @brief Productor del búfer acotado (condvars)
+ */
+static void cv_producer(void *arg) {
+    (void)arg;
+    enable_interrupts();
+
+    for (unsigned long i = 1; i <= WAIT_TEST_ITEMS; i++) {
+        mutex_lock(&cv_test_mutex);
+        while (cv_count == WAIT_TEST_BUF) {
+            cond_wait(&cv_not_full, &cv_test_mutex);
+        }
+        cv_buf[cv_in] = i;
+        cv_in = (cv_in + 1) % WAIT_TEST_BUF;
+        cv_count++;
+        cond_signal(&cv_not_empty);
+        mutex_unlock(&cv_test_mutex);
+    }
+    complete(&wait_test_done);
+}
+
+/**
+ * @brief Consumidor del búfer acotado (condvars)
+ */
+static void cv_consumer(void *arg) {
+    (void)arg;
+    enable_interrupts();
+
+    for (int i = 0; i < WAIT_TEST_ITEMS; i++) {
+        mutex_lock(&cv_test_mutex);
+        while (cv_count == 0) {
+            cond_wait(&cv_not_empty, &cv_test_mutex);
+        }
+        cv_sum += cv_buf[cv_out];
+        cv_out = (cv_out + 1) % WAIT_TEST_BUF;
+        cv_count--;
+        cond_signal(&cv_not_full);
+        mutex_unlock(&cv_test_mutex);
+    }
+    complete(&wait_test_done);
+}
+
+/**
+ * @brief Ejecuta las pruebas en orden y comprueba los resultados
+ */
+static void wait_tester(void *arg) {
+    (void)arg;
+    enable_interrupts();
+    int failures = 0;
+
+    /* 1. Timeout sin despertador: vence y devuelve 0 */
+    unsigned long start = sys_timer_count;
+    long left = wait_event_timeout(wait_test_wq, wait_test_flag != 0, WAIT_TEST_TIMEOUT);
+    unsigned long waited = sys_timer_count - start;
+    kprintf("   [WAIT] Timeout: devuelve %d tras %d ticks (esperado 0 tras %d)\n",
+            left, waited, WAIT_TEST_TIMEOUT);
+    if (left != 0 || waited < WAIT_TEST_TIMEOUT) failures++;
+
+    /* 2. Despertado antes del timeout: devuelve ticks restantes */
+    create_process(wait_test_waker, nullptr, 5, "wait_waker");
+    left = wait_event_timeout(wait_test_wq, wait_test_flag != 0, 100);
+    kprintf("   [WAIT] wake_up: condición %d, quedaban %d ticks\n", wait_test_flag, left);
+    if (left <= 0 || !wait_test_flag) failures++;
+
+    /* 3. Completion con timeout que vence (nadie la completa) */
+    if (wait_for_completion_timeout(&wait_test_gate, 3) != 0) failures++;
+
+    /* 4. complete_all() abre la puerta a todos los waiters */
+    for (int i = 0; i < 3; i++) {
+        create_process(wait_test_gate_waiter, nullptr, 5, "gate_waiter");
+    }
+    sleep(2);
+    complete_all(&wait_test_gate);
+    for (int i = 0; i < 3; i++) {
+        wait_for_completion(&wait_test_done);
+    }
+    kprintf("   [WAIT] complete_all: %d/3 waiters liberados\n", wait_test_gate_passed);
+    if (wait_test_gate_passed != 3) failures++;
+
+    /* 5. Búfer acotado con mutex + condvars */
+    create_process(cv_producer, nullptr, 5, "cv_producer");
+    create_process(cv_consumer, nullptr, 5, "cv_consumer");
+    wait_for_completion(&wait_test_done);
+    wait_for_completion(&wait_test_done);
+
+    unsigned long expected = (unsigned long)WAIT_TEST_ITEMS * (WAIT_TEST_ITEMS + 1) / 2;
+    kprintf("   [WAIT] Condvars: suma %d/%d\n", cv_sum, expected);
+    if (cv_sum != expected) failures++;
+
+    kprintf("   [WAIT] %s\n", failures == 0 ? "OK" : "FALLO");
+}
+
+/**
+ * @brief Lanza prueba de wait queues, completions y condvars
+ *
+ * @details
+ *   RESULTADO ESPERADO:
+ *   - wait_event_timeout() devuelve 0 al vencer y > 0 si lo despiertan
+ *   - wait_for_completion_timeout() vence sin complete()
+ *   - complete_all() libera a los 3 waiters
+ *   - El búfer acotado entrega todos los elementos (suma 1..N)
+ */
+void test_wait(void) {
+    kprintf("\n[TEST] --- Probando Wait Queues, Completions y Condvars ---\n");
+
+    init_waitqueue_head(&wait_test_wq);
+    wait_test_flag = 0;
+    init_completion(&wait_test_done);
+    init_completion(&wait_test_gate);
+    wait_test_gate_passed = 0;
+
+    static int initialized = 0;
+    if (!initialized) {
+        mutex_init(&cv_test_mutex, "cv_test");
+        initialized = 1;
+    }
+    cond_init(&cv_not_empty);
+    cond_init(&cv_not_full);
+    cv_count = cv_in = cv_out = 0;
+    cv_sum = 0;
+
+    create_process(wait_tester, nullptr, 5, "wait_tester");
+}
+
+/* ========================================================================== */
+/* PRUEBAS DEL BUDDY ALLOCATOR                                               */
+/* ========================================================================== */
+
+#define BUDDY_TEST_BLOCKS  8
+#define BUDDY_BENCH_PAGES  256
+
+/**
+ * @brief Prueba del buddy allocator
+ *
+ * @details
+ *   1. Bloques de órdenes 0..7: alineados a su tamaño y sin solaparse
+ *   2. Tras liberarlos (en otro orden) las páginas libres vuelven al
+ *      valor inicial (fusión)
+ *   3. Coste medio de alloc_pages(0)/free_pages() con muchas páginas
+ *      ya asignadas (antes crecía con el número de páginas usadas)
+ *   4. get_free_page() (pool a cero) devuelve páginas enteras a cero,
+ *      aunque se hayan ensuciado antes de liberarlas
+ */
+void test_buddy(void) {
+    kprintf("\n[TEST] --- Probando buddy allocator del PMM ---\n");
+
+    unsigned long free_before = pmm_nr_free_pages();
+    pmm_buddyinfo();
+
+    unsigned long blocks[BUDDY_TEST_BLOCKS];
+    int errors = 0;
+
+    for (unsigned int o = 0; o < BUDDY_TEST_BLOCKS; o++) {
+        blocks[o] = alloc_pages(o);
+        if (blocks[o] == 0) {
+            kprintf("   [BUDDY] Error: sin memoria para orden %d\n", (long)o);
+            errors++;
+            continue;
+        }
+        if (blocks[o] & ((PAGE_SIZE << o) - 1)) {
+            kprintf("   [BUDDY] Error: bloque de orden %d en 0x%x sin alinear\n",
+                    (long)o, blocks[o]);
+            errors++;
+        }
+        /* Marcar el bloque entero para detectar solapes */
+        memset((void *)blocks[o], (int)(o + 1), PAGE_SIZE << o);
+    }
+
+    for (unsigned int o = 0; o < BUDDY_TEST_BLOCKS; o++) {
+        if (blocks[o] == 0) continue;
+        unsigned char *b = (unsigned char *)blocks[o];
+        if (b[0] != o + 1 || b[(PAGE_SIZE << o) - 1] != o + 1) {
+            kprintf("   [BUDDY] Error: bloque de orden %d pisado\n", (long)o);
+            errors++;
+        }
+    }
+    pmm_buddyinfo();
+
+    /* Liberar en orden distinto al de asignación */
+    for (int o = BUDDY_TEST_BLOCKS - 1; o >= 0; o -= 2) {
+        if (blocks[o]) free_pages(blocks[o], o);
+    }
+    for (int o = BUDDY_TEST_BLOCKS - 2; o >= 0; o -= 2) {
+        if (blocks[o]) free_pages(blocks[o], o);
+    }
+
+    /* Con memoria ya ocupada, una página debe seguir costando lo mismo */
+    static unsigned long bench[BUDDY_BENCH_PAGES];
+    unsigned long start = timer_get_count();
+    for (int i = 0; i < BUDDY_BENCH_PAGES; i++) {
+        bench[i] = alloc_pages(0);
+    }
+    unsigned long alloc_ticks = timer_get_count() - start;
+
+    start = timer_get_count();
+    for (int i = 0; i < BUDDY_BENCH_PAGES; i++) {
+        if (bench[i]) free_pages(bench[i], 0);
+    }
+    unsigned long free_ticks = timer_get_count() - start;
+
+    unsigned long freq = timer_get_freq();
+    if (freq > 0) {
+        kprintf("   [BUDDY] alloc_pages(0) ~%d ns, free_pages(0) ~%d ns\n",
+                alloc_ticks * 1000000000UL / freq / BUDDY_BENCH_PAGES,
+                free_ticks * 1000000000UL / freq / BUDDY_BENCH_PAGES);
+    }
+
+    /* Ensuciar páginas, devolverlas y pedirlas de nuevo limpias */
+    for (int i = 0; i < BUDDY_TEST_BLOCKS; i++) {
+        blocks[i] = get_free_page();
+        if (blocks[i]) memset((void *)blocks[i], 0xAA, PAGE_SIZE);
+    }
+    for (int i = 0; i < BUDDY_TEST_BLOCKS; i++) {
+        if (blocks[i]) free_page(blocks[i]);
+    }
+
+    start = timer_get_count();
+    for (int i = 0; i < BUDDY_TEST_BLOCKS; i++) {
+        blocks[i] = get_free_page();
+    }
+    unsigned long zero_ticks = timer_get_count() - start;
+
+    for (int i = 0; i < BUDDY_TEST_BLOCKS; i++) {
+        if (blocks[i] == 0) continue;
+        unsigned long *w = (unsigned long *)blocks[i];
+        for (int j = 0; j < PAGE_SIZE / 8; j++) {
+            if (w[j] != 0) {
+                kprintf("   [BUDDY] Error: get_free_page() 0x%x no está a cero\n", blocks[i]);
+                errors++;
+                break;
+            }
+        }
+        free_page(blocks[i]);
+    }
+    if (freq > 0) {
+        kprintf("   [BUDDY] get_free_page() (pool a cero) ~%d ns\n",
+                zero_ticks * 1000000000UL / freq / BUDDY_TEST_BLOCKS);
+    }
+
+    unsigned long free_after = pmm_nr_free_pages();
+    pmm_buddyinfo();
+
+    if (free_after != free_before) {
+        kprintf("   [BUDDY] Error: %d páginas libres antes, %d después\n",
+                free_before, free_after);
+        errors++;
+    }
+
+    if (errors == 0) {
+        kprintf("[TEST] Buddy allocator OK: bloques alineados, sin solapes y fusionados\n");
+    } else {
+        kprintf("[TEST] Buddy allocator FALLÓ: %d errores\n", (long)errors);
+    }
+}
+
+/* ========================================================================== */
+/* PRUEBAS DEL SLAB ALLOCATOR                                                */
+/* ========================================================================== */
+
+#define SLAB_TEST_OBJS   200
+#define SLAB_TEST_MAGIC  0x51AB51ABUL
+
+struct slab_test_obj {
+    unsigned long magic;     /* Puesto por el constructor */
+    unsigned long owner;     /* Índice de quien lo tiene asignado */
+    char payload[40];
+};
+
+static void slab_test_ctor(void *p) {
+    struct slab_test_obj *o = (struct slab_test_obj *)p;
+    o->magic = SLAB_TEST_MAGIC;
+    o->owner = 0;
+}
+
+/**
+ * @brief Prueba del slab allocator
+ *
+ * @details
+ *   1. Caché con constructor: todos los objetos llegan construidos
+ *   2. Cada objeto marcado con su índice no es pisado por otro
+ *   3. Tras liberar todo (devolviendo el estado construido) solo queda
+ *      un slab vacío de reserva; kmem_cache_shrink() lo devuelve
+ *   4. Coste medio de kmem_cache_alloc()/free() frente a kmalloc()/kfree()
+ */
+void test_slab(void) {
+    kprintf("\n[TEST] --- Probando cachés de objetos (slab) ---\n");
+
+    struct kmem_cache *cache = kmem_cache_create("slab_test",
+                                                 sizeof(struct slab_test_obj),
+                                                 0, slab_test_ctor);
+    if (cache == nullptr) {
+        kprintf("[TEST] Slab FALLÓ: no se pudo crear la caché\n");
+        return;
+    }
+
+    unsigned long pages_before = pmm_nr_free_pages();
+    static struct slab_test_obj *objs[SLAB_TEST_OBJS];
+    int errors = 0;
+
+    unsigned long start = timer_get_count();
+    for (int i = 0; i < SLAB_TEST_OBJS; i++) {
+        objs[i] = kmem_cache_alloc(cache);
+    }
+    unsigned long alloc_ticks = timer_get_count() - start;
+
+    for (int i = 0; i < SLAB_TEST_OBJS; i++) {
+        if (objs[i] == nullptr || objs[i]->magic != SLAB_TEST_MAGIC || objs[i]->owner != 0) {
+            kprintf("   [SLAB] Error: objeto %d sin construir\n", (long)i);
+            errors++;
+            objs[i] = nullptr;
+            continue;
+        }
+        if ((unsigned long)objs[i] % SLAB_MIN_ALIGN != 0) {
+            kprintf("   [SLAB] Error: objeto %d sin alinear\n", (long)i);
+            errors++;
+        }
+        objs[i]->owner = i + 1;
+        memset(objs[i]->payload, i & 0xFF, sizeof(objs[i]->payload));
+    }
+    for (int i = 0; i < SLAB_TEST_OBJS; i++) {
+        if (objs[i] == nullptr) continue;
+        if (objs[i]->owner != (unsigned long)(i + 1) ||
+            objs[i]->payload[39] != (char)(i & 0xFF)) {
+            kprintf("   [SLAB] Error: objeto %d pisado\n", (long)i);
+            errors++;
+        }
+    }
+    slabinfo_print();
+
+    start = timer_get_count();
+    for (int i = 0; i < SLAB_TEST_OBJS; i++) {
+        if (objs[i] == nullptr) continue;
+        objs[i]->owner = 0;      /* Estado construido */
+        kmem_cache_free(cache, objs[i]);
+    }
+    unsigned long free_ticks = timer_get_count() - start;
+
+    if (cache->active_objs != 0 || cache->nr_slabs != 1) {
+        kprintf("   [SLAB] Error: %d objetos activos y %d slabs tras liberar todo\n",
+                (long)cache->active_objs, (long)cache->nr_slabs);
+        errors++;
+    }
+
+    /* Un objeto reciclado sigue construido */
+    struct slab_test_obj *again = kmem_cache_alloc(cache);
+    if (again == nullptr || again->magic != SLAB_TEST_MAGIC || again->owner != 0) {
+        kprintf("   [SLAB] Error: objeto reciclado sin construir\n");
+        errors++;
+    }
+    kmem_cache_free(cache, again);
+
+    kmem_cache_shrink(cache);
+    if (kmem_cache_destroy(cache) < 0) {
+        errors++;
+    }
+    if (pmm_nr_free_pages() != pages_before) {
+        kprintf("   [SLAB] Error: %d páginas libres antes, %d después\n",
+                pages_before, pmm_nr_free_pages());
+        errors++;
+    }
+
+    /* Mismo patrón con kmalloc() como referencia */
+    start = timer_get_count();
+    for (int i = 0; i < SLAB_TEST_OBJS; i++) {
+        objs[i] = kmalloc(sizeof(struct slab_test_obj));
+    }
+    unsigned long kmalloc_ticks = timer_get_count() - start;
+    for (int i = 0; i < SLAB_TEST_OBJS; i++) {
+        kfree(objs[i]);
+    }
+
+    unsigned long freq = timer_get_freq();
+    if (freq > 0) {
+        kprintf("   [SLAB] kmem_cache_alloc ~%d ns, kmem_cache_free ~%d ns, kmalloc ~%d ns\n",
+                alloc_ticks * 1000000000UL / freq / SLAB_TEST_OBJS,
+                free_ticks * 1000000000UL / freq / SLAB_TEST_OBJS,
+                kmalloc_ticks * 1000000000UL / freq / SLAB_TEST_OBJS);
+    }
+
+    if (errors == 0) {
+        kprintf("[TEST] Slab OK: objetos construidos, sin solapes y slabs devueltos\n");
+    } else {
+        kprintf("[TEST] Slab FALLÓ: %d errores\n", (long)errors);
+    }
+}
+
+/* ========================================================================== */
+/* PRUEBAS DEL HEAP (kmalloc)                                                */
+/* ========================================================================== */
+
+#define HEAP_TEST_BLOCKS  256
+#define HEAP_TEST_WORKERS 4
+#define HEAP_TEST_ITERS   3000
+#define HEAP_TEST_SLOTS   16
+
+static atomic_t heap_workers_done = ATOMIC_INIT(0);
+static atomic_t heap_worker_errors = ATOMIC_INIT(0);
+
+/**
+ * @brief Worker: asigna, marca, comprueba y libera con expropiación activa
+ */
+static void heap_worker(void *arg) {
+    unsigned long id = (unsigned long)arg + 1;
+    char *slots[HEAP_TEST_SLOTS] = { nullptr };
+    unsigned int sizes[HEAP_TEST_SLOTS];
+    enable_interrupts();
+
+    for (int i = 0; i < HEAP_TEST_ITERS; i++) {
+        int k = (int)((i * 7 + id) % HEAP_TEST_SLOTS);
+
+        if (slots[k] != nullptr) {
+            if (slots[k][0] != (char)id || slots[k][sizes[k] - 1] != (char)id) {
+                atomic_inc(&heap_worker_errors);
+            }
+            kfree(slots[k]);
+            slots[k] = nullptr;
+        } else {
+            sizes[k] = 8 + (unsigned int)((i * 13 + id * 101) % 700);
+            slots[k] = kmalloc(sizes[k]);
+            if (slots[k] != nullptr) {
+                memset(slots[k], (int)id, sizes[k]);
+            }
+        }
+        if ((i & 63) == 0) delay(500);   /* Ventana para que el timer expropie */
+    }
+    for (int k = 0; k < HEAP_TEST_SLOTS; k++) kfree(slots[k]);
+
+    if (atomic_inc_return(&heap_workers_done) == HEAP_TEST_WORKERS) {
+        int drained = kheap_drain();
+        int bad = kheap_check();
+        long smashed = atomic_read(&heap_worker_errors);
+        kprintf("   [HEAP] %d workers concurrentes: %d bloques pisados, %d bloques de magazines devueltos, heap %s\n",
+                (long)HEAP_TEST_WORKERS, smashed, (long)drained,
+                (bad == 0 && smashed == 0) ? "OK" : "CORRUPTO");
+    }
+}
+
+/**
+ * @brief Prueba de kmalloc/kzalloc/kfree
+ *
+ * @details
+ *   1. Bloques de tamaños mezclados, marcados y comprobados (sin solapes)
+ *   2. Se liberan primero los pares y luego los impares: cada kfree()
+ *      de la segunda pasada fusiona hacia atrás y hacia delante
+ *   3. kheap_check(): footers y flags coherentes y ningún par de
+ *      bloques libres contiguos sin fusionar
+ *   4. kzalloc() devuelve memoria a cero aunque se reutilice
+ *   5. Coste medio de kmalloc()/kfree() con el heap fragmentado
+ *   6. Workers concurrentes expropiados a mitad de kmalloc()/kfree():
+ *      al terminar el heap debe seguir consistente
+ */
+void test_heap(void) {
+    kprintf("\n[TEST] --- Probando heap del kernel (segregated fit) ---\n");
+
+    static char *blocks[HEAP_TEST_BLOCKS];
+    int errors = 0;
+
+    unsigned long start = timer_get_count();
+    for (int i = 0; i < HEAP_TEST_BLOCKS; i++) {
+        unsigned int size = 16 + (i * 37) % 3000;
+        blocks[i] = kmalloc(size);
+        if (blocks[i] != nullptr) {
+            memset(blocks[i], i & 0xFF, size);
+        }
+    }
+    unsigned long alloc_ticks = timer_get_count() - start;
+
+    for (int i = 0; i < HEAP_TEST_BLOCKS; i++) {
+        unsigned int size = 16 + (i * 37) % 3000;
+        if (blocks[i] == nullptr ||
+            blocks[i][0] != (char)(i & 0xFF) || blocks[i][size - 1] != (char)(i & 0xFF)) {
+            kprintf("   [HEAP] Error: bloque %d perdido o pisado\n", (long)i);
+            errors++;
+        }
+    }
+
+    start = timer_get_count();
+    for (int i = 0; i < HEAP_TEST_BLOCKS; i += 2) kfree(blocks[i]);
+    for (int i = 1; i < HEAP_TEST_BLOCKS; i += 2) kfree(blocks[i]);
+    unsigned long free_ticks = timer_get_count() - start;
+
+    /* Todo fusionado: ningún bloque libre junto a otro libre */
+    int bad = kheap_check();
+    if (bad != 0) {
+        kprintf("   [HEAP] Error: %d inconsistencias en el heap\n", (long)bad);
+        errors += bad;
+    }
+
+    char *dirty = kmalloc(512);
+    if (dirty != nullptr) memset(dirty, 0xAA, 512);
+    kfree(dirty);
+    char *clean = kzalloc(512);
+    for (int i = 0; clean != nullptr && i < 512; i++) {
+        if (clean[i] != 0) {
+            kprintf("   [HEAP] Error: kzalloc() no devolvió memoria a cero\n");
+            errors++;
+            break;
+        }
+    }
+    kfree(clean);
+
+    unsigned long freq = timer_get_freq();
+    if (freq > 0) {
+        kprintf("   [HEAP] kmalloc ~%d ns, kfree ~%d ns\n",
+                alloc_ticks * 1000000000UL / freq / HEAP_TEST_BLOCKS,
+                free_ticks * 1000000000UL / freq / HEAP_TEST_BLOCKS);
+    }
+
+    if (errors == 0) {
+        kprintf("[TEST] Heap OK: sin solapes, fusión en ambos sentidos y kzalloc a cero\n");
+    } else {
+        kprintf("[TEST] Heap FALLÓ: %d errores\n", (long)errors);
+    }
+
+    atomic_set(&heap_workers_done, 0);
+    atomic_set(&heap_worker_errors, 0);
+    for (unsigned long i = 0; i < HEAP_TEST_WORKERS; i++) {
+        create_process(heap_worker, (void *)i, 5, "heap_worker");
+    }
+}
+
+/* ========================================================================== */
+/* TEST: ESTADÍSTICAS DE MEMORIA (meminfo)                                   */
+/* ========================================================================== */
+
+#define MEMINFO_TEST_BLOCKS 32
+#define MEMINFO_TEST_SIZE   200
+
+/**
+ * @brief Prueba de los contadores del heap/PMM y del rastreo por sitio
+ *
+ * @details
+ *   1. N kmalloc() desde un mismo sitio suben 'en uso' y el máximo
+ *   2. El sitio aparece en kheap_trace_top() con N asignaciones y sus
+ *      bytes vivos; tras los kfree() vuelven a bajar
+ *   3. El mayor bloque libre nunca supera el total libre
+ *   4. alloc_pages(2) resta 4 páginas libres y suma una asignación
+ */
+void test_meminfo(void) {
+    kprintf("\n[TEST] --- Probando contadores de memoria (meminfo) ---\n");
+
+    static void *blocks[MEMINFO_TEST_BLOCKS];
+    static struct alloc_site top[MEMTRACE_TOP];
+    struct kheap_stats before, during, after;
+    int errors = 0;
+
+    int was_tracing = kheap_trace(1);
+    kheap_get_stats(&before);
+
+    for (int i = 0; i < MEMINFO_TEST_BLOCKS; i++) {
+        blocks[i] = kmalloc(MEMINFO_TEST_SIZE);
+    }
+    kheap_get_stats(&during);
+
+    unsigned long expected = MEMINFO_TEST_BLOCKS * MEMINFO_TEST_SIZE;
+    if (during.in_use_bytes < before.in_use_bytes + expected ||
+        during.peak_bytes < during.in_use_bytes) {
+        kprintf("   [MEMINFO] Error: 'en uso' no refleja %d bytes nuevos\n", (long)expected);
+        errors++;
+    }
+
+    /* El sitio del bucle: N asignaciones vivas de al menos SIZE bytes */
+    int n = kheap_trace_top(top, MEMTRACE_TOP);
+    unsigned long site = 0;
+    for (int i = 0; i < n; i++) {
+        if (top[i].allocs - top[i].frees >= MEMINFO_TEST_BLOCKS &&
+            top[i].live_bytes >= expected) {
+            site = top[i].site;
+            break;
+        }
+    }
+    if (site == 0) {
+        kprintf("   [MEMINFO] Error: el sitio de llamada no aparece en la tabla\n");
+        errors++;
+    }
+
+    for (int i = 0; i < MEMINFO_TEST_BLOCKS; i++) {
+        kfree(blocks[i]);
+    }
+    kheap_get_stats(&after);
+
+    n = kheap_trace_top(top, MEMTRACE_TOP);
+    for (int i = 0; site != 0 && i < n; i++) {
+        if (top[i].site == site && top[i].live_bytes >= expected) {
+            kprintf("   [MEMINFO] Error: el sitio 0x%x sigue con %d bytes vivos\n",
+                    site, (long)top[i].live_bytes);
+            errors++;
+        }
+    }
+    if (after.in_use_bytes + expected > during.in_use_bytes ||
+        after.largest_free > after.free_bytes) {
+        kprintf("   [MEMINFO] Error: contadores del heap incoherentes tras kfree()\n");
+        errors++;
+    }
+
+    kheap_trace(was_tracing);
+
+    /* PMM: un bloque de orden 2 son 4 páginas */
+    struct pmm_stats p0, p1;
+    pmm_get_stats(&p0);
+    unsigned long pages = alloc_pages(2);
+    pmm_get_stats(&p1);
+    if (pages == 0 || p0.free_pages - p1.free_pages != 4 || p1.allocs != p0.allocs + 1 ||
+        p1.peak_used_pages < p1.total_pages - p1.free_pages) {
+        kprintf("   [MEMINFO] Error: contadores del PMM incoherentes\n");
+        errors++;
+    }
+    if (pages != 0) free_pages(pages, 2);
+
+    if (errors == 0) {
+        kprintf("[TEST] Meminfo OK: uso, máximo, sitios de llamada y PMM coherentes\n");
+    } else {
+        kprintf("[TEST] Meminfo FALLÓ: %d errores\n", (long)errors);
+    }
+}
+
+/* ========================================================================== */
+/* TEST: MAPEOS CON BLOQUES Y CONTIGUOUS HINT                                */
+/* ========================================================================== */
+
+#define MAP_TEST_FLAGS  (MM_SH | MM_RW | MM_KERNEL | (ATTR_NORMAL << 2))
+#define MAP_TEST_BASE   0x40000000UL
+#define MAP_TEST_RAM    (128UL * 1024 * 1024)
+
+/**
+ * @brief Prueba de map_range() sobre tablas de prueba (no activas)
+ *
+ * @details
+ *   1. 64MB + 68KB: 32 bloques de 2MB en dos grupos MM_CONTIG, 16
+ *      páginas contiguas y una suelta; solo 2 tablas nuevas
+ *   2. 1GB alineado: un único bloque L1
+ *   3. map_page() dentro de un bloque lo parte sin cambiar el resto de
+ *      traducciones y quita MM_CONTIG a su grupo
+ *   4. Coste y tablas de mapear 128MB con map_page() frente a map_range()
+ */
+void test_map(void) {
+    kprintf("\n[TEST] --- Probando map_range (bloques 2MB/1GB + contiguous) ---\n");
+
+    int errors = 0;
+    unsigned long free_start = pmm_nr_free_pages();
+    unsigned long *root = (unsigned long *)get_free_page();
+    if (root == nullptr) {
+        kprintf("[TEST] Map FALLÓ: sin memoria\n");
+        return;
+    }
+
+    /* 1. Bloques de 2MB + páginas */
+    unsigned long size = 64UL * 1024 * 1024 + 17 * PAGE_SIZE;
+    unsigned long before = pmm_nr_free_pages();
+    map_range(root, MAP_TEST_BASE, MAP_TEST_BASE, size, MAP_TEST_FLAGS);
+    if (before - pmm_nr_free_pages() != 2) {
+        kprintf("   [MAP] Error: %d tablas para 64MB (esperadas 2)\n",
+                (long)(before - pmm_nr_free_pages()));
+        errors++;
+    }
+
+    unsigned long *l2 = (unsigned long *)(root[L1_INDEX(MAP_TEST_BASE)] & PTE_ADDR_MASK);
+    unsigned long *l3 = (unsigned long *)(l2[32] & PTE_ADDR_MASK);
+    if ((l2[0] & 3) != PT_BLOCK || !(l2[0] & MM_CONTIG) || !(l2[31] & MM_CONTIG) ||
+        (l2[32] & 3) != PT_TABLE || !(l3[15] & MM_CONTIG) || (l3[16] & MM_CONTIG) ||
+        (l3[17] & 1)) {
+        kprintf("   [MAP] Error: descriptores inesperados en el rango de 64MB\n");
+        errors++;
+    }
+    for (unsigned long off = 0; off < size; off += 0x1F3000) {
+        if (vmm_translate(root, MAP_TEST_BASE + off + 8) != MAP_TEST_BASE + off + 8) {
+            kprintf("   [MAP] Error: traducción incorrecta en +0x%x\n", off);
+            errors++;
+            break;
+        }
+    }
+
+    /* 2. Un bloque de 1GB */
+    map_range(root, 0x80000000UL, 0x80000000UL, L1_BLOCK_SIZE, MAP_TEST_FLAGS);
+    if ((root[2] & 3) != PT_BLOCK ||
+        vmm_translate(root, 0x92345678UL) != 0x92345678UL) {
+        kprintf("   [MAP] Error: el bloque de 1GB no se creó\n");
+        errors++;
+    }
+
+    /* 3. Partir un bloque de 2MB (grupo contiguo) y el de 1GB */
+    unsigned long va = MAP_TEST_BASE + L2_BLOCK_SIZE + 5 * PAGE_SIZE;
+    map_page(root, va, 0x47000000UL, MAP_TEST_FLAGS);
+    map_page(root, 0x80000000UL + 3 * L2_BLOCK_SIZE, 0x47001000UL, MAP_TEST_FLAGS);
+    if ((l2[1] & 3) != PT_TABLE || (l2[0] & MM_CONTIG) || !(l2[16] & MM_CONTIG) ||
+        vmm_translate(root, va) != 0x47000000UL ||
+        vmm_translate(root, va + PAGE_SIZE) != va + PAGE_SIZE ||
+        vmm_translate(root, 0x80000000UL + 3 * L2_BLOCK_SIZE) != 0x47001000UL ||
+        vmm_translate(root, 0x80000000UL + 4 * L2_BLOCK_SIZE) != 0x80000000UL + 4 * L2_BLOCK_SIZE) {
+        kprintf("   [MAP] Error: partir bloques cambió otras traducciones\n");
+        errors++;
+    }
+    vmm_free_tables(root);
+
+    /* 4. Mapa lineal de 128MB: página a página frente a map_range() */
+    before = pmm_nr_free_pages();
+    unsigned long start = timer_get_count();
+    for (unsigned long a = MAP_TEST_BASE; a < MAP_TEST_BASE + MAP_TEST_RAM; a += PAGE_SIZE) {
+        map_page(root, a, a, MAP_TEST_FLAGS);
+    }
+    unsigned long page_ticks = timer_get_count() - start;
+    unsigned long page_tables = before - pmm_nr_free_pages();
+    vmm_free_tables(root);
+
+    before = pmm_nr_free_pages();
+    start = timer_get_count();
+    map_range(root, MAP_TEST_BASE, MAP_TEST_BASE, MAP_TEST_RAM, MAP_TEST_FLAGS);
+    unsigned long range_ticks = timer_get_count() - start;
+    unsigned long range_tables = before - pmm_nr_free_pages();
+    vmm_free_tables(root);
+
+    unsigned long freq = timer_get_freq();
+    if (freq > 0) {
+        kprintf("   [MAP] 128MB: map_page %d us y %d tablas; map_range %d us y %d tablas\n",
+                page_ticks * 1000000UL / freq, (long)page_tables,
+                range_ticks * 1000000UL / freq, (long)range_tables);
+    }
+
+    free_page((unsigned long)root);
+    if (pmm_nr_free_pages() != free_start) {
+        kprintf("   [MAP] Error: %d páginas de tablas sin liberar\n",
+                (long)(free_start - pmm_nr_free_pages()));
+        errors++;
+    }
+
+    if (errors == 0) {
+        kprintf("[TEST] Map OK: bloques, grupos contiguos y partición de bloques\n");
+    } else {
+        kprintf("[TEST] Map FALLÓ: %d errores\n", (long)errors);
+    }
+}
+
+/* ========================================================================== */
+/* TEST: REPARTO DE LA RAM (DEVICE TREE + MEMBLOCK)                          */
+/* ========================================================================== */
+
+/**
+ * @brief ¿Se solapan [a0, a1) y [b0, b1)?
+ */
+static int ranges_overlap(unsigned long a0, unsigned long a1, unsigned long b0, unsigned long b1) {
+    return a0 < b1 && b0 < a1;
+}
+
+/**
+ * @brief Prueba del reparto de la RAM hecho en el arranque
+ *
+ * @details
+ *   1. Kernel, DTB, heap y RamDisk están dentro de la RAM y no se solapan
+ *   2. El PMM gestiona la RAM menos lo reservado (salvo redondeo a página)
+ *   3. kmalloc() devuelve memoria del heap y get_free_page() páginas
+ *      fuera de todas las regiones reservadas
+ */
+void test_memblock(void) {
+    kprintf("\n[TEST] --- Probando reparto de RAM (Device Tree + memblock) ---\n");
+
+    const struct mem_layout *l = mm_layout();
+    unsigned long ranges[4][2] = {
+        { l->kernel_start, l->kernel_end },
+        { l->dtb_start, l->dtb_end },
+        { l->heap_start, l->heap_end },
+        { l->ramdisk_start, l->ramdisk_end },
+    };
+    const char *names[4] = { "kernel", "DTB", "heap", "RamDisk" };
+    int errors = 0;
+
+    kprintf("   [MEMBLOCK] RAM [0x%x - 0x%x), %d MB\n",
+            l->ram_start, l->ram_end, (long)(memblock_phys_mem_size() / (1024 * 1024)));
+
+    for (int i = 0; i < 4; i++) {
+        if (ranges[i][0] == ranges[i][1]) continue;   /* Sin DTB */
+
+        if (ranges[i][0] < l->ram_start || ranges[i][1] > l->ram_end) {
+            kprintf("   [MEMBLOCK] Error: %s fuera de la RAM\n", names[i]);
+            errors++;
+        }
+        for (int j = i + 1; j < 4; j++) {
+            if (ranges[j][0] != ranges[j][1] &&
+                ranges_overlap(ranges[i][0], ranges[i][1], ranges[j][0], ranges[j][1])) {
+                kprintf("   [MEMBLOCK] Error: %s y %s se solapan\n", names[i], names[j]);
+                errors++;
+            }
+        }
+    }
+
+    struct pmm_stats ps;
+    pmm_get_stats(&ps);
+    unsigned long expected = memblock_phys_mem_size() - memblock_reserved_size();
+    unsigned long managed = ps.total_pages * PAGE_SIZE;
+    if (managed > expected || expected - managed >= MEMBLOCK_MAX_REGIONS * PAGE_SIZE) {
+        kprintf("   [MEMBLOCK] Error: el PMM gestiona %d KB de %d KB libres\n",
+                (long)(managed / 1024), (long)(expected / 1024));
+        errors++;
+    }
+
+    char *p = kmalloc(64);
+    unsigned long page = get_free_page();
+    if (p == nullptr || (unsigned long)p < l->heap_start || (unsigned long)p >= l->heap_end) {
+        kprintf("   [MEMBLOCK] Error: kmalloc() fuera del heap\n");
+        errors++;
+    }
+    for (int i = 0; page != 0 && i < 4; i++) {
+        if (ranges_overlap(page, page + PAGE_SIZE, ranges[i][0], ranges[i][1])) {
+            kprintf("   [MEMBLOCK] Error: el PMM entregó una página del %s\n", names[i]);
+            errors++;
+        }
+    }
+    kfree(p);
+    if (page != 0) free_page(page);
+
+    if (errors == 0) {
+        kprintf("[TEST] Memblock OK: regiones disjuntas y PMM con el resto de la RAM\n");
+    } else {
+        kprintf("[TEST] Memblock FALLÓ: %d errores\n", (long)errors);
+    }
+}
+
+/* ========================================================================== */
+/* PRUEBAS DE ESPACIOS DE DIRECCIONES (ASID)                                */
+/* ========================================================================== */
+
+#define ASID_TEST_VA      (DEMAND_VA_BASE + 0x300000)   /* Misma VA en todos */
+#define ASID_TEST_WORKERS 3
+#define ASID_TEST_ROUNDS  5
+
+static volatile int asid_lock;
+static volatile int asid_workers_done;
+static volatile int asid_errors;
+
+/**
+ * @brief Escribe su PID en ASID_TEST_VA y comprueba que nadie lo pisa
+ *
+ * @details
+ *   Cada ronda duerme para que los demás workers se planifiquen y
+ *   escriban en la misma VA: si las tablas o las entradas de la TLB se
+ *   compartieran, leería el PID de otro.
+ */
+static void asid_worker(void *arg) {
+    (void)arg;
+    enable_interrupts();
+
+    volatile unsigned long *slot = (volatile unsigned long *)ASID_TEST_VA;
+    unsigned long me = current_process->pid;
+    int errors = 0;
+
+    for (int r = 0; r < ASID_TEST_ROUNDS; r++) {
+        *slot = me * 100 + r;       /* Primera ronda: Page Fault en su tabla */
+        sleep(2);
+        if (*slot != me * 100 + r) {
+            kprintf("   [ASID] PID %d: leído %d, esperaba %d\n", me, *slot, me * 100 + r);
+            errors++;
+        }
+    }
+
+    unsigned long phys = vmm_translate(current_process->pgd, ASID_TEST_VA);
+    kprintf("   [ASID] PID %d: pgd 0x%x, ASID %d, VA 0x%x -> 0x%x\n",
+            me, (unsigned long)current_process->pgd,
+            current_process->asid & 0xFFFF, ASID_TEST_VA, phys);
+
+    unsigned long flags = spin_lock_irqsave(&asid_lock);
+    asid_errors += errors;
+    int last = (++asid_workers_done == ASID_TEST_WORKERS);
+    spin_unlock_irqrestore(&asid_lock, flags);
+
+    if (last) {
+        if (vmm_translate(kernel_pgd, ASID_TEST_VA) != 0) {
+            kprintf("   [ASID] Error: la VA de usuario aparece en kernel_pgd\n");
+            asid_errors++;
+        }
+
+        struct asid_stats st;
+        asid_get_stats(&st);
+        kprintf("   [ASID] %d bits, generación %d, %d asignados, %d cambios de generación\n",
+                (long)st.bits, st.generation, st.allocs, st.rollovers);
+
+        if (asid_errors == 0) {
+            kprintf("[TEST] ASID OK: %d procesos con la misma VA y memoria distinta\n",
+                    (long)ASID_TEST_WORKERS);
+        } else {
+            kprintf("[TEST] ASID FALLÓ: %d errores\n", (long)asid_errors);
+        }
+    }
+}
+
+/**
+ * @brief Lanza la prueba de espacios de direcciones por proceso
+ *
+ * @details
+ *   RESULTADO ESPERADO:
+ *   - Cada worker lee siempre su propio valor en ASID_TEST_VA
+ *   - pgd y ASID distintos en cada worker, y páginas físicas distintas
+ *   - kernel_pgd no tiene nada mapeado en esa VA
+ */
+void test_asid(void) {
+    kprintf("\n[TEST] --- Probando espacios de direcciones por proceso (ASID) ---\n");
+
+    asid_workers_done = 0;
+    asid_errors = 0;
+
+    for (int i = 0; i < ASID_TEST_WORKERS; i++) {
+        create_process(asid_worker, nullptr, 5, "asid_worker");
+    }
+}
+
+/* ========================================================================== */
+/* PRUEBAS DE INVALIDACIÓN SELECTIVA DE LA TLB                              */
+/* ========================================================================== */
+
+#define TLB_TEST_VA     (DEMAND_VA_BASE + 0x400000)
+#define TLB_TEST_PAGES  16
+#define TLB_TEST_FLAGS  (MM_RW | MM_KERNEL | MM_SH | MM_NG | (ATTR_NORMAL << 2))
+
+/**
+ * @brief Lee la primera palabra de cada página de la ventana de prueba
+ * @return Ticks de contador empleados
+ */
+static unsigned long tlb_sweep(unsigned long *values) {
+    unsigned long start = timer_get_count();
+    for (int i = 0; i < TLB_TEST_PAGES; i++) {
+        values[i] = *(volatile unsigned long *)(TLB_TEST_VA + i * PAGE_SIZE);
+    }
+    return timer_get_count() - start;
+}
+
+/**
+ * @brief Prueba de tlb_invalidate_page/range/asid
+ *
+ * @details
+ *   Mapea TLB_TEST_PAGES páginas (juego A), las lee para cargar la TLB
+ *   y las cambia a otro juego de físicas (B) con break-before-make: se
+ *   desmapea, se invalida con la primitiva a probar y se mapea de nuevo.
+ *   Si la invalidación no borrase la entrada cacheada se seguiría leyendo
+ *   el juego anterior:
+ *   - Tras tlb_invalidate_page() de la primera, esa lee de B y el resto de A
+ *   - Tras tlb_invalidate_range() de todas, todas leen de B
+ *   - Tras flush_tlb_mm() del proceso actual, todas vuelven a leer de A
+ *   Compara además el coste de releer la ventana tras vaciar la TLB
+ *   entera o solo una página.
+ */
+void test_tlb(void) {
+    kprintf("\n[TEST] --- Probando invalidación selectiva de la TLB ---\n");
+    kprintf("   [TLB] Invalidación por rangos: %s\n",
+            cpu_has_feature(CPU_FEATURE_TLBIRANGE) ? "RVAE1IS" : "no (VAE1IS por página)");
+
+    unsigned long *pgd = current_process->pgd;
+    unsigned long set_a[TLB_TEST_PAGES], set_b[TLB_TEST_PAGES], values[TLB_TEST_PAGES];
+    int errors = 0;
+
+    for (int i = 0; i < TLB_TEST_PAGES; i++) {
+        set_a[i] = get_free_page();
+        set_b[i] = get_free_page();
+        if (!set_a[i] || !set_b[i]) {
+            kprintf("[TEST] TLB FALLÓ: sin memoria\n");
+            return;
+        }
+        *(unsigned long *)set_a[i] = i;
+        *(unsigned long *)set_b[i] = 100 + i;
+        map_page(pgd, TLB_TEST_VA + i * PAGE_SIZE, set_a[i], TLB_TEST_FLAGS);
+    }
+    tlb_map_barrier();
+    tlb_sweep(values);
+
+    /* 1. Una página */
+    unmap_page(pgd, TLB_TEST_VA);
+    tlb_invalidate_page(TLB_TEST_VA);
+    map_page(pgd, TLB_TEST_VA, set_b[0], TLB_TEST_FLAGS);
+    tlb_map_barrier();
+    tlb_sweep(values);
+    if (values[0] != 100 || values[1] != 1) {
+        kprintf("   [TLB] Error: tras invalidar una página se lee %d, %d\n", values[0], values[1]);
+        errors++;
+    }
+
+    /* 2. Rango */
+    for (int i = 0; i < TLB_TEST_PAGES; i++) {
+        unmap_page(pgd, TLB_TEST_VA + i * PAGE_SIZE);
+    }
+    tlb_invalidate_range(TLB_TEST_VA, TLB_TEST_VA + TLB_TEST_PAGES * PAGE_SIZE);
+    for (int i = 0; i < TLB_TEST_PAGES; i++) {
+        map_page(pgd, TLB_TEST_VA + i * PAGE_SIZE, set_b[i], TLB_TEST_FLAGS);
+    }
+    tlb_map_barrier();
+    tlb_sweep(values);
+    for (int i = 0; i < TLB_TEST_PAGES; i++) {
+        if (values[i] != (unsigned long)(100 + i)) {
+            kprintf("   [TLB] Error: página %d lee %d tras invalidar el rango\n", (long)i, values[i]);
+            errors++;
+        }
+    }
+
+    /* 3. ASID del proceso: la única invalidación es flush_tlb_mm() */
+    for (int i = 0; i < TLB_TEST_PAGES; i++) {
+        unmap_page(pgd, TLB_TEST_VA + i * PAGE_SIZE);
+    }
+    flush_tlb_mm(current_process);
+    for (int i = 0; i < TLB_TEST_PAGES; i++) {
+        map_page(pgd, TLB_TEST_VA + i * PAGE_SIZE, set_a[i], TLB_TEST_FLAGS);
+    }
+    tlb_map_barrier();
+    tlb_sweep(values);
+    for (int i = 0; i < TLB_TEST_PAGES; i++) {
+        if (values[i] != (unsigned long)i) {
+            kprintf("   [TLB] Error: página %d lee %d tras flush_tlb_mm()\n", (long)i, values[i]);
+            errors++;
+        }
+    }
+
+    /* 4. Coste de releer la ventana: TLB entera vs una página */
+    tlb_sweep(values);
+    tlb_invalidate_all();
+    unsigned long cold = tlb_sweep(values);
+    tlb_invalidate_page(TLB_TEST_VA);
+    unsigned long warm = tlb_sweep(values);
+    kprintf("   [TLB] Releer %d páginas: %d ticks tras vaciar la TLB, %d tras invalidar una\n",
+            (long)TLB_TEST_PAGES, cold, warm);
+
+    for (int i = 0; i < TLB_TEST_PAGES; i++) {
+        unmap_page(pgd, TLB_TEST_VA + i * PAGE_SIZE);
+    }
+    tlb_invalidate_range(TLB_TEST_VA, TLB_TEST_VA + TLB_TEST_PAGES * PAGE_SIZE);
+    for (int i = 0; i < TLB_TEST_PAGES; i++) {
+        free_page(set_a[i]);
+        free_page(set_b[i]);
+    }
+
+    if (errors == 0) {
+        kprintf("[TEST] TLB OK: página, rango y ASID invalidan solo lo suyo\n");
+    } else {
+        kprintf("[TEST] TLB FALLÓ: %d errores\n", (long)errors);
+    }
+}
+
+/* ========================================================================== */
+/* PRUEBAS DE FORK CON COPY-ON-WRITE                                        */
+/* ========================================================================== */
+
+#define FORK_TEST_VA       (DEMAND_VA_BASE + 0x500000)
+#define FORK_TEST_PAGES    8
+#define FORK_TEST_CHILDREN 3
+
+static struct semaphore fork_done;
+static volatile int fork_errors;
+
+/**
+ * @brief Rellena una tabla, se clona y comprueba el aislamiento COW
+ *
+ * @details
+ *   Cada hijo ve la tabla del padre, escribe en su primera página
+ *   (fallo COW: se copia solo esa) y termina. El padre mide cuántas
+ *   páginas del PMM costó cada fork() y comprueba que ninguna escritura
+ *   de los hijos le llegó.
+ */
+static void fork_worker(void *arg) {
+    (void)arg;
+    enable_interrupts();
+
+    unsigned long *table = (unsigned long *)FORK_TEST_VA;
+    unsigned long words = FORK_TEST_PAGES * PAGE_SIZE / sizeof(unsigned long);
+    for (unsigned long i = 0; i < words; i++) {
+        table[i] = i;
+    }
+
+    unsigned long free_before = pmm_nr_free_pages();
+    int forked = 0;
+
+    for (int c = 0; c < FORK_TEST_CHILDREN; c++) {
+        long pid = fork();
+        if (pid == 0) {
+            /* === Hijo === */
+            unsigned long seen = table[words - 1];
+            table[0] = 1000 + current_process->pid;     /* Escritura -> fallo COW */
+            int ok = (seen == words - 1 && table[0] == (unsigned long)(1000 + current_process->pid));
+            kprintf("   [FORK] Hijo PID %d: ve la tabla del padre, escritura COW %s\n",
+                    current_process->pid, ok ? "ok" : "FALLO");
+            if (!ok) fork_errors++;
+            sem_signal(&fork_done);
+            return;
+        }
+        if (pid > 0) forked++;
+    }
+
+    unsigned long cost = (free_before - pmm_nr_free_pages()) / (forked ? forked : 1);
+    kprintf("   [FORK] %d hijos: %d paginas del PMM por fork() para %d paginas de datos\n",
+            (long)forked, cost, (long)FORK_TEST_PAGES);
+
+    for (int c = 0; c < forked; c++) {
+        sem_wait(&fork_done);
+    }
+
+    for (unsigned long i = 0; i < words; i++) {
+        if (table[i] != i) {
+            kprintf("   [FORK] Error: el padre ve %d en la palabra %d\n", table[i], i);
+            fork_errors++;
+            break;
+        }
+    }
+
+    if (forked == FORK_TEST_CHILDREN && fork_errors == 0) {
+        kprintf("[TEST] Fork OK: hijos aislados, solo se copian las paginas escritas\n");
+    } else {
+        kprintf("[TEST] Fork FALLÓ: %d hijos, %d errores\n", (long)forked, (long)fork_errors);
+    }
+}
+
+/**
+ * @brief Lanza la prueba de fork() con copy-on-write
+ *
+ * @details
+ *   RESULTADO ESPERADO:
+ *   - Cada fork() cuesta unas pocas páginas de tablas (raíz, L2, L3),
+ *     no FORK_TEST_PAGES páginas de datos
+ *   - Los hijos leen la tabla del padre y su escritura no le llega
+ */
+void test_fork(void) {
+    kprintf("\n[TEST] --- Probando fork() con copy-on-write ---\n");
+
+    sem_init(&fork_done, 0);
+    fork_errors = 0;
+    create_process(fork_worker, nullptr, 5, "fork_worker");
+}
+
+/* ========================================================================== */
+/* PRUEBAS DE PROCESOS DE USUARIO (EL0)                                     */
+/* ========================================================================== */
+
+#define USER_TEST_SHARED_VA  (DEMAND_VA_BASE + 0x600000)  /* Página compartida con el kernel */
+#define USER_TEST_DEMAND_VA  (DEMAND_VA_BASE + 0x601000)  /* Demand paging desde EL0 */
+#define USER_TEST_STACK_WORDS 64
+
+/**
+ * @brief Resultados que un proceso de EL0 deja al kernel
+ *
+ * @details
+ *   El proceso de usuario no puede leer ni escribir memoria del kernel:
+ *   se comunica por una página que el kernel mapea en su espacio en
+ *   USER_TEST_SHARED_VA y lee por el mapa lineal.
+ */
+struct user_test_page {
+    volatile unsigned long stack_ok;
+    volatile unsigned long demand_ok;
+    volatile unsigned long done;
+};
+
+/**
+ * @brief Termina el proceso de usuario actual (SYS_EXIT desde EL0)
+ */
+static inline void user_test_exit(void) {
+    asm volatile(
+        "mov x8, #1\n"      /* SYS_EXIT */
+        "mov x19, #0\n"     /* Código de salida */
+        "svc #0\n"
+        : : : "x8", "x19", "memory"
+    );
+}
+
+/**
+ * @brief Lanza un proceso de EL0 con 'shared' mapeada en USER_TEST_SHARED_VA
+ * @return PID, o -1 si no se pudo crear
+ *
+ * @details
+ *   La sección sin expropiación (rcu_read_lock) impide que el proceso
+ *   corra antes de tener la página: su tabla base todavía no está en
+ *   TTBR0, así que basta con escribir el descriptor. La página gana una
+ *   referencia por el mapeo; vmm_destroy_pgd() la suelta al terminar.
+ */
+static long user_test_spawn(void (*fn)(void), const char *name, unsigned long shared) {
+    page_get(shared);
+
+    rcu_read_lock();
+    long pid = create_user_process(fn, name);
+    struct pcb *p = (pid < 0) ? nullptr : process_find(pid);
+    if (p != nullptr) {
+        map_page(p->pgd, USER_TEST_SHARED_VA, shared,
+                 MM_RW | MM_USER | MM_SH | MM_NG | (ATTR_NORMAL << 2));
+    }
+    rcu_read_unlock();
+
+    if (p == nullptr) {
+        page_put(shared);
+        return -1;
+    }
+    return pid;
+}
+
+/**
+ * @brief Código de EL0: usa su pila y una página de demanda
+ *
+ * @details
+ *   Solo toca memoria de usuario y sale por SVC: no puede llamar a
+ *   funciones del kernel que lean sus datos. El prólogo ya escribe en
+ *   la pila (cima en USER_VA_END): el primer fallo llega en la primera
+ *   instrucción que guarda registros.
+ */
+static void user_test_probe(void) {
+    struct user_test_page *sh = (struct user_test_page *)USER_TEST_SHARED_VA;
+    volatile unsigned long frame[USER_TEST_STACK_WORDS];
+    volatile unsigned long *demand = (volatile unsigned long *)USER_TEST_DEMAND_VA;
+    unsigned long last = PAGE_SIZE / sizeof(unsigned long) - 1;
+
+    for (int i = 0; i < USER_TEST_STACK_WORDS; i++) {
+        frame[i] = (unsigned long)i * 3;
+    }
+    unsigned long sum = 0;
+    for (int i = 0; i < USER_TEST_STACK_WORDS; i++) {
+        sum += frame[i];
+    }
+    sh->stack_ok = (sum == 3UL * USER_TEST_STACK_WORDS * (USER_TEST_STACK_WORDS - 1) / 2);
+
+    demand[0] = 0xE10;
+    demand[last] = 0xE11;
+    sh->demand_ok = (demand[0] == 0xE10 && demand[last] == 0xE11);
+
+    sh->done = 1;
+    user_test_exit();
+}
+
+/**
+ * @brief Espera el resultado del proceso de EL0 y lo comprueba
+ */
+static void user_test_checker(void *arg) {
+    unsigned long shared = (unsigned long)arg;
+    struct user_test_page *sh = (struct user_test_page *)shared;
+    enable_interrupts();
+
+    /* Si handle_fault() lo mata, 'done' no llega nunca */
+    for (int t = 0; t < 100 && !sh->done; t++) {
+        sleep(5);
+    }
+
+    if (sh->done && sh->stack_ok && sh->demand_ok) {
+        kprintf("[TEST] User OK: pila y demand paging desde EL0\n");
+    } else {
+        kprintf("[TEST] User FALLÓ: terminado %d, pila %d, demanda %d\n",
+                (long)sh->done, (long)sh->stack_ok, (long)sh->demand_ok);
+    }
+    page_put(shared);
+}
+
+/**
+ * @brief Lanza un proceso real de EL0 (create_user_process)
+ *
+ * @details
+ *   RESULTADO ESPERADO:
+ *   - Los fallos de la pila (en la cima de USER_VA_END) y de
+ *     USER_TEST_DEMAND_VA llegan con EC 0x24 y se mapean con MM_USER
+ *   - El proceso escribe y relee ambas páginas y sale con SYS_EXIT;
+ *     si las páginas fueran solo de EL1, el fallo de permisos lo mataría
+ */
+void test_user(void) {
+    kprintf("\n[TEST] --- Probando proceso de usuario (EL0) ---\n");
+
+    unsigned long shared = get_free_page();
+    if (shared == 0) {
+        kprintf("[TEST] User FALLÓ: sin memoria\n");
+        return;
+    }
+
+    if (user_test_spawn(user_test_probe, "user_probe", shared) < 0) {
+        kprintf("[TEST] User FALLÓ: no se pudo crear el proceso\n");
+        page_put(shared);
+        return;
+    }
+    create_process(user_test_checker, (void *)shared, 5, "user_check");
+}
+
+/* ========================================================================== */
+/* PRUEBAS DE FUTEX DESDE EL0                                               */
+/* ========================================================================== */
+
+#define FUTEX_USER_WORKERS   2
+#define FUTEX_USER_ITERS     500
+#define FUTEX_USER_DEMAND_VA (DEMAND_VA_BASE + 0x602000)  /* umutex privado (demanda) */
+
+/**
+ * @brief Página compartida por los procesos de EL0 de la prueba de futex
+ *
+ * @details
+ *   Todos la tienen en USER_TEST_SHARED_VA sobre la misma física: la
+ *   clave del futex (dirección física) coincide aunque cada uno la
+ *   traduzca con su propia tabla base.
+ */
+struct futex_user_page {
+    volatile int lock;
+    volatile unsigned long counter;
+    volatile unsigned long done;
+    volatile unsigned long errors;
+};
+
+/**
+ * @brief Proceso de EL0: umutex privado, dirección del kernel y umutex
+ *        compartido con contención
+ *
+ * @details
+ *   1. umutex en FUTEX_USER_DEMAND_VA: el primer CAS es un fallo de
+ *      demanda desde EL0; FUTEX_WAKE sin waiters devuelve 0 y
+ *      FUTEX_WAIT con otro valor devuelve -1 sin dormir (ambos traducen
+ *      la página de usuario a su física)
+ *   2. FUTEX_WAKE sobre una variable del kernel: -1 (fuera de
+ *      [DEMAND_VA_BASE, USER_VA_END))
+ *   3. Contador compartido bajo el umutex de la página común; la espera
+ *      dentro de la sección hace que el timer expropie al propietario y
+ *      el otro proceso duerma en FUTEX_WAIT
+ */
+static void futex_user_worker(void) {
+    struct futex_user_page *sh = (struct futex_user_page *)USER_TEST_SHARED_VA;
+    volatile int *own = (volatile int *)FUTEX_USER_DEMAND_VA;
+    unsigned long errors = 0;
+
+    /* 1. Página privada de demanda */
+    umutex_lock(own);
+    if (*own != 1) errors++;
+    umutex_unlock(own);
+    if (futex_call(own, FUTEX_WAKE, 1) != 0) errors++;
+    if (futex_call(own, FUTEX_WAIT, 5) != -1) errors++;
+
+    /* 2. Dirección del kernel (solo se usa el valor del puntero) */
+    if (futex_call(&futex_test_lock, FUTEX_WAKE, 1) != -1) errors++;
+
+    /* 3. Contención en la página compartida */
+    for (int i = 0; i < FUTEX_USER_ITERS; i++) {
+        umutex_lock(&sh->lock);
+        unsigned long v = sh->counter;
+        if ((i & 31) == 0) {
+            for (int k = 0; k < 100000; k++) asm volatile("nop");
+        }
+        sh->counter = v + 1;
+        umutex_unlock(&sh->lock);
+    }
+
+    umutex_lock(&sh->lock);
+    sh->errors += errors;
+    sh->done++;
+    umutex_unlock(&sh->lock);
+
+    user_test_exit();
+}
+
+/**
+ * @brief Espera a los procesos de EL0 y comprueba el contador
+ */
+static void futex_user_checker(void *arg) {
+    unsigned long shared = (unsigned long)arg;
+    struct futex_user_page *sh = (struct futex_user_page *)shared;
+    enable_interrupts();
+
+    for (int t = 0; t < 400 && sh->done < FUTEX_USER_WORKERS; t++) {
+        sleep(5);
+    }
+
+    unsigned long expected = FUTEX_USER_WORKERS * FUTEX_USER_ITERS;
+    kprintf("   [FUTEX] EL0: contador %d/%d, %d/%d procesos, %d errores (%s)\n",
+            sh->counter, expected, sh->done, (long)FUTEX_USER_WORKERS, sh->errors,
+            (sh->done == FUTEX_USER_WORKERS && sh->counter == expected && sh->errors == 0)
+                ? "OK" : "FALLO");
+    page_put(shared);
+}
+
+/**
+ * @brief Lanza FUTEX_USER_WORKERS procesos de EL0 sobre una página común
+ */
+static void futex_user_start(void) {
+    unsigned long shared = get_free_page();
+    if (shared == 0) {
+        kprintf("   [FUTEX] EL0: FALLO (sin memoria)\n");
+        return;
+    }
+
+    int started = 0;
+    for (int i = 0; i < FUTEX_USER_WORKERS; i++) {
+        if (user_test_spawn(futex_user_worker, "futex_user", shared) >= 0) started++;
+    }
+    if (started < FUTEX_USER_WORKERS) {
+        kprintf("   [FUTEX] EL0: FALLO (%d/%d procesos creados)\n",
+                (long)started, (long)FUTEX_USER_WORKERS);
+    }
+    create_process(futex_user_checker, (void *)shared, 5, "futex_ucheck");
+}
@@ -0,0 +1,545 @@
+/**
+ * @file schedsim.c
+ * @brief Simulador de eventos discretos para el scheduler del kernel
+ *
+ * @details
+ *   Ejecuta el código REAL de src/kernel/scheduler.c, src/kernel/softirq.c
+ *   y src/semaphore.c como programa nativo del host, con tiempo virtual:
+ *
+ *   MODELO DE EJECUCIÓN:
+ *   - El tiempo avanza en unidades virtuales (SIM_TICK unidades = 1 tick)
+ *   - Cada tarea sintética es un pequeño programa de operaciones:
+ *     CPU(n) consume tiempo; SLEEP, SEM_WAIT y SEM_SIGNAL son instantáneas
+ *     y llaman a sleep()/sem_wait()/sem_signal() "como" current_process
+ *   - Eventos: fin de la ráfaga de CPU actual o siguiente tick del timer,
+ *     lo que llegue antes
+ *   - En cada tick se reproduce la ruta del IRQ: timer_tick() y
+ *     need_reschedule (handle_timer_irq), do_softirq() y schedule() si
+ *     is_reschedule_pending() (irq_handler_stub)
+ *
+ *   MÉTRICAS:
+ *   - Equidad: índice de Jain sobre el tiempo de CPU de cada clase
+ *   - Latencia de despertar: desde que una tarea bloqueada pasa a READY
+ *     hasta que vuelve a ejecutarse (percentiles p50/p90/p99/máx)
+ *   - Coste de schedule(): tiempo de host medido en la simulación y en
+ *     un microbenchmark con N procesos READY
+ *
+ *   Con la misma semilla los resultados de tiempo virtual son idénticos
+ *   en cada ejecución (solo varían los ns medidos en el host).
+ *
+ *   USO:
+ *   @code
+ *   make sim
+ *   build/schedsim [-s semilla] [-t ticks] [hogs|sleepers|chain|mixed|all]
+ *   @endcode
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../../include/sched.h"
+#include "../../include/kernel/scheduler.h"
+#include "../../include/kernel/softirq.h"
+#include "../../include/semaphore.h"
+
+/* Definidos en shim.c (kernel/process.h no se incluye: su exit() choca con libc) */
+extern struct pcb process[MAX_PROCESS];
+extern struct pcb *current_process;
+
+/* ========================================================================== */
+/* CONSTANTES                                                                */
+/* ========================================================================== */
+
+#define SIM_TICK        1000   /* Unidades de tiempo virtual por tick */
+#define SIM_MAX_OPS     8      /* Operaciones por programa de tarea */
+#define SIM_MAX_SEMS    16
+#define SIM_MAX_INSTANT 1000   /* Ops instantáneas seguidas antes de abortar */
+
+/* ========================================================================== */
+/* TAREAS SINTÉTICAS                                                         */
+/* ========================================================================== */
+
+enum op_kind { OP_CPU, OP_SLEEP, OP_SEM_WAIT, OP_SEM_SIGNAL, OP_LOOP };
+
+struct op {
+    enum op_kind kind;
+    long arg;      /* Unidades de CPU, ticks de sleep o índice de semáforo */
+    long jitter;   /* Variación aleatoria +-jitter para OP_CPU */
+};
+
+enum task_class { CLASS_HOG, CLASS_SLEEPER, CLASS_CHAIN, NR_CLASSES };
+
+static const char *class_names[NR_CLASSES] = { "hog", "sleeper", "chain" };
+
+struct sim_task {
+    int used;
+    int class;
+    struct op prog[SIM_MAX_OPS];
+    int nops;
+    int pc;                /* Próxima operación */
+    long remaining;        /* Unidades que faltan del OP_CPU actual (-1 = sin empezar) */
+    unsigned long cpu;     /* Unidades de CPU consumidas */
+    long last_state;       /* Estado del PCB en la última observación */
+    long ready_at;         /* Instante en que despertó (-1 = no pendiente) */
+    unsigned long wakeups;
+};
+
+/* Muestras de latencia (crecen con realloc) */
+struct samples {
+    unsigned long *v;
+    size_t n;
+    size_t cap;
+};
+
+/* ========================================================================== */
+/* ESTADO DE LA SIMULACIÓN                                                   */
+/* ========================================================================== */
+
+static struct sim_task tasks[MAX_PROCESS];
+static struct semaphore sems[SIM_MAX_SEMS];
+static struct samples lat[NR_CLASSES];
+
+static unsigned long now;             /* Tiempo virtual actual */
+static unsigned long idle_time;       /* Tiempo con PID 0 en la CPU */
+static unsigned long rng_state;
+static struct pcb *last_current;
+
+static unsigned long sched_calls;     /* schedule() lanzados desde el tick */
+static unsigned long sched_ns;        /* Tiempo de host en esas llamadas */
+
+/* ========================================================================== */
+/* UTILIDADES                                                                */
+/* ========================================================================== */
+
+/* xorshift64: determinista y suficiente para jitter */
+static unsigned long rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static unsigned long host_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)ts.tv_sec * 1000000000UL + (unsigned long)ts.tv_nsec;
+}
+
+static void sample_add(struct samples *s, unsigned long v) {
+    if (s->n == s->cap) {
+        s->cap = s->cap ? s->cap * 2 : 256;
+        s->v = realloc(s->v, s->cap * sizeof(unsigned long));
+        if (!s->v) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    s->v[s->n++] = v;
+}
+
+static int cmp_ulong(const void *a, const void *b) {
+    unsigned long x = *(const unsigned long *)a;
+    unsigned long y = *(const unsigned long *)b;
+    return (x > y) - (x < y);
+}
+
+/* Solo con s->n > 0: report() imprime "n/a" para una clase sin muestras */
+static unsigned long percentile(struct samples *s, int p) {
+    if (s->n == 0) return 0;
+    size_t idx = (s->n * p) / 100;
+    if (idx >= s->n) idx = s->n - 1;
+    return s->v[idx];
+}
+
+/* ========================================================================== */
+/* CREACIÓN DE TAREAS                                                        */
+/* ========================================================================== */
+
+/**
+ * @brief Reinicia el "kernel" simulado: solo PID 0 (idle) en ejecución
+ */
+static void sim_reset(unsigned long seed) {
+    memset(process, 0, sizeof(process));
+    memset(tasks, 0, sizeof(tasks));
+    for (int i = 0; i < NR_CLASSES; i++) {
+        free(lat[i].v);
+        lat[i].v = nullptr;
+        lat[i].n = lat[i].cap = 0;
+    }
+
+    process[0].pid = 0;
+    process[0].state = PROCESS_RUNNING;
+    process[0].priority = 0;
+    strcpy(process[0].name, "idle");
+    current_process = &process[0];
+    last_current = current_process;
+
+    sys_timer_count = 0;
+    need_reschedule = 0;
+    timer_schedule_event(0);
+
+    now = 0;
+    idle_time = 0;
+    sched_calls = 0;
+    sched_ns = 0;
+    sim_context_switches = 0;
+    rng_state = seed ? seed : 1;
+}
+
+/**
+ * @brief Crea una tarea con el mismo estado inicial que create_process()
+ */
+static struct sim_task *sim_spawn(int class, int priority, const char *name) {
+    for (int pid = 1; pid < MAX_PROCESS; pid++) {
+        if (process[pid].state != PROCESS_UNUSED) continue;
+
+        struct pcb *p = &process[pid];
+        p->pid = pid;
+        p->state = PROCESS_READY;
+        p->priority = priority;
+        p->block_reason = BLOCK_REASON_NONE;
+        snprintf(p->name, sizeof(p->name), "%s", name);
+
+        struct sim_task *t = &tasks[pid];
+        t->used = 1;
+        t->class = class;
+        t->remaining = -1;
+        t->last_state = PROCESS_READY;
+        t->ready_at = -1;
+        return t;
+    }
+
+    fprintf(stderr, "schedsim: tabla de procesos llena\n");
+    exit(1);
+}
+
+static void sim_op(struct sim_task *t, enum op_kind kind, long arg, long jitter) {
+    t->prog[t->nops].kind = kind;
+    t->prog[t->nops].arg = arg;
+    t->prog[t->nops].jitter = jitter;
+    t->nops++;
+}
+
+/* ========================================================================== */
+/* OBSERVACIÓN DE TRANSICIONES                                               */
+/* ========================================================================== */
+
+/**
+ * @brief Detecta despertares y cambios de current_process tras cada
+ *        llamada al código del kernel
+ */
+static void sim_observe(void) {
+    for (int i = 1; i < MAX_PROCESS; i++) {
+        struct sim_task *t = &tasks[i];
+        if (!t->used) continue;
+
+        long st = process[i].state;
+        if (t->last_state == PROCESS_BLOCKED && st != PROCESS_BLOCKED) {
+            t->ready_at = (long)now;
+            t->wakeups++;
+        }
+        t->last_state = st;
+    }
+
+    if (current_process != last_current) {
+        struct sim_task *t = &tasks[current_process->pid];
+        if (t->used && t->ready_at >= 0) {
+            sample_add(&lat[t->class], now - (unsigned long)t->ready_at);
+            t->ready_at = -1;
+        }
+        last_current = current_process;
+    }
+}
+
+/* ========================================================================== */
+/* MOTOR DE EVENTOS                                                          */
+/* ========================================================================== */
+
+static struct sim_task *sim_current(void) {
+    struct sim_task *t = &tasks[current_process->pid];
+    return t->used ? t : nullptr;
+}
+
+/**
+ * @brief Ejecuta las operaciones instantáneas de la tarea en CPU
+ *
+ * @details
+ *   Se avanza 'pc' ANTES de llamar al kernel: si la tarea se bloquea,
+ *   al volver a ejecutarse continúa con la operación siguiente (en
+ *   sem_wait() el semáforo se le entrega al despertarla).
+ */
+static void sim_run_instant(void) {
+    for (int guard = 0; guard < SIM_MAX_INSTANT; guard++) {
+        struct sim_task *t = sim_current();
+        if (!t) return;
+
+        struct op *op = &t->prog[t->pc];
+        switch (op->kind) {
+            case OP_CPU:
+                return;
+            case OP_LOOP:
+                t->pc = 0;
+                continue;
+            case OP_SLEEP:
+                t->pc++;
+                sleep((unsigned int)op->arg);
+                break;
+            case OP_SEM_WAIT:
+                t->pc++;
+                sem_wait(&sems[op->arg]);
+                break;
+            case OP_SEM_SIGNAL:
+                t->pc++;
+                sem_signal(&sems[op->arg]);
+                break;
+        }
+        sim_observe();
+    }
+
+    fprintf(stderr, "schedsim: PID %ld no consume CPU (programa sin OP_CPU?)\n",
+            current_process->pid);
+    exit(1);
+}
+
+/**
+ * @brief Reproduce handle_timer_irq() + irq_handler_stub para un tick
+ */
+static void sim_tick(void) {
+    timer_tick();
+    need_reschedule = 1;   /* Como handle_timer_irq() */
+    do_softirq();
+    sim_observe();
+
+    if (is_reschedule_pending()) {
+        unsigned long t0 = host_ns();
+        schedule();
+        sched_ns += host_ns() - t0;
+        sched_calls++;
+        sim_observe();
+    }
+}
+
+/**
+ * @brief Simula 'ticks' ticks del timer
+ */
+static void sim_run(unsigned long ticks) {
+    unsigned long end = ticks * SIM_TICK;
+    unsigned long next_tick = SIM_TICK;
+
+    while (now < end) {
+        sim_run_instant();
+
+        struct sim_task *t = sim_current();
+        if (t) {
+            struct op *op = &t->prog[t->pc];
+            if (t->remaining < 0) {
+                long j = op->jitter ? (long)(rng_next() % (2 * op->jitter + 1)) - op->jitter : 0;
+                t->remaining = op->arg + j > 1 ? op->arg + j : 1;
+            }
+
+            unsigned long run = next_tick - now;
+            if ((unsigned long)t->remaining < run) run = t->remaining;
+
+            now += run;
+            t->cpu += run;
+            t->remaining -= run;
+            if (t->remaining == 0) {
+                t->remaining = -1;
+                t->pc++;
+            }
+        } else {
+            idle_time += next_tick - now;
+            now = next_tick;
+        }
+
+        if (now >= next_tick) {
+            sim_tick();
+            next_tick += SIM_TICK;
+        }
+    }
+}
+
+/* ========================================================================== */
+/* ESCENARIOS                                                                */
+/* ========================================================================== */
+
+/* Tareas que solo consumen CPU */
+static void add_hogs(int n, int priority) {
+    for (int i = 0; i < n; i++) {
+        struct sim_task *t = sim_spawn(CLASS_HOG, priority, "hog");
+        sim_op(t, OP_CPU, 50 * SIM_TICK, 0);
+        sim_op(t, OP_LOOP, 0, 0);
+    }
+}
+
+/* Tareas interactivas: ráfaga corta y sleep */
+static void add_sleepers(int n, int priority) {
+    for (int i = 0; i < n; i++) {
+        struct sim_task *t = sim_spawn(CLASS_SLEEPER, priority, "sleeper");
+        sim_op(t, OP_CPU, SIM_TICK / 5, SIM_TICK / 10);
+        sim_op(t, OP_SLEEP, 3 + i % 4, 0);
+        sim_op(t, OP_LOOP, 0, 0);
+    }
+}
+
+/* Anillo de n tareas que se pasan un testigo con semáforos */
+static void add_chain(int n, int priority) {
+    for (int i = 0; i < n; i++) {
+        sem_init(&sems[i], i == 0 ? 1 : 0);
+    }
+    for (int i = 0; i < n; i++) {
+        struct sim_task *t = sim_spawn(CLASS_CHAIN, priority, "chain");
+        sim_op(t, OP_SEM_WAIT, i, 0);
+        sim_op(t, OP_CPU, SIM_TICK / 2, SIM_TICK / 4);
+        sim_op(t, OP_SEM_SIGNAL, (i + 1) % n, 0);
+        sim_op(t, OP_LOOP, 0, 0);
+    }
+}
+
+struct scenario {
+    const char *name;
+    const char *desc;
+    void (*setup)(void);
+};
+
+static void setup_hogs(void)     { add_hogs(8, 10); }
+static void setup_sleepers(void) { add_hogs(4, 10); add_sleepers(8, 10); }
+static void setup_chain(void)    { add_chain(6, 10); add_hogs(2, 10); }
+static void setup_mixed(void)    { add_hogs(4, 10); add_sleepers(6, 10); add_chain(4, 10); }
+
+static const struct scenario scenarios[] = {
+    { "hogs",     "8 tareas de CPU",                     setup_hogs },
+    { "sleepers", "4 de CPU + 8 interactivas (sleep)",   setup_sleepers },
+    { "chain",    "anillo de 6 con semaforos + 2 de CPU", setup_chain },
+    { "mixed",    "4 de CPU + 6 interactivas + anillo de 4", setup_mixed },
+};
+
+#define NR_SCENARIOS (sizeof(scenarios) / sizeof(scenarios[0]))
+
+/* ========================================================================== */
+/* INFORMES                                                                  */
+/* ========================================================================== */
+
+static void report(const struct scenario *sc, unsigned long ticks) {
+    printf("\n=== %s: %s (%lu ticks) ===\n", sc->name, sc->desc, ticks);
+
+    unsigned long total = now ? now : 1;
+    printf("CPU idle: %.1f%%   cambios de contexto: %lu   schedule() desde tick: %lu\n",
+           100.0 * idle_time / total, sim_context_switches, sched_calls);
+
+    printf("%-8s %5s %8s %8s %9s %9s %9s %9s\n",
+           "clase", "n", "cpu%", "jain", "p50", "p90", "p99", "max");
+
+    for (int c = 0; c < NR_CLASSES; c++) {
+        int n = 0;
+        double sum = 0, sum2 = 0;
+        for (int i = 1; i < MAX_PROCESS; i++) {
+            if (!tasks[i].used || tasks[i].class != c) continue;
+            double x = (double)tasks[i].cpu;
+            sum += x;
+            sum2 += x * x;
+            n++;
+        }
+        if (n == 0) continue;
+
+        double jain = (sum2 > 0) ? (sum * sum) / (n * sum2) : 1.0;
+        struct samples *s = &lat[c];
+        qsort(s->v, s->n, sizeof(unsigned long), cmp_ulong);
+
+        printf("%-8s %5d %7.1f%% %8.3f", class_names[c], n, 100.0 * sum / total, jain);
+
+        /* Sin muestras no hay latencia que enseñar (no es un 0.00) */
+        if (s->n == 0) {
+            printf(" %9s %9s %9s %9s\n", "n/a", "n/a", "n/a", "n/a");
+            continue;
+        }
+
+        /* Latencias en ticks (con decimales) */
+        printf(" %9.2f %9.2f %9.2f %9.2f\n",
+               percentile(s, 50) / (double)SIM_TICK,
+               percentile(s, 90) / (double)SIM_TICK,
+               percentile(s, 99) / (double)SIM_TICK,
+               s->v[s->n - 1] / (double)SIM_TICK);
+    }
+
+    if (sched_calls) {
+        printf("coste schedule() (host): %.1f ns/llamada\n", (double)sched_ns / sched_calls);
+    }
+}
+
+/**
+ * @brief Microbenchmark: coste de schedule() con n procesos READY
+ */
+static void bench_schedule(int n) {
+    const unsigned long iters = 200000;
+
+    sim_reset(1);
+    for (int i = 0; i < n; i++) {
+        sim_spawn(CLASS_HOG, 10 + i % 5, "bench");
+    }
+
+    unsigned long t0 = host_ns();
+    for (unsigned long i = 0; i < iters; i++) {
+        schedule();
+    }
+    unsigned long elapsed = host_ns() - t0;
+
+    printf("  %2d READY: %7.1f ns/llamada\n", n, (double)elapsed / iters);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "uso: %s [-s semilla] [-t ticks] [hogs|sleepers|chain|mixed|all]\n", prog);
+    exit(2);
+}
+
+/* ========================================================================== */
+/* MAIN                                                                      */
+/* ========================================================================== */
+
+int main(int argc, char **argv) {
+    unsigned long seed = 1;
+    unsigned long ticks = 10000;
+    const char *which = "all";
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            seed = strtoul(argv[++i], nullptr, 0);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            ticks = strtoul(argv[++i], nullptr, 0);
+        } else if (argv[i][0] == '-') {
+            usage(argv[0]);
+        } else {
+            which = argv[i];
+        }
+    }
+
+    /* Igual que timer_init(): la softirq del timer despierta a los dormidos */
+    open_softirq(SOFTIRQ_TIMER, timer_softirq);
+
+    printf("schedsim: semilla %lu, %d unidades/tick, MAX_PROCESS %d\n",
+           seed, SIM_TICK, MAX_PROCESS);
+
+    int ran = 0;
+    for (size_t i = 0; i < NR_SCENARIOS; i++) {
+        if (strcmp(which, "all") != 0 && strcmp(which, scenarios[i].name) != 0) continue;
+
+        sim_reset(seed);
+        scenarios[i].setup();
+        sim_run(ticks);
+        report(&scenarios[i], ticks);
+        ran++;
+    }
+    if (!ran) usage(argv[0]);
+
+    printf("\nMicrobenchmark schedule():\n");
+    bench_schedule(4);
+    bench_schedule(16);
+    bench_schedule(MAX_PROCESS - 1);
+
+    return 0;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file shim.c
+ * @brief Sustitutos en C de los símbolos del kernel que usa el scheduler
+ *
+ * @details
+ *   El scheduler real (src/kernel/scheduler.c) depende de:
+ *   - process[] y current_process (src/kernel/process.c)
+ *   - cpu_switch_to, local_irq_*, enable/disable_interrupts (src/entry.S)
+ *   - spin_lock/spin_unlock (src/locks.S, vía src/semaphore.c)
+ *   - delayed_work_tick (src/kernel/workqueue.c)
+ *   - timer_get_count (src/utils.S, sello CNTPCT de cada tick)
+ *   - rcu_note_context_switch (src/kernel/rcu.c)
+ *   - switch_mm (src/mm/asid.c)
+ *
+ *   En el host no hay pilas que cambiar ni IRQs que enmascarar:
+ *   - cpu_switch_to() solo cuenta el cambio. schedule() ya ha actualizado
+ *     current_process, así que el simulador "continúa" como el proceso
+ *     elegido en cuanto la llamada retorna.
+ *   - Las secciones críticas son triviales (un único hilo de ejecución).
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ */
+
+#include "../../include/sched.h"
+
+/* ========================================================================== */
+/* ESTADO DE PROCESOS (src/kernel/process.c)                                 */
+/* ========================================================================== */
+
+struct pcb process[MAX_PROCESS];
+struct pcb *current_process;
+
+/* ========================================================================== */
+/* CAMBIO DE CONTEXTO E IRQs (src/entry.S)                                   */
+/* ========================================================================== */
+
+unsigned long sim_context_switches = 0;
+
+void cpu_switch_to(struct pcb *prev, struct pcb *next) {
+    (void)prev;
+    (void)next;
+    sim_context_switches++;
+}
+
+void enable_interrupts(void) {}
+void disable_interrupts(void) {}
+
+unsigned long local_irq_save(void) {
+    return 0;
+}
+
+void local_irq_restore(unsigned long flags) {
+    (void)flags;
+}
+
+/* ========================================================================== */
+/* SPINLOCKS (src/locks.S)                                                   */
+/* ========================================================================== */
+
+void spin_lock(volatile int *lock) {
+    *lock = 1;
+}
+
+void spin_unlock(volatile int *lock) {
+    *lock = 0;
+}
+
+/* ========================================================================== */
+/* CONTADOR DEL SISTEMA (src/utils.S)                                        */
+/* ========================================================================== */
+
+extern volatile unsigned long sys_timer_count;
+
+/* Tiempo virtual: cada tick equivale a TIMER_INTERVAL (2000000) ciclos */
+unsigned long timer_get_count(void) {
+    return sys_timer_count * 2000000UL;
+}
+
+/* ========================================================================== */
+/* WORKQUEUES (src/kernel/workqueue.c)                                       */
+/* ========================================================================== */
+
+void delayed_work_tick(unsigned long now) {
+    (void)now;
+}
+
+/* ========================================================================== */
+/* RCU (src/kernel/rcu.c)                                                    */
+/* ========================================================================== */
+
+/* Sin lectores RCU en el simulador: no hay callbacks que avanzar */
+void rcu_note_context_switch(void) {}
+
+/* ========================================================================== */
+/* ASIDS (src/mm/asid.c)                                                     */
+/* ========================================================================== */
+
+/* Sin MMU en el host: no hay TTBR0 que preparar */
+void switch_mm(struct pcb *next) {
+    (void)next;
+}
@@ -0,0 +1,27 @@
+/**
+ * @file shim.h
+ * @brief Capa de compatibilidad para compilar el scheduler en el host
+ *
+ * @details
+ *   Se incluye con -include en TODAS las unidades de compilación del
+ *   simulador (también en src/kernel/scheduler.c, src/kernel/softirq.c,
+ *   src/kernel/wait.c y src/semaphore.c, que se compilan sin modificar).
+ *
+ *   - nullptr: los compiladores anteriores a C23 no lo conocen
+ *   - sim_*: ganchos que shim.c expone al simulador
+ *
+ * @author Sistema Operativo Educativo BareMetalM4
+ * @version 0.7
+ */
+
+#ifndef SCHEDSIM_SHIM_H
+#define SCHEDSIM_SHIM_H
+
+#if !defined(__STDC_VERSION__) || __STDC_VERSION__ < 202311L
+#define nullptr ((void *)0)
+#endif
+
+/* Número de cambios de contexto realizados (llamadas a cpu_switch_to) */
+extern unsigned long sim_context_switches;
+
+#endif /* SCHEDSIM_SHIM_H */